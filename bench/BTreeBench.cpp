@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Vector.h>
+#include <baseline/SortedVector.h>
+#include <baseline/BTreeMap.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+typedef key_value_pair_t<int64_t, int64_t> pair_t;
+
+static void run( size_t count )
+{
+  char label[64];
+  bench::Stopwatch timer;
+  int64_t found = 0;
+
+  // small sizes repeat the lookups and scans to get measurable times
+  const size_t rounds = MAX( size_t( 1 ), size_t( 1000000 ) / count );
+
+  Vector<int64_t> keys;
+  keys.setCapacity( count );
+  uint64_t seed = 42;
+  for( size_t i = 0; i < count; i++ ) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    keys.push_back( int64_t( seed >> 1 ) );
+  }
+
+  {
+    BTreeMap<int64_t, int64_t> map;
+    timer.reset();
+    for( size_t i = 0; i < count; i++ ) {
+      map.add( keys[i], int64_t( i ) );
+    }
+    snprintf( label, sizeof( label ), "%zu BTreeMap insert", count );
+    bench::report( label, timer.seconds(), 0 );
+  }
+
+  SortedVector<pair_t> sorted;
+  Vector<pair_t> pairs;
+  timer.reset();
+  pairs.setCapacity( count );
+  for( size_t i = 0; i < count; i++ ) {
+    pairs.push_back( pair_t( keys[i], int64_t( i ) ) );
+  }
+  sorted.merge( pairs );
+  snprintf( label, sizeof( label ), "%zu SortedVector build", count );
+  bench::report( label, timer.seconds(), 0 );
+  pairs.clear();
+
+  BTreeMap<int64_t, int64_t> map;
+  timer.reset();
+  map.bulkLoad( sorted );
+  snprintf( label, sizeof( label ), "%zu BTreeMap bulkLoad", count );
+  bench::report( label, timer.seconds(), 0 );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    for( size_t i = 0; i < count; i++ ) {
+      found += map.find( keys[i] ).isValid();
+      found += map.find( keys[i] ^ 1 ).isValid();
+    }
+  }
+  snprintf( label, sizeof( label ), "%zu BTreeMap lookup", count );
+  bench::report( label, timer.seconds() / rounds, 0 );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    for( size_t i = 0; i < count; i++ ) {
+      found += sorted.indexOf( pair_t( keys[i] ) ) >= 0;
+      found += sorted.indexOf( pair_t( keys[i] ^ 1 ) ) >= 0;
+    }
+  }
+  snprintf( label, sizeof( label ), "%zu SortedVector lookup", count );
+  bench::report( label, timer.seconds() / rounds, 0 );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    for( BTreeMap<int64_t, int64_t>::Iterator it = map.begin(); it.isValid(); it.next() ) {
+      found += it.value();
+    }
+  }
+  snprintf( label, sizeof( label ), "%zu BTreeMap scan", count );
+  bench::report( label, timer.seconds() / rounds, double( count ) * sizeof( pair_t ) );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    const pair_t* items = sorted.array();
+    for( size_t i = 0; i < count; i++ ) {
+      found += items[i].value;
+    }
+  }
+  snprintf( label, sizeof( label ), "%zu SortedVector scan", count );
+  bench::report( label, timer.seconds() / rounds, double( count ) * sizeof( pair_t ) );
+
+  bench::doNotOptimize( found );
+}
+
+/**
+ * Compares BTreeMap with a SortedVector of key/value pairs for random
+ * int64_t keys: building, looking up every key plus as many misses, and
+ * scanning in key order. Runs once per count given, 1K and 1M by default.
+ *
+ *   BTreeBench [count...]
+ */
+int main( int argc, char** argv )
+{
+  if( argc < 2 ) {
+    run( 1000 );
+    run( 1000000 );
+  }
+  for( int i = 1; i < argc; i++ ) {
+    run( bench::sizeArg( argc, argv, i, 0 ) );
+  }
+  printf( "peak RSS %ld KB\n", bench::peakRSSKB() );
+  return 0;
+}
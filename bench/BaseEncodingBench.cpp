@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/BaseEncoding.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * Table driven base64, a group at a time: what the vector kernels are
+ * measured against.
+ */
+static BENCH_NOINLINE void reference_encode( const uint8_t* src, size_t len, char* dst )
+{
+  static const char chars[64 + 1] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  for( size_t i = 0; i + 3 <= len; i += 3, dst += 4 ) {
+    const uint32_t v = ( uint32_t( src[i] ) << 16 ) | ( uint32_t( src[i + 1] ) << 8 ) | src[i + 2];
+    dst[0] = chars[v >> 18];
+    dst[1] = chars[( v >> 12 ) & 63];
+    dst[2] = chars[( v >> 6 ) & 63];
+    dst[3] = chars[v & 63];
+  }
+}
+
+static BENCH_NOINLINE bool reference_decode( const char* src, size_t len, uint8_t* dst )
+{
+  static uint8_t values[256];
+  if( values[0] == 0 ) {
+    memset( values, 0xFF, sizeof( values ) );
+    for( int i = 0; i < 64; i++ ) {
+      values[uint8_t( "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[i] )] = uint8_t( i );
+    }
+  }
+  for( size_t i = 0; i + 4 <= len; i += 4, dst += 3 ) {
+    const uint32_t a = values[uint8_t( src[i] )];
+    const uint32_t b = values[uint8_t( src[i + 1] )];
+    const uint32_t c = values[uint8_t( src[i + 2] )];
+    const uint32_t d = values[uint8_t( src[i + 3] )];
+    if( ( a | b | c | d ) & 0x80 ) {
+      return false;
+    }
+    const uint32_t v = ( a << 18 ) | ( b << 12 ) | ( c << 6 ) | d;
+    dst[0] = uint8_t( v >> 16 );
+    dst[1] = uint8_t( v >> 8 );
+    dst[2] = uint8_t( v );
+  }
+  return true;
+}
+
+/**
+ * Encodes and decodes a 1MB buffer with a scalar base64 reference and
+ * with each of the encodings, reporting MB/s of binary data.
+ *
+ *   BaseEncodingBench [total]
+ */
+int main( int argc, char** argv )
+{
+  const size_t total = bench::sizeArg( argc, argv, 1, size_t( 256 ) << 20 );
+  const size_t size = 3 * 5 * ( 1 << 16 );
+  const size_t rounds = MAX( total / size, size_t( 1 ) );
+  Vector<uint8_t> data;
+  data.setCapacity( size );
+  uint32_t seed = 7;
+  for( size_t i = 0; i < size; i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    data.add( uint8_t( seed >> 24 ) );
+  }
+  const uint8_t* p = data.array();
+  Vector<char> text;
+  text.insertAt( char( 0 ), 0, 2 * size );
+  Vector<uint8_t> bytes;
+  bytes.insertAt( uint8_t( 0 ), 0, size );
+  size_t check = 0;
+
+  bench::Stopwatch timer;
+  for( size_t r = 0; r < rounds; r++ ) {
+    reference_encode( p, size, text.editArray() );
+  }
+  bench::report( "reference base64 encode", timer.seconds(), double( rounds ) * double( size ) );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    check += reference_decode( text.array(), size / 3 * 4, bytes.editArray() );
+  }
+  bench::report( "reference base64 decode", timer.seconds(), double( rounds ) * double( size ) );
+
+  static const struct {
+    const char* name;
+    BaseEncoding& encoding;
+  } encodings[] = {
+    { "base64", base64Encoding() },
+    { "base64url", base64UrlEncoding() },
+    { "base32", base32Encoding() },
+    { "hex", hexEncoding() },
+  };
+  for( size_t e = 0; e < sizeof( encodings ) / sizeof( encodings[0] ); e++ ) {
+    const BaseEncoding& encoding = encodings[e].encoding;
+    const size_t chars = encoding.encodedLength( size );
+    char label[64];
+
+    timer.reset();
+    for( size_t r = 0; r < rounds; r++ ) {
+      encoding.encodeInto( p, size, text.editArray() );
+    }
+    snprintf( label, sizeof( label ), "%s encode", encodings[e].name );
+    bench::report( label, timer.seconds(), double( rounds ) * double( size ) );
+
+    timer.reset();
+    for( size_t r = 0; r < rounds; r++ ) {
+      check += encoding.decodeInto( text.array(), chars, bytes.editArray() );
+    }
+    snprintf( label, sizeof( label ), "%s decode", encodings[e].name );
+    bench::report( label, timer.seconds(), double( rounds ) * double( size ) );
+    if( memcmp( bytes.array(), p, size ) != 0 ) {
+      fprintf( stderr, "%s does not round trip\n", encodings[e].name );
+      return 1;
+    }
+  }
+  bench::doNotOptimize( check );
+  return 0;
+}
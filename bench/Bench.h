@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_BENCH_H_
+#define BASELINE_BENCH_H_
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/resource.h>
+#endif
+
+/**
+ * Keeps a helper out of line so that inlining it into one caller but not
+ * another does not skew a comparison.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+  #define BENCH_NOINLINE __attribute__(( noinline ))
+#elif defined(_MSC_VER)
+  #define BENCH_NOINLINE __declspec( noinline )
+#else
+  #define BENCH_NOINLINE
+#endif
+
+namespace bench {
+
+class Stopwatch
+{
+public:
+  Stopwatch() {
+    reset();
+  }
+
+  void reset() {
+    mStart = std::chrono::steady_clock::now();
+  }
+
+  double seconds() const {
+    return std::chrono::duration<double>( std::chrono::steady_clock::now() - mStart ).count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point mStart;
+};
+
+/**
+ * Peak resident set size of this process in kilobytes, or 0 if unknown.
+ */
+inline long peakRSSKB()
+{
+#if defined(__unix__) || defined(__APPLE__)
+  struct rusage usage;
+  if( getrusage( RUSAGE_SELF, &usage ) == 0 ) {
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+  }
+#endif
+  return 0;
+}
+
+/**
+ * Parse argv[index] as a size (accepts K/M/G suffixes), or return def.
+ */
+inline size_t sizeArg( int argc, char** argv, int index, size_t def )
+{
+  if( index >= argc ) {
+    return def;
+  }
+  char* end;
+  size_t value = strtoull( argv[index], &end, 10 );
+  switch( *end ) {
+  case 'G':
+  case 'g':
+    value <<= 30;
+    break;
+  case 'M':
+  case 'm':
+    value <<= 20;
+    break;
+  case 'K':
+  case 'k':
+    value <<= 10;
+    break;
+  }
+  return value;
+}
+
+/**
+ * Keep the optimizer from discarding a computed value.
+ */
+template<typename T>
+inline void doNotOptimize( const T& value )
+{
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile( "" : : "r,m"( value ) : "memory" );
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+inline void report( const char* name, double seconds, double bytes )
+{
+  if( bytes > 0 ) {
+    printf( "%-40s %10.3f ms  %10.2f MB/s\n", name, seconds * 1e3, bytes / seconds / ( 1024.0 * 1024.0 ) );
+  } else {
+    printf( "%-40s %10.3f ms\n", name, seconds * 1e3 );
+  }
+}
+
+} // namespace bench
+
+#endif // BASELINE_BENCH_H_
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Hash.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * The old Crc32::update: one table lookup per byte.
+ */
+static uint32_t bytewise_crc32( const uint8_t* data, size_t len )
+{
+  static uint32_t table[256];
+  if( table[1] == 0 ) {
+    for( uint32_t i = 0; i < 256; i++ ) {
+      uint32_t crc = i;
+      for( int bit = 0; bit < 8; bit++ ) {
+        crc = crc & 1 ? ( crc >> 1 ) ^ 0xEDB88320 : crc >> 1;
+      }
+      table[i] = crc;
+    }
+  }
+  uint32_t crc = 0xFFFFFFFF;
+  while( len-- > 0 ) {
+    crc = table[( crc ^ *data++ ) & 0xFF] ^ ( crc >> 8 );
+  }
+  return ~crc;
+}
+
+template<typename F>
+static void run( const char* name, const Vector<uint8_t>& data, size_t block, size_t rounds, F f )
+{
+  uint32_t crc = 0;
+  bench::Stopwatch timer;
+  for( size_t r = 0; r < rounds; r++ ) {
+    for( size_t off = 0; off + block <= data.size(); off += block ) {
+      crc ^= f( data.array() + off, block );
+    }
+  }
+  const double seconds = timer.seconds();
+  char label[64];
+  snprintf( label, sizeof( label ), "%s %zu", name, block );
+  bench::report( label, seconds, double( rounds ) * double( data.size() / block * block ) );
+  printf( "%-40s %10.2f GB/s\n", "", double( rounds ) * double( data.size() ) / seconds / 1e9 );
+  bench::doNotOptimize( crc );
+}
+
+/**
+ * Checksums a 1MB buffer in blocks of 64 bytes, 4K and 1MB, repeated
+ * until total bytes have been processed, with the old byte at a time
+ * loop, crc32() and crc32c().
+ *
+ *   CrcBench [total]
+ */
+int main( int argc, char** argv )
+{
+  const size_t total = bench::sizeArg( argc, argv, 1, size_t( 1 ) << 30 );
+  const size_t size = 1 << 20;
+  Vector<uint8_t> data;
+  data.setCapacity( size );
+  uint32_t seed = 7;
+  for( size_t i = 0; i < size; i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    data.add( uint8_t( seed >> 24 ) );
+  }
+  const size_t rounds = MAX( total / size, size_t( 1 ) );
+
+  static const size_t blocks[] = { 64, 4096, 1 << 20 };
+  run( "bytewise crc32", data, 1 << 20, MAX( rounds / 8, size_t( 1 ) ), bytewise_crc32 );
+  for( int b = 0; b < 3; b++ ) {
+    run( "crc32", data, blocks[b], rounds, []( const uint8_t * p, size_t len ) {
+      return crc32( 0, p, len );
+    } );
+    run( "crc32c", data, blocks[b], rounds, []( const uint8_t * p, size_t len ) {
+      return crc32c( 0, p, len );
+    } );
+  }
+  return 0;
+}
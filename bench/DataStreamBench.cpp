@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/DataStreams.h>
+#include <baseline/SharedBuffer.h>
+#include <baseline/Streams.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+struct Record {
+  uint32_t id;
+  int64_t delta;
+  double value;
+  uint16_t flags;
+  String8 name;
+};
+
+/**
+ * A field at a time through the virtual write(), fixed width, the way
+ * records were written before DataOutputStream.
+ */
+static BENCH_NOINLINE void handRolledWrite( OutputStream& out, const Record& r )
+{
+  uint32_t nameLen = r.name.length();
+  out.write( ( uint8_t* )&r.id, 0, sizeof( r.id ) );
+  out.write( ( uint8_t* )&r.delta, 0, sizeof( r.delta ) );
+  out.write( ( uint8_t* )&r.value, 0, sizeof( r.value ) );
+  out.write( ( uint8_t* )&r.flags, 0, sizeof( r.flags ) );
+  out.write( ( uint8_t* )&nameLen, 0, sizeof( nameLen ) );
+  out.write( ( uint8_t* )r.name.string(), 0, nameLen );
+}
+
+static BENCH_NOINLINE bool handRolledRead( InputStream& in, Record& r )
+{
+  uint32_t nameLen;
+  char name[256];
+  if( in.read( ( uint8_t* )&r.id, 0, sizeof( r.id ) ) != sizeof( r.id ) ||
+      in.read( ( uint8_t* )&r.delta, 0, sizeof( r.delta ) ) != sizeof( r.delta ) ||
+      in.read( ( uint8_t* )&r.value, 0, sizeof( r.value ) ) != sizeof( r.value ) ||
+      in.read( ( uint8_t* )&r.flags, 0, sizeof( r.flags ) ) != sizeof( r.flags ) ||
+      in.read( ( uint8_t* )&nameLen, 0, sizeof( nameLen ) ) != sizeof( nameLen ) ||
+      nameLen > sizeof( name ) || in.read( ( uint8_t* )name, 0, nameLen ) != int( nameLen ) ) {
+    return false;
+  }
+  r.name.setTo( name, nameLen );
+  return true;
+}
+
+static BENCH_NOINLINE void dataWrite( DataOutputStream& out, const Record& r )
+{
+  out.writeVarint( r.id );
+  out.writeZigzag( r.delta );
+  out.writeLE( r.value );
+  out.writeLE( r.flags );
+  out.writeString( r.name );
+}
+
+static BENCH_NOINLINE bool dataRead( DataInputStream& in, Record& r )
+{
+  uint64_t id;
+  if( in.readVarint( &id ) != OK || in.readZigzag( &r.delta ) != OK || in.readLE( &r.value ) != OK ||
+      in.readLE( &r.flags ) != OK || in.readString( &r.name ) != OK ) {
+    return false;
+  }
+  r.id = uint32_t( id );
+  return true;
+}
+
+//! a copy of what out holds, since closing it frees the buffer
+static SharedBuffer* take( ByteArrayOutputStream& out )
+{
+  SharedBuffer* buf = SharedBuffer::alloc( out.size() );
+  memcpy( buf->data(), out.toSharedBuffer(), out.size() );
+  out.close();
+  return buf;
+}
+
+/**
+ * Serializes and parses a stream of small records field by field through
+ * the virtual stream calls, and with DataOutputStream/DataInputStream
+ * (varints and zigzag where the hand-rolled format is fixed width).
+ * Reports records/s and the encoded size.
+ *
+ *   DataStreamBench [records]
+ */
+int main( int argc, char** argv )
+{
+  const size_t count = bench::sizeArg( argc, argv, 1, 2000000 );
+  static const char* names[] = { "sensor", "a", "pressure-inlet", "temperature.core.7" };
+  Record r;
+  r.value = 0;
+
+  bench::Stopwatch timer;
+  ByteArrayOutputStream handOut( count * 32 );
+  for( size_t i = 0; i < count; i++ ) {
+    r.id = uint32_t( i );
+    r.delta = int64_t( i % 1000 ) - 500;
+    r.value += 0.25;
+    r.flags = uint16_t( i & 7 );
+    r.name.setTo( names[i & 3] );
+    handRolledWrite( handOut, r );
+  }
+  double seconds = timer.seconds();
+  printf( "%-40s %10.3f ms %10.2f Mrecords/s %8zu bytes/record\n", "hand-rolled write", seconds * 1e3,
+          count / seconds / 1e6, handOut.size() / count );
+  SharedBuffer* handBuf = take( handOut );
+
+  timer.reset();
+  ByteArrayOutputStream dataSink( count * 32 );
+  {
+    DataOutputStream out( dataSink );
+    r.value = 0;
+    for( size_t i = 0; i < count; i++ ) {
+      r.id = uint32_t( i );
+      r.delta = int64_t( i % 1000 ) - 500;
+      r.value += 0.25;
+      r.flags = uint16_t( i & 7 );
+      r.name.setTo( names[i & 3] );
+      dataWrite( out, r );
+    }
+    out.flush();
+  }
+  seconds = timer.seconds();
+  printf( "%-40s %10.3f ms %10.2f Mrecords/s %8zu bytes/record\n", "DataOutputStream", seconds * 1e3,
+          count / seconds / 1e6, dataSink.size() / count );
+  SharedBuffer* dataBuf = take( dataSink );
+
+  size_t check = 0;
+  timer.reset();
+  {
+    ByteArrayInputStream in( handBuf, 0, handBuf->size() );
+    while( handRolledRead( in, r ) ) {
+      check += r.id + r.name.length();
+    }
+    in.close();
+  }
+  seconds = timer.seconds();
+  printf( "%-40s %10.3f ms %10.2f Mrecords/s\n", "hand-rolled read", seconds * 1e3, count / seconds / 1e6 );
+
+  timer.reset();
+  {
+    ByteArrayInputStream raw( dataBuf, 0, dataBuf->size() );
+    DataInputStream in( raw );
+    while( dataRead( in, r ) ) {
+      check -= r.id + r.name.length();
+    }
+    in.close();
+  }
+  seconds = timer.seconds();
+  printf( "%-40s %10.3f ms %10.2f Mrecords/s\n", "DataInputStream", seconds * 1e3, count / seconds / 1e6 );
+
+  handBuf->release();
+  dataBuf->release();
+  if( check != 0 ) {
+    fprintf( stderr, "records differ\n" );
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/FastHash.h>
+#include <baseline/Hash.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * The old hash_type<String8>: FNV-1a, one multiply per byte.
+ */
+static uint64_t fnv1a( const uint8_t* p, size_t len, uint64_t seed )
+{
+  uint32_t hash = 2166136261u ^ uint32_t( seed );
+  while( len-- > 0 ) {
+    hash = ( hash ^ *p++ ) * 16777619u;
+  }
+  return hash;
+}
+
+static uint64_t crc( const uint8_t* p, size_t len, uint64_t seed )
+{
+  return crc32c( uint32_t( seed ), p, len );
+}
+
+static uint64_t fast( const uint8_t* p, size_t len, uint64_t seed )
+{
+  return hash64( p, len, seed );
+}
+
+/**
+ * Hashes count keys of len bytes, each seeded with the previous result so
+ * that the time is the latency of one hash rather than the throughput of
+ * several in flight.
+ */
+template<typename F>
+static void latency( const char* name, const Vector<uint8_t>& data, size_t len, size_t count, F f )
+{
+  const size_t keys = data.size() / len;
+  uint64_t h = 0;
+  bench::Stopwatch timer;
+  for( size_t i = 0; i < count; i++ ) {
+    h = f( data.array() + ( i % keys ) * len, len, h );
+  }
+  const double seconds = timer.seconds();
+  printf( "%-12s %3zu byte keys %10.2f ns/hash\n", name, len, seconds * 1e9 / double( count ) );
+  bench::doNotOptimize( h );
+}
+
+template<typename F>
+static void throughput( const char* name, const Vector<uint8_t>& data, size_t rounds, F f )
+{
+  uint64_t h = 0;
+  bench::Stopwatch timer;
+  for( size_t r = 0; r < rounds; r++ ) {
+    h ^= f( data.array(), data.size() );
+  }
+  const double seconds = timer.seconds();
+  bench::report( name, seconds, double( rounds ) * double( data.size() ) );
+  printf( "%-40s %10.2f GB/s\n", "", double( rounds ) * double( data.size() ) / seconds / 1e9 );
+  bench::doNotOptimize( h );
+}
+
+/**
+ * Small key latency of hash64() against FNV-1a and crc32c, then the
+ * throughput of hash64(), createHash64() fed 4K at a time, crc32c() and
+ * SHA1 over a 1MB buffer.
+ *
+ *   FastHashBench [total]
+ */
+int main( int argc, char** argv )
+{
+  const size_t total = bench::sizeArg( argc, argv, 1, size_t( 1 ) << 30 );
+  const size_t size = 1 << 20;
+  Vector<uint8_t> data;
+  data.setCapacity( size );
+  uint32_t seed = 7;
+  for( size_t i = 0; i < size; i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    data.add( uint8_t( seed >> 24 ) );
+  }
+
+  static const size_t lengths[] = { 8, 16, 32, 64 };
+  const size_t count = 10000000;
+  for( int i = 0; i < 4; i++ ) {
+    latency( "fnv1a", data, lengths[i], count, fnv1a );
+    latency( "crc32c", data, lengths[i], count, crc );
+    latency( "hash64", data, lengths[i], count, fast );
+  }
+
+  const size_t rounds = MAX( total / size, size_t( 1 ) );
+  throughput( "hash64 1M", data, rounds, []( const uint8_t * p, size_t len ) {
+    return hash64( p, len );
+  } );
+  up<HashFunction> stream = createHash64();
+  throughput( "createHash64 4K updates", data, rounds, [&stream]( const uint8_t * p, size_t len ) {
+    stream->reset();
+    for( size_t off = 0; off < len; off += 4096 ) {
+      stream->update( const_cast<uint8_t*>( p ) + off, MIN( size_t( 4096 ), len - off ) );
+    }
+    return uint64_t( stream->finalize().toHexString().length() );
+  } );
+  throughput( "crc32c 1M", data, rounds, []( const uint8_t * p, size_t len ) {
+    return uint64_t( crc32c( 0, p, len ) );
+  } );
+  up<HashFunction> sha1 = createSHA1();
+  throughput( "sha1 1M", data, MAX( rounds / 8, size_t( 1 ) ), [&sha1]( const uint8_t * p, size_t len ) {
+    sha1->reset();
+    sha1->update( const_cast<uint8_t*>( p ), len );
+    return uint64_t( sha1->finalize().toHexString().length() );
+  } );
+  return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Comparable.h>
+#include <baseline/Hash.h>
+#include <baseline/SharedBuffer.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * The old HashCode: the digest in a SharedBuffer, compared through
+ * Comparable's virtual compare().
+ */
+class HeapHashCode : public Comparable<HeapHashCode>
+{
+public:
+  HeapHashCode( const void* buf, size_t len ) {
+    mBuffer = SharedBuffer::alloc( len );
+    memcpy( mBuffer->data(), buf, len );
+  }
+  HeapHashCode( const HeapHashCode& rhs )
+    : mBuffer( rhs.mBuffer ) {
+    mBuffer->acquire();
+  }
+  ~HeapHashCode() {
+    mBuffer->release();
+  }
+
+  BENCH_NOINLINE int compare( const HeapHashCode& rhs ) const override {
+    int retval = mBuffer->size() - rhs.mBuffer->size();
+    if( retval == 0 ) {
+      retval = memcmp( mBuffer->data(), rhs.mBuffer->data(), mBuffer->size() );
+    }
+    return retval;
+  }
+
+private:
+  SharedBuffer* mBuffer;
+};
+
+template<typename F>
+static void run( const char* name, size_t records, F f )
+{
+  bench::Stopwatch timer;
+  const size_t matches = f();
+  const double seconds = timer.seconds();
+  printf( "%-40s %10.2f ns/record\n", name, seconds * 1e9 / double( records ) );
+  bench::doNotOptimize( matches );
+}
+
+/**
+ * Hashes records of 32 bytes with CRC32C and compares each digest with
+ * a known one, the inner loop of block dedup: with the old heap
+ * HashCode, with finalize() and with finalizeInto().
+ *
+ *   HashCodeBench [records]
+ */
+int main( int argc, char** argv )
+{
+  const size_t records = bench::sizeArg( argc, argv, 1, 10000000 );
+  const size_t recordSize = 32;
+  Vector<uint8_t> data;
+  data.insertAt( uint8_t( 0 ), 0, 4096 * recordSize );
+  for( size_t i = 0; i < data.size(); i++ ) {
+    data.editItemAt( i ) = uint8_t( i % 7 == 0 ? i / recordSize : 0 );
+  }
+  uint8_t* p = data.editArray();
+  up<HashFunction> hash = createCRC32C();
+
+  // the digest every record is checked against
+  hash->update( p, recordSize );
+  uint8_t target[HashCode::kMaxSize];
+  const size_t targetLen = hash->finalizeInto( target );
+
+  run( "heap HashCode", records, [&]() {
+    const HeapHashCode expected( target, targetLen );
+    uint8_t digest[HashCode::kMaxSize];
+    size_t matches = 0;
+    for( size_t i = 0; i < records; i++ ) {
+      hash->reset();
+      hash->update( p + ( i % 4096 ) * recordSize, recordSize );
+      const size_t len = hash->finalizeInto( digest );
+      matches += HeapHashCode( digest, len ) == expected;
+    }
+    return matches;
+  } );
+
+  run( "inline HashCode, finalize()", records, [&]() {
+    const HashCode expected( target, targetLen );
+    size_t matches = 0;
+    for( size_t i = 0; i < records; i++ ) {
+      hash->reset();
+      hash->update( p + ( i % 4096 ) * recordSize, recordSize );
+      matches += hash->finalize() == expected;
+    }
+    return matches;
+  } );
+
+  run( "finalizeInto()", records, [&]() {
+    uint8_t digest[HashCode::kMaxSize];
+    size_t matches = 0;
+    for( size_t i = 0; i < records; i++ ) {
+      hash->reset();
+      hash->update( p + ( i % 4096 ) * recordSize, recordSize );
+      const size_t len = hash->finalizeInto( digest );
+      matches += len == targetLen && memcmp( digest, target, len ) == 0;
+    }
+    return matches;
+  } );
+  return 0;
+}
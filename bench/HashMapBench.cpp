@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Vector.h>
+#include <baseline/SortedVector.h>
+#include <baseline/HashMap.h>
+#include <baseline/String8.h>
+
+#include <unordered_map>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+struct String8Hash {
+  size_t operator()( const String8& value ) const {
+    return hash_type( value );
+  }
+};
+
+template<typename TKey>
+static void run( const char* name, const Vector<TKey>& keys, const Vector<TKey>& misses )
+{
+  typedef key_value_pair_t<TKey, int> pair_t;
+  const size_t count = keys.size();
+  char label[64];
+  bench::Stopwatch timer;
+  size_t found = 0;
+
+  HashMap<TKey, int> map;
+  timer.reset();
+  for( size_t i = 0; i < count; i++ ) {
+    map.add( keys[i], int( i ) );
+  }
+  snprintf( label, sizeof( label ), "%s HashMap insert", name );
+  bench::report( label, timer.seconds(), 0 );
+  timer.reset();
+  for( size_t i = 0; i < count; i++ ) {
+    found += map.indexOfKey( keys[i] ) >= 0;
+    found += map.indexOfKey( misses[i] ) >= 0;
+  }
+  snprintf( label, sizeof( label ), "%s HashMap lookup", name );
+  bench::report( label, timer.seconds(), 0 );
+
+  // built with one bulk merge, adding one by one is quadratic
+  SortedVector<pair_t> sorted;
+  Vector<pair_t> pairs;
+  timer.reset();
+  pairs.setCapacity( count );
+  for( size_t i = 0; i < count; i++ ) {
+    pairs.push_back( pair_t( keys[i], int( i ) ) );
+  }
+  sorted.merge( pairs );
+  snprintf( label, sizeof( label ), "%s SortedVector build", name );
+  bench::report( label, timer.seconds(), 0 );
+  timer.reset();
+  for( size_t i = 0; i < count; i++ ) {
+    found += sorted.indexOf( pair_t( keys[i] ) ) >= 0;
+    found += sorted.indexOf( pair_t( misses[i] ) ) >= 0;
+  }
+  snprintf( label, sizeof( label ), "%s SortedVector lookup", name );
+  bench::report( label, timer.seconds(), 0 );
+
+  typedef typename std::conditional<std::is_same<TKey, String8>::value, String8Hash, std::hash<TKey>>::type hasher;
+  std::unordered_map<TKey, int, hasher> stdMap;
+  timer.reset();
+  for( size_t i = 0; i < count; i++ ) {
+    stdMap[keys[i]] = int( i );
+  }
+  snprintf( label, sizeof( label ), "%s unordered_map insert", name );
+  bench::report( label, timer.seconds(), 0 );
+  timer.reset();
+  for( size_t i = 0; i < count; i++ ) {
+    found += stdMap.count( keys[i] );
+    found += stdMap.count( misses[i] );
+  }
+  snprintf( label, sizeof( label ), "%s unordered_map lookup", name );
+  bench::report( label, timer.seconds(), 0 );
+
+  bench::doNotOptimize( found );
+}
+
+/**
+ * Inserts count random keys into HashMap, a SortedVector of key/value
+ * pairs and std::unordered_map, then looks up every key plus as many
+ * missing ones. Runs with int64_t and String8 keys.
+ *
+ *   HashMapBench [count]
+ */
+int main( int argc, char** argv )
+{
+  const size_t count = bench::sizeArg( argc, argv, 1, 1000000 );
+
+  Vector<int64_t> ints;
+  Vector<int64_t> intMisses;
+  Vector<String8> strings;
+  Vector<String8> stringMisses;
+  uint64_t seed = 42;
+  for( size_t i = 0; i < count; i++ ) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    // even keys are inserted, odd ones are misses
+    const int64_t key = int64_t( seed >> 20 ) & ~int64_t( 1 );
+    ints.push_back( key );
+    intMisses.push_back( key | 1 );
+    char buf[32];
+    snprintf( buf, sizeof( buf ), "user/%lld", ( long long )key );
+    strings.push_back( String8( buf ) );
+    snprintf( buf, sizeof( buf ), "user/%lld", ( long long )( key | 1 ) );
+    stringMisses.push_back( String8( buf ) );
+  }
+
+  run( "int64", ints, intMisses );
+  run( "String8", strings, stringMisses );
+  return 0;
+}
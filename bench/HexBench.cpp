@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/BaseEncoding.h>
+#include <baseline/SharedBuffer.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * The old HexBaseEncoding::encode: String8::append two characters at a
+ * time.
+ */
+static String8 append_encode( const uint8_t* buf, size_t len )
+{
+  static const char dec2hex[16 + 1] = "0123456789abcdef";
+  String8 string;
+  char strbuf[2];
+  for( size_t i = 0; i < len; i++ ) {
+    strbuf[0] = dec2hex[( buf[i] >> 4 ) & 15];
+    strbuf[1] = dec2hex[buf[i] & 15];
+    string.append( strbuf, 2 );
+  }
+  return string;
+}
+
+/**
+ * Hex encodes and decodes 32 byte digests and a 1MB buffer, reporting
+ * MB/s of binary data.
+ *
+ *   HexBench [total]
+ */
+int main( int argc, char** argv )
+{
+  const size_t total = bench::sizeArg( argc, argv, 1, size_t( 256 ) << 20 );
+  const size_t size = 1 << 20;
+  Vector<uint8_t> data;
+  data.setCapacity( size );
+  uint32_t seed = 7;
+  for( size_t i = 0; i < size; i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    data.add( uint8_t( seed >> 24 ) );
+  }
+  uint8_t* p = data.editArray();
+  BaseEncoding& hex = hexEncoding();
+
+  static const size_t blocks[] = { 32, 1 << 20 };
+  for( int b = 0; b < 2; b++ ) {
+    const size_t block = blocks[b];
+    const size_t rounds = MAX( total / block, size_t( 1 ) );
+    char label[64];
+    size_t length = 0;
+
+    bench::Stopwatch timer;
+    for( size_t r = 0; r < rounds / 16; r++ ) {
+      length += append_encode( p + ( r * block ) % size, block ).length();
+    }
+    snprintf( label, sizeof( label ), "append encode %zu", block );
+    bench::report( label, timer.seconds(), double( rounds / 16 ) * double( block ) );
+
+    timer.reset();
+    for( size_t r = 0; r < rounds; r++ ) {
+      length += hex.encode( p + ( r * block ) % size, block ).length();
+    }
+    snprintf( label, sizeof( label ), "encode %zu", block );
+    bench::report( label, timer.seconds(), double( rounds ) * double( block ) );
+
+    const String8 encoded = hex.encode( p, block );
+    timer.reset();
+    for( size_t r = 0; r < rounds; r++ ) {
+      SharedBuffer* decoded = hex.decode( encoded );
+      length += decoded->size();
+      decoded->release();
+    }
+    snprintf( label, sizeof( label ), "decode %zu", block );
+    bench::report( label, timer.seconds(), double( rounds ) * double( block ) );
+    bench::doNotOptimize( length );
+  }
+  return 0;
+}
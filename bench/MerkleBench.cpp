@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/ExecutorService.h>
+#include <baseline/Hash.h>
+#include <baseline/MerkleTree.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+static up<HashFunction> hash64Factory()
+{
+  return createHash64();
+}
+
+static void run( const char* name, MerkleTree::Factory factory, const Vector<uint8_t>& data )
+{
+  char label[64];
+  {
+    up<HashFunction> h = factory();
+    bench::Stopwatch timer;
+    h->update( const_cast<uint8_t*>( data.array() ), data.size() );
+    bench::doNotOptimize( h->finalize().size() );
+    snprintf( label, sizeof( label ), "%s serial update", name );
+    bench::report( label, timer.seconds(), double( data.size() ) );
+  }
+
+  static const int threads[] = { 0, 1, 2, 4, 8 };
+  for( int t = 0; t < 5; t++ ) {
+    sp<ExecutorService> executor;
+    if( threads[t] > 0 ) {
+      executor = ExecutorService::createExecutorService( String8( "merkle" ), threads[t] );
+    }
+    MerkleTree tree( factory );
+    bench::Stopwatch timer;
+    tree.build( data.array(), data.size(), executor );
+    const double seconds = timer.seconds();
+    snprintf( label, sizeof( label ), "%s tree, %d threads", name, threads[t] );
+    bench::report( label, seconds, double( data.size() ) );
+    if( executor != nullptr ) {
+      executor->shutdown();
+    }
+
+    timer.reset();
+    tree.update( tree.chunkCount() / 2, data.array() + tree.chunkCount() / 2 * tree.chunkSize(), tree.chunkSize() );
+    if( t == 0 ) {
+      snprintf( label, sizeof( label ), "%s re-hash one chunk", name );
+      bench::report( label, timer.seconds(), 0 );
+    }
+  }
+}
+
+/**
+ * Hashes a buffer as a single stream and as a MerkleTree of 1MB chunks
+ * with 0 (calling thread only) to 8 executor threads, then times
+ * re-hashing one changed chunk.
+ *
+ *   MerkleBench [size]
+ */
+int main( int argc, char** argv )
+{
+  const size_t size = bench::sizeArg( argc, argv, 1, size_t( 256 ) << 20 );
+  Vector<uint8_t> data;
+  data.setCapacity( size );
+  uint32_t seed = 7;
+  for( size_t i = 0; i < size; i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    data.add( uint8_t( seed >> 24 ) );
+  }
+
+  run( "sha256", createSHA256, data );
+  run( "hash64", hash64Factory, data );
+  return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/RefBase.h>
+#include <baseline/String8.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+struct Item : public RefBase {
+  int mValue;
+};
+
+static Vector<String8> makeStrings( size_t count )
+{
+  Vector<String8> vector;
+  for( size_t i = 0; i < count; i++ ) {
+    vector.push_back( String8::format( "key-%zu", i ) );
+  }
+  return vector;
+}
+
+/**
+ * Push temporaries into Vector<String8> and Vector<sp<T>>, grow them by
+ * inserting at the front, and pass them around by value.
+ *
+ *   MoveBench [count]
+ */
+int main( int argc, char** argv )
+{
+  const size_t count = bench::sizeArg( argc, argv, 1, 1000000 );
+  bench::Stopwatch timer;
+
+  timer.reset();
+  Vector<String8> strings = makeStrings( count );
+  printf( "%-40s %10.3f ms\n", "Vector<String8> push_back(temp)", timer.seconds() * 1e3 );
+
+  timer.reset();
+  for( int i = 0; i < 1000; i++ ) {
+    strings.insertAt( String8( "front" ), 0 );
+  }
+  printf( "%-40s %10.3f ms\n", "Vector<String8> insertAt(0) x1000", timer.seconds() * 1e3 );
+
+  timer.reset();
+  Vector<sp<Item>> items;
+  for( size_t i = 0; i < count; i++ ) {
+    items.push_back( sp<Item>( new Item ) );
+  }
+  printf( "%-40s %10.3f ms\n", "Vector<sp<T>> push_back(temp)", timer.seconds() * 1e3 );
+
+  timer.reset();
+  for( int i = 0; i < 1000; i++ ) {
+    items.insertAt( items[i], 0 );
+  }
+  printf( "%-40s %10.3f ms\n", "Vector<sp<T>> insertAt(0) x1000", timer.seconds() * 1e3 );
+
+  timer.reset();
+  for( int i = 0; i < 1000; i++ ) {
+    Vector<sp<Item>> moved( std::move( items ) );
+    items = std::move( moved );
+  }
+  printf( "%-40s %10.3f ms\n", "Vector<sp<T>> move x1000", timer.seconds() * 1e3 );
+
+  bench::doNotOptimize( strings.size() + items.size() );
+  return 0;
+}
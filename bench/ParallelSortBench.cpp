@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Vector.h>
+#include <baseline/SortedVector.h>
+#include <baseline/ExecutorService.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+static void fill( Vector<int64_t>& vector, size_t count, uint32_t seed )
+{
+  vector.clear();
+  vector.setCapacity( count );
+  for( size_t i = 0; i < count; i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    vector.push_back( int64_t( seed ) << 16 | int64_t( i & 0xffff ) );
+  }
+}
+
+/**
+ * Sorts a random Vector<int64_t>, then merges two SortedVector<int64_t>
+ * of count items each, with the merge of a SortedVector and of an
+ * unsorted Vector, on 1, 4 and 16 threads. 1 thread is the serial path.
+ *
+ *   ParallelSortBench [count]
+ */
+int main( int argc, char** argv )
+{
+  const size_t count = bench::sizeArg( argc, argv, 1, 4000000 );
+  static const int threads[] = { 1, 4, 16 };
+
+  for( int t = 0; t < 3; t++ ) {
+    sp<ExecutorService> executor;
+    if( threads[t] > 1 ) {
+      executor = ExecutorService::createExecutorService( String8( "bench" ), threads[t] );
+    }
+    char name[64];
+    bench::Stopwatch timer;
+
+    Vector<int64_t> vector;
+    fill( vector, count, 12345 );
+    timer.reset();
+    vector.sort( []( const int64_t & lhs, const int64_t & rhs ) {
+      return ( lhs > rhs ) - ( lhs < rhs );
+    }, executor );
+    snprintf( name, sizeof( name ), "sort %d threads", threads[t] );
+    bench::report( name, timer.seconds(), double( count * sizeof( int64_t ) ) );
+
+    Vector<int64_t> other;
+    fill( other, count, 54321 );
+    SortedVector<int64_t> lhs;
+    SortedVector<int64_t> rhs;
+    lhs.merge( vector );
+    rhs.merge( other );
+
+    timer.reset();
+    lhs.merge( rhs, executor );
+    snprintf( name, sizeof( name ), "merge sorted %d threads", threads[t] );
+    bench::report( name, timer.seconds(), double( lhs.size() * sizeof( int64_t ) ) );
+
+    SortedVector<int64_t> target;
+    target.merge( vector );
+    timer.reset();
+    target.merge( other, executor );
+    snprintf( name, sizeof( name ), "merge unsorted %d threads", threads[t] );
+    bench::report( name, timer.seconds(), double( target.size() * sizeof( int64_t ) ) );
+
+    bench::doNotOptimize( lhs[count / 2] );
+    bench::doNotOptimize( target[count / 2] );
+    if( executor != nullptr ) {
+      executor->shutdown();
+    }
+  }
+  return 0;
+}
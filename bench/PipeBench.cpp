@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Streams.h>
+#include <baseline/SharedBuffer.h>
+#include <baseline/Thread.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+static const size_t kBlock = 64 * 1024;
+
+class Producer : public Thread
+{
+public:
+  Producer( OutputStream& out, size_t total ) : mOut( out ), mTotal( total ) {}
+
+  void run() {
+    produce( mOut, mTotal );
+    mOut.close();
+  }
+
+  static void produce( OutputStream& out, size_t total ) {
+    static uint8_t block[kBlock];
+    for( size_t i = 0; i < kBlock; i++ ) {
+      block[i] = uint8_t( i * 13 );
+    }
+    for( size_t sent = 0; sent < total; sent += kBlock ) {
+      out.write( block, 0, MIN( kBlock, total - sent ) );
+    }
+  }
+
+private:
+  OutputStream& mOut;
+  size_t mTotal;
+};
+
+static uint64_t consume( InputStream& in )
+{
+  static uint8_t buf[kBlock];
+  uint64_t sum = 0;
+  int n;
+  while( ( n = in.read( buf, 0, kBlock ) ) > 0 ) {
+    sum += buf[0] + buf[n - 1] + n;
+  }
+  return sum;
+}
+
+/**
+ * Streams total bytes from a producer to a consumer, first through a
+ * 1MB pipe with the producer on its own thread, then the old way: into a
+ * ByteArrayOutputStream and back out through a ByteArrayInputStream.
+ * Peak RSS is printed after each, the pipe first so that its number is
+ * not hidden by the buffered payload.
+ *
+ *   PipeBench [total]
+ */
+int main( int argc, char** argv )
+{
+  const size_t total = bench::sizeArg( argc, argv, 1, size_t( 1 ) << 30 );
+  bench::Stopwatch timer;
+
+  {
+    UniquePtr<OutputStream> out;
+    UniquePtr<InputStream> in;
+    createPipe( 1 << 20, out, in );
+    sp<Producer> producer( new Producer( *out, total ) );
+    timer.reset();
+    producer->start();
+    const uint64_t sum = consume( *in );
+    producer->join();
+    in->close();
+    bench::report( "pipe", timer.seconds(), double( total ) );
+    printf( "%-40s %10ld KB peak RSS\n", "", bench::peakRSSKB() );
+    bench::doNotOptimize( sum );
+  }
+
+  {
+    timer.reset();
+    ByteArrayOutputStream out( kBlock );
+    Producer::produce( out, total );
+    SharedBuffer* buffer = SharedBuffer::bufferFromData( out.toSharedBuffer() );
+    ByteArrayInputStream in( buffer, 0, out.size() );
+    const uint64_t sum = consume( in );
+    in.close();
+    out.close();
+    bench::report( "byte array round trip", timer.seconds(), double( total ) );
+    printf( "%-40s %10ld KB peak RSS\n", "", bench::peakRSSKB() );
+    bench::doNotOptimize( sum );
+  }
+  return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/CircleBuffer.h>
+#include <baseline/MirroredByteRing.h>
+
+#include <string.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+static const size_t kRingSize = 64 * 1024;
+static const size_t kChunk = 3000;
+
+/**
+ * The old CircleBuffer transfer: element by element and only up to the
+ * end of the storage, so callers loop.
+ */
+class ElementRing
+{
+public:
+  ElementRing( uint32_t capacity )
+    : mCapacity( capacity ), mSize( 0 ), mHead( 0 ), mTail( 0 ), mData( new uint8_t[capacity] ) {}
+  ~ElementRing() {
+    delete[] mData;
+  }
+
+  uint32_t write( const uint8_t* buf, uint32_t size ) {
+    uint32_t len = MIN( size, mCapacity - mSize );
+    len = MIN( len, mCapacity - mHead );
+    for( uint32_t i = 0; i < len; i++ ) {
+      mData[mHead + i] = buf[i];
+    }
+    mHead = ( mHead + len ) % mCapacity;
+    mSize += len;
+    return len;
+  }
+
+  uint32_t read( uint8_t* buf, uint32_t size ) {
+    uint32_t len = MIN( size, mSize );
+    len = MIN( len, mCapacity - mTail );
+    for( uint32_t i = 0; i < len; i++ ) {
+      buf[i] = mData[mTail + i];
+    }
+    mTail = ( mTail + len ) % mCapacity;
+    mSize -= len;
+    return len;
+  }
+
+private:
+  uint32_t mCapacity;
+  uint32_t mSize;
+  uint32_t mHead;
+  uint32_t mTail;
+  uint8_t* mData;
+};
+
+BENCH_NOINLINE static uint64_t checksum( const uint8_t* buf, size_t len )
+{
+  uint64_t sum = 0;
+  size_t i = 0;
+  for( ; i + 8 <= len; i += 8 ) {
+    uint64_t word;
+    memcpy( &word, buf + i, 8 );
+    sum += word;
+  }
+  for( ; i < len; i++ ) {
+    sum += buf[i];
+  }
+  return sum;
+}
+
+template<typename RING>
+static void copyThrough( const char* name, RING& ring, size_t total, const uint8_t* chunk )
+{
+  uint8_t out[kChunk];
+  uint64_t sum = 0;
+  bench::Stopwatch timer;
+  for( size_t moved = 0; moved < total; moved += kChunk ) {
+    size_t done = 0;
+    while( done < kChunk ) {
+      done += ring.write( chunk + done, uint32_t( kChunk - done ) );
+    }
+    done = 0;
+    while( done < kChunk ) {
+      done += ring.read( out + done, uint32_t( kChunk - done ) );
+    }
+    sum += checksum( out, kChunk );
+  }
+  bench::report( name, timer.seconds(), double( total ) );
+  bench::doNotOptimize( sum );
+}
+
+static void parseInPlace( const char* name, MirroredByteRing& ring, size_t total, const uint8_t* chunk )
+{
+  uint64_t sum = 0;
+  bench::Stopwatch timer;
+  for( size_t moved = 0; moved < total; moved += kChunk ) {
+    memcpy( ring.writePtr(), chunk, kChunk );
+    ring.commit( kChunk );
+    sum += checksum( ring.readPtr(), kChunk );
+    ring.consume( kChunk );
+  }
+  bench::report( name, timer.seconds(), double( total ) );
+  bench::doNotOptimize( sum );
+}
+
+/**
+ * Streams total bytes through a ring in 3000 byte records, which do not
+ * divide the 64K ring so records regularly wrap around the end. Every
+ * record is checksummed by the reader; the in place variant checksums
+ * readPtr() directly instead of copying the record out.
+ *
+ *   RingBench [total]
+ */
+int main( int argc, char** argv )
+{
+  const size_t total = bench::sizeArg( argc, argv, 1, size_t( 1 ) << 30 );
+
+  uint8_t chunk[kChunk];
+  for( size_t i = 0; i < kChunk; i++ ) {
+    chunk[i] = uint8_t( i * 31 );
+  }
+
+  ElementRing element( kRingSize );
+  copyThrough( "element copy ring", element, total, chunk );
+
+  CircleBuffer<uint8_t> circle( kRingSize );
+  copyThrough( "circle buffer", circle, total, chunk );
+
+  MirroredByteRing mirrored( kRingSize );
+  if( mirrored.initCheck() != OK ) {
+    printf( "could not map mirrored ring\n" );
+    return 1;
+  }
+  copyThrough( "mirrored ring", mirrored, total, chunk );
+  parseInPlace( "mirrored ring in place", mirrored, total, chunk );
+  return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/CircleBuffer.h>
+#include <baseline/SPSCRing.h>
+#include <baseline/Mutex.h>
+#include <baseline/Thread.h>
+
+#if defined(__linux__)
+  #include <pthread.h>
+  #include <sched.h>
+  #include <unistd.h>
+#endif
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * Pins the calling thread to core % online cores, where supported.
+ */
+static void pin( int core )
+{
+#if defined(__linux__)
+  const long cores = sysconf( _SC_NPROCESSORS_ONLN );
+  cpu_set_t set;
+  CPU_ZERO( &set );
+  CPU_SET( core % ( cores > 0 ? cores : 1 ), &set );
+  pthread_setaffinity_np( pthread_self(), sizeof( set ), &set );
+#else
+  (void)core;
+#endif
+}
+
+/**
+ * CircleBuffer guarded by a Mutex, the way it is shared between threads
+ * without SPSCRing.
+ */
+class LockedBuffer
+{
+public:
+  LockedBuffer( uint32_t capacity ) : mBuffer( capacity ) {}
+
+  uint32_t write( const uint64_t* buf, uint32_t size ) {
+    Mutex::Autolock lock( mMutex );
+    return mBuffer.write( buf, size );
+  }
+
+  uint32_t read( uint64_t* buf, uint32_t size ) {
+    Mutex::Autolock lock( mMutex );
+    return mBuffer.read( buf, size );
+  }
+
+private:
+  Mutex mMutex;
+  CircleBuffer<uint64_t> mBuffer;
+};
+
+template<typename RING>
+class Producer : public Thread
+{
+public:
+  Producer( RING& ring, uint64_t count, uint32_t batch )
+    : mRing( ring ), mCount( count ), mBatch( batch ) {}
+
+  void run() {
+    pin( 1 );
+    uint64_t buf[64];
+    uint64_t next = 0;
+    while( next < mCount ) {
+      const uint32_t n = uint32_t( MIN( uint64_t( mBatch ), mCount - next ) );
+      for( uint32_t i = 0; i < n; i++ ) {
+        buf[i] = next + i;
+      }
+      uint32_t done = 0;
+      while( done < n ) {
+        const uint32_t written = mRing.write( buf + done, n - done );
+        if( !written ) {
+          Thread::yield();
+        }
+        done += written;
+      }
+      next += n;
+    }
+  }
+
+private:
+  RING& mRing;
+  uint64_t mCount;
+  uint32_t mBatch;
+};
+
+template<typename RING>
+static void run( const char* label, uint64_t count, uint32_t batch )
+{
+  RING ring( 1024 );
+  sp<Producer<RING> > producer( new Producer<RING>( ring, count, batch ) );
+
+  bench::Stopwatch timer;
+  producer->start();
+
+  uint64_t buf[64];
+  uint64_t received = 0;
+  uint64_t sum = 0;
+  while( received < count ) {
+    const uint32_t n = ring.read( buf, batch );
+    if( !n ) {
+      Thread::yield();
+    }
+    for( uint32_t i = 0; i < n; i++ ) {
+      sum += buf[i];
+    }
+    received += n;
+  }
+  producer->join();
+  const double seconds = timer.seconds();
+
+  char name[64];
+  snprintf( name, sizeof( name ), "%s batch %u", label, batch );
+  bench::report( name, seconds, double( count * sizeof( uint64_t ) ) );
+  printf( "%-40s %10.2f M msgs/s\n", "", double( count ) / seconds / 1e6 );
+  bench::doNotOptimize( sum );
+}
+
+/**
+ * Passes count uint64_t messages from a producer thread to the main
+ * thread through SPSCRing and through a Mutex guarded CircleBuffer,
+ * one at a time and in batches. Producer and consumer are pinned to
+ * cores 1 and 0 (modulo the number of online cores).
+ *
+ *   SPSCRingBench [count]
+ */
+int main( int argc, char** argv )
+{
+  const uint64_t count = bench::sizeArg( argc, argv, 1, 20000000 );
+  static const uint32_t batches[] = { 1, 16, 64 };
+
+  pin( 0 );
+  for( int b = 0; b < 3; b++ ) {
+    run<SPSCRing<uint64_t> >( "spsc ring", count, batches[b] );
+    run<LockedBuffer>( "mutex circle buffer", count, batches[b] );
+  }
+  return 0;
+}
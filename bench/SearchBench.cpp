@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Vector.h>
+#include <baseline/SortedVector.h>
+#include <baseline/Search.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * The lookups SortedVector did before it searched the typed array itself:
+ * a binary search through SortedVectorImpl calling do_compare().
+ */
+template<typename TYPE>
+class ErasedSortedVector : public SortedVectorImpl
+{
+public:
+  ErasedSortedVector( const SortedVector<TYPE>& items )
+    : SortedVectorImpl( sizeof( TYPE ), HAS_TRIVIAL_CTOR | HAS_TRIVIAL_DTOR | HAS_TRIVIAL_COPY | HAS_TRIVIAL_MOVE ) {
+    merge( reinterpret_cast<const SortedVectorImpl&>( items ) );
+  }
+  virtual ~ErasedSortedVector() {
+    finish_vector();
+  }
+
+protected:
+  virtual void do_construct( void*, size_t ) const {}
+  virtual void do_destroy( void*, size_t ) const {}
+  virtual void do_copy( void* dest, const void* from, size_t num ) const {
+    memcpy( dest, from, num * sizeof( TYPE ) );
+  }
+  virtual void do_splat( void* dest, const void* item, size_t num ) const {
+    splat_type( static_cast<TYPE*>( dest ), static_cast<const TYPE*>( item ), num );
+  }
+  virtual void do_move_forward( void* dest, const void* from, size_t num ) const {
+    memmove( dest, from, num * sizeof( TYPE ) );
+  }
+  virtual void do_move_backward( void* dest, const void* from, size_t num ) const {
+    memmove( dest, from, num * sizeof( TYPE ) );
+  }
+  virtual int do_compare( const void* lhs, const void* rhs ) const {
+    return compare_type( *static_cast<const TYPE*>( lhs ), *static_cast<const TYPE*>( rhs ) );
+  }
+};
+
+static void runScans( size_t count, size_t rounds )
+{
+  char label[64];
+  bench::Stopwatch timer;
+  Vector<int32_t> vector;
+  for( size_t i = 0; i < count; i++ ) {
+    vector.add( int32_t( ( i * 2654435761u ) >> 4 ) );
+  }
+  const int32_t* a = vector.array();
+  const int32_t missing = -1;
+  size_t sum = 0;
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    sum += find_type<int32_t>( a, count, missing );
+  }
+  snprintf( label, sizeof( label ), "%zu int32 find generic", count );
+  bench::report( label, timer.seconds(), double( count ) * rounds * sizeof( int32_t ) );
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    sum += vector.indexOf( missing );
+  }
+  snprintf( label, sizeof( label ), "%zu int32 find", count );
+  bench::report( label, timer.seconds(), double( count ) * rounds * sizeof( int32_t ) );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    sum += count_type<int32_t>( a, count, missing );
+  }
+  snprintf( label, sizeof( label ), "%zu int32 count generic", count );
+  bench::report( label, timer.seconds(), double( count ) * rounds * sizeof( int32_t ) );
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    sum += count_type( a, count, missing );
+  }
+  snprintf( label, sizeof( label ), "%zu int32 count", count );
+  bench::report( label, timer.seconds(), double( count ) * rounds * sizeof( int32_t ) );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    sum += min_type<int32_t>( a, count ) + max_type<int32_t>( a, count );
+  }
+  snprintf( label, sizeof( label ), "%zu int32 min+max generic", count );
+  bench::report( label, timer.seconds(), double( count ) * rounds * sizeof( int32_t ) );
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    sum += min_type( a, count ) + max_type( a, count );
+  }
+  snprintf( label, sizeof( label ), "%zu int32 min+max", count );
+  bench::report( label, timer.seconds(), double( count ) * rounds * sizeof( int32_t ) );
+
+  bench::doNotOptimize( sum );
+}
+
+static void runLookups( size_t count, size_t lookups )
+{
+  char label[64];
+  bench::Stopwatch timer;
+  SortedVector<uint64_t> sorted;
+  Vector<uint64_t> values;
+  uint64_t seed = 42;
+  for( size_t i = 0; i < count; i++ ) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    values.add( seed );
+  }
+  sorted.merge( values );
+  ErasedSortedVector<uint64_t> erased( sorted );
+  size_t sum = 0;
+
+  timer.reset();
+  for( size_t i = 0; i < lookups; i++ ) {
+    sum += erased.orderOf( &values[i % count] );
+  }
+  snprintf( label, sizeof( label ), "%zu uint64 orderOf do_compare", count );
+  bench::report( label, timer.seconds(), 0 );
+  timer.reset();
+  for( size_t i = 0; i < lookups; i++ ) {
+    sum += lower_bound_type<uint64_t>( sorted.array(), count, values[i % count] );
+  }
+  snprintf( label, sizeof( label ), "%zu uint64 orderOf generic", count );
+  bench::report( label, timer.seconds(), 0 );
+  timer.reset();
+  for( size_t i = 0; i < lookups; i++ ) {
+    sum += sorted.orderOf( values[i % count] );
+  }
+  snprintf( label, sizeof( label ), "%zu uint64 orderOf", count );
+  bench::report( label, timer.seconds(), 0 );
+
+  bench::doNotOptimize( sum );
+}
+
+/**
+ * Compares the search kernels with the generic versions: scans of a
+ * Vector<int32_t>, and lookups in a SortedVector<uint64_t> against the
+ * do_compare() binary search it used before.
+ *
+ *   SearchBench [count]
+ */
+int main( int argc, char** argv )
+{
+  const size_t count = bench::sizeArg( argc, argv, 1, 1000000 );
+
+  runScans( 1000, 100000 );
+  runScans( count, MAX( size_t( 1 ), 100000000 / count ) );
+  runLookups( 1000, 1000000 );
+  runLookups( count, 1000000 );
+  return 0;
+}
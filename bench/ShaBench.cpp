@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Hash.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+static void run( const char* name, HashFunction& hash, Vector<uint8_t>& data, size_t chunk, size_t total )
+{
+  bench::Stopwatch timer;
+  size_t hashed = 0;
+  while( hashed < total ) {
+    hash.reset();
+    for( size_t off = 0; off < data.size(); off += chunk ) {
+      hash.update( data.editArray() + off, MIN( chunk, data.size() - off ) );
+    }
+    HashCode code = hash.finalize();
+    bench::doNotOptimize( code );
+    hashed += data.size();
+  }
+  char label[64];
+  snprintf( label, sizeof( label ), "%s chunk %zu", name, chunk );
+  bench::report( label, timer.seconds(), double( hashed ) );
+}
+
+/**
+ * Hashes a 1MB buffer with SHA1 and SHA256, fed in 1000 byte and 64K
+ * pieces, until total bytes have been hashed. The SHA extensions are
+ * used when the CPU has them.
+ *
+ *   ShaBench [total]
+ */
+int main( int argc, char** argv )
+{
+  const size_t total = bench::sizeArg( argc, argv, 1, size_t( 256 ) << 20 );
+  Vector<uint8_t> data;
+  data.setCapacity( 1 << 20 );
+  uint32_t seed = 3;
+  for( size_t i = 0; i < ( 1 << 20 ); i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    data.add( uint8_t( seed >> 24 ) );
+  }
+
+  up<HashFunction> sha1 = createSHA1();
+  up<HashFunction> sha256 = createSHA256();
+  static const size_t chunks[] = { 1000, 64 * 1024 };
+  for( int c = 0; c < 2; c++ ) {
+    run( "sha1", *sha1, data, chunks[c], total );
+    run( "sha256", *sha256, data, chunks[c], total );
+  }
+  return 0;
+}
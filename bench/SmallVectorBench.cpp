@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Vector.h>
+#include <baseline/SmallVector.h>
+#include <baseline/String8.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+template<typename V, typename T>
+static void run( const char* name, size_t iterations, size_t items, const T& item )
+{
+  bench::Stopwatch timer;
+  size_t total = 0;
+  for( size_t i = 0; i < iterations; i++ ) {
+    V vector;
+    for( size_t j = 0; j < items; j++ ) {
+      vector.push_back( item );
+    }
+    total += vector.size();
+    bench::doNotOptimize( vector.array() );
+  }
+  bench::doNotOptimize( total );
+  bench::report( name, timer.seconds(), 0 );
+}
+
+/**
+ * Builds and throws away iterations vectors of a few items, the way
+ * temporaries are used in hot loops. Compares Vector with SmallVector
+ * holding the items inline, and SmallVector spilling to the heap.
+ *
+ *   SmallVectorBench [iterations]
+ */
+int main( int argc, char** argv )
+{
+  const size_t iterations = bench::sizeArg( argc, argv, 1, 10000000 );
+  const String8 str( "item" );
+
+  run<Vector<int>>( "Vector<int> 4 items", iterations, 4, 1 );
+  run<SmallVector<int, 8>>( "SmallVector<int, 8> 4 items", iterations, 4, 1 );
+  run<Vector<int>>( "Vector<int> 16 items", iterations / 4, 16, 1 );
+  run<SmallVector<int, 8>>( "SmallVector<int, 8> 16 items", iterations / 4, 16, 1 );
+  run<Vector<String8>>( "Vector<String8> 4 items", iterations, 4, str );
+  run<SmallVector<String8, 8>>( "SmallVector<String8, 8> 4 items", iterations, 4, str );
+  return 0;
+}
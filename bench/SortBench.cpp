@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+static int compareInt( const int32_t* lhs, const int32_t* rhs )
+{
+  return ( *lhs > *rhs ) - ( *lhs < *rhs );
+}
+
+static int compareIntR( const void* lhs, const void* rhs, void* )
+{
+  return compareInt( static_cast<const int32_t*>( lhs ), static_cast<const int32_t*>( rhs ) );
+}
+
+static void fill( Vector<int32_t>& vector, size_t count, int kind )
+{
+  vector.clear();
+  vector.setCapacity( count );
+  uint32_t seed = 12345;
+  for( size_t i = 0; i < count; i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    switch( kind ) {
+    case 0:
+      vector.push_back( int32_t( seed >> 1 ) );
+      break;
+    case 1:
+      vector.push_back( int32_t( i ) );
+      break;
+    default:
+      vector.push_back( int32_t( count - i ) );
+      break;
+    }
+  }
+}
+
+/**
+ * Sorts random, sorted and reverse sorted Vector<int32_t> through the
+ * inlined functor path, the compar_t function pointer API and the
+ * type-erased VectorImpl::sort.
+ *
+ *   SortBench [count]
+ */
+int main( int argc, char** argv )
+{
+  const size_t count = bench::sizeArg( argc, argv, 1, 1000000 );
+  static const char* kinds[] = { "random", "sorted", "reverse" };
+
+  for( int kind = 0; kind < 3; kind++ ) {
+    Vector<int32_t> vector;
+    char name[64];
+    bench::Stopwatch timer;
+
+    fill( vector, count, kind );
+    timer.reset();
+    vector.sort( []( const int32_t & lhs, const int32_t & rhs ) {
+      return ( lhs > rhs ) - ( lhs < rhs );
+    } );
+    snprintf( name, sizeof( name ), "%s functor", kinds[kind] );
+    bench::report( name, timer.seconds(), double( count * sizeof( int32_t ) ) );
+
+    fill( vector, count, kind );
+    timer.reset();
+    vector.sort( compareInt );
+    snprintf( name, sizeof( name ), "%s compar_t", kinds[kind] );
+    bench::report( name, timer.seconds(), double( count * sizeof( int32_t ) ) );
+
+    fill( vector, count, kind );
+    timer.reset();
+    reinterpret_cast<VectorImpl&>( vector ).sort( compareIntR, NULL );
+    snprintf( name, sizeof( name ), "%s VectorImpl", kinds[kind] );
+    bench::report( name, timer.seconds(), double( count * sizeof( int32_t ) ) );
+
+    bench::doNotOptimize( vector[count / 2] );
+  }
+  return 0;
+}
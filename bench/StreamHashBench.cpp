@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Hash.h>
+#include <baseline/SharedBuffer.h>
+#include <baseline/Streams.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * Writes into a preallocated buffer, so that the copy costs one memcpy.
+ */
+class BufferOutputStream : public OutputStream
+{
+public:
+  BufferOutputStream( uint8_t* dest )
+    : mDest( dest ), mSize( 0 ) {}
+
+  void close() {}
+  int write( uint8_t* buf, size_t off, size_t len ) {
+    memcpy( mDest + mSize, &buf[off], len );
+    mSize += len;
+    return len;
+  }
+
+  uint8_t* mDest;
+  size_t mSize;
+};
+
+static void run( const char* name, SharedBuffer* source, uint8_t* dest, up<HashFunction> ( *factory )() )
+{
+  char label[64];
+  up<HashFunction> hash = factory();
+  const double bytes = double( source->size() );
+
+  bench::Stopwatch timer;
+  {
+    ByteArrayInputStream in( source, 0, source->size() );
+    BufferOutputStream out( dest );
+    pump( in, out );
+    hash->update( dest, out.mSize );
+  }
+  snprintf( label, sizeof( label ), "%s copy, then hash", name );
+  bench::report( label, timer.seconds(), bytes );
+  bench::doNotOptimize( hash->finalize() );
+
+  hash->reset();
+  timer.reset();
+  {
+    ByteArrayInputStream raw( source, 0, source->size() );
+    HashingInputStream in( raw, *hash );
+    BufferOutputStream out( dest );
+    pump( in, out );
+  }
+  snprintf( label, sizeof( label ), "%s HashingInputStream", name );
+  bench::report( label, timer.seconds(), bytes );
+  bench::doNotOptimize( hash->finalize() );
+}
+
+static up<HashFunction> hash64Factory()
+{
+  return createHash64();
+}
+
+/**
+ * Copies a buffer larger than the caches with pump() and hashes it, once
+ * as a second pass over the copy and once on the way through with
+ * HashingInputStream.
+ *
+ *   StreamHashBench [size]
+ */
+int main( int argc, char** argv )
+{
+  const size_t size = bench::sizeArg( argc, argv, 1, size_t( 256 ) << 20 );
+  SharedBuffer* source = SharedBuffer::alloc( size );
+  SharedBuffer* dest = SharedBuffer::alloc( size );
+  uint8_t* p = static_cast<uint8_t*>( source->data() );
+  uint32_t seed = 7;
+  for( size_t i = 0; i < size; i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    p[i] = uint8_t( seed >> 24 );
+  }
+  // fault the destination in before timing
+  memset( dest->data(), 0, size );
+
+  for( int round = 0; round < 2; round++ ) {
+    run( "crc32c", source, static_cast<uint8_t*>( dest->data() ), createCRC32C );
+    run( "hash64", source, static_cast<uint8_t*>( dest->data() ), hash64Factory );
+    run( "sha1", source, static_cast<uint8_t*>( dest->data() ), createSHA1 );
+  }
+
+  source->release();
+  dest->release();
+  return 0;
+}
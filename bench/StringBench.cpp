@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/HashMap.h>
+#include <baseline/String8.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+static const char* kTags[] = { "net", "Camera2", "AudioFlinger", "wifi.supplicant", "ActivityManager",
+                               "sensors", "gps", "InputDispatcher" };
+static const size_t kTagCount = sizeof( kTags ) / sizeof( kTags[0] );
+
+/**
+ * What a logger does with its tag: build a String8 from the literal, copy
+ * it into the record, and drop both.
+ */
+static BENCH_NOINLINE size_t logTags( size_t count )
+{
+  size_t total = 0;
+  for( size_t i = 0; i < count; i++ ) {
+    String8 tag( kTags[i % kTagCount] );
+    String8 copy( tag );
+    total += copy.length();
+  }
+  return total;
+}
+
+static void makeKey( char* key, size_t i )
+{
+  snprintf( key, 32, "key.%zu", i );
+}
+
+/**
+ * Short String8 keys built from a char buffer, inserted into a HashMap and
+ * looked up again, the way configuration and property maps are used.
+ */
+static BENCH_NOINLINE size_t mapKeys( size_t count, HashMap<String8, int>& map )
+{
+  char key[32];
+  for( size_t i = 0; i < count; i++ ) {
+    makeKey( key, i );
+    map.add( String8( key ), int( i ) );
+  }
+  size_t found = 0;
+  for( size_t i = 0; i < count * 4; i++ ) {
+    makeKey( key, ( i * 7 ) % count );
+    found += map.indexOfKey( String8( key ) ) >= 0;
+  }
+  return found;
+}
+
+/**
+ * A growing Vector of short names, which copies every element through
+ * memcpy() on each reallocation and releases them all at the end.
+ */
+static BENCH_NOINLINE size_t vectorOfNames( size_t count )
+{
+  Vector<String8> names;
+  for( size_t i = 0; i < count; i++ ) {
+    names.add( String8( kTags[i % kTagCount] ) );
+  }
+  size_t total = 0;
+  for( size_t i = 0; i < names.size(); i++ ) {
+    total += names[i].length();
+  }
+  return total;
+}
+
+/**
+ * Workloads dominated by short strings: log tags, map keys and vectors of
+ * names. Reports Mstrings/s; every string here fits in String8's inline
+ * storage.
+ *
+ *   StringBench [count]
+ */
+int main( int argc, char** argv )
+{
+  const size_t count = bench::sizeArg( argc, argv, 1, 1000000 );
+
+  bench::Stopwatch timer;
+  bench::doNotOptimize( logTags( count * 10 ) );
+  double seconds = timer.seconds();
+  printf( "%-40s %10.3f ms %10.2f Mstrings/s\n", "log tags (construct+copy)", seconds * 1e3,
+          count * 10 / seconds / 1e6 );
+
+  timer.reset();
+  {
+    HashMap<String8, int> map;
+    size_t found = mapKeys( count, map );
+    seconds = timer.seconds();
+    if( found != count * 4 ) {
+      fprintf( stderr, "lookups failed\n" );
+      return 1;
+    }
+  }
+  printf( "%-40s %10.3f ms %10.2f Mstrings/s\n", "map keys (insert+4x lookup)", seconds * 1e3,
+          count * 5 / seconds / 1e6 );
+
+  timer.reset();
+  bench::doNotOptimize( vectorOfNames( count * 4 ) );
+  seconds = timer.seconds();
+  printf( "%-40s %10.3f ms %10.2f Mstrings/s\n", "vector of names", seconds * 1e3, count * 4 / seconds / 1e6 );
+  return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/String8.h>
+#include <baseline/StringBuilder.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+static const char* kTags[] = { "ActivityManager", "wifi", "AudioFlinger", "net" };
+
+struct LogLine {
+  int64_t seconds;
+  int millis;
+  char level;
+  const char* tag;
+  int pid;
+  int requestId;
+  double elapsed;
+};
+
+static LogLine makeLine( size_t i )
+{
+  LogLine line;
+  line.seconds = 1697712000 + int64_t( i / 1000 );
+  line.millis = int( i % 1000 );
+  line.level = "VDIWE"[i % 5];
+  line.tag = kTags[i & 3];
+  line.pid = int( 1000 + i % 30000 );
+  line.requestId = int( i * 7919 );
+  line.elapsed = double( i % 100000 ) / 997.0;
+  return line;
+}
+
+static BENCH_NOINLINE void formatString8( String8& log, const LogLine& l )
+{
+  log.appendFormat( "%lld.%03d %c/%s(%5d): request %d took %.3f ms\n", ( long long )l.seconds, l.millis, l.level,
+                    l.tag, l.pid, l.requestId, l.elapsed );
+}
+
+static BENCH_NOINLINE void formatBuilder( StringBuilder& log, const LogLine& l )
+{
+  log.appendFormat( "%lld.%03d %c/%s(%5d): request %d took %.3f ms\n", ( long long )l.seconds, l.millis, l.level,
+                    l.tag, l.pid, l.requestId, l.elapsed );
+}
+
+static BENCH_NOINLINE void appendBuilder( StringBuilder& log, const LogLine& l )
+{
+  log.appendInt( l.seconds );
+  log.append( '.' );
+  if( l.millis < 100 ) {
+    log.append( l.millis < 10 ? "00" : "0" );
+  }
+  log.appendInt( l.millis );
+  log.append( ' ' );
+  log.append( l.level );
+  log.append( '/' );
+  log.append( l.tag );
+  log.append( '(' );
+  for( int p = l.pid < 10000 ? ( l.pid < 1000 ? 2 : 1 ) : 0; p > 0; p-- ) {
+    log.append( ' ' );
+  }
+  log.appendInt( l.pid );
+  log.append( "): request ", 11 );
+  log.appendInt( l.requestId );
+  log.append( " took ", 6 );
+  log.appendDouble( l.elapsed, 3 );
+  log.append( " ms\n", 4 );
+}
+
+/**
+ * Assembles count log lines into one string with String8::appendFormat(),
+ * StringBuilder::appendFormat() and StringBuilder's typed appends, then
+ * builds a string from 16 byte pieces with String8::append() and
+ * StringBuilder::append().
+ *
+ *   StringBuilderBench [lines]
+ */
+int main( int argc, char** argv )
+{
+  const size_t count = bench::sizeArg( argc, argv, 1, 300000 );
+
+  bench::Stopwatch timer;
+  String8 string8Log;
+  for( size_t i = 0; i < count; i++ ) {
+    formatString8( string8Log, makeLine( i ) );
+  }
+  double seconds = timer.seconds();
+  bench::report( "String8::appendFormat", seconds, double( string8Log.length() ) );
+
+  timer.reset();
+  StringBuilder formatted;
+  for( size_t i = 0; i < count; i++ ) {
+    formatBuilder( formatted, makeLine( i ) );
+  }
+  String8 formattedLog = formatted.toString8();
+  seconds = timer.seconds();
+  bench::report( "StringBuilder::appendFormat", seconds, double( formattedLog.length() ) );
+
+  timer.reset();
+  StringBuilder appended;
+  for( size_t i = 0; i < count; i++ ) {
+    appendBuilder( appended, makeLine( i ) );
+  }
+  String8 appendedLog = appended.toString8();
+  seconds = timer.seconds();
+  bench::report( "StringBuilder typed appends", seconds, double( appendedLog.length() ) );
+
+  if( formattedLog != string8Log || appendedLog != string8Log ) {
+    fprintf( stderr, "logs differ\n" );
+    return 1;
+  }
+
+  const size_t pieces = count * 4;
+  static const char piece[] = "0123456789abcdef";
+  timer.reset();
+  String8 string8;
+  for( size_t i = 0; i < pieces; i++ ) {
+    string8.append( piece, 16 );
+  }
+  seconds = timer.seconds();
+  bench::report( "String8::append 16 bytes", seconds, double( string8.length() ) );
+
+  timer.reset();
+  StringBuilder builder;
+  for( size_t i = 0; i < pieces; i++ ) {
+    builder.append( piece, 16 );
+  }
+  String8 built = builder.toString8();
+  seconds = timer.seconds();
+  bench::report( "StringBuilder::append 16 bytes", seconds, double( built.length() ) );
+  return built == string8 ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/HashMap.h>
+#include <baseline/Mutex.h>
+#include <baseline/String8.h>
+#include <baseline/StringPool.h>
+#include <baseline/Thread.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+static const size_t kNames = 4000;
+static char gNames[kNames][32];
+static size_t gLengths[kNames];
+
+/**
+ * A String8 keyed HashMap behind one Mutex, the way a shared tag table
+ * is kept without StringPool.
+ */
+class LockedTable
+{
+public:
+  LockedTable() {
+    for( size_t i = 0; i < kNames; i++ ) {
+      mMap.add( String8( gNames[i], gLengths[i] ), int( i ) );
+    }
+  }
+
+  size_t lookup( size_t i ) {
+    const String8 key( gNames[i], gLengths[i] );
+    Mutex::Autolock lock( mMutex );
+    return size_t( mMap.indexOfKey( key ) );
+  }
+
+private:
+  Mutex mMutex;
+  HashMap<String8, int> mMap;
+};
+
+class PoolTable
+{
+public:
+  PoolTable() {
+    for( size_t i = 0; i < kNames; i++ ) {
+      mPool.intern( gNames[i], gLengths[i] );
+    }
+  }
+
+  size_t lookup( size_t i ) {
+    return size_t( mPool.intern( gNames[i], gLengths[i] ).length() );
+  }
+
+private:
+  StringPool mPool;
+};
+
+template<typename TABLE>
+class Reader : public Thread
+{
+public:
+  Reader( TABLE& table, size_t id, size_t count ) : mTable( table ), mId( id ), mCount( count ), mSum( 0 ) {}
+
+  void run() {
+    size_t sum = 0;
+    for( size_t i = 0; i < mCount; i++ ) {
+      sum += mTable.lookup( ( i * 7 + mId * 131 ) % kNames );
+    }
+    mSum = sum;
+  }
+
+  size_t sum() const {
+    return mSum;
+  }
+
+private:
+  TABLE& mTable;
+  size_t mId;
+  size_t mCount;
+  size_t mSum;
+};
+
+template<typename TABLE>
+static void run( const char* label, TABLE& table, size_t threads, size_t count )
+{
+  Vector<sp<Reader<TABLE> > > readers;
+  for( size_t t = 0; t < threads; t++ ) {
+    readers.add( new Reader<TABLE>( table, t, count / threads ) );
+  }
+  bench::Stopwatch timer;
+  for( size_t t = 0; t < threads; t++ ) {
+    readers[t]->start();
+  }
+  size_t sum = 0;
+  for( size_t t = 0; t < threads; t++ ) {
+    readers[t]->join();
+    sum += readers[t]->sum();
+  }
+  const double seconds = timer.seconds();
+  bench::doNotOptimize( sum );
+
+  char name[64];
+  snprintf( name, sizeof( name ), "%s, %zu threads", label, threads );
+  printf( "%-40s %10.3f ms %10.2f Mlookups/s\n", name, seconds * 1e3, count / seconds / 1e6 );
+}
+
+static BENCH_NOINLINE size_t compareStrings( const Vector<String8>& a, const Vector<String8>& b, size_t rounds )
+{
+  size_t matches = 0;
+  for( size_t r = 0; r < rounds; r++ ) {
+    for( size_t i = 0; i < a.size(); i++ ) {
+      matches += a[i] == b[i];
+      matches += hash_type( a[i] ) & 1;
+    }
+  }
+  return matches;
+}
+
+static BENCH_NOINLINE size_t compareInterned( const Vector<InternedString>& a, const Vector<InternedString>& b,
+                                              size_t rounds )
+{
+  size_t matches = 0;
+  for( size_t r = 0; r < rounds; r++ ) {
+    for( size_t i = 0; i < a.size(); i++ ) {
+      matches += a[i] == b[i];
+      matches += hash_type( a[i] ) & 1;
+    }
+  }
+  return matches;
+}
+
+/**
+ * Looks up a few thousand tag names from 1, 4 and 16 threads, in a
+ * StringPool and in a Mutex guarded HashMap<String8, int>, then compares
+ * and hashes pairs of equal names as String8 and as InternedString.
+ *
+ *   StringPoolBench [lookups]
+ */
+int main( int argc, char** argv )
+{
+  const size_t count = bench::sizeArg( argc, argv, 1, 8000000 );
+  for( size_t i = 0; i < kNames; i++ ) {
+    gLengths[i] = snprintf( gNames[i], sizeof( gNames[i] ), "subsystem%zu.field.%zu", i % 37, i );
+  }
+
+  {
+    LockedTable locked;
+    PoolTable pool;
+    static const size_t threads[] = { 1, 4, 16 };
+    for( size_t t = 0; t < sizeof( threads ) / sizeof( threads[0] ); t++ ) {
+      run( "mutex + HashMap<String8>", locked, threads[t], count );
+      run( "StringPool::intern", pool, threads[t], count );
+    }
+  }
+
+  StringPool pool;
+  Vector<String8> a, b;
+  Vector<InternedString> ia, ib;
+  for( size_t i = 0; i < kNames; i++ ) {
+    a.add( String8( gNames[i] ) );
+    b.add( String8( gNames[i] ) );
+    ia.add( pool.intern( gNames[i] ) );
+    ib.add( pool.intern( gNames[i] ) );
+  }
+  const size_t rounds = count / kNames;
+  bench::Stopwatch timer;
+  bench::doNotOptimize( compareStrings( a, b, rounds ) );
+  double seconds = timer.seconds();
+  printf( "%-40s %10.3f ms %10.2f Mcompares/s\n", "String8 == and hash", seconds * 1e3, rounds * kNames / seconds / 1e6 );
+
+  timer.reset();
+  bench::doNotOptimize( compareInterned( ia, ib, rounds ) );
+  seconds = timer.seconds();
+  printf( "%-40s %10.3f ms %10.2f Mcompares/s\n", "InternedString == and hash", seconds * 1e3,
+          rounds * kNames / seconds / 1e6 );
+  return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/String8.h>
+#include <baseline/Unicode.h>
+#include <baseline/String16.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * About 1MB of UTF-8 made of words from one script, with spaces and
+ * punctuation in between.
+ */
+static String8 corpus( const char* const* words, size_t count )
+{
+  String8 str;
+  uint32_t seed = 11;
+  while( str.length() < ( 1 << 20 ) ) {
+    seed = seed * 1664525 + 1013904223;
+    str.append( words[( seed >> 16 ) % count] );
+    str.append( ( seed >> 8 ) % 13 == 0 ? ". " : " " );
+  }
+  return str;
+}
+
+static void run( const char* name, const String8& text, size_t rounds )
+{
+  const uint8_t* src = ( const uint8_t* )text.string();
+  const size_t len = text.length();
+  const double bytes = double( rounds ) * double( len );
+  Vector<char16_t> utf16;
+  utf16.insertAt( char16_t( 0 ), 0, len + 1 );
+  Vector<char> utf8;
+  utf8.insertAt( char( 0 ), 0, 3 * len + 1 );
+  char label[64];
+  size_t check = 0;
+
+  bench::Stopwatch timer;
+  for( size_t r = 0; r < rounds; r++ ) {
+    check += utf8_length( text.string() );
+  }
+  snprintf( label, sizeof( label ), "%s utf8_length", name );
+  bench::report( label, timer.seconds(), bytes );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    check += utf8_validate( src, len );
+  }
+  snprintf( label, sizeof( label ), "%s utf8_validate", name );
+  bench::report( label, timer.seconds(), bytes );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    check += utf8_to_utf16_length( src, len );
+    utf8_to_utf16( src, len, utf16.editArray() );
+  }
+  snprintf( label, sizeof( label ), "%s to UTF-16, two pass", name );
+  bench::report( label, timer.seconds(), bytes );
+
+  timer.reset();
+  ssize_t units = 0;
+  for( size_t r = 0; r < rounds; r++ ) {
+    units = utf8_to_utf16_checked( src, len, utf16.editArray() );
+    check += units;
+  }
+  snprintf( label, sizeof( label ), "%s to UTF-16, checked", name );
+  bench::report( label, timer.seconds(), bytes );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    check += utf16_to_utf8_length( utf16.array(), units );
+    utf16_to_utf8( utf16.array(), units, utf8.editArray() );
+  }
+  snprintf( label, sizeof( label ), "%s from UTF-16, two pass", name );
+  bench::report( label, timer.seconds(), bytes );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    check += utf16_to_utf8_checked( utf16.array(), units, utf8.editArray() );
+  }
+  snprintf( label, sizeof( label ), "%s from UTF-16, checked", name );
+  bench::report( label, timer.seconds(), bytes );
+
+  timer.reset();
+  for( size_t r = 0; r < rounds; r++ ) {
+    String16 str16( text );
+    String8 str8( str16 );
+    check += str8.length();
+  }
+  snprintf( label, sizeof( label ), "%s String16 and back", name );
+  bench::report( label, timer.seconds(), bytes );
+  bench::doNotOptimize( check );
+}
+
+/**
+ * Validates and transcodes ASCII, Latin, CJK and emoji text, with the
+ * old code point at a time functions and the checked single pass ones.
+ * Reports MB/s of UTF-8.
+ *
+ *   UnicodeBench [total]
+ */
+int main( int argc, char** argv )
+{
+  const size_t total = bench::sizeArg( argc, argv, 1, size_t( 64 ) << 20 );
+  const size_t rounds = MAX( total >> 20, size_t( 1 ) );
+
+  static const char* ascii[] = { "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "stream", "buffer" };
+  static const char* latin[] = { "d\xC3\xA9j\xC3\xA0", "caf\xC3\xA9", "na\xC3\xAFve", "gar\xC3\xA7on", "\xC3\xBC" "ber",
+                                 "stra\xC3\x9F" "e", "ma\xC3\xB1" "ana", "fen\xC3\xAAtre", "le", "et"
+                               };
+  static const char* cjk[] = { "\xE6\x97\xA5\xE6\x9C\xAC", "\xE4\xB8\xAD\xE6\x96\x87", "\xE6\xBC\xA2\xE5\xAD\x97",
+                               "\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF", "\xED\x95\x9C\xEA\xB5\xAD\xEC\x96\xB4"
+                             };
+  static const char* emoji[] = { "\xF0\x9F\x98\x80", "\xF0\x9F\x9A\x80\xF0\x9F\x8C\x8D", "\xF0\x9F\x91\x8D",
+                                 "\xF0\x9F\x8E\x89\xF0\x9F\x8E\x82", "ok"
+                               };
+
+  run( "ascii", corpus( ascii, sizeof( ascii ) / sizeof( ascii[0] ) ), rounds );
+  run( "latin", corpus( latin, sizeof( latin ) / sizeof( latin[0] ) ), rounds );
+  run( "cjk", corpus( cjk, sizeof( cjk ) / sizeof( cjk[0] ) ), rounds );
+  run( "emoji", corpus( emoji, sizeof( emoji ) / sizeof( emoji[0] ) ), rounds );
+  return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/SharedBuffer.h>
+#include <baseline/Vector.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * Appends uint64_t items one at a time until the vector holds the requested
+ * number of bytes (default 4G), reporting wall time and peak RSS. Pass
+ * "heap" as the second argument to disable page mapped buffers.
+ *
+ *   VectorAppendBench [bytes] [heap|mapped]
+ */
+int main( int argc, char** argv )
+{
+  const size_t bytes = bench::sizeArg( argc, argv, 1, size_t( 4 ) << 30 );
+  const bool heap = argc > 2 && strcmp( argv[2], "heap" ) == 0;
+  if( heap ) {
+    SharedBuffer::setMapThreshold( SIZE_MAX );
+  }
+
+  const size_t count = bytes / sizeof( uint64_t );
+  bench::Stopwatch timer;
+  {
+    Vector<uint64_t> vector;
+    for( uint64_t i = 0; i < count; i++ ) {
+      vector.push_back( i );
+    }
+    bench::doNotOptimize( vector.array()[count - 1] );
+  }
+  double seconds = timer.seconds();
+
+  bench::report( heap ? "append (heap)" : "append (mapped)", seconds, double( bytes ) );
+  printf( "peak RSS: %ld MB\n", bench::peakRSSKB() / 1024 );
+  return 0;
+}
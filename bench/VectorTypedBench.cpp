@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Vector.h>
+#include <baseline/RefBase.h>
+#include <baseline/String8.h>
+
+#include "Bench.h"
+
+using namespace baseline;
+
+/**
+ * A vector that only uses the type-erased VectorImpl calls, the way
+ * Vector did before it had inlined fast paths.
+ */
+template<typename TYPE>
+class ErasedVector : public VectorImpl
+{
+public:
+  ErasedVector()
+    : VectorImpl( sizeof( TYPE ),
+                  ( ( traits<TYPE>::has_trivial_ctor   ? HAS_TRIVIAL_CTOR   : 0 )
+                    | ( traits<TYPE>::has_trivial_dtor   ? HAS_TRIVIAL_DTOR   : 0 )
+                    | ( traits<TYPE>::has_trivial_copy   ? HAS_TRIVIAL_COPY   : 0 )
+                    | ( traits<TYPE>::has_trivial_move   ? HAS_TRIVIAL_MOVE   : 0 ) ) ) {
+  }
+  virtual ~ErasedVector() {
+    finish_vector();
+  }
+
+  inline int add( const TYPE& item ) {
+    return VectorImpl::add( &item );
+  }
+  inline TYPE& editItemAt( size_t index ) {
+    return *static_cast<TYPE*>( editItemLocation( index ) );
+  }
+  inline void reserve( size_t n ) {
+    setCapacity( n );
+  }
+
+protected:
+  virtual void do_construct( void* storage, size_t num ) const {
+    construct_type( reinterpret_cast<TYPE*>( storage ), num );
+  }
+  virtual void do_destroy( void* storage, size_t num ) const {
+    destroy_type( reinterpret_cast<TYPE*>( storage ), num );
+  }
+  virtual void do_copy( void* dest, const void* from, size_t num ) const {
+    copy_type( reinterpret_cast<TYPE*>( dest ), reinterpret_cast<const TYPE*>( from ), num );
+  }
+  virtual void do_splat( void* dest, const void* item, size_t num ) const {
+    splat_type( reinterpret_cast<TYPE*>( dest ), reinterpret_cast<const TYPE*>( item ), num );
+  }
+  virtual void do_move_forward( void* dest, const void* from, size_t num ) const {
+    move_forward_type( reinterpret_cast<TYPE*>( dest ), reinterpret_cast<const TYPE*>( from ), num );
+  }
+  virtual void do_move_backward( void* dest, const void* from, size_t num ) const {
+    move_backward_type( reinterpret_cast<TYPE*>( dest ), reinterpret_cast<const TYPE*>( from ), num );
+  }
+};
+
+struct Node : public LightRefBase<Node> {
+};
+
+template<typename V, typename T>
+static void run( const char* name, size_t count, const T& item )
+{
+  char label[64];
+  bench::Stopwatch timer;
+
+  V vector;
+  vector.reserve( count );
+  timer.reset();
+  for( size_t i = 0; i < count; i++ ) {
+    vector.add( item );
+  }
+  snprintf( label, sizeof( label ), "%s add", name );
+  bench::report( label, timer.seconds(), 0 );
+
+  timer.reset();
+  for( size_t i = 0; i < count; i++ ) {
+    vector.editItemAt( i ) = item;
+  }
+  snprintf( label, sizeof( label ), "%s editItemAt", name );
+  bench::report( label, timer.seconds(), 0 );
+
+  timer.reset();
+  while( !vector.isEmpty() ) {
+    vector.pop();
+  }
+  snprintf( label, sizeof( label ), "%s pop", name );
+  bench::report( label, timer.seconds(), 0 );
+}
+
+/**
+ * Adds count items to a vector with enough capacity, assigns every item
+ * through editItemAt() and pops them all, with Vector and with the same
+ * calls going through VectorImpl.
+ *
+ *   VectorTypedBench [count]
+ */
+int main( int argc, char** argv )
+{
+  const size_t count = bench::sizeArg( argc, argv, 1, 4000000 );
+  const String8 str( "item" );
+  const sp<Node> node( new Node );
+
+  run<Vector<int>>( "Vector<int>", count, 1 );
+  run<ErasedVector<int>>( "VectorImpl int", count, 1 );
+  run<Vector<String8>>( "Vector<String8>", count, str );
+  run<ErasedVector<String8>>( "VectorImpl String8", count, str );
+  run<Vector<sp<Node>>>( "Vector<sp<>>", count, node );
+  run<ErasedVector<sp<Node>>>( "VectorImpl sp<>", count, node );
+  return 0;
+}
@@ -0,0 +1,797 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_BTREE_H_
+#define BASELINE_BTREE_H_
+
+#include <baseline/TypeHelpers.h>
+
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+#endif
+
+namespace baseline {
+
+/*
+ * In-node key search. Nodes are small, so arithmetic keys are counted
+ * with a branch-free linear scan (four at a time for int32_t with SSE2),
+ * everything else uses a binary search with strictly_order_type().
+ */
+namespace btree_detail {
+
+struct NoValue {};
+
+template<typename TYPE> inline
+size_t lower_bound_in( const TYPE* keys, size_t n, const TYPE& key, std::false_type )
+{
+  size_t lo = 0;
+  while( n > 0 ) {
+    const size_t half = n / 2;
+    if( strictly_order_type( keys[lo + half], key ) ) {
+      lo += half + 1;
+      n -= half + 1;
+    } else {
+      n = half;
+    }
+  }
+  return lo;
+}
+
+template<typename TYPE> inline
+size_t upper_bound_in( const TYPE* keys, size_t n, const TYPE& key, std::false_type )
+{
+  size_t lo = 0;
+  while( n > 0 ) {
+    const size_t half = n / 2;
+    if( !strictly_order_type( key, keys[lo + half] ) ) {
+      lo += half + 1;
+      n -= half + 1;
+    } else {
+      n = half;
+    }
+  }
+  return lo;
+}
+
+template<typename TYPE> inline
+size_t lower_bound_in( const TYPE* keys, size_t n, const TYPE& key, std::true_type )
+{
+  size_t count = 0;
+  for( size_t i = 0; i < n; i++ ) {
+    count += keys[i] < key;
+  }
+  return count;
+}
+
+template<typename TYPE> inline
+size_t upper_bound_in( const TYPE* keys, size_t n, const TYPE& key, std::true_type )
+{
+  size_t count = 0;
+  for( size_t i = 0; i < n; i++ ) {
+    count += !( key < keys[i] );
+  }
+  return count;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+inline size_t count_bits4( int mask )
+{
+  return ( mask & 1 ) + ( ( mask >> 1 ) & 1 ) + ( ( mask >> 2 ) & 1 ) + ( ( mask >> 3 ) & 1 );
+}
+
+inline size_t lower_bound_in( const int32_t* keys, size_t n, const int32_t& key, std::true_type )
+{
+  const __m128i k = _mm_set1_epi32( key );
+  size_t count = 0;
+  size_t i = 0;
+  for( ; i + 4 <= n; i += 4 ) {
+    const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( keys + i ) );
+    count += count_bits4( _mm_movemask_ps( _mm_castsi128_ps( _mm_cmplt_epi32( v, k ) ) ) );
+  }
+  for( ; i < n; i++ ) {
+    count += keys[i] < key;
+  }
+  return count;
+}
+
+inline size_t upper_bound_in( const int32_t* keys, size_t n, const int32_t& key, std::true_type )
+{
+  const __m128i k = _mm_set1_epi32( key );
+  size_t count = 0;
+  size_t i = 0;
+  for( ; i + 4 <= n; i += 4 ) {
+    const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( keys + i ) );
+    count += 4 - count_bits4( _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpgt_epi32( v, k ) ) ) );
+  }
+  for( ; i < n; i++ ) {
+    count += !( key < keys[i] );
+  }
+  return count;
+}
+#endif
+
+//! index of the first key not less than key
+template<typename TYPE> inline
+size_t lower_bound_in( const TYPE* keys, size_t n, const TYPE& key )
+{
+  return lower_bound_in( keys, n, key, typename std::is_arithmetic<TYPE>::type() );
+}
+
+//! index of the first key greater than key
+template<typename TYPE> inline
+size_t upper_bound_in( const TYPE* keys, size_t n, const TYPE& key )
+{
+  return upper_bound_in( keys, n, key, typename std::is_arithmetic<TYPE>::type() );
+}
+
+void* alloc_node( size_t size );
+void free_node( void* node );
+
+} // namespace btree_detail
+
+ANDROID_BASIC_TYPES_TRAITS( btree_detail::NoValue )
+
+/*!
+ * The B+tree behind BTreeMap<> and BTreeSet<>.
+ *
+ * Nodes are kNodeBytes long, a few cache lines aligned on a cache line,
+ * and hold as many keys as fit. Entries only live in the leaves, which
+ * are linked in order so that range scans never go back up the tree.
+ * Inner nodes hold the smallest key of every child but the first.
+ *
+ * Full nodes split in half, except that appending past the last leaf
+ * starts a new leaf so that ascending inserts leave the leaves full.
+ * Removing does not rebalance, a node is only freed once it is empty.
+ */
+template<typename TKey, typename TValue>
+class BTreeImpl
+{
+public:
+  enum {
+    kCacheLine = 64,
+    kNodeBytes = 4 * kCacheLine,
+    kMaxHeight = 32,
+  };
+
+protected:
+  struct Node {
+    uint16_t mCount;    // number of keys
+    uint16_t mLeaf;
+  };
+
+  enum {
+    kLeafHeader = sizeof( Node ) > sizeof( void* ) ? sizeof( Node ) + 2 * sizeof( void* ) : 3 * sizeof( void* ),
+    kLeafCapacity = MAX( 4, ( kNodeBytes - kLeafHeader ) / ( sizeof( TKey ) + sizeof( TValue ) ) ),
+    kInnerCapacity = MAX( 4, ( kNodeBytes - 2 * sizeof( void* ) ) / ( sizeof( TKey ) + sizeof( void* ) ) ),
+  };
+
+  struct Leaf : Node {
+    Leaf* mPrev;
+    Leaf* mNext;
+    typename std::aligned_storage<sizeof( TKey ) * kLeafCapacity, alignof( TKey )>::type mKeys;
+    typename std::aligned_storage<sizeof( TValue ) * kLeafCapacity, alignof( TValue )>::type mValues;
+
+    inline TKey* keys() {
+      return reinterpret_cast<TKey*>( &mKeys );
+    }
+    inline const TKey* keys() const {
+      return reinterpret_cast<const TKey*>( &mKeys );
+    }
+    inline TValue* values() {
+      return reinterpret_cast<TValue*>( &mValues );
+    }
+    inline const TValue* values() const {
+      return reinterpret_cast<const TValue*>( &mValues );
+    }
+  };
+
+  struct Inner : Node {
+    Node* mChildren[kInnerCapacity + 1];
+    typename std::aligned_storage<sizeof( TKey ) * kInnerCapacity, alignof( TKey )>::type mKeys;
+
+    inline TKey* keys() {
+      return reinterpret_cast<TKey*>( &mKeys );
+    }
+    inline const TKey* keys() const {
+      return reinterpret_cast<const TKey*>( &mKeys );
+    }
+  };
+
+public:
+  /*!
+   * Position of an entry. Iterators stay valid until the tree is next
+   * modified.
+   */
+  class Iterator
+  {
+  public:
+    Iterator() : mLeaf( 0 ), mIndex( 0 ) {}
+
+    //! false once past either end
+    inline bool isValid() const {
+      return mLeaf != 0;
+    }
+    inline const TKey& key() const {
+      return mLeaf->keys()[mIndex];
+    }
+    inline const TValue& value() const {
+      return mLeaf->values()[mIndex];
+    }
+    inline void next() {
+      if( ++mIndex == mLeaf->mCount ) {
+        mLeaf = mLeaf->mNext;
+        mIndex = 0;
+      }
+    }
+    inline void prev() {
+      if( mIndex == 0 ) {
+        mLeaf = mLeaf->mPrev;
+        mIndex = mLeaf ? mLeaf->mCount - 1 : 0;
+      } else {
+        mIndex--;
+      }
+    }
+
+  private:
+    friend class BTreeImpl;
+    Iterator( const Leaf* leaf, size_t index ) : mLeaf( leaf ), mIndex( index ) {}
+
+    const Leaf* mLeaf;
+    size_t mIndex;
+  };
+
+  BTreeImpl();
+  BTreeImpl( const BTreeImpl& rhs );
+  BTreeImpl( BTreeImpl&& rhs );
+  ~BTreeImpl();
+
+  BTreeImpl& operator = ( const BTreeImpl& rhs );
+  BTreeImpl& operator = ( BTreeImpl&& rhs );
+
+  inline size_t size() const {
+    return mSize;
+  }
+  inline bool isEmpty() const {
+    return mSize == 0;
+  }
+  void clear();
+
+  inline Iterator begin() const {
+    return Iterator( mFirst, 0 );
+  }
+  inline Iterator last() const {
+    return Iterator( mLast, mLast ? mLast->mCount - 1 : 0 );
+  }
+  Iterator find( const TKey& key ) const;
+  Iterator lowerBound( const TKey& key ) const;
+  Iterator upperBound( const TKey& key ) const;
+
+protected:
+  //! value for key, or NULL
+  TValue* edit( const TKey& key );
+
+  template<typename K, typename V>
+  status_t insert( K&& key, V&& value );
+  status_t erase( const TKey& key );
+
+  //! replaces the content with count entries from source, which must be
+  //! strictly ascending. source.next( TKey* key, TValue* value ) copy
+  //! constructs the next entry in place.
+  template<typename Source>
+  status_t load( size_t count, Source& source );
+
+private:
+  struct Path {
+    Inner* mNodes[kMaxHeight];
+    size_t mSlots[kMaxHeight];
+    size_t mDepth;
+  };
+
+  struct TreeSource;
+
+  Leaf* _descend( const TKey& key, Path* path ) const;
+  Iterator _position( const TKey& key, bool upper ) const;
+  void _insert_child( Inner* node, size_t slot, TKey* key, Node* child );
+  void _remove_child( Path& path, size_t level );
+  void _destroy( Node* node );
+
+  Node* mRoot;
+  Leaf* mFirst;
+  Leaf* mLast;
+  size_t mSize;
+};
+
+// ---------------------------------------------------------------------------
+// No user serviceable parts from here...
+// ---------------------------------------------------------------------------
+
+template<typename TKey, typename TValue>
+struct BTreeImpl<TKey, TValue>::TreeSource {
+  // walks through another tree, for copies
+  TreeSource( const BTreeImpl& tree ) : mIt( tree.begin() ) {}
+  inline void next( TKey* key, TValue* value ) {
+    new( key ) TKey( mIt.key() );
+    new( value ) TValue( mIt.value() );
+    mIt.next();
+  }
+  Iterator mIt;
+};
+
+template<typename TKey, typename TValue>
+BTreeImpl<TKey, TValue>::BTreeImpl()
+  : mRoot( 0 ), mFirst( 0 ), mLast( 0 ), mSize( 0 )
+{
+}
+
+template<typename TKey, typename TValue>
+BTreeImpl<TKey, TValue>::BTreeImpl( const BTreeImpl& rhs )
+  : mRoot( 0 ), mFirst( 0 ), mLast( 0 ), mSize( 0 )
+{
+  TreeSource source( rhs );
+  if( load( rhs.size(), source ) != NO_ERROR ) {
+    LOG_ERROR( "BTree", "out of memory copying %d entries", int( rhs.size() ) );
+  }
+}
+
+template<typename TKey, typename TValue>
+BTreeImpl<TKey, TValue>::BTreeImpl( BTreeImpl&& rhs )
+  : mRoot( rhs.mRoot ), mFirst( rhs.mFirst ), mLast( rhs.mLast ), mSize( rhs.mSize )
+{
+  rhs.mRoot = 0;
+  rhs.mFirst = rhs.mLast = 0;
+  rhs.mSize = 0;
+}
+
+template<typename TKey, typename TValue>
+BTreeImpl<TKey, TValue>::~BTreeImpl()
+{
+  clear();
+}
+
+template<typename TKey, typename TValue>
+BTreeImpl<TKey, TValue>& BTreeImpl<TKey, TValue>::operator = ( const BTreeImpl& rhs )
+{
+  if( this != &rhs ) {
+    TreeSource source( rhs );
+    if( load( rhs.size(), source ) != NO_ERROR ) {
+      LOG_ERROR( "BTree", "out of memory copying %d entries", int( rhs.size() ) );
+    }
+  }
+  return *this;
+}
+
+template<typename TKey, typename TValue>
+BTreeImpl<TKey, TValue>& BTreeImpl<TKey, TValue>::operator = ( BTreeImpl&& rhs )
+{
+  if( this != &rhs ) {
+    clear();
+    mRoot = rhs.mRoot;
+    mFirst = rhs.mFirst;
+    mLast = rhs.mLast;
+    mSize = rhs.mSize;
+    rhs.mRoot = 0;
+    rhs.mFirst = rhs.mLast = 0;
+    rhs.mSize = 0;
+  }
+  return *this;
+}
+
+template<typename TKey, typename TValue>
+void BTreeImpl<TKey, TValue>::clear()
+{
+  if( mRoot ) {
+    _destroy( mRoot );
+  }
+  mRoot = 0;
+  mFirst = mLast = 0;
+  mSize = 0;
+}
+
+template<typename TKey, typename TValue>
+void BTreeImpl<TKey, TValue>::_destroy( Node* node )
+{
+  if( node->mLeaf ) {
+    Leaf* leaf = static_cast<Leaf*>( node );
+    destroy_type( leaf->keys(), leaf->mCount );
+    destroy_type( leaf->values(), leaf->mCount );
+  } else {
+    Inner* inner = static_cast<Inner*>( node );
+    for( size_t i = 0; i <= inner->mCount; i++ ) {
+      _destroy( inner->mChildren[i] );
+    }
+    destroy_type( inner->keys(), inner->mCount );
+  }
+  btree_detail::free_node( node );
+}
+
+template<typename TKey, typename TValue>
+typename BTreeImpl<TKey, TValue>::Leaf* BTreeImpl<TKey, TValue>::_descend( const TKey& key, Path* path ) const
+{
+  Node* node = mRoot;
+  size_t depth = 0;
+  while( !node->mLeaf ) {
+    Inner* inner = static_cast<Inner*>( node );
+    const size_t slot = btree_detail::upper_bound_in( inner->keys(), inner->mCount, key );
+    if( path ) {
+      path->mNodes[depth] = inner;
+      path->mSlots[depth] = slot;
+    }
+    depth++;
+    node = inner->mChildren[slot];
+  }
+  if( path ) {
+    path->mDepth = depth;
+  }
+  return static_cast<Leaf*>( node );
+}
+
+template<typename TKey, typename TValue>
+typename BTreeImpl<TKey, TValue>::Iterator BTreeImpl<TKey, TValue>::_position( const TKey& key, bool upper ) const
+{
+  if( !mRoot ) {
+    return Iterator();
+  }
+  const Leaf* leaf = _descend( key, 0 );
+  const size_t index = upper ?
+                       btree_detail::upper_bound_in( leaf->keys(), leaf->mCount, key ) :
+                       btree_detail::lower_bound_in( leaf->keys(), leaf->mCount, key );
+  if( index == leaf->mCount ) {
+    // past this leaf, the next one starts at its separator
+    return Iterator( leaf->mNext, 0 );
+  }
+  return Iterator( leaf, index );
+}
+
+template<typename TKey, typename TValue>
+typename BTreeImpl<TKey, TValue>::Iterator BTreeImpl<TKey, TValue>::find( const TKey& key ) const
+{
+  Iterator it = _position( key, false );
+  if( it.isValid() && strictly_order_type( key, it.key() ) ) {
+    return Iterator();
+  }
+  return it;
+}
+
+template<typename TKey, typename TValue>
+typename BTreeImpl<TKey, TValue>::Iterator BTreeImpl<TKey, TValue>::lowerBound( const TKey& key ) const
+{
+  return _position( key, false );
+}
+
+template<typename TKey, typename TValue>
+typename BTreeImpl<TKey, TValue>::Iterator BTreeImpl<TKey, TValue>::upperBound( const TKey& key ) const
+{
+  return _position( key, true );
+}
+
+template<typename TKey, typename TValue>
+TValue* BTreeImpl<TKey, TValue>::edit( const TKey& key )
+{
+  Iterator it = find( key );
+  if( !it.isValid() ) {
+    return 0;
+  }
+  return const_cast<TValue*>( &it.value() );
+}
+
+template<typename TKey, typename TValue> template<typename K, typename V>
+status_t BTreeImpl<TKey, TValue>::insert( K&& key, V&& value )
+{
+  if( !mRoot ) {
+    Leaf* leaf = static_cast<Leaf*>( btree_detail::alloc_node( sizeof( Leaf ) ) );
+    if( !leaf ) {
+      return NO_MEMORY;
+    }
+    leaf->mCount = 0;
+    leaf->mLeaf = 1;
+    leaf->mPrev = leaf->mNext = 0;
+    mRoot = mFirst = mLast = leaf;
+  }
+
+  Path path;
+  Leaf* leaf = _descend( key, &path );
+  size_t pos = btree_detail::lower_bound_in( leaf->keys(), leaf->mCount, key );
+  if( pos < leaf->mCount && !strictly_order_type( key, leaf->keys()[pos] ) ) {
+    leaf->values()[pos] = std::forward<V>( value );
+    return NO_ERROR;
+  }
+
+  if( leaf->mCount < kLeafCapacity ) {
+    move_forward_type( leaf->keys() + pos + 1, leaf->keys() + pos, leaf->mCount - pos );
+    move_forward_type( leaf->values() + pos + 1, leaf->values() + pos, leaf->mCount - pos );
+    new( leaf->keys() + pos ) TKey( std::forward<K>( key ) );
+    new( leaf->values() + pos ) TValue( std::forward<V>( value ) );
+    leaf->mCount++;
+    mSize++;
+    return NO_ERROR;
+  }
+
+  // the leaf and every full inner node above it split. get all the nodes
+  // first, so that running out of memory leaves the tree untouched.
+  size_t splits = 1;
+  while( splits <= path.mDepth && path.mNodes[path.mDepth - splits]->mCount == kInnerCapacity ) {
+    splits++;
+  }
+  const size_t needed = splits + ( splits > path.mDepth ? 1 : 0 );
+  LOG_FATAL_IF( needed > kMaxHeight, "BTree: too high" );
+  void* spare[kMaxHeight + 1];
+  for( size_t i = 0; i < needed; i++ ) {
+    spare[i] = btree_detail::alloc_node( i == 0 ? sizeof( Leaf ) : sizeof( Inner ) );
+    if( !spare[i] ) {
+      while( i-- ) {
+        btree_detail::free_node( spare[i] );
+      }
+      return NO_MEMORY;
+    }
+  }
+
+  // split the leaf. appending past the last leaf starts a new one
+  Leaf* right = static_cast<Leaf*>( spare[0] );
+  const size_t mid = ( pos == kLeafCapacity && !leaf->mNext ) ? size_t( kLeafCapacity ) : kLeafCapacity / 2;
+  right->mCount = kLeafCapacity - mid;
+  right->mLeaf = 1;
+  move_backward_type( right->keys(), leaf->keys() + mid, right->mCount );
+  move_backward_type( right->values(), leaf->values() + mid, right->mCount );
+  leaf->mCount = mid;
+  right->mPrev = leaf;
+  right->mNext = leaf->mNext;
+  if( leaf->mNext ) {
+    leaf->mNext->mPrev = right;
+  } else {
+    mLast = right;
+  }
+  leaf->mNext = right;
+
+  Leaf* target = leaf;
+  if( pos > mid || mid == kLeafCapacity ) {
+    target = right;
+    pos -= mid;
+  }
+  move_forward_type( target->keys() + pos + 1, target->keys() + pos, target->mCount - pos );
+  move_forward_type( target->values() + pos + 1, target->values() + pos, target->mCount - pos );
+  new( target->keys() + pos ) TKey( std::forward<K>( key ) );
+  new( target->values() + pos ) TValue( std::forward<V>( value ) );
+  target->mCount++;
+  mSize++;
+
+  // push the separator up, splitting full inner nodes on the way
+  typename std::aligned_storage<sizeof( TKey ), alignof( TKey )>::type sepStorage;
+  TKey* sep = reinterpret_cast<TKey*>( &sepStorage );
+  new( sep ) TKey( right->keys()[0] );
+  Node* child = right;
+  size_t level = path.mDepth;
+  size_t used = 1;
+  while( level > 0 ) {
+    Inner* parent = path.mNodes[level - 1];
+    size_t slot = path.mSlots[level - 1];
+    if( parent->mCount < kInnerCapacity ) {
+      _insert_child( parent, slot, sep, child );
+      return NO_ERROR;
+    }
+
+    // split the inner node around the middle of its keys plus the new one.
+    // the middle key moves up and becomes the pending separator.
+    Inner* split = static_cast<Inner*>( spare[used++] );
+    const size_t half = kInnerCapacity / 2;
+    split->mLeaf = 0;
+    if( slot == half ) {
+      split->mCount = kInnerCapacity - half;
+      move_backward_type( split->keys(), parent->keys() + half, split->mCount );
+      split->mChildren[0] = child;
+      memcpy( split->mChildren + 1, parent->mChildren + half + 1, split->mCount * sizeof( Node* ) );
+      parent->mCount = half;
+    } else {
+      const size_t cut = slot < half ? half - 1 : half;
+      typename std::aligned_storage<sizeof( TKey ), alignof( TKey )>::type upStorage;
+      TKey* up = reinterpret_cast<TKey*>( &upStorage );
+      move_backward_type( up, parent->keys() + cut, 1 );
+      split->mCount = kInnerCapacity - cut - 1;
+      move_backward_type( split->keys(), parent->keys() + cut + 1, split->mCount );
+      memcpy( split->mChildren, parent->mChildren + cut + 1, ( split->mCount + 1 ) * sizeof( Node* ) );
+      parent->mCount = cut;
+      if( slot < half ) {
+        _insert_child( parent, slot, sep, child );
+      } else {
+        _insert_child( split, slot - cut - 1, sep, child );
+      }
+      move_backward_type( sep, up, 1 );
+    }
+    child = split;
+    level--;
+  }
+
+  // the root split
+  Inner* root = static_cast<Inner*>( spare[used] );
+  root->mLeaf = 0;
+  root->mCount = 1;
+  move_backward_type( root->keys(), sep, 1 );
+  root->mChildren[0] = mRoot;
+  root->mChildren[1] = child;
+  mRoot = root;
+  return NO_ERROR;
+}
+
+template<typename TKey, typename TValue>
+void BTreeImpl<TKey, TValue>::_insert_child( Inner* node, size_t slot, TKey* key, Node* child )
+{
+  // takes over key, child goes right after it
+  move_forward_type( node->keys() + slot + 1, node->keys() + slot, node->mCount - slot );
+  memmove( node->mChildren + slot + 2, node->mChildren + slot + 1, ( node->mCount - slot ) * sizeof( Node* ) );
+  move_backward_type( node->keys() + slot, key, 1 );
+  node->mChildren[slot + 1] = child;
+  node->mCount++;
+}
+
+template<typename TKey, typename TValue>
+status_t BTreeImpl<TKey, TValue>::erase( const TKey& key )
+{
+  if( !mRoot ) {
+    return NAME_NOT_FOUND;
+  }
+  Path path;
+  Leaf* leaf = _descend( key, &path );
+  const size_t pos = btree_detail::lower_bound_in( leaf->keys(), leaf->mCount, key );
+  if( pos == leaf->mCount || strictly_order_type( key, leaf->keys()[pos] ) ) {
+    return NAME_NOT_FOUND;
+  }
+
+  destroy_type( leaf->keys() + pos, 1 );
+  destroy_type( leaf->values() + pos, 1 );
+  move_backward_type( leaf->keys() + pos, leaf->keys() + pos + 1, leaf->mCount - pos - 1 );
+  move_backward_type( leaf->values() + pos, leaf->values() + pos + 1, leaf->mCount - pos - 1 );
+  leaf->mCount--;
+  mSize--;
+
+  if( leaf->mCount == 0 ) {
+    if( leaf->mPrev ) {
+      leaf->mPrev->mNext = leaf->mNext;
+    } else {
+      mFirst = leaf->mNext;
+    }
+    if( leaf->mNext ) {
+      leaf->mNext->mPrev = leaf->mPrev;
+    } else {
+      mLast = leaf->mPrev;
+    }
+    btree_detail::free_node( leaf );
+    _remove_child( path, path.mDepth );
+  }
+  return NO_ERROR;
+}
+
+template<typename TKey, typename TValue>
+void BTreeImpl<TKey, TValue>::_remove_child( Path& path, size_t level )
+{
+  // the child at path level was freed, drop it from its parent
+  while( level > 0 ) {
+    Inner* parent = path.mNodes[level - 1];
+    const size_t slot = path.mSlots[level - 1];
+    if( parent->mCount == 0 ) {
+      // that was its only child
+      btree_detail::free_node( parent );
+      level--;
+      continue;
+    }
+    const size_t k = slot > 0 ? slot - 1 : 0;
+    destroy_type( parent->keys() + k, 1 );
+    move_backward_type( parent->keys() + k, parent->keys() + k + 1, parent->mCount - k - 1 );
+    memmove( parent->mChildren + slot, parent->mChildren + slot + 1, ( parent->mCount - slot ) * sizeof( Node* ) );
+    parent->mCount--;
+    break;
+  }
+  if( level == 0 ) {
+    mRoot = 0;
+    return;
+  }
+  while( !mRoot->mLeaf && mRoot->mCount == 0 ) {
+    Inner* root = static_cast<Inner*>( mRoot );
+    mRoot = root->mChildren[0];
+    btree_detail::free_node( root );
+  }
+}
+
+template<typename TKey, typename TValue> template<typename Source>
+status_t BTreeImpl<TKey, TValue>::load( size_t count, Source& source )
+{
+  clear();
+  if( count == 0 ) {
+    return NO_ERROR;
+  }
+
+  // allocate every node first so that failing leaves an empty tree
+  const size_t leaves = ( count + kLeafCapacity - 1 ) / kLeafCapacity;
+  size_t total = leaves;
+  for( size_t n = leaves; n > 1; ) {
+    n = ( n + kInnerCapacity ) / ( kInnerCapacity + 1 );
+    total += n;
+  }
+  Node** nodes = static_cast<Node**>( malloc( total * sizeof( Node* ) ) );
+  const TKey** mins = static_cast<const TKey**>( malloc( leaves * sizeof( TKey* ) ) );
+  if( !nodes || !mins ) {
+    free( nodes );
+    free( mins );
+    return NO_MEMORY;
+  }
+  for( size_t i = 0; i < total; i++ ) {
+    nodes[i] = static_cast<Node*>( btree_detail::alloc_node( i < leaves ? sizeof( Leaf ) : sizeof( Inner ) ) );
+    if( !nodes[i] ) {
+      while( i-- ) {
+        btree_detail::free_node( nodes[i] );
+      }
+      free( nodes );
+      free( mins );
+      return NO_MEMORY;
+    }
+  }
+
+  // spread the entries evenly over the leaves
+  Leaf* prev = 0;
+  for( size_t i = 0; i < leaves; i++ ) {
+    Leaf* leaf = static_cast<Leaf*>( nodes[i] );
+    leaf->mLeaf = 1;
+    leaf->mCount = count / leaves + ( i < count % leaves ? 1 : 0 );
+    for( size_t j = 0; j < leaf->mCount; j++ ) {
+      source.next( leaf->keys() + j, leaf->values() + j );
+    }
+    leaf->mPrev = prev;
+    leaf->mNext = 0;
+    if( prev ) {
+      prev->mNext = leaf;
+    }
+    prev = leaf;
+    mins[i] = leaf->keys();
+  }
+  mFirst = static_cast<Leaf*>( nodes[0] );
+  mLast = prev;
+
+  // then build the inner levels bottom up
+  Node** level = nodes;
+  size_t n = leaves;
+  while( n > 1 ) {
+    Node** parents = level + n;
+    const size_t parentCount = ( n + kInnerCapacity ) / ( kInnerCapacity + 1 );
+    size_t c = 0;
+    for( size_t p = 0; p < parentCount; p++ ) {
+      Inner* inner = static_cast<Inner*>( parents[p] );
+      const size_t children = n / parentCount + ( p < n % parentCount ? 1 : 0 );
+      inner->mLeaf = 0;
+      inner->mCount = children - 1;
+      for( size_t j = 0; j < children; j++ ) {
+        inner->mChildren[j] = level[c + j];
+        if( j > 0 ) {
+          new( inner->keys() + j - 1 ) TKey( *mins[c + j] );
+        }
+      }
+      mins[p] = mins[c];
+      c += children;
+    }
+    level = parents;
+    n = parentCount;
+  }
+  mRoot = level[0];
+  mSize = count;
+
+  free( nodes );
+  free( mins );
+  return NO_ERROR;
+}
+
+} // namespace baseline
+
+#endif // BASELINE_BTREE_H_
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_BTREEMAP_H_
+#define BASELINE_BTREEMAP_H_
+
+#include <baseline/BTree.h>
+#include <baseline/SortedVector.h>
+#include <baseline/TypeHelpers.h>
+#include <baseline/Vector.h>
+
+namespace baseline {
+
+/*!
+ * Ordered map from keys to values, kept in a B+tree. Keys are compared
+ * with strictly_order_type(). Lookups and updates take O(log n) and a
+ * handful of cache lines, and entries can be walked in key order from
+ * any position:
+ *
+ *   for( BTreeMap<K, V>::Iterator it = map.lowerBound( lo );
+ *        it.isValid() && it.key() < hi; it.next() ) {
+ *     use( it.key(), it.value() );
+ *   }
+ *
+ * Unlike Vector, copies are deep.
+ */
+template <typename TKey, typename TValue>
+class BTreeMap : private BTreeImpl<TKey, TValue>
+{
+  typedef BTreeImpl<TKey, TValue> Impl;
+
+public:
+  typedef TKey    key_type;
+  typedef TValue  value_type;
+  typedef key_value_pair_t<TKey, TValue> entry_type;
+  typedef typename Impl::Iterator Iterator;
+
+  /*!
+   * Constructors and destructors
+   */
+
+  BTreeMap() {}
+  BTreeMap( const BTreeMap<TKey, TValue>& rhs ) : Impl( rhs ) {}
+  BTreeMap( BTreeMap<TKey, TValue>&& rhs ) : Impl( std::move( rhs ) ) {}
+
+  /*! copy operator */
+  BTreeMap<TKey, TValue>& operator = ( const BTreeMap<TKey, TValue>& rhs ) {
+    Impl::operator = ( rhs );
+    return *this;
+  }
+
+  /*! move operator, rhs is left empty */
+  BTreeMap<TKey, TValue>& operator = ( BTreeMap<TKey, TValue>&& rhs ) {
+    Impl::operator = ( std::move( rhs ) );
+    return *this;
+  }
+
+  /*
+   * empty the map
+   */
+
+  inline void clear() {
+    Impl::clear();
+  }
+
+  /*!
+   * map stats
+   */
+
+  //! returns number of entries in the map
+  inline size_t size() const {
+    return Impl::size();
+  }
+  //! returns whether or not the map is empty
+  inline bool isEmpty() const {
+    return Impl::isEmpty();
+  }
+
+  /*!
+   * accessors
+   */
+
+  //! first entry, invalid if the map is empty
+  inline Iterator begin() const {
+    return Impl::begin();
+  }
+  //! last entry, walk backwards with prev()
+  inline Iterator last() const {
+    return Impl::last();
+  }
+  //! entry for key, invalid if there is none
+  inline Iterator find( const TKey& key ) const {
+    return Impl::find( key );
+  }
+  //! first entry whose key is not less than key
+  inline Iterator lowerBound( const TKey& key ) const {
+    return Impl::lowerBound( key );
+  }
+  //! first entry whose key is greater than key
+  inline Iterator upperBound( const TKey& key ) const {
+    return Impl::upperBound( key );
+  }
+
+  //! whether there is an entry for key
+  inline bool hasKey( const TKey& key ) const {
+    return Impl::find( key ).isValid();
+  }
+
+  //! value for key, which must be in the map
+  const TValue& valueFor( const TKey& key ) const;
+  TValue& editValueFor( const TKey& key );
+
+  /*!
+   * modifying the map
+   */
+
+  //! adds an entry, or replaces the value of the one for key
+  inline status_t add( const TKey& key, const TValue& value ) {
+    return Impl::insert( key, value );
+  }
+  inline status_t add( const TKey& key, TValue&& value ) {
+    return Impl::insert( key, std::move( value ) );
+  }
+  inline status_t add( TKey&& key, TValue&& value ) {
+    return Impl::insert( std::move( key ), std::move( value ) );
+  }
+
+  //! removes the entry for key. returns NAME_NOT_FOUND if there is none
+  inline status_t removeItem( const TKey& key ) {
+    return Impl::erase( key );
+  }
+
+  /*!
+   * replaces the content of the map with entries, which must be sorted
+   * by strictly ascending keys, much faster than adding them one by one.
+   * returns BAD_VALUE and leaves the map untouched otherwise.
+   */
+  status_t bulkLoad( const Vector<entry_type>& entries );
+  status_t bulkLoad( const SortedVector<entry_type>& entries );
+
+private:
+  struct ArraySource;
+  status_t _bulkLoad( const entry_type* entries, size_t count );
+};
+
+// ---------------------------------------------------------------------------
+// No user serviceable parts from here...
+// ---------------------------------------------------------------------------
+
+template<typename TKey, typename TValue>
+struct BTreeMap<TKey, TValue>::ArraySource {
+  ArraySource( const entry_type* entries ) : mEntries( entries ) {}
+  inline void next( TKey* key, TValue* value ) {
+    new( key ) TKey( mEntries->key );
+    new( value ) TValue( mEntries->value );
+    mEntries++;
+  }
+  const entry_type* mEntries;
+};
+
+template<typename TKey, typename TValue> inline
+const TValue& BTreeMap<TKey, TValue>::valueFor( const TKey& key ) const
+{
+  const Iterator it = Impl::find( key );
+  LOG_FATAL_IF( !it.isValid(), "%s: key not found", __PRETTY_FUNCTION__ );
+  return it.value();
+}
+
+template<typename TKey, typename TValue> inline
+TValue& BTreeMap<TKey, TValue>::editValueFor( const TKey& key )
+{
+  TValue* value = Impl::edit( key );
+  LOG_FATAL_IF( !value, "%s: key not found", __PRETTY_FUNCTION__ );
+  return *value;
+}
+
+template<typename TKey, typename TValue> inline
+status_t BTreeMap<TKey, TValue>::bulkLoad( const Vector<entry_type>& entries )
+{
+  return _bulkLoad( entries.array(), entries.size() );
+}
+
+template<typename TKey, typename TValue> inline
+status_t BTreeMap<TKey, TValue>::bulkLoad( const SortedVector<entry_type>& entries )
+{
+  return _bulkLoad( entries.array(), entries.size() );
+}
+
+template<typename TKey, typename TValue>
+status_t BTreeMap<TKey, TValue>::_bulkLoad( const entry_type* entries, size_t count )
+{
+  for( size_t i = 1; i < count; i++ ) {
+    if( !strictly_order_type( entries[i - 1].key, entries[i].key ) ) {
+      return BAD_VALUE;
+    }
+  }
+  ArraySource source( entries );
+  return Impl::load( count, source );
+}
+
+} // namespace baseline
+
+#endif // BASELINE_BTREEMAP_H_
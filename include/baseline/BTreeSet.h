@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_BTREESET_H_
+#define BASELINE_BTREESET_H_
+
+#include <baseline/BTree.h>
+#include <baseline/SortedVector.h>
+#include <baseline/TypeHelpers.h>
+#include <baseline/Vector.h>
+
+namespace baseline {
+
+/*!
+ * Ordered set of items, kept in a B+tree like a BTreeMap without values.
+ * Walk through a range with lowerBound() and Iterator::next(), the item
+ * is the iterator's key().
+ */
+template <typename TYPE>
+class BTreeSet : private BTreeImpl<TYPE, btree_detail::NoValue>
+{
+  typedef BTreeImpl<TYPE, btree_detail::NoValue> Impl;
+
+public:
+  typedef TYPE value_type;
+  typedef typename Impl::Iterator Iterator;
+
+  /*!
+   * Constructors and destructors
+   */
+
+  BTreeSet() {}
+  BTreeSet( const BTreeSet<TYPE>& rhs ) : Impl( rhs ) {}
+  BTreeSet( BTreeSet<TYPE>&& rhs ) : Impl( std::move( rhs ) ) {}
+
+  /*! copy operator */
+  BTreeSet<TYPE>& operator = ( const BTreeSet<TYPE>& rhs ) {
+    Impl::operator = ( rhs );
+    return *this;
+  }
+
+  /*! move operator, rhs is left empty */
+  BTreeSet<TYPE>& operator = ( BTreeSet<TYPE>&& rhs ) {
+    Impl::operator = ( std::move( rhs ) );
+    return *this;
+  }
+
+  /*
+   * empty the set
+   */
+
+  inline void clear() {
+    Impl::clear();
+  }
+
+  /*!
+   * set stats
+   */
+
+  //! returns number of items in the set
+  inline size_t size() const {
+    return Impl::size();
+  }
+  //! returns whether or not the set is empty
+  inline bool isEmpty() const {
+    return Impl::isEmpty();
+  }
+
+  /*!
+   * accessors
+   */
+
+  inline Iterator begin() const {
+    return Impl::begin();
+  }
+  inline Iterator last() const {
+    return Impl::last();
+  }
+  inline Iterator find( const TYPE& item ) const {
+    return Impl::find( item );
+  }
+  inline Iterator lowerBound( const TYPE& item ) const {
+    return Impl::lowerBound( item );
+  }
+  inline Iterator upperBound( const TYPE& item ) const {
+    return Impl::upperBound( item );
+  }
+  inline bool contains( const TYPE& item ) const {
+    return Impl::find( item ).isValid();
+  }
+
+  /*!
+   * modifying the set
+   */
+
+  //! adds an item, or replaces the equal one already in the set
+  inline status_t add( const TYPE& item ) {
+    return _add( item );
+  }
+  inline status_t add( TYPE&& item ) {
+    return _add( std::move( item ) );
+  }
+
+  //! removes an item. returns NAME_NOT_FOUND if it is not in the set
+  inline status_t remove( const TYPE& item ) {
+    return Impl::erase( item );
+  }
+
+  /*!
+   * replaces the content of the set with items, which must be strictly
+   * ascending. returns BAD_VALUE and leaves the set untouched otherwise.
+   */
+  status_t bulkLoad( const Vector<TYPE>& items );
+  status_t bulkLoad( const SortedVector<TYPE>& items );
+
+private:
+  struct ArraySource;
+  template<typename T> status_t _add( T&& item );
+  status_t _bulkLoad( const TYPE* items, size_t count );
+};
+
+// ---------------------------------------------------------------------------
+// No user serviceable parts from here...
+// ---------------------------------------------------------------------------
+
+template<typename TYPE>
+struct BTreeSet<TYPE>::ArraySource {
+  ArraySource( const TYPE* items ) : mItems( items ) {}
+  inline void next( TYPE* item, btree_detail::NoValue* value ) {
+    new( item ) TYPE( *mItems++ );
+    new( value ) btree_detail::NoValue();
+  }
+  const TYPE* mItems;
+};
+
+template<typename TYPE> template<typename T> inline
+status_t BTreeSet<TYPE>::_add( T&& item )
+{
+  // an equal item is only replaced if TYPE orders on part of its content
+  const Iterator it = Impl::find( item );
+  if( it.isValid() ) {
+    const_cast<TYPE&>( it.key() ) = std::forward<T>( item );
+    return NO_ERROR;
+  }
+  return Impl::insert( std::forward<T>( item ), btree_detail::NoValue() );
+}
+
+template<typename TYPE> inline
+status_t BTreeSet<TYPE>::bulkLoad( const Vector<TYPE>& items )
+{
+  return _bulkLoad( items.array(), items.size() );
+}
+
+template<typename TYPE> inline
+status_t BTreeSet<TYPE>::bulkLoad( const SortedVector<TYPE>& items )
+{
+  return _bulkLoad( items.array(), items.size() );
+}
+
+template<typename TYPE>
+status_t BTreeSet<TYPE>::_bulkLoad( const TYPE* items, size_t count )
+{
+  for( size_t i = 1; i < count; i++ ) {
+    if( !strictly_order_type( items[i - 1], items[i] ) ) {
+      return BAD_VALUE;
+    }
+  }
+  ArraySource source( items );
+  return Impl::load( count, source );
+}
+
+} // namespace baseline
+
+#endif // BASELINE_BTREESET_H_
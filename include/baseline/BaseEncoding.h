@@ -24,18 +24,79 @@ namespace baseline {
 
 class SharedBuffer;
 
+/**
+ * Binary to text encoding. encode() and decode() work on whole buffers;
+ * EncodingOutputStream and DecodingInputStream (see Streams.h) work on
+ * streams through encodeInto() and decodeInto().
+ */
 class BaseEncoding
 {
 public:
   virtual ~BaseEncoding();
   String8 encode( SharedBuffer* ) const;
-  virtual String8 encode( void* buf, size_t len ) const = 0;
-  virtual SharedBuffer* decode( const String8& ) const = 0;
+  String8 encode( const void* buf, size_t len ) const;
+
+  /**
+   * Returns a new SharedBuffer with the bytes str encodes, which the
+   * caller must release, or nullptr if str is not a valid encoding.
+   */
+  SharedBuffer* decode( const String8& str ) const;
+
+  //! the number of characters len bytes encode to
+  virtual size_t encodedLength( size_t len ) const = 0;
+
+  //! the most bytes len characters can decode to
+  virtual size_t decodedLength( size_t len ) const = 0;
+
+  /**
+   * Encodes len bytes at src to the encodedLength( len ) characters at
+   * dst, without a terminating null. When len is not a multiple of
+   * groupBytes() the last group is partial, so only the end of a text
+   * should be encoded that way.
+   */
+  virtual void encodeInto( const void* src, size_t len, char* dst ) const = 0;
+
+  /**
+   * Decodes len characters at src to dst, which must have room for
+   * decodedLength( len ) bytes, and returns how many bytes that was, or
+   * BAD_VALUE if src is not valid.
+   */
+  virtual ssize_t decodeInto( const char* src, size_t len, uint8_t* dst ) const = 0;
+
+  /**
+   * Text is made of groups of groupChars() characters that each hold
+   * groupBytes() bytes, so that it can be encoded and decoded in pieces
+   * that are whole groups.
+   */
+  virtual size_t groupBytes() const = 0;
+  virtual size_t groupChars() const = 0;
 
 };
 
+/**
+ * Lowercase hex, two characters per byte. Decoding accepts either case.
+ */
 BaseEncoding& hexEncoding();
 
+/**
+ * Base64 as in RFC 4648 section 4, padded with '='. Decoding also
+ * accepts text without the padding.
+ */
+BaseEncoding& base64Encoding();
+
+/**
+ * The URL and file name safe Base64 of RFC 4648 section 5 ('-' and '_'
+ * instead of '+' and '/'), without padding. Decoding accepts it either
+ * way.
+ */
+BaseEncoding& base64UrlEncoding();
+
+/**
+ * Base32 as in RFC 4648 section 6, uppercase and padded with '='.
+ * Decoding accepts either case, with or without the padding.
+ */
+BaseEncoding& base32Encoding();
+
 } // namespace
 
 #endif // BASELINE_BASEENCODING_H_
\ No newline at end of file
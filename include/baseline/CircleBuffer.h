@@ -18,6 +18,10 @@
 #ifndef BASELINE_CIRCLEBUFFER_H_
 #define BASELINE_CIRCLEBUFFER_H_
 
+#include <baseline/TypeHelpers.h>
+
+#include <string.h>
+
 namespace baseline {
 
 template<typename T>
@@ -45,13 +49,23 @@ public:
   inline
   void clear();
 
+  /**
+   * Copies up to size items into the buffer, wrapping around the end if
+   * needed, and returns how many were copied (at most available()).
+   */
   uint32_t write( const T* buf, uint32_t size );
   void put( const T& v );
 
+  /**
+   * Copies up to size items out of the buffer, wrapping around the end if
+   * needed, and returns how many were copied (at most size()).
+   */
   uint32_t read( T* buf, uint32_t size );
   T get();
 
 private:
+  static void copy( T* dest, const T* src, uint32_t n );
+
   uint32_t mCapacity;
   uint32_t mSize;
   uint32_t mHead;
@@ -115,16 +129,30 @@ void CircleBuffer<T>::clear()
   mTail = 0;
 }
 
+template<typename T>
+void CircleBuffer<T>::copy( T* dest, const T* src, uint32_t n )
+{
+  if( traits<T>::has_trivial_copy ) {
+    memcpy( dest, src, n * sizeof( T ) );
+  } else {
+    for( uint32_t i = 0; i < n; i++ ) {
+      dest[i] = src[i];
+    }
+  }
+}
+
 template <typename T>
 uint32_t CircleBuffer<T>::write( const T* buf, uint32_t size )
 {
-  uint32_t len = MIN( size, mCapacity - mSize );
-  len = MIN( len, mCapacity - mHead );
-  for( uint32_t i = 0; i < len; i++ ) {
-    mData[mHead + i] = buf[i];
+  const uint32_t len = MIN( size, mCapacity - mSize );
+  const uint32_t first = MIN( len, mCapacity - mHead );
+  copy( mData + mHead, buf, first );
+  copy( mData, buf + first, len - first );
+
+  mHead += len;
+  if( mHead >= mCapacity ) {
+    mHead -= mCapacity;
   }
-
-  mHead = ( mHead + len ) % mCapacity;
   mSize += len;
   return len;
 }
@@ -132,13 +160,15 @@ uint32_t CircleBuffer<T>::write( const T* buf, uint32_t size )
 template <typename T>
 uint32_t CircleBuffer<T>::read( T* buf, uint32_t size )
 {
-  uint32_t len = MIN( size, mSize );
-  len = MIN( len, mCapacity - mTail );
-  for( uint32_t i = 0; i < len; i++ ) {
-    buf[i] = mData[mTail + i];
+  const uint32_t len = MIN( size, mSize );
+  const uint32_t first = MIN( len, mCapacity - mTail );
+  copy( buf, mData + mTail, first );
+  copy( buf + first, mData, len - first );
+
+  mTail += len;
+  if( mTail >= mCapacity ) {
+    mTail -= mCapacity;
   }
-
-  mTail = ( mTail + len ) % mCapacity;
   mSize -= len;
   return len;
 }
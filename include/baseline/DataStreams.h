@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_DATASTREAMS_H_
+#define BASELINE_DATASTREAMS_H_
+
+#include <baseline/Streams.h>
+#include <baseline/String8.h>
+#include <baseline/Vector.h>
+
+#include <type_traits>
+
+namespace baseline {
+
+class SharedBuffer;
+
+namespace data_detail {
+
+inline uint8_t byteswap( uint8_t value )
+{
+  return value;
+}
+
+inline uint16_t byteswap( uint16_t value )
+{
+  return __builtin_bswap16( value );
+}
+
+inline uint32_t byteswap( uint32_t value )
+{
+  return __builtin_bswap32( value );
+}
+
+inline uint64_t byteswap( uint64_t value )
+{
+  return __builtin_bswap64( value );
+}
+
+//! the unsigned integer with the size of T
+template<size_t N> struct bits_type;
+template<> struct bits_type<1> {
+  typedef uint8_t type;
+};
+template<> struct bits_type<2> {
+  typedef uint16_t type;
+};
+template<> struct bits_type<4> {
+  typedef uint32_t type;
+};
+template<> struct bits_type<8> {
+  typedef uint64_t type;
+};
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static const bool kBigEndianHost = true;
+#else
+static const bool kBigEndianHost = false;
+#endif
+
+//! stores value at p, big endian if bigEndian and little endian otherwise
+template<typename T>
+inline void store( uint8_t* p, T value, bool bigEndian )
+{
+  typename bits_type<sizeof( T )>::type bits;
+  memcpy( &bits, &value, sizeof( T ) );
+  if( bigEndian != kBigEndianHost ) {
+    bits = byteswap( bits );
+  }
+  memcpy( p, &bits, sizeof( T ) );
+}
+
+template<typename T>
+inline T load( const uint8_t* p, bool bigEndian )
+{
+  typename bits_type<sizeof( T )>::type bits;
+  memcpy( &bits, p, sizeof( T ) );
+  if( bigEndian != kBigEndianHost ) {
+    bits = byteswap( bits );
+  }
+  T value;
+  memcpy( &value, &bits, sizeof( T ) );
+  return value;
+}
+
+inline uint64_t zigzag( int64_t value )
+{
+  return ( uint64_t( value ) << 1 ) ^ uint64_t( value >> 63 );
+}
+
+inline int64_t unzigzag( uint64_t value )
+{
+  return int64_t( value >> 1 ) ^ -int64_t( value & 1 );
+}
+
+static const size_t kMaxVarintSize = 10;
+
+//! counted fields are read into storage that starts at this many bytes
+//! and doubles as the data arrives, so a bogus count costs nothing
+static const size_t kFirstChunkSize = 64 * 1024;
+
+//! how many of count elements to have room for once done have arrived
+inline size_t nextChunk( size_t done, size_t count, size_t elementSize )
+{
+  size_t chunk = kFirstChunkSize / elementSize;
+  if( chunk < done ) {
+    chunk = done;
+  }
+  return count - done <= chunk ? count : done + chunk;
+}
+
+} // namespace data_detail
+
+/**
+ * Writes typed fields to an OutputStream through a buffer, so that a
+ * field costs a few stores and out sees one write() per buffer full.
+ *
+ *  - writeLE() and writeBE(): integers, float and double at their full
+ *    width, little or big endian.
+ *  - writeVarint(): LEB128, 7 bits per byte, low bits first, so that
+ *    small values take one byte. writeZigzag() does the same for signed
+ *    values, mapping 0, -1, 1, -2 ... to 0, 1, 2, 3 ...
+ *  - writeString(), writeBuffer() and writeArray(): a varint count, then
+ *    the bytes or elements (little endian).
+ *
+ * Every write returns OK or the error out returned, which sticks: later
+ * writes return it too. Nothing reaches out before flush(), close() or a
+ * full buffer; the destructor does not flush.
+ */
+class DataOutputStream : public OutputStream
+{
+public:
+  explicit DataOutputStream( OutputStream& out, size_t bufferSize = 4096 );
+  ~DataOutputStream();
+
+  //! writes what is buffered to out
+  status_t flush();
+
+  //! flushes and closes out
+  void close();
+
+  //! buffered raw bytes, returns len or an error
+  int write( uint8_t* buf, size_t off, size_t len );
+
+  status_t writeBytes( const void* data, size_t len );
+
+  template<typename T>
+  inline status_t writeLE( T value ) {
+    return writeFixed( value, false );
+  }
+
+  template<typename T>
+  inline status_t writeBE( T value ) {
+    return writeFixed( value, true );
+  }
+
+  inline status_t writeVarint( uint64_t value ) {
+    if( mPos + data_detail::kMaxVarintSize > mCapacity && makeRoom( data_detail::kMaxVarintSize ) != OK ) {
+      return mError;
+    }
+    uint8_t* p = &mBuffer[mPos];
+    while( value >= 0x80 ) {
+      *p++ = uint8_t( value | 0x80 );
+      value >>= 7;
+    }
+    *p++ = uint8_t( value );
+    mPos = p - mBuffer;
+    return OK;
+  }
+
+  inline status_t writeZigzag( int64_t value ) {
+    return writeVarint( data_detail::zigzag( value ) );
+  }
+
+  status_t writeString( const String8& str );
+
+  //! the size of buf and its bytes, which a null buf writes as empty
+  status_t writeBuffer( const SharedBuffer* buf );
+
+  template<typename T>
+  status_t writeArray( const T* array, size_t count );
+
+  template<typename T>
+  inline status_t writeArray( const Vector<T>& vector ) {
+    return writeArray( vector.array(), vector.size() );
+  }
+
+  //! bytes given to this stream so far, buffered or not
+  inline uint64_t count() const {
+    return mFlushed + mPos;
+  }
+
+private:
+  template<typename T>
+  inline status_t writeFixed( T value, bool bigEndian ) {
+    static_assert( std::is_arithmetic<T>::value, "only integers and floating point" );
+    if( mPos + sizeof( T ) > mCapacity && makeRoom( sizeof( T ) ) != OK ) {
+      return mError;
+    }
+    data_detail::store( &mBuffer[mPos], value, bigEndian );
+    mPos += sizeof( T );
+    return OK;
+  }
+
+  //! flushes so that len more bytes fit
+  status_t makeRoom( size_t len );
+
+  OutputStream& mOut;
+  uint8_t* mBuffer;
+  size_t mCapacity;
+  size_t mPos;
+  uint64_t mFlushed;
+  status_t mError;
+};
+
+/**
+ * Reads the fields DataOutputStream writes from an InputStream, through
+ * a buffer. A read returns OK, NOT_ENOUGH_DATA if the stream ended inside
+ * the field, BAD_VALUE for a varint longer than 64 bits or a count too
+ * large to allocate, or the error in returned. Errors stick, and a read
+ * that runs out of data leaves what it was given to fill alone. Strings,
+ * buffers and arrays grow as their bytes arrive rather than allocating
+ * whatever their count claims up front.
+ */
+class DataInputStream : public InputStream
+{
+public:
+  explicit DataInputStream( InputStream& in, size_t bufferSize = 4096 );
+  ~DataInputStream();
+
+  //! closes in
+  void close();
+
+  //! buffered raw bytes, returns how many or -1 at the end
+  int read( uint8_t* buf, size_t off, size_t len );
+
+  //! exactly len bytes
+  status_t readBytes( void* data, size_t len );
+
+  template<typename T>
+  inline status_t readLE( T* value ) {
+    return readFixed( value, false );
+  }
+
+  template<typename T>
+  inline status_t readBE( T* value ) {
+    return readFixed( value, true );
+  }
+
+  inline status_t readVarint( uint64_t* value ) {
+    // a whole varint is buffered unless the stream is about to end
+    if( mEnd - mPos < data_detail::kMaxVarintSize ) {
+      return readVarintSlow( value );
+    }
+    const uint8_t* p = &mBuffer[mPos];
+    uint64_t result = 0;
+    for( int shift = 0; shift < 64; shift += 7 ) {
+      const uint8_t byte = *p++;
+      result |= uint64_t( byte & 0x7F ) << shift;
+      if( byte < 0x80 ) {
+        if( shift == 63 && byte > 1 ) {
+          break;
+        }
+        mPos = p - mBuffer;
+        *value = result;
+        return OK;
+      }
+    }
+    return mError = BAD_VALUE;
+  }
+
+  inline status_t readZigzag( int64_t* value ) {
+    uint64_t raw;
+    const status_t err = readVarint( &raw );
+    if( err == OK ) {
+      *value = data_detail::unzigzag( raw );
+    }
+    return err;
+  }
+
+  status_t readString( String8* str );
+
+  //! *buf is set to a new SharedBuffer, which the caller must release
+  status_t readBuffer( SharedBuffer** buf );
+
+  //! replaces the contents of vector
+  template<typename T>
+  status_t readArray( Vector<T>* vector );
+
+private:
+  template<typename T>
+  inline status_t readFixed( T* value, bool bigEndian ) {
+    static_assert( std::is_arithmetic<T>::value, "only integers and floating point" );
+    if( mEnd - mPos < sizeof( T ) ) {
+      const status_t err = fill( sizeof( T ) );
+      if( err != OK ) {
+        return err;
+      }
+    }
+    *value = data_detail::load<T>( &mBuffer[mPos], bigEndian );
+    mPos += sizeof( T );
+    return OK;
+  }
+
+  //! reads until len bytes are buffered, or the stream ends
+  status_t fill( size_t len );
+  status_t readVarintSlow( uint64_t* value );
+  status_t readCount( uint64_t* count, size_t elementSize );
+
+  InputStream& mIn;
+  uint8_t* mBuffer;
+  size_t mCapacity;
+  size_t mPos;
+  size_t mEnd;
+  bool mEof;
+  status_t mError;
+};
+
+template<typename T>
+status_t DataOutputStream::writeArray( const T* array, size_t count )
+{
+  static_assert( std::is_arithmetic<T>::value, "only integers and floating point" );
+  status_t err = writeVarint( count );
+  if( err != OK || count == 0 ) {
+    return err;
+  }
+  if( sizeof( T ) == 1 || !data_detail::kBigEndianHost ) {
+    return writeBytes( array, count * sizeof( T ) );
+  }
+  for( size_t i = 0; i < count && err == OK; i++ ) {
+    err = writeLE( array[i] );
+  }
+  return err;
+}
+
+template<typename T>
+status_t DataInputStream::readArray( Vector<T>* vector )
+{
+  static_assert( std::is_arithmetic<T>::value, "only integers and floating point" );
+  uint64_t count;
+  status_t err = readCount( &count, sizeof( T ) );
+  if( err != OK ) {
+    return err;
+  }
+  Vector<T> result;
+  size_t done = 0;
+  while( done < count ) {
+    const size_t want = data_detail::nextChunk( done, count, sizeof( T ) );
+    if( result.insertAt( T(), done, want - done ) < 0 ) {
+      return NO_MEMORY;
+    }
+    T* array = result.editArray();
+    if( sizeof( T ) == 1 || !data_detail::kBigEndianHost ) {
+      err = readBytes( &array[done], ( want - done ) * sizeof( T ) );
+    } else {
+      for( size_t i = done; i < want && err == OK; i++ ) {
+        err = readLE( &array[i] );
+      }
+    }
+    if( err != OK ) {
+      return err;
+    }
+    done = want;
+  }
+  *vector = result;
+  return OK;
+}
+
+} // namespace
+
+#endif // BASELINE_DATASTREAMS_H_
@@ -68,6 +68,14 @@ public:
    */
   virtual sp<Future> scheduleWithFixedDelay( const sp<Runnable>&, uint32_t delayMS ) = 0;
 
+  /**
+   * number of worker threads running tasks. Executors that do not say
+   * count as one, so parallel operations on them do not fan out.
+   */
+  virtual int getNumThreads() const {
+    return 1;
+  }
+
 };
 
 }
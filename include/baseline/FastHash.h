@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_FASTHASH_H_
+#define BASELINE_FASTHASH_H_
+
+#include <string.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+  #include <intrin.h>
+#endif
+
+namespace baseline {
+
+/**
+ * 128 bit result of hash128().
+ */
+struct Hash128 {
+  uint64_t low;
+  uint64_t high;
+
+  inline bool operator == ( const Hash128& rhs ) const {
+    return low == rhs.low && high == rhs.high;
+  }
+  inline bool operator != ( const Hash128& rhs ) const {
+    return !( *this == rhs );
+  }
+};
+
+namespace hash_detail {
+
+static const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+static const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+// keys for inputs of up to 16 bytes, which do not read the secret
+static const uint64_t kShortKey1 = 0xBE4BA423396CFEB8ull;
+static const uint64_t kShortKey2 = 0x1CAD21F72C81017Cull;
+static const uint64_t kShortKey3 = 0xDB979083E96DD4DEull;
+static const uint64_t kShortKey4 = 0x1F67B3B7A4A44072ull;
+
+// mixed into the seed for the high half of short hash128() results, so
+// that it differs from what hash64() returns for the same seed
+static const uint64_t kHighSeed = 0x9FB21C651E98DF25ull;
+
+inline uint64_t read64( const uint8_t* p )
+{
+  uint64_t value;
+  memcpy( &value, p, sizeof( value ) );
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64( value );
+#endif
+  return value;
+}
+
+inline uint32_t read32( const uint8_t* p )
+{
+  uint32_t value;
+  memcpy( &value, p, sizeof( value ) );
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap32( value );
+#endif
+  return value;
+}
+
+inline uint64_t rotl64( uint64_t value, int bits )
+{
+  return ( value << bits ) | ( value >> ( 64 - bits ) );
+}
+
+//! the 128 bit product of lhs and rhs, high half xor low half
+inline uint64_t mul128_fold64( uint64_t lhs, uint64_t rhs )
+{
+#if defined(__SIZEOF_INT128__)
+  const unsigned __int128 product = ( unsigned __int128 )lhs * rhs;
+  return uint64_t( product ) ^ uint64_t( product >> 64 );
+#elif defined(_MSC_VER) && defined(_M_X64)
+  uint64_t high;
+  const uint64_t low = _umul128( lhs, rhs, &high );
+  return low ^ high;
+#else
+  const uint64_t lo_lo = ( lhs & 0xFFFFFFFF ) * ( rhs & 0xFFFFFFFF );
+  const uint64_t hi_lo = ( lhs >> 32 ) * ( rhs & 0xFFFFFFFF );
+  const uint64_t lo_hi = ( lhs & 0xFFFFFFFF ) * ( rhs >> 32 );
+  const uint64_t hi_hi = ( lhs >> 32 ) * ( rhs >> 32 );
+  const uint64_t cross = ( lo_lo >> 32 ) + ( hi_lo & 0xFFFFFFFF ) + lo_hi;
+  const uint64_t upper = ( hi_lo >> 32 ) + ( cross >> 32 ) + hi_hi;
+  const uint64_t lower = ( cross << 32 ) | ( lo_lo & 0xFFFFFFFF );
+  return lower ^ upper;
+#endif
+}
+
+inline uint64_t avalanche( uint64_t h )
+{
+  h ^= h >> 37;
+  h *= 0x165667919E3779F9ull;
+  return h ^ ( h >> 32 );
+}
+
+inline uint64_t avalanche_xmx( uint64_t h )
+{
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  return h ^ ( h >> 32 );
+}
+
+inline uint64_t avalanche_rrmxmx( uint64_t h, uint64_t len )
+{
+  h ^= rotl64( h, 49 ) ^ rotl64( h, 24 );
+  h *= 0x9FB21C651E98DF25ull;
+  h ^= ( h >> 35 ) + len;
+  h *= 0x9FB21C651E98DF25ull;
+  return h ^ ( h >> 28 );
+}
+
+//! inputs of up to 16 bytes
+inline uint64_t hash_short( const uint8_t* p, size_t len, uint64_t seed )
+{
+  if( len > 8 ) {
+    const uint64_t lo = read64( p ) ^ ( kShortKey1 + seed );
+    const uint64_t hi = read64( p + len - 8 ) ^ ( kShortKey2 - seed );
+    return avalanche( len + rotl64( lo, 29 ) + hi + mul128_fold64( lo, hi ) );
+  }
+  if( len >= 4 ) {
+    const uint64_t input = read32( p + len - 4 ) + ( uint64_t( read32( p ) ) << 32 );
+    return avalanche_rrmxmx( input ^ ( kShortKey3 + seed ), len );
+  }
+  if( len > 0 ) {
+    const uint32_t combined = ( uint32_t( p[0] ) << 16 ) | ( uint32_t( p[len >> 1] ) << 24 ) |
+                              uint32_t( p[len - 1] ) | ( uint32_t( len ) << 8 );
+    return avalanche_xmx( combined ^ ( ( kShortKey4 & 0xFFFFFFFF ) + seed ) );
+  }
+  return avalanche_xmx( seed ^ kShortKey4 );
+}
+
+uint64_t hash_long64( const uint8_t* p, size_t len, uint64_t seed );
+Hash128 hash_long128( const uint8_t* p, size_t len, uint64_t seed );
+
+} // namespace hash_detail
+
+/**
+ * Fast non-cryptographic 64 bit hash of len bytes, for hash table keys,
+ * dedup and checksums where an attacker is not a concern. Built like
+ * XXH3: keys of up to 16 bytes take a few multiplies inline, longer ones
+ * are mixed 16 bytes at a time against a secret, and inputs over 240 bytes
+ * run an accumulator loop that uses AVX2 or SSE2 where available. The
+ * result is the same on every platform, but not the same as XXH3's.
+ */
+inline uint64_t hash64( const void* data, size_t len, uint64_t seed = 0 )
+{
+  const uint8_t* p = static_cast<const uint8_t*>( data );
+  if( len <= 16 ) {
+    return hash_detail::hash_short( p, len, seed );
+  }
+  return hash_detail::hash_long64( p, len, seed );
+}
+
+/**
+ * 128 bit version of hash64(), for dedup of large numbers of chunks.
+ */
+inline Hash128 hash128( const void* data, size_t len, uint64_t seed = 0 )
+{
+  const uint8_t* p = static_cast<const uint8_t*>( data );
+  if( len <= 16 ) {
+    Hash128 result;
+    result.low = hash_detail::hash_short( p, len, seed );
+    result.high = hash_detail::hash_short( p, len, hash_detail::rotl64( seed, 32 ) ^ hash_detail::kHighSeed );
+    return result;
+  }
+  return hash_detail::hash_long128( p, len, seed );
+}
+
+} // namespace baseline
+
+#endif // BASELINE_FASTHASH_H_
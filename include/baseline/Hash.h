@@ -18,36 +18,116 @@
 #ifndef BASELINE_HASH_H_
 #define BASELINE_HASH_H_
 
+#include <string.h>
+
 #include <baseline/String8.h>
 #include <baseline/UniquePointer.h>
-#include <baseline/Comparable.h>
+#include <baseline/TypeHelpers.h>
 
 namespace baseline {
 
-class SharedBuffer;
-
-class HashCode : public Comparable<HashCode>
+/**
+ * A digest of up to kMaxSize bytes, held inline so that producing,
+ * copying and comparing one never allocates. Copies are plain memory
+ * copies. Ordered by size, then bytes.
+ */
+class HashCode
 {
 public:
-  HashCode( void* buf, size_t len );
-  HashCode( const HashCode& );
-  ~HashCode();
+  enum {
+    kMaxSize = 64
+  };
+
+  inline HashCode()
+    : mSize( 0 ) {}
+
+  //! len beyond kMaxSize is cut off
+  HashCode( const void* buf, size_t len );
+
+  inline const uint8_t* data() const {
+    return mData;
+  }
+  inline size_t size() const {
+    return mSize;
+  }
 
   String8 toHexString() const;
-  int compare( const HashCode& rhs ) const override;
+
+  inline int compare( const HashCode& rhs ) const {
+    if( mSize != rhs.mSize ) {
+      return int( mSize ) - int( rhs.mSize );
+    }
+    return memcmp( mData, rhs.mData, mSize );
+  }
+
+  inline bool operator==( const HashCode& rhs ) const {
+    return mSize == rhs.mSize && memcmp( mData, rhs.mData, mSize ) == 0;
+  }
+  inline bool operator!=( const HashCode& rhs ) const {
+    return !( *this == rhs );
+  }
+  inline bool operator<( const HashCode& rhs ) const {
+    return compare( rhs ) < 0;
+  }
+  inline bool operator<=( const HashCode& rhs ) const {
+    return compare( rhs ) <= 0;
+  }
+  inline bool operator>( const HashCode& rhs ) const {
+    return compare( rhs ) > 0;
+  }
+  inline bool operator>=( const HashCode& rhs ) const {
+    return compare( rhs ) >= 0;
+  }
 
 private:
-  SharedBuffer* mBuffer;
+  friend class HashFunction;
+
+  uint8_t mSize;
+  uint8_t mData[kMaxSize];
 };
 
+ANDROID_TRIVIAL_DTOR_TRAIT( HashCode )
+ANDROID_TRIVIAL_COPY_TRAIT( HashCode )
+ANDROID_TRIVIAL_MOVE_TRAIT( HashCode )
+
+inline int compare_type( const HashCode& lhs, const HashCode& rhs )
+{
+  return lhs.compare( rhs );
+}
+
+inline int strictly_order_type( const HashCode& lhs, const HashCode& rhs )
+{
+  return lhs.compare( rhs ) < 0;
+}
+
+// digests are uniformly distributed already, so their leading bytes will do
+template<> inline hash_t hash_type( const HashCode& value )
+{
+  hash_t hash = hash_t( value.size() );
+  memcpy( &hash, value.data(), MIN( value.size(), sizeof( hash ) ) );
+  return hash;
+}
+
 class HashFunction
 {
 public:
   virtual ~HashFunction();
   virtual void update( void* buf, size_t len ) = 0;
-  virtual HashCode finalize() = 0;
   virtual void reset() = 0;
 
+  /**
+   * Writes the digest of everything passed to update() since the last
+   * reset() to out, which must have room for HashCode::kMaxSize bytes,
+   * and returns how many bytes that was.
+   */
+  virtual size_t finalizeInto( void* out ) = 0;
+
+  inline HashCode finalize() {
+    HashCode code;
+    code.mSize = uint8_t( finalizeInto( code.mData ) );
+    return code;
+  }
+
 };
 
 /**
@@ -55,8 +135,59 @@ public:
  */
 up<HashFunction> createCRC32();
 
+/**
+ * Create a new HashFunction that computes CRC32C (Castagnoli), the CRC
+ * used by iSCSI, ext4 and most storage formats.
+ */
+up<HashFunction> createCRC32C();
+
+/**
+ * Create a new HashFunction that computes SHA1. Uses the SHA extensions
+ * (SHA-NI) where the CPU has them.
+ */
 up<HashFunction> createSHA1();
 
+/**
+ * Create a new HashFunction that computes SHA256. Uses the SHA extensions
+ * (SHA-NI) where the CPU has them.
+ */
+up<HashFunction> createSHA256();
+
+/**
+ * Create a new HashFunction that computes hash64() with the given seed,
+ * for input that arrives in pieces. The HashCode holds the 8 bytes of the
+ * result, most significant first.
+ */
+up<HashFunction> createHash64( uint64_t seed = 0 );
+
+/**
+ * Same as createHash64() for hash128(). The HashCode holds high, then low.
+ */
+up<HashFunction> createHash128( uint64_t seed = 0 );
+
+/**
+ * Updates a CRC32 (the zlib / IEEE 802.3 one) with len bytes. Start with
+ * crc 0; the value returned is final and can be passed back in to continue.
+ * Uses carry-less multiply (PCLMULQDQ) where the CPU has it and slice-by-8
+ * tables otherwise.
+ */
+uint32_t crc32( uint32_t crc, const void* buf, size_t len );
+
+/**
+ * Same as crc32() for CRC32C, using the SSE4.2 crc32 instruction and
+ * PCLMULQDQ where available.
+ */
+uint32_t crc32c( uint32_t crc, const void* buf, size_t len );
+
+/**
+ * The CRC32 of A followed by B, given only crcA, crcB and the length of B,
+ * so that chunks can be checksummed in parallel and joined afterwards.
+ */
+uint32_t crc32Combine( uint32_t crcA, uint32_t crcB, uint64_t lenB );
+
+//! crc32Combine() for CRC32C
+uint32_t crc32cCombine( uint32_t crcA, uint32_t crcB, uint64_t lenB );
+
 } // namespace
 
 #endif // BASELINE_HASH_H_
\ No newline at end of file
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_HASHMAP_H_
+#define BASELINE_HASHMAP_H_
+
+#include <baseline/HashTableImpl.h>
+#include <baseline/TypeHelpers.h>
+
+namespace baseline {
+
+/*!
+ * Unordered map from keys to values, using hash_type() on the keys.
+ * Copies share their storage until one of them is modified.
+ *
+ * Entries are addressed by index; indices stay valid until the map is
+ * next modified. To walk through the map:
+ *
+ *   for( int i = map.next( -1 ); i >= 0; i = map.next( i ) ) {
+ *     use( map.keyAt( i ), map.valueAt( i ) );
+ *   }
+ */
+template <typename TKey, typename TValue>
+class HashMap : private HashTableImpl
+{
+public:
+  typedef TKey    key_type;
+  typedef TValue  value_type;
+  typedef key_value_pair_t<TKey, TValue> entry_type;
+
+  /*!
+   * Constructors and destructors
+   */
+
+  HashMap();
+  HashMap( const HashMap<TKey, TValue>& rhs );
+  HashMap( HashMap<TKey, TValue>&& rhs );
+  virtual ~HashMap();
+
+  /*! copy operator */
+  HashMap<TKey, TValue>&  operator = ( const HashMap<TKey, TValue>& rhs );
+
+  /*! move operator, rhs is left empty */
+  HashMap<TKey, TValue>&  operator = ( HashMap<TKey, TValue>&& rhs );
+
+  /*
+   * empty the map
+   */
+
+  inline void clear() {
+    HashTableImpl::clear();
+  }
+
+  /*!
+   * map stats
+   */
+
+  //! returns number of entries in the map
+  inline size_t size() const {
+    return HashTableImpl::size();
+  }
+  //! returns whether or not the map is empty
+  inline bool isEmpty() const {
+    return HashTableImpl::isEmpty();
+  }
+  //! returns how many entries can be stored without growing
+  inline size_t capacity() const {
+    return HashTableImpl::capacity();
+  }
+  //! makes room for size entries
+  inline int setCapacity( size_t size ) {
+    return HashTableImpl::setCapacity( size );
+  }
+
+  /*!
+   * accessors
+   */
+
+  //! index of the entry for key, or NAME_NOT_FOUND
+  int indexOfKey( const TKey& key ) const;
+
+  //! value for key, which must be in the map
+  const TValue& valueFor( const TKey& key ) const;
+  TValue& editValueFor( const TKey& key );
+
+  //! next entry after index, or -1. start with -1.
+  inline int next( int index ) const {
+    return HashTableImpl::next( index );
+  }
+
+  inline const TKey& keyAt( size_t index ) const {
+    return entryAt( index ).key;
+  }
+  inline const TValue& valueAt( size_t index ) const {
+    return entryAt( index ).value;
+  }
+  TValue& editValueAt( size_t index );
+
+  /*!
+   * modifying the map
+   */
+
+  //! adds an entry, or replaces the value if key is already in the map.
+  //! returns the index of the entry or an error.
+  int add( const TKey& key, const TValue& value );
+  int add( TKey&& key, TValue&& value );
+
+  //! removes the entry for key. returns its index or NAME_NOT_FOUND
+  int removeItem( const TKey& key );
+
+  //! removes the entry at index
+  inline void removeItemAt( size_t index ) {
+    HashTableImpl::removeAt( index );
+  }
+
+protected:
+  virtual void do_destroy( void* storage, size_t num ) const;
+  virtual void do_copy( void* dest, const void* from, size_t num ) const;
+  virtual void do_move( void* dest, const void* from, size_t num ) const;
+  virtual bool do_equals( const void* storage, const void* key ) const;
+
+private:
+  inline const entry_type& entryAt( size_t index ) const {
+    return *static_cast<const entry_type*>( HashTableImpl::entryAt( index ) );
+  }
+};
+
+// HashMap<K, V> can be trivially moved using memcpy() because moving does not
+// require any change to the underlying SharedBuffer contents or reference count.
+template<typename K, typename V> struct trait_trivial_move<HashMap<K, V>> {
+  enum { value = true };
+};
+
+// ---------------------------------------------------------------------------
+// No user serviceable parts from here...
+// ---------------------------------------------------------------------------
+
+template<typename TKey, typename TValue> inline
+HashMap<TKey, TValue>::HashMap()
+  : HashTableImpl( sizeof( entry_type ),
+                   ( ( traits<entry_type>::has_trivial_ctor   ? HAS_TRIVIAL_CTOR   : 0 )
+                     | ( traits<entry_type>::has_trivial_dtor   ? HAS_TRIVIAL_DTOR   : 0 )
+                     | ( traits<entry_type>::has_trivial_copy   ? HAS_TRIVIAL_COPY   : 0 )
+                     | ( traits<entry_type>::has_trivial_move   ? HAS_TRIVIAL_MOVE   : 0 ) )
+                 )
+{
+}
+
+template<typename TKey, typename TValue> inline
+HashMap<TKey, TValue>::HashMap( const HashMap<TKey, TValue>& rhs )
+  : HashTableImpl( rhs )
+{
+}
+
+template<typename TKey, typename TValue> inline
+HashMap<TKey, TValue>::HashMap( HashMap<TKey, TValue>&& rhs )
+  : HashTableImpl( std::move( static_cast<HashTableImpl&>( rhs ) ) )
+{
+}
+
+template<typename TKey, typename TValue> inline
+HashMap<TKey, TValue>::~HashMap()
+{
+  finish_table();
+}
+
+template<typename TKey, typename TValue> inline
+HashMap<TKey, TValue>& HashMap<TKey, TValue>::operator = ( const HashMap<TKey, TValue>& rhs )
+{
+  HashTableImpl::operator = ( rhs );
+  return *this;
+}
+
+template<typename TKey, typename TValue> inline
+HashMap<TKey, TValue>& HashMap<TKey, TValue>::operator = ( HashMap<TKey, TValue>&& rhs )
+{
+  HashTableImpl::operator = ( std::move( static_cast<HashTableImpl&>( rhs ) ) );
+  return *this;
+}
+
+template<typename TKey, typename TValue> inline
+int HashMap<TKey, TValue>::indexOfKey( const TKey& key ) const
+{
+  return HashTableImpl::find( hash_type( key ), &key );
+}
+
+template<typename TKey, typename TValue> inline
+const TValue& HashMap<TKey, TValue>::valueFor( const TKey& key ) const
+{
+  const int index = indexOfKey( key );
+  LOG_FATAL_IF( index < 0, "%s: key not found", __PRETTY_FUNCTION__ );
+  return valueAt( index );
+}
+
+template<typename TKey, typename TValue> inline
+TValue& HashMap<TKey, TValue>::editValueFor( const TKey& key )
+{
+  const int index = indexOfKey( key );
+  LOG_FATAL_IF( index < 0, "%s: key not found", __PRETTY_FUNCTION__ );
+  return editValueAt( index );
+}
+
+template<typename TKey, typename TValue> inline
+TValue& HashMap<TKey, TValue>::editValueAt( size_t index )
+{
+  return static_cast<entry_type*>( HashTableImpl::editEntryAt( index ) )->value;
+}
+
+template<typename TKey, typename TValue> inline
+int HashMap<TKey, TValue>::add( const TKey& key, const TValue& value )
+{
+  bool created;
+  const int index = HashTableImpl::insert( hash_type( key ), &key, &created );
+  if( index >= 0 ) {
+    entry_type* entry = static_cast<entry_type*>( HashTableImpl::editEntryAt( index ) );
+    if( created ) {
+      new( entry ) entry_type( key, value );
+    } else {
+      entry->value = value;
+    }
+  }
+  return index;
+}
+
+template<typename TKey, typename TValue> inline
+int HashMap<TKey, TValue>::add( TKey&& key, TValue&& value )
+{
+  bool created;
+  const int index = HashTableImpl::insert( hash_type( key ), &key, &created );
+  if( index >= 0 ) {
+    entry_type* entry = static_cast<entry_type*>( HashTableImpl::editEntryAt( index ) );
+    if( created ) {
+      new( &entry->key ) TKey( std::move( key ) );
+      new( &entry->value ) TValue( std::move( value ) );
+    } else {
+      entry->value = std::move( value );
+    }
+  }
+  return index;
+}
+
+template<typename TKey, typename TValue> inline
+int HashMap<TKey, TValue>::removeItem( const TKey& key )
+{
+  const int index = indexOfKey( key );
+  if( index >= 0 ) {
+    HashTableImpl::removeAt( index );
+  }
+  return index;
+}
+
+// ---------------------------------------------------------------------------
+
+template<typename TKey, typename TValue>
+void HashMap<TKey, TValue>::do_destroy( void* storage, size_t num ) const
+{
+  destroy_type( reinterpret_cast<entry_type*>( storage ), num );
+}
+
+template<typename TKey, typename TValue>
+void HashMap<TKey, TValue>::do_copy( void* dest, const void* from, size_t num ) const
+{
+  copy_type( reinterpret_cast<entry_type*>( dest ), reinterpret_cast<const entry_type*>( from ), num );
+}
+
+template<typename TKey, typename TValue>
+void HashMap<TKey, TValue>::do_move( void* dest, const void* from, size_t num ) const
+{
+  move_backward_type( reinterpret_cast<entry_type*>( dest ), reinterpret_cast<const entry_type*>( from ), num );
+}
+
+template<typename TKey, typename TValue>
+bool HashMap<TKey, TValue>::do_equals( const void* storage, const void* key ) const
+{
+  return reinterpret_cast<const entry_type*>( storage )->key == *reinterpret_cast<const TKey*>( key );
+}
+
+}
+
+#endif // BASELINE_HASHMAP_H_
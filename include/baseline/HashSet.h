@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_HASHSET_H_
+#define BASELINE_HASHSET_H_
+
+#include <baseline/HashTableImpl.h>
+#include <baseline/TypeHelpers.h>
+
+namespace baseline {
+
+/*!
+ * Unordered set of items, using hash_type() on the items. Copies share
+ * their storage until one of them is modified. Items are addressed by
+ * index, which stays valid until the set is next modified; walk through
+ * the set with next() like a HashMap.
+ */
+template <typename TYPE>
+class HashSet : private HashTableImpl
+{
+public:
+  typedef TYPE    value_type;
+
+  /*!
+   * Constructors and destructors
+   */
+
+  HashSet();
+  HashSet( const HashSet<TYPE>& rhs );
+  HashSet( HashSet<TYPE>&& rhs );
+  virtual ~HashSet();
+
+  /*! copy operator */
+  HashSet<TYPE>&  operator = ( const HashSet<TYPE>& rhs );
+
+  /*! move operator, rhs is left empty */
+  HashSet<TYPE>&  operator = ( HashSet<TYPE>&& rhs );
+
+  /*
+   * empty the set
+   */
+
+  inline void clear() {
+    HashTableImpl::clear();
+  }
+
+  /*!
+   * set stats
+   */
+
+  //! returns number of items in the set
+  inline size_t size() const {
+    return HashTableImpl::size();
+  }
+  //! returns whether or not the set is empty
+  inline bool isEmpty() const {
+    return HashTableImpl::isEmpty();
+  }
+  //! returns how many items can be stored without growing
+  inline size_t capacity() const {
+    return HashTableImpl::capacity();
+  }
+  //! makes room for size items
+  inline int setCapacity( size_t size ) {
+    return HashTableImpl::setCapacity( size );
+  }
+
+  /*!
+   * accessors
+   */
+
+  //! index of item, or NAME_NOT_FOUND
+  inline int indexOf( const TYPE& item ) const {
+    return HashTableImpl::find( hash_type( item ), &item );
+  }
+
+  //! next item after index, or -1. start with -1.
+  inline int next( int index ) const {
+    return HashTableImpl::next( index );
+  }
+
+  inline const TYPE& itemAt( size_t index ) const {
+    return *static_cast<const TYPE*>( HashTableImpl::entryAt( index ) );
+  }
+
+  /*!
+   * modifying the set
+   */
+
+  //! adds an item, or replaces the equal one already in the set.
+  //! returns the index of the item or an error.
+  int add( const TYPE& item );
+  int add( TYPE&& item );
+
+  //! removes an item. returns its index or NAME_NOT_FOUND
+  int remove( const TYPE& item );
+
+  //! removes the item at index
+  inline void removeItemAt( size_t index ) {
+    HashTableImpl::removeAt( index );
+  }
+
+protected:
+  virtual void do_destroy( void* storage, size_t num ) const;
+  virtual void do_copy( void* dest, const void* from, size_t num ) const;
+  virtual void do_move( void* dest, const void* from, size_t num ) const;
+  virtual bool do_equals( const void* storage, const void* key ) const;
+};
+
+// HashSet<T> can be trivially moved using memcpy() because moving does not
+// require any change to the underlying SharedBuffer contents or reference count.
+template<typename T> struct trait_trivial_move<HashSet<T>> {
+  enum { value = true };
+};
+
+// ---------------------------------------------------------------------------
+// No user serviceable parts from here...
+// ---------------------------------------------------------------------------
+
+template<class TYPE> inline
+HashSet<TYPE>::HashSet()
+  : HashTableImpl( sizeof( TYPE ),
+                   ( ( traits<TYPE>::has_trivial_ctor   ? HAS_TRIVIAL_CTOR   : 0 )
+                     | ( traits<TYPE>::has_trivial_dtor   ? HAS_TRIVIAL_DTOR   : 0 )
+                     | ( traits<TYPE>::has_trivial_copy   ? HAS_TRIVIAL_COPY   : 0 )
+                     | ( traits<TYPE>::has_trivial_move   ? HAS_TRIVIAL_MOVE   : 0 ) )
+                 )
+{
+}
+
+template<class TYPE> inline
+HashSet<TYPE>::HashSet( const HashSet<TYPE>& rhs )
+  : HashTableImpl( rhs )
+{
+}
+
+template<class TYPE> inline
+HashSet<TYPE>::HashSet( HashSet<TYPE>&& rhs )
+  : HashTableImpl( std::move( static_cast<HashTableImpl&>( rhs ) ) )
+{
+}
+
+template<class TYPE> inline
+HashSet<TYPE>::~HashSet()
+{
+  finish_table();
+}
+
+template<class TYPE> inline
+HashSet<TYPE>& HashSet<TYPE>::operator = ( const HashSet<TYPE>& rhs )
+{
+  HashTableImpl::operator = ( rhs );
+  return *this;
+}
+
+template<class TYPE> inline
+HashSet<TYPE>& HashSet<TYPE>::operator = ( HashSet<TYPE>&& rhs )
+{
+  HashTableImpl::operator = ( std::move( static_cast<HashTableImpl&>( rhs ) ) );
+  return *this;
+}
+
+template<class TYPE> inline
+int HashSet<TYPE>::add( const TYPE& item )
+{
+  bool created;
+  const int index = HashTableImpl::insert( hash_type( item ), &item, &created );
+  if( index >= 0 ) {
+    TYPE* storage = static_cast<TYPE*>( HashTableImpl::editEntryAt( index ) );
+    if( created ) {
+      new( storage ) TYPE( item );
+    } else {
+      *storage = item;
+    }
+  }
+  return index;
+}
+
+template<class TYPE> inline
+int HashSet<TYPE>::add( TYPE&& item )
+{
+  bool created;
+  const int index = HashTableImpl::insert( hash_type( item ), &item, &created );
+  if( index >= 0 ) {
+    TYPE* storage = static_cast<TYPE*>( HashTableImpl::editEntryAt( index ) );
+    if( created ) {
+      new( storage ) TYPE( std::move( item ) );
+    } else {
+      *storage = std::move( item );
+    }
+  }
+  return index;
+}
+
+template<class TYPE> inline
+int HashSet<TYPE>::remove( const TYPE& item )
+{
+  const int index = indexOf( item );
+  if( index >= 0 ) {
+    HashTableImpl::removeAt( index );
+  }
+  return index;
+}
+
+// ---------------------------------------------------------------------------
+
+template<class TYPE>
+void HashSet<TYPE>::do_destroy( void* storage, size_t num ) const
+{
+  destroy_type( reinterpret_cast<TYPE*>( storage ), num );
+}
+
+template<class TYPE>
+void HashSet<TYPE>::do_copy( void* dest, const void* from, size_t num ) const
+{
+  copy_type( reinterpret_cast<TYPE*>( dest ), reinterpret_cast<const TYPE*>( from ), num );
+}
+
+template<class TYPE>
+void HashSet<TYPE>::do_move( void* dest, const void* from, size_t num ) const
+{
+  move_backward_type( reinterpret_cast<TYPE*>( dest ), reinterpret_cast<const TYPE*>( from ), num );
+}
+
+template<class TYPE>
+bool HashSet<TYPE>::do_equals( const void* storage, const void* key ) const
+{
+  return *reinterpret_cast<const TYPE*>( storage ) == *reinterpret_cast<const TYPE*>( key );
+}
+
+}
+
+#endif // BASELINE_HASHSET_H_
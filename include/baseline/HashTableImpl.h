@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_HASHTABLEIMPL_H_
+#define BASELINE_HASHTABLEIMPL_H_
+
+#include <baseline/TypeHelpers.h>
+
+namespace baseline {
+
+/*!
+ * Implementation of the guts of the hash table classes.
+ * This class is used as a type-erased base for HashMap<> and HashSet<>.
+ *
+ * This is an open addressing table. Slots come in groups of kGroupSize,
+ * and every slot has a control byte that is either kEmpty, kDeleted or 7
+ * bits of the hash of the entry it holds. A lookup scans the control bytes
+ * of a whole group at once (with SSE2 when available) and only compares
+ * entries whose control byte and cached 32-bit hash both match, so keys
+ * are hashed once and rarely compared. Groups are probed quadratically.
+ *
+ * Control bytes, hashes and entries share one SharedBuffer, which copies
+ * of the table share until one of them is modified.
+ */
+class HashTableImpl
+{
+public:
+  enum { // flags passed to the ctor
+    HAS_TRIVIAL_CTOR    = 0x00000001,
+    HAS_TRIVIAL_DTOR    = 0x00000002,
+    HAS_TRIVIAL_COPY    = 0x00000004,
+    HAS_TRIVIAL_MOVE    = 0x00000008,
+  };
+
+  enum {
+    kGroupSize = 16,
+  };
+
+  HashTableImpl( size_t entrySize, uint32_t flags );
+  HashTableImpl( const HashTableImpl& rhs );
+  HashTableImpl( HashTableImpl&& rhs );
+  virtual ~HashTableImpl();
+
+  /*! must be called from subclasses destructor */
+  void finish_table();
+
+  HashTableImpl& operator = ( const HashTableImpl& rhs );
+  HashTableImpl& operator = ( HashTableImpl&& rhs );
+
+  /*! table stats */
+  inline size_t size() const {
+    return mSize;
+  }
+  inline bool isEmpty() const {
+    return mSize == 0;
+  }
+  //! number of entries the table holds before it has to grow
+  size_t capacity() const;
+  //! makes room for size entries. returns the new capacity or NO_MEMORY
+  int setCapacity( size_t size );
+
+  //! removes all entries
+  void clear();
+
+  //! index of the first entry after index, or -1 if there is none.
+  //! start with -1 to walk through all the entries.
+  int next( int index ) const;
+
+protected:
+  //! index of the entry matching key, or NAME_NOT_FOUND
+  int find( hash_t hash, const void* key ) const;
+
+  //! index of the entry matching key, or of a new slot for it. a new
+  //! slot is uninitialized, the caller must construct the entry in
+  //! place. *created tells which one it is. returns NO_MEMORY on failure.
+  int insert( hash_t hash, const void* key, bool* created );
+
+  //! destroys the entry at index
+  void removeAt( size_t index );
+
+  const void* entryAt( size_t index ) const;
+  //! writable entry, unsharing the storage if needed. NULL on failure.
+  void* editEntryAt( size_t index );
+
+  virtual void do_destroy( void* storage, size_t num ) const = 0;
+  virtual void do_copy( void* dest, const void* from, size_t num ) const = 0;
+  virtual void do_move( void* dest, const void* from, size_t num ) const = 0;
+  //! whether the entry at storage has the given key
+  virtual bool do_equals( const void* storage, const void* key ) const = 0;
+
+private:
+  status_t _edit();
+  status_t _resize( size_t slots );
+  size_t _find_free( hash_t hash ) const;
+  void _release_storage();
+  bool _can_relocate() const;
+
+  inline uint8_t* _ctrl() const;
+  inline hash_t* _hashes() const;
+  inline char* _entries() const;
+
+  void* mStorage;       // control bytes, followed by hashes and entries
+  size_t mSlots;        // power of two, 0 or at least kGroupSize
+  size_t mSize;         // number of entries
+  size_t mGrowthLeft;   // empty slots that can be used before growing
+
+  const uint32_t mFlags;
+  const size_t mEntrySize;
+};
+
+}
+
+#endif // BASELINE_HASHTABLEIMPL_H_
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_MERKLETREE_H_
+#define BASELINE_MERKLETREE_H_
+
+#include <baseline/Hash.h>
+#include <baseline/Vector.h>
+#include <baseline/StrongPointer.h>
+
+namespace baseline {
+
+class ExecutorService;
+class InputStream;
+
+/**
+ * Merkle tree over fixed size chunks of a large buffer or stream, using
+ * any HashFunction. The chunks are hashed in parallel on an
+ * ExecutorService; the levels above them are small and are hashed on the
+ * calling thread.
+ *
+ * A leaf is H( 0x00 || chunk ) and an inner node H( 0x01 || left || right ),
+ * so that a leaf can not pass for a node. A node without a sibling moves up
+ * a level unchanged. Empty input has one empty chunk.
+ *
+ * After a chunk changes, update() re-hashes it and the nodes above it
+ * only. proof() gives the siblings on the path from a chunk to the root,
+ * which verify() checks against the root without the other chunks.
+ */
+class MerkleTree
+{
+public:
+  typedef up<HashFunction> ( *Factory )();
+
+  explicit MerkleTree( Factory factory, size_t chunkSize = 1 << 20 );
+
+  /**
+   * Hashes len bytes at data. Without an executor, everything runs on
+   * the calling thread, which must not be one of executor's threads.
+   */
+  status_t build( const void* data, size_t len, const sp<ExecutorService>& executor = nullptr );
+
+  /**
+   * Hashes everything in in until EOF, reading a chunk per thread at a
+   * time. A read error is returned and leaves the tree unbuilt.
+   */
+  status_t build( InputStream& in, const sp<ExecutorService>& executor = nullptr );
+
+  /**
+   * Re-hashes chunk index, which now holds the len bytes at chunk. len
+   * must be the size of the chunk it replaces.
+   */
+  status_t update( size_t index, const void* chunk, size_t len );
+
+  HashCode root() const;
+  HashCode leaf( size_t index ) const;
+
+  /**
+   * Sets siblings to the hashes needed to get from chunk index to root(),
+   * lowest first, one after the other.
+   */
+  status_t proof( size_t index, Vector<uint8_t>& siblings ) const;
+
+  /**
+   * True if the len bytes at chunk are chunk index of chunkCount under
+   * root, according to siblings from proof(). False for a root that is
+   * not a digest of factory's size, like that of an unbuilt tree.
+   */
+  static bool verify( Factory factory, const HashCode& root, size_t index, size_t chunkCount,
+                      const void* chunk, size_t len, const Vector<uint8_t>& siblings );
+
+  inline size_t chunkSize() const {
+    return mChunkSize;
+  }
+  inline size_t chunkCount() const {
+    return mLevelStart.size() > 1 ? mLevelStart[1] : 0;
+  }
+  inline uint64_t length() const {
+    return mLength;
+  }
+
+private:
+  struct BuildState;
+  static void leafTask( void* state, size_t index );
+
+  status_t prepare();
+  void hashLeaves( const uint8_t* data, size_t len, size_t firstLeaf, const sp<ExecutorService>& executor );
+  void buildLevels( size_t leaves );
+  inline uint8_t* node( size_t level, size_t index ) {
+    return mNodes.editArray() + ( mLevelStart[level] + index ) * mDigestSize;
+  }
+  inline const uint8_t* node( size_t level, size_t index ) const {
+    return mNodes.array() + ( mLevelStart[level] + index ) * mDigestSize;
+  }
+  inline size_t levelSize( size_t level ) const {
+    return mLevelStart[level + 1] - mLevelStart[level];
+  }
+
+  Factory mFactory;
+  size_t mChunkSize;
+  size_t mDigestSize;
+  uint64_t mLength;
+  // the digests of every level, leaves first, mDigestSize bytes each
+  Vector<uint8_t> mNodes;
+  // node index where each level starts, plus one past the root
+  Vector<size_t> mLevelStart;
+};
+
+} // namespace baseline
+
+#endif // BASELINE_MERKLETREE_H_
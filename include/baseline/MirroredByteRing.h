@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_MIRROREDBYTERING_H_
+#define BASELINE_MIRROREDBYTERING_H_
+
+namespace baseline {
+
+/**
+ * A byte ring buffer whose storage is mapped twice, back to back, in
+ * virtual memory. Byte capacity() + i is the same memory as byte i, so the
+ * readable bytes are always one contiguous span starting at readPtr() and
+ * the writable space one contiguous span starting at writePtr(), even when
+ * they wrap around the end. Readers can parse records in place instead of
+ * copying them out first.
+ *
+ * The capacity is rounded up to the allocation granularity of the platform
+ * (the page size on POSIX systems, 64K on Windows). Check initCheck()
+ * after construction: if the mapping could not be made it returns an
+ * error and the ring has no capacity.
+ *
+ * Like CircleBuffer, MirroredByteRing is not thread-safe.
+ */
+class MirroredByteRing
+{
+public:
+  MirroredByteRing( size_t capacity );
+  ~MirroredByteRing();
+
+  //! OK, or the error that kept the storage from being mapped
+  status_t initCheck() const;
+
+  inline size_t capacity() const {
+    return mCapacity;
+  }
+
+  inline size_t size() const {
+    return mSize;
+  }
+
+  inline size_t available() const {
+    return mCapacity - mSize;
+  }
+
+  inline bool empty() const {
+    return mSize == 0;
+  }
+
+  inline bool full() const {
+    return mSize == mCapacity;
+  }
+
+  inline void clear() {
+    mTail = 0;
+    mSize = 0;
+  }
+
+  //! the size() readable bytes, contiguous
+  inline const uint8_t* readPtr() const {
+    return mData + mTail;
+  }
+
+  //! drops len (at most size()) bytes from the front of readPtr()
+  void consume( size_t len );
+
+  //! the available() writable bytes, contiguous
+  inline uint8_t* writePtr() {
+    size_t head = mTail + mSize;
+    if( head >= mCapacity ) {
+      head -= mCapacity;
+    }
+    return mData + head;
+  }
+
+  //! makes len (at most available()) bytes written at writePtr() readable
+  void commit( size_t len );
+
+  //! copies up to len bytes in, returns how many
+  size_t write( const uint8_t* buf, size_t len );
+
+  //! copies up to len bytes out, returns how many
+  size_t read( uint8_t* buf, size_t len );
+
+private:
+  //A MirroredByteRing cannot be copied
+  MirroredByteRing( const MirroredByteRing& );
+  MirroredByteRing& operator = ( const MirroredByteRing& );
+
+  uint8_t* mData;
+  size_t mCapacity;
+  size_t mTail;
+  size_t mSize;
+  status_t mStatus;
+  void* mHandle;
+};
+
+} // namespace baseline
+
+#endif // BASELINE_MIRROREDBYTERING_H_
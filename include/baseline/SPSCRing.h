@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_SPSCRING_H_
+#define BASELINE_SPSCRING_H_
+
+#include <baseline/TypeHelpers.h>
+
+#include <atomic>
+#include <utility>
+
+namespace baseline {
+
+/**
+ * A CircleBuffer that one thread can write to while another one reads
+ * from it, without locking. There must be only one writer and one reader
+ * at any time; size(), available(), empty() and full() are exact for them
+ * and a snapshot for anyone else.
+ *
+ * The write and read indices live on separate cache lines, and each side
+ * keeps a copy of the other side's index so that it only reads the
+ * shared one when its copy says the ring is full (or empty). Writes and
+ * reads copy in at most two pieces, with memcpy() for trivial types.
+ * Reads move non-trivial items out and reset their slots, so that the
+ * ring does not keep references alive after they are consumed.
+ *
+ * The capacity is rounded up to a power of two.
+ */
+template<typename T>
+class SPSCRing
+{
+public:
+  SPSCRing( uint32_t capacity );
+  ~SPSCRing();
+
+  inline
+  uint32_t capacity() const;
+
+  inline
+  uint32_t size() const;
+
+  inline
+  uint32_t available() const;
+
+  inline
+  bool empty() const;
+
+  inline
+  bool full() const;
+
+  //! writer side. copies up to size items, returns how many
+  uint32_t write( const T* buf, uint32_t size );
+  //! writer side. returns false if the ring is full
+  bool put( const T& v );
+
+  //! reader side. copies up to size items, returns how many
+  uint32_t read( T* buf, uint32_t size );
+  //! reader side. returns false if the ring is empty
+  bool get( T* v );
+
+private:
+  enum {
+    kCacheLine = 64
+  };
+
+  static void copy( T* dest, const T* src, uint32_t n );
+  //! moves n items from src to dest and leaves src empty
+  static void take( T* dest, T* src, uint32_t n );
+
+  // indices run freely and wrap around, positions are index & mMask
+  T* mData;
+  uint32_t mMask;
+  char mPad0[kCacheLine];
+
+  // written by the writer
+  std::atomic<uint32_t> mHead;
+  uint32_t mTailCache;
+  char mPad1[kCacheLine - sizeof( std::atomic<uint32_t> ) - sizeof( uint32_t )];
+
+  // written by the reader
+  std::atomic<uint32_t> mTail;
+  uint32_t mHeadCache;
+  char mPad2[kCacheLine - sizeof( std::atomic<uint32_t> ) - sizeof( uint32_t )];
+
+  SPSCRing( const SPSCRing& );
+  SPSCRing& operator = ( const SPSCRing& );
+};
+
+/////////////// Implementation ////////////////////
+
+template<typename T>
+SPSCRing<T>::SPSCRing( uint32_t capacity )
+  : mHead( 0 ), mTailCache( 0 ), mTail( 0 ), mHeadCache( 0 )
+{
+  uint32_t size = 1;
+  while( size < capacity && size < 0x80000000u ) {
+    size <<= 1;
+  }
+  mMask = size - 1;
+  mData = new T[size];
+}
+
+template<typename T>
+SPSCRing<T>::~SPSCRing()
+{
+  delete[] mData;
+}
+
+template<typename T>
+uint32_t SPSCRing<T>::capacity() const
+{
+  return mMask + 1;
+}
+
+template<typename T>
+uint32_t SPSCRing<T>::size() const
+{
+  return mHead.load( std::memory_order_acquire ) - mTail.load( std::memory_order_acquire );
+}
+
+template<typename T>
+uint32_t SPSCRing<T>::available() const
+{
+  return capacity() - size();
+}
+
+template<typename T>
+bool SPSCRing<T>::empty() const
+{
+  return size() == 0;
+}
+
+template<typename T>
+bool SPSCRing<T>::full() const
+{
+  return size() == capacity();
+}
+
+template<typename T>
+void SPSCRing<T>::copy( T* dest, const T* src, uint32_t n )
+{
+  if( traits<T>::has_trivial_copy ) {
+    memcpy( dest, src, n * sizeof( T ) );
+  } else {
+    for( uint32_t i = 0; i < n; i++ ) {
+      dest[i] = src[i];
+    }
+  }
+}
+
+template<typename T>
+void SPSCRing<T>::take( T* dest, T* src, uint32_t n )
+{
+  if( traits<T>::has_trivial_copy ) {
+    memcpy( dest, src, n * sizeof( T ) );
+  } else {
+    for( uint32_t i = 0; i < n; i++ ) {
+      dest[i] = std::move( src[i] );
+      src[i] = T();
+    }
+  }
+}
+
+template <typename T>
+uint32_t SPSCRing<T>::write( const T* buf, uint32_t size )
+{
+  const uint32_t head = mHead.load( std::memory_order_relaxed );
+  uint32_t space = capacity() - ( head - mTailCache );
+  if( space < size ) {
+    mTailCache = mTail.load( std::memory_order_acquire );
+    space = capacity() - ( head - mTailCache );
+  }
+  const uint32_t len = MIN( size, space );
+  const uint32_t pos = head & mMask;
+  const uint32_t first = MIN( len, capacity() - pos );
+  copy( mData + pos, buf, first );
+  copy( mData, buf + first, len - first );
+  mHead.store( head + len, std::memory_order_release );
+  return len;
+}
+
+template <typename T>
+uint32_t SPSCRing<T>::read( T* buf, uint32_t size )
+{
+  const uint32_t tail = mTail.load( std::memory_order_relaxed );
+  uint32_t count = mHeadCache - tail;
+  if( count < size ) {
+    mHeadCache = mHead.load( std::memory_order_acquire );
+    count = mHeadCache - tail;
+  }
+  const uint32_t len = MIN( size, count );
+  const uint32_t pos = tail & mMask;
+  const uint32_t first = MIN( len, capacity() - pos );
+  take( buf, mData + pos, first );
+  take( buf + first, mData, len - first );
+  mTail.store( tail + len, std::memory_order_release );
+  return len;
+}
+
+template<typename T>
+bool SPSCRing<T>::put( const T& v )
+{
+  return write( &v, 1 ) == 1;
+}
+
+template<typename T>
+bool SPSCRing<T>::get( T* v )
+{
+  return read( v, 1 ) == 1;
+}
+
+}
+
+#endif // BASELINE_SPSCRING_H_
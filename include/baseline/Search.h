@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_SEARCH_H_
+#define BASELINE_SEARCH_H_
+
+#include <baseline/TypeHelpers.h>
+
+namespace baseline {
+
+/*
+ * Searching arrays of items.
+ *
+ *   find_type( a, n, value )         index of the first item equal to value, or n
+ *   count_type( a, n, value )        number of items equal to value
+ *   lower_bound_type( a, n, value )  index of the first item not less than
+ *                                    value, a must be sorted
+ *   min_type( a, n ), max_type( a, n )
+ *                                    smallest and largest item, n must not be 0
+ *
+ * The generic versions compare items with operator == and compare_type().
+ * 32 and 64 bit integers go to kernels that use SSE2, or AVX2 when the
+ * CPU has it. lower_bound_type() then does a branch-free binary search
+ * with prefetching down to a couple of cache lines, and counts the
+ * smaller items in those with SIMD compares.
+ */
+
+template<typename TYPE> inline
+size_t find_type( const TYPE* a, size_t n, const TYPE& value )
+{
+  for( size_t i = 0; i < n; i++ ) {
+    if( a[i] == value ) {
+      return i;
+    }
+  }
+  return n;
+}
+
+template<typename TYPE> inline
+size_t count_type( const TYPE* a, size_t n, const TYPE& value )
+{
+  size_t count = 0;
+  for( size_t i = 0; i < n; i++ ) {
+    count += ( a[i] == value ) ? 1 : 0;
+  }
+  return count;
+}
+
+template<typename TYPE> inline
+size_t lower_bound_type( const TYPE* a, size_t n, const TYPE& value )
+{
+  if( n == 0 ) {
+    return 0;
+  }
+  const TYPE* base = a;
+  while( n > 1 ) {
+    const size_t half = n / 2;
+    base = ( compare_type( base[half], value ) < 0 ) ? base + half : base;
+    n -= half;
+  }
+  return ( base - a ) + ( compare_type( *base, value ) < 0 ? 1 : 0 );
+}
+
+template<typename TYPE> inline
+const TYPE& min_type( const TYPE* a, size_t n )
+{
+  const TYPE* m = a;
+  for( size_t i = 1; i < n; i++ ) {
+    if( compare_type( a[i], *m ) < 0 ) {
+      m = a + i;
+    }
+  }
+  return *m;
+}
+
+template<typename TYPE> inline
+const TYPE& max_type( const TYPE* a, size_t n )
+{
+  const TYPE* m = a;
+  for( size_t i = 1; i < n; i++ ) {
+    if( compare_type( *m, a[i] ) < 0 ) {
+      m = a + i;
+    }
+  }
+  return *m;
+}
+
+namespace search_detail {
+
+// the kernels work on raw lanes. ordered comparisons flip the lanes with
+// bias, 0 for signed integers and the sign bit for unsigned ones.
+size_t find32( const uint32_t* a, size_t n, uint32_t value );
+size_t find64( const uint64_t* a, size_t n, uint64_t value );
+size_t count32( const uint32_t* a, size_t n, uint32_t value );
+size_t count64( const uint64_t* a, size_t n, uint64_t value );
+size_t lower_bound32( const uint32_t* a, size_t n, uint32_t value, uint32_t bias );
+size_t lower_bound64( const uint64_t* a, size_t n, uint64_t value, uint64_t bias );
+size_t min32( const uint32_t* a, size_t n, uint32_t bias );
+size_t min64( const uint64_t* a, size_t n, uint64_t bias );
+size_t max32( const uint32_t* a, size_t n, uint32_t bias );
+size_t max64( const uint64_t* a, size_t n, uint64_t bias );
+
+} // namespace search_detail
+
+#define BASELINE_SEARCH_KERNELS( T, BITS, BIAS )                                                     \
+  inline size_t find_type( const T* a, size_t n, const T& value ) {                                 \
+    return search_detail::find##BITS( reinterpret_cast<const uint##BITS##_t*>( a ), n,             \
+                                      uint##BITS##_t( value ) );                                     \
+  }                                                                                                  \
+  inline size_t count_type( const T* a, size_t n, const T& value ) {                                \
+    return search_detail::count##BITS( reinterpret_cast<const uint##BITS##_t*>( a ), n,            \
+                                       uint##BITS##_t( value ) );                                    \
+  }                                                                                                  \
+  inline size_t lower_bound_type( const T* a, size_t n, const T& value ) {                          \
+    return search_detail::lower_bound##BITS( reinterpret_cast<const uint##BITS##_t*>( a ), n,      \
+                                             uint##BITS##_t( value ), BIAS );                        \
+  }                                                                                                  \
+  inline const T& min_type( const T* a, size_t n ) {                                                \
+    return a[search_detail::min##BITS( reinterpret_cast<const uint##BITS##_t*>( a ), n, BIAS )];  \
+  }                                                                                                  \
+  inline const T& max_type( const T* a, size_t n ) {                                                \
+    return a[search_detail::max##BITS( reinterpret_cast<const uint##BITS##_t*>( a ), n, BIAS )];  \
+  }
+
+BASELINE_SEARCH_KERNELS( int32_t, 32, 0 )
+BASELINE_SEARCH_KERNELS( uint32_t, 32, 0x80000000u )
+BASELINE_SEARCH_KERNELS( int64_t, 64, 0 )
+BASELINE_SEARCH_KERNELS( uint64_t, 64, 0x8000000000000000ull )
+
+#undef BASELINE_SEARCH_KERNELS
+
+} // namespace baseline
+
+#endif // BASELINE_SEARCH_H_
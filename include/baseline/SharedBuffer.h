@@ -31,6 +31,19 @@ public:
     eKeepStorage = 0x00000001
   };
 
+  /*! buffers of at least this many bytes are backed by their own page
+   *  mapping (with transparent huge pages where available) rather than
+   *  the heap, so that editResize() can grow them without copying.
+   */
+  static const size_t kDefaultMapThreshold = 32 * 1024 * 1024;
+
+  /*! change the mapping threshold. SIZE_MAX disables page mapped buffers.
+   *  Should be called before any buffer is allocated; existing buffers
+   *  keep the storage they were allocated with.
+   */
+  static void setMapThreshold( size_t size );
+  static size_t mapThreshold();
+
   /*! allocate a buffer of size 'size' and acquire() it.
    *  call release() to free it.
    */
@@ -85,6 +98,9 @@ public:
   //! returns wether or not we're the only owner
   inline bool onlyOwner() const;
 
+  //! returns wether or not this buffer is backed by its own page mapping
+  inline bool isMapped() const;
+
 
 private:
   inline SharedBuffer() { }
@@ -92,10 +108,17 @@ private:
   SharedBuffer( const SharedBuffer& );
   SharedBuffer& operator = ( const SharedBuffer& );
 
+  enum {
+    eMapped = 0x00000001
+  };
+
+  static void free_storage( SharedBuffer* buf );
+
   // 16 bytes. must be sized to preserve correct alignment.
   mutable int32_t mRefs;
   size_t mSize;
-  uint32_t mReserved[2];
+  uint32_t mFlags;
+  uint32_t mReserved;
 };
 
 // ---------------------------------------------------------------------------
@@ -135,6 +158,11 @@ bool SharedBuffer::onlyOwner() const
   return ( mRefs == 1 );
 }
 
+bool SharedBuffer::isMapped() const
+{
+  return ( mFlags & eMapped ) != 0;
+}
+
 
 }
 
@@ -0,0 +1,560 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_SMALLVECTOR_H_
+#define BASELINE_SMALLVECTOR_H_
+
+#include <baseline/SharedBuffer.h>
+#include <baseline/Sort.h>
+#include <baseline/TypeHelpers.h>
+#include <baseline/Vector.h>
+
+#include <type_traits>
+
+namespace baseline {
+
+/*!
+ * A vector that keeps up to N items inside the object itself, and only
+ * allocates a SharedBuffer once it grows past that. Meant for the many
+ * vectors that stay small and short lived, where the allocation costs
+ * more than the items.
+ *
+ * SmallVector has the API of Vector, but since the inline items cannot
+ * be shared, copies are deep and the heap storage is never shared
+ * either. Moving a SmallVector moves its items when they are inline.
+ */
+template <class TYPE, size_t N>
+class SmallVector
+{
+public:
+  typedef TYPE    value_type;
+
+  /*!
+   * Constructors and destructors
+   */
+
+  SmallVector();
+  SmallVector( const SmallVector<TYPE, N>& rhs );
+  SmallVector( SmallVector<TYPE, N>&& rhs );
+  explicit                SmallVector( const Vector<TYPE>& rhs );
+  ~SmallVector();
+
+  /*! copy operator */
+  SmallVector<TYPE, N>&   operator = ( const SmallVector<TYPE, N>& rhs );
+
+  /*! move operator, rhs is left empty */
+  SmallVector<TYPE, N>&   operator = ( SmallVector<TYPE, N>&& rhs );
+
+  /*
+  * empty the vector, going back to the inline storage
+  */
+
+  void            clear();
+
+  /*!
+   * vector stats
+   */
+
+  //! returns number of items in the vector
+  inline  size_t          size() const                {
+    return mCount;
+  }
+  //! returns whether or not the vector is empty
+  inline  bool            isEmpty() const             {
+    return mCount == 0;
+  }
+  //! returns how many items can be stored without reallocating the backing store
+  inline  size_t          capacity() const            {
+    return mCapacity;
+  }
+  //! returns whether or not the items are stored inline
+  inline  bool            isInline() const            {
+    return mArray == _inline();
+  }
+  //! sets the capacity. capacity can never be reduced less than size()
+  int         setCapacity( size_t size );
+
+  /*!
+   * C-style array access
+   */
+
+  //! read-only C-style access
+  inline  const TYPE*     array() const               {
+    return mArray;
+  }
+  //! read-write C-style access
+  inline  TYPE*           editArray()                 {
+    return mArray;
+  }
+
+  /*!
+   * accessors
+   */
+
+  //! read-only access to an item at a given index
+  inline  const TYPE&     operator []( size_t index ) const;
+  //! alternate name for operator []
+  inline  const TYPE&     itemAt( size_t index ) const {
+    return operator[]( index );
+  }
+  //! stack-usage of the vector. returns the top of the stack (last element)
+  inline  const TYPE&     top() const                 {
+    return mArray[mCount - 1];
+  }
+
+  /*!
+   * modifying the array
+   */
+
+  //! grants write access to an item
+  inline TYPE&           editItemAt( size_t index )   {
+    return mArray[index];
+  }
+  //! grants right access to the top of the stack (last element)
+  inline TYPE&           editTop()                    {
+    return mArray[mCount - 1];
+  }
+
+  /*!
+   * append/insert another vector
+   */
+
+  //! insert another vector at a given index
+  inline int         insertVectorAt( const Vector<TYPE>& vector, size_t index ) {
+    return insertArrayAt( vector.array(), index, vector.size() );
+  }
+
+  //! append another vector at the end of this one
+  inline int         appendVector( const Vector<TYPE>& vector ) {
+    return insertArrayAt( vector.array(), mCount, vector.size() );
+  }
+
+  //! insert an array at a given index
+  int         insertArrayAt( const TYPE* array, size_t index, size_t length );
+
+  //! append an array at the end of this vector
+  inline int         appendArray( const TYPE* array, size_t length ) {
+    return insertArrayAt( array, mCount, length );
+  }
+
+  /*!
+   * add/insert/replace items
+   */
+
+  //! insert one or several items initialized with their default constructor
+  int         insertAt( size_t index, size_t numItems = 1 );
+  //! insert one or several items initialized from a prototype item
+  int         insertAt( const TYPE& prototype_item, size_t index, size_t numItems = 1 );
+  //! pop the top of the stack (removes the last element). No-op if the stack's empty
+  inline  void            pop();
+  //! pushes an item initialized with its default constructor
+  inline  void            push()                      {
+    insertAt( mCount );
+  }
+  //! pushes an item on the top of the stack
+  inline  void            push( const TYPE& item )    {
+    insertAt( item, mCount );
+  }
+  //! pushes an item on the top of the stack, moving it in place
+  inline  void            push( TYPE&& item )         {
+    emplace( mCount, std::move( item ) );
+  }
+  //! same as push() but returns the index the item was added at (or an error)
+  inline  int         add()                           {
+    return insertAt( mCount );
+  }
+  //! same as push() but returns the index the item was added at (or an error)
+  inline  int         add( const TYPE& item )         {
+    return insertAt( item, mCount );
+  }
+  //! same as push() but returns the index the item was added at (or an error)
+  inline  int         add( TYPE&& item )              {
+    return emplace( mCount, std::move( item ) );
+  }
+  //! insert an item constructed in place from args
+  template<typename... Args>
+  int         emplace( size_t index, Args&& ... args );
+  //! add an item constructed in place from args at the end of the vector
+  template<typename... Args>
+  inline int  emplace_back( Args&& ... args ) {
+    return emplace( mCount, std::forward<Args>( args )... );
+  }
+  //! replace an item with a new one initialized with its default constructor
+  int         replaceAt( size_t index );
+  //! replace an item with a new one
+  int         replaceAt( const TYPE& item, size_t index );
+
+  /*!
+   * remove items
+   */
+
+  //! remove several items
+  int         removeItemsAt( size_t index, size_t count = 1 );
+  //! remove one item
+  inline  int         removeAt( size_t index )  {
+    return removeItemsAt( index );
+  }
+
+  /*!
+   * sort (stable) the array
+   */
+
+  typedef int ( *compar_t )( const TYPE* lhs, const TYPE* rhs );
+
+  inline status_t        sort( compar_t cmp ) {
+    return sort( [cmp]( const TYPE & lhs, const TYPE & rhs ) {
+      return cmp( &lhs, &rhs );
+    } );
+  }
+
+  //! sort (stable) in natural order (via < operator)
+  inline status_t        sort() {
+    return sort( []( const TYPE & lhs, const TYPE & rhs ) {
+      return compare_type( lhs, rhs );
+    } );
+  }
+
+  //! sort (stable) with a functor cmp( const TYPE&, const TYPE& ) returning
+  //! <0, 0 or >0
+  template<typename Compare>
+  inline status_t        sort( Compare cmp ) {
+    return stable_sort_type( mArray, mCount, cmp );
+  }
+
+  /*
+   * these inlines add some level of compatibility with STL.
+   */
+  typedef TYPE* iterator;
+  typedef TYPE const* const_iterator;
+
+  inline iterator begin() {
+    return mArray;
+  }
+  inline iterator end()   {
+    return mArray + mCount;
+  }
+  inline const_iterator begin() const {
+    return mArray;
+  }
+  inline const_iterator end() const   {
+    return mArray + mCount;
+  }
+  inline void reserve( size_t n ) {
+    setCapacity( n );
+  }
+  inline bool empty() const {
+    return isEmpty();
+  }
+  inline void push_back( const TYPE& item )  {
+    insertAt( item, mCount, 1 );
+  }
+  inline void push_back( TYPE&& item )  {
+    emplace( mCount, std::move( item ) );
+  }
+  inline void push_front( const TYPE& item ) {
+    insertAt( item, 0, 1 );
+  }
+  inline iterator erase( iterator pos ) {
+    return begin() + removeItemsAt( pos - mArray );
+  }
+
+private:
+  inline TYPE* _inline() {
+    return reinterpret_cast<TYPE*>( &mInline );
+  }
+  inline const TYPE* _inline() const {
+    return reinterpret_cast<const TYPE*>( &mInline );
+  }
+
+  TYPE* _grow( size_t where, size_t amount );
+  void _release_storage();
+  void _take( SmallVector<TYPE, N>& rhs );
+
+  TYPE* mArray;
+  size_t mCount;
+  size_t mCapacity;
+  typename std::aligned_storage<sizeof( TYPE ) * N, alignof( TYPE )>::type mInline;
+
+  static_assert( N > 0, "SmallVector needs some inline capacity, use Vector otherwise" );
+};
+
+// ---------------------------------------------------------------------------
+// No user serviceable parts from here...
+// ---------------------------------------------------------------------------
+
+template<class TYPE, size_t N> inline
+SmallVector<TYPE, N>::SmallVector()
+  : mArray( _inline() ), mCount( 0 ), mCapacity( N )
+{
+}
+
+template<class TYPE, size_t N> inline
+SmallVector<TYPE, N>::SmallVector( const SmallVector<TYPE, N>& rhs )
+  : mArray( _inline() ), mCount( 0 ), mCapacity( N )
+{
+  insertArrayAt( rhs.mArray, 0, rhs.mCount );
+}
+
+template<class TYPE, size_t N> inline
+SmallVector<TYPE, N>::SmallVector( SmallVector<TYPE, N>&& rhs )
+  : mArray( _inline() ), mCount( 0 ), mCapacity( N )
+{
+  _take( rhs );
+}
+
+template<class TYPE, size_t N> inline
+SmallVector<TYPE, N>::SmallVector( const Vector<TYPE>& rhs )
+  : mArray( _inline() ), mCount( 0 ), mCapacity( N )
+{
+  insertArrayAt( rhs.array(), 0, rhs.size() );
+}
+
+template<class TYPE, size_t N> inline
+SmallVector<TYPE, N>::~SmallVector()
+{
+  clear();
+}
+
+template<class TYPE, size_t N> inline
+SmallVector<TYPE, N>& SmallVector<TYPE, N>::operator = ( const SmallVector<TYPE, N>& rhs )
+{
+  if( this != &rhs ) {
+    destroy_type( mArray, mCount );
+    mCount = 0;
+    insertArrayAt( rhs.mArray, 0, rhs.mCount );
+  }
+  return *this;
+}
+
+template<class TYPE, size_t N> inline
+SmallVector<TYPE, N>& SmallVector<TYPE, N>::operator = ( SmallVector<TYPE, N>&& rhs )
+{
+  if( this != &rhs ) {
+    clear();
+    _take( rhs );
+  }
+  return *this;
+}
+
+template<class TYPE, size_t N> inline
+void SmallVector<TYPE, N>::_take( SmallVector<TYPE, N>& rhs )
+{
+  // this is empty and inline
+  if( rhs.isInline() ) {
+    move_backward_type( mArray, rhs.mArray, rhs.mCount );
+  } else {
+    mArray = rhs.mArray;
+    mCapacity = rhs.mCapacity;
+    rhs.mArray = rhs._inline();
+    rhs.mCapacity = N;
+  }
+  mCount = rhs.mCount;
+  rhs.mCount = 0;
+}
+
+template<class TYPE, size_t N> inline
+void SmallVector<TYPE, N>::clear()
+{
+  destroy_type( mArray, mCount );
+  mCount = 0;
+  _release_storage();
+}
+
+template<class TYPE, size_t N> inline
+void SmallVector<TYPE, N>::_release_storage()
+{
+  if( !isInline() ) {
+    SharedBuffer::bufferFromData( mArray )->release();
+    mArray = _inline();
+    mCapacity = N;
+  }
+}
+
+template<class TYPE, size_t N> inline
+const TYPE& SmallVector<TYPE, N>::operator[]( size_t index ) const
+{
+  LOG_FATAL_IF( index >= size(),
+                "%s: index=%u out of range (%u)", __PRETTY_FUNCTION__,
+                int( index ), int( size() ) );
+  return mArray[index];
+}
+
+template<class TYPE, size_t N>
+int SmallVector<TYPE, N>::setCapacity( size_t new_capacity )
+{
+  if( new_capacity <= mCapacity ) {
+    // we can't reduce the capacity
+    return mCapacity;
+  }
+  SharedBuffer* sb = SharedBuffer::alloc( new_capacity * sizeof( TYPE ) );
+  if( !sb ) {
+    return NO_MEMORY;
+  }
+  TYPE* array = static_cast<TYPE*>( sb->data() );
+  move_backward_type( array, mArray, mCount );
+  _release_storage();
+  mArray = array;
+  mCapacity = new_capacity;
+  return new_capacity;
+}
+
+template<class TYPE, size_t N>
+TYPE* SmallVector<TYPE, N>::_grow( size_t where, size_t amount )
+{
+  const size_t new_size = mCount + amount;
+  if( new_size > mCapacity ) {
+    const size_t new_capacity = MAX( 2 * N, ( ( new_size * 3 ) + 1 ) / 2 );
+    if( !isInline() && traits<TYPE>::has_trivial_move && where == mCount ) {
+      // grow in place if the allocator can
+      SharedBuffer* sb = SharedBuffer::bufferFromData( mArray )->editResize( new_capacity * sizeof( TYPE ) );
+      if( !sb ) {
+        return 0;
+      }
+      mArray = static_cast<TYPE*>( sb->data() );
+    } else {
+      SharedBuffer* sb = SharedBuffer::alloc( new_capacity * sizeof( TYPE ) );
+      if( !sb ) {
+        return 0;
+      }
+      TYPE* array = static_cast<TYPE*>( sb->data() );
+      move_backward_type( array, mArray, where );
+      move_backward_type( array + where + amount, mArray + where, mCount - where );
+      _release_storage();
+      mArray = array;
+    }
+    mCapacity = new_capacity;
+  } else if( where < mCount ) {
+    move_forward_type( mArray + where + amount, mArray + where, mCount - where );
+  }
+  mCount = new_size;
+  return mArray + where;
+}
+
+template<class TYPE, size_t N>
+int SmallVector<TYPE, N>::insertArrayAt( const TYPE* array, size_t index, size_t length )
+{
+  if( index > mCount ) {
+    return BAD_INDEX;
+  }
+  TYPE* where = _grow( index, length );
+  if( !where ) {
+    return NO_MEMORY;
+  }
+  copy_type( where, array, length );
+  return index;
+}
+
+template<class TYPE, size_t N>
+int SmallVector<TYPE, N>::insertAt( size_t index, size_t numItems )
+{
+  if( index > mCount ) {
+    return BAD_INDEX;
+  }
+  TYPE* where = _grow( index, numItems );
+  if( !where ) {
+    return NO_MEMORY;
+  }
+  construct_type( where, numItems );
+  return index;
+}
+
+template<class TYPE, size_t N>
+int SmallVector<TYPE, N>::insertAt( const TYPE& item, size_t index, size_t numItems )
+{
+  if( index > mCount ) {
+    return BAD_INDEX;
+  }
+  if( &item >= mArray && &item < mArray + mCount ) {
+    // the item would move before we copy it
+    const TYPE copy( item );
+    return insertAt( copy, index, numItems );
+  }
+  TYPE* where = _grow( index, numItems );
+  if( !where ) {
+    return NO_MEMORY;
+  }
+  splat_type( where, &item, numItems );
+  return index;
+}
+
+template<class TYPE, size_t N> template<typename... Args>
+int SmallVector<TYPE, N>::emplace( size_t index, Args&& ... args )
+{
+  if( index > mCount ) {
+    return BAD_INDEX;
+  }
+  if( mCount == mCapacity ) {
+    // args may refer to items that are about to move
+    TYPE item( std::forward<Args>( args )... );
+    TYPE* where = _grow( index, 1 );
+    if( !where ) {
+      return NO_MEMORY;
+    }
+    new( where ) TYPE( std::move( item ) );
+    return index;
+  }
+  TYPE* where = _grow( index, 1 );
+  new( where ) TYPE( std::forward<Args>( args )... );
+  return index;
+}
+
+template<class TYPE, size_t N> inline
+void SmallVector<TYPE, N>::pop()
+{
+  if( mCount ) {
+    destroy_type( mArray + mCount - 1, 1 );
+    mCount--;
+  }
+}
+
+template<class TYPE, size_t N>
+int SmallVector<TYPE, N>::replaceAt( size_t index )
+{
+  if( index >= mCount ) {
+    return BAD_INDEX;
+  }
+  mArray[index] = TYPE();
+  return index;
+}
+
+template<class TYPE, size_t N>
+int SmallVector<TYPE, N>::replaceAt( const TYPE& item, size_t index )
+{
+  if( index >= mCount ) {
+    return BAD_INDEX;
+  }
+  if( &mArray[index] != &item ) {
+    mArray[index] = item;
+  }
+  return index;
+}
+
+template<class TYPE, size_t N>
+int SmallVector<TYPE, N>::removeItemsAt( size_t index, size_t count )
+{
+  if( ( index + count ) > mCount ) {
+    return BAD_VALUE;
+  }
+  destroy_type( mArray + index, count );
+  move_backward_type( mArray + index, mArray + index + count, mCount - index - count );
+  mCount -= count;
+  return index;
+}
+
+} // namespace baseline
+
+#endif // BASELINE_SMALLVECTOR_H_
@@ -0,0 +1,450 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_SORT_H_
+#define BASELINE_SORT_H_
+
+#include <baseline/TypeHelpers.h>
+#include <baseline/StrongPointer.h>
+
+namespace baseline {
+
+class ExecutorService;
+
+/*
+ * Stable, adaptive merge sort.
+ *
+ * The array is split into natural runs (strictly descending runs are
+ * reversed in place), short runs are extended to a minimum length with
+ * binary insertion sort, and runs are then merged pairwise until one is
+ * left. Already sorted input costs n - 1 comparisons and no moves.
+ *
+ * cmp( lhs, rhs ) takes two const TYPE& and returns <0, 0 or >0 like
+ * compare_type(). It is called directly so it can be inlined.
+ */
+
+template<typename TYPE, typename Compare>
+status_t stable_sort_type( TYPE* a, size_t n, Compare cmp );
+
+namespace sort_detail {
+
+template<typename TYPE, typename Compare> inline
+void binary_insertion_sort( TYPE* a, size_t lo, size_t start, size_t hi, Compare& cmp )
+{
+  // a[lo, start) is already sorted
+  for( size_t i = start; i < hi; i++ ) {
+    if( !( cmp( a[i], a[i - 1] ) < 0 ) ) {
+      continue;
+    }
+    TYPE pivot( std::move( a[i] ) );
+    size_t l = lo;
+    size_t h = i - 1;
+    while( l < h ) {
+      const size_t mid = l + ( h - l ) / 2;
+      if( cmp( pivot, a[mid] ) < 0 ) {
+        h = mid;
+      } else {
+        l = mid + 1;
+      }
+    }
+    for( size_t j = i; j > l; j-- ) {
+      a[j] = std::move( a[j - 1] );
+    }
+    a[l] = std::move( pivot );
+  }
+}
+
+template<typename TYPE, typename Compare> inline
+size_t count_run( TYPE* a, size_t lo, size_t n, Compare& cmp )
+{
+  size_t hi = lo + 1;
+  if( hi == n ) {
+    return 1;
+  }
+  if( cmp( a[hi], a[lo] ) < 0 ) {
+    // only strictly descending runs may be reversed, or we lose stability
+    while( hi + 1 < n && cmp( a[hi + 1], a[hi] ) < 0 ) {
+      hi++;
+    }
+    hi++;
+    for( size_t l = lo, h = hi - 1; l < h; l++, h-- ) {
+      TYPE tmp( std::move( a[l] ) );
+      a[l] = std::move( a[h] );
+      a[h] = std::move( tmp );
+    }
+  } else {
+    while( hi + 1 < n && !( cmp( a[hi + 1], a[hi] ) < 0 ) ) {
+      hi++;
+    }
+    hi++;
+  }
+  return hi - lo;
+}
+
+template<typename TYPE, typename Compare> inline
+void merge_runs( TYPE* src, size_t lo, size_t mid, size_t hi, TYPE* dst, Compare& cmp )
+{
+  size_t i = lo;
+  size_t j = mid;
+  size_t k = lo;
+  if( !( cmp( src[mid], src[mid - 1] ) < 0 ) ) {
+    // runs are already in order
+    while( k < hi ) {
+      dst[k++] = std::move( src[i++] );
+    }
+    return;
+  }
+  while( i < mid && j < hi ) {
+    if( cmp( src[j], src[i] ) < 0 ) {
+      dst[k++] = std::move( src[j++] );
+    } else {
+      dst[k++] = std::move( src[i++] );
+    }
+  }
+  while( i < mid ) {
+    dst[k++] = std::move( src[i++] );
+  }
+  while( j < hi ) {
+    dst[k++] = std::move( src[j++] );
+  }
+}
+
+inline size_t min_run_length( size_t n )
+{
+  // same choice as TimSort: n / minrun is a power of two, or close to it
+  size_t r = 0;
+  while( n >= 64 ) {
+    r |= n & 1;
+    n >>= 1;
+  }
+  return n + r;
+}
+
+/*
+ * Splits a[0, n) into sorted runs of at least min_run_length( n ) items
+ * and stores their start offsets in bounds, terminated by n. Returns the
+ * number of runs. bounds must hold n / min_run_length( n ) + 2 entries.
+ */
+template<typename TYPE, typename Compare> inline
+size_t make_runs( TYPE* a, size_t n, size_t* bounds, Compare& cmp )
+{
+  const size_t minRun = min_run_length( n );
+  size_t numRuns = 0;
+  size_t lo = 0;
+  while( lo < n ) {
+    size_t len = count_run( a, lo, n, cmp );
+    if( len < minRun ) {
+      const size_t forced = MIN( minRun, n - lo );
+      binary_insertion_sort( a, lo, lo + len, lo + forced, cmp );
+      len = forced;
+    }
+    bounds[numRuns++] = lo;
+    lo += len;
+  }
+  bounds[numRuns] = n;
+  return numRuns;
+}
+
+/*
+ * Merges adjacent runs pairwise, ping-ponging between a and tmp, which
+ * must both hold n constructed items. The runs start out in a. Returns
+ * the array holding the result.
+ */
+template<typename TYPE, typename Compare> inline
+TYPE* merge_passes( TYPE* a, TYPE* tmp, size_t* bounds, size_t numRuns, Compare& cmp )
+{
+  TYPE* src = a;
+  TYPE* dst = tmp;
+  while( numRuns > 1 ) {
+    size_t out = 0;
+    size_t r = 0;
+    for( ; r + 1 < numRuns; r += 2 ) {
+      merge_runs( src, bounds[r], bounds[r + 1], bounds[r + 2], dst, cmp );
+      bounds[out++] = bounds[r];
+    }
+    if( r < numRuns ) {
+      // odd run out, carry it over
+      for( size_t k = bounds[r]; k < bounds[r + 1]; k++ ) {
+        dst[k] = std::move( src[k] );
+      }
+      bounds[out++] = bounds[r];
+    }
+    bounds[out] = bounds[numRuns];
+    numRuns = out;
+
+    TYPE* t = src;
+    src = dst;
+    dst = t;
+  }
+  return src;
+}
+
+/*
+ * Returns how many tasks a parallel operation on executor should be split
+ * into, 1 without an executor.
+ */
+size_t parallelism( const sp<ExecutorService>& executor );
+
+/*
+ * Calls fn( state, i ) for every i in [0, count) and returns once all of
+ * them have finished. The calling thread runs the first call itself and
+ * hands the others to executor, so it must not be one of executor's own
+ * threads. Without an executor everything runs on the calling thread.
+ */
+void run_tasks( const sp<ExecutorService>& executor, size_t count,
+                void ( *fn )( void* state, size_t index ), void* state );
+
+// fewer items than this are not worth handing to another thread
+enum { kParallelGrain = 8 * 1024, kMaxTasks = 64 };
+
+/*
+ * Returns how many items of a are among the first k items of the stable
+ * merge of a and b, where items of a go first on ties.
+ */
+template<typename TYPE, typename Compare> inline
+size_t co_rank( const TYPE* a, size_t na, const TYPE* b, size_t nb, size_t k, Compare& cmp )
+{
+  size_t lo = k > nb ? k - nb : 0;
+  size_t hi = MIN( k, na );
+  while( lo < hi ) {
+    const size_t mid = lo + ( hi - lo ) / 2;
+    if( cmp( b[k - mid - 1], a[mid] ) < 0 ) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+template<typename TYPE, typename Compare> inline
+void merge_into( TYPE* a, size_t na, TYPE* b, size_t nb, TYPE* dst, Compare& cmp )
+{
+  TYPE* const aEnd = a + na;
+  TYPE* const bEnd = b + nb;
+  while( a < aEnd && b < bEnd ) {
+    if( cmp( *b, *a ) < 0 ) {
+      *dst++ = std::move( *b++ );
+    } else {
+      *dst++ = std::move( *a++ );
+    }
+  }
+  while( a < aEnd ) {
+    *dst++ = std::move( *a++ );
+  }
+  while( b < bEnd ) {
+    *dst++ = std::move( *b++ );
+  }
+}
+
+/*
+ * State shared by the tasks of parallel_stable_sort_type(). Each chunk is
+ * sorted on its own, then runs are merged pairwise; every merge is cut
+ * into pieces at co-ranks so that all tasks get the same amount of output
+ * to produce, however unbalanced the runs are.
+ */
+template<typename TYPE, typename Compare>
+struct ParallelSort {
+  struct Piece {
+    size_t lo, mid, hi;   // runs src[lo, mid) and src[mid, hi)
+    size_t k0, k1;        // output range, relative to lo
+  };
+
+  ParallelSort( TYPE* a, TYPE* tmp, Compare& cmp )
+    : a( a ), tmp( tmp ), src( tmp ), dst( a ), cmp( cmp ) {}
+
+  static void sortChunk( void* state, size_t i ) {
+    ParallelSort* s = static_cast<ParallelSort*>( state );
+    const size_t lo = s->bounds[i];
+    const size_t hi = s->bounds[i + 1];
+    s->errors[i] = stable_sort_type( s->a + lo, hi - lo, s->cmp );
+    for( size_t k = lo; k < hi; k++ ) {
+      new( s->tmp + k ) TYPE( std::move( s->a[k] ) );
+    }
+  }
+
+  static void mergePiece( void* state, size_t i ) {
+    ParallelSort* s = static_cast<ParallelSort*>( state );
+    const Piece& p = s->pieces[i];
+    TYPE* a = s->src + p.lo;
+    TYPE* b = s->src + p.mid;
+    const size_t na = p.mid - p.lo;
+    const size_t nb = p.hi - p.mid;
+    const size_t i0 = co_rank( a, na, b, nb, p.k0, s->cmp );
+    const size_t i1 = co_rank( a, na, b, nb, p.k1, s->cmp );
+    merge_into( a + i0, i1 - i0, b + ( p.k0 - i0 ), ( p.k1 - i1 ) - ( p.k0 - i0 ),
+                s->dst + p.lo + p.k0, s->cmp );
+  }
+
+  static void finishChunk( void* state, size_t i ) {
+    ParallelSort* s = static_cast<ParallelSort*>( state );
+    const size_t lo = s->chunks[i];
+    const size_t hi = s->chunks[i + 1];
+    if( s->src == s->tmp ) {
+      for( size_t k = lo; k < hi; k++ ) {
+        s->a[k] = std::move( s->tmp[k] );
+      }
+    }
+    destroy_type( s->tmp + lo, hi - lo );
+  }
+
+  TYPE* a;
+  TYPE* tmp;
+  TYPE* src;
+  TYPE* dst;
+  Compare& cmp;
+  size_t chunks[kMaxTasks + 1];
+  size_t bounds[kMaxTasks + 1];
+  status_t errors[kMaxTasks];
+  Piece pieces[kMaxTasks + 1];
+};
+
+} // namespace sort_detail
+
+template<typename TYPE, typename Compare>
+status_t stable_sort_type( TYPE* a, size_t n, Compare cmp )
+{
+  if( n < 2 ) {
+    return NO_ERROR;
+  }
+
+  size_t* bounds = static_cast<size_t*>( malloc( ( n / sort_detail::min_run_length( n ) + 2 ) * sizeof( size_t ) ) );
+  if( !bounds ) {
+    return NO_MEMORY;
+  }
+
+  const size_t numRuns = sort_detail::make_runs( a, n, bounds, cmp );
+  if( numRuns > 1 ) {
+    TYPE* tmp = static_cast<TYPE*>( malloc( n * sizeof( TYPE ) ) );
+    if( !tmp ) {
+      free( bounds );
+      return NO_MEMORY;
+    }
+    for( size_t i = 0; i < n; i++ ) {
+      new( tmp + i ) TYPE( std::move( a[i] ) );
+    }
+    // the runs now live in tmp, the first pass merges them back into a
+    TYPE* result = sort_detail::merge_passes( tmp, a, bounds, numRuns, cmp );
+    if( result != a ) {
+      for( size_t i = 0; i < n; i++ ) {
+        a[i] = std::move( result[i] );
+      }
+    }
+    destroy_type( tmp, n );
+    free( tmp );
+  }
+
+  free( bounds );
+  return NO_ERROR;
+}
+
+/*
+ * Same as stable_sort_type(), with the work spread over the threads of
+ * executor. cmp is called from several threads at once and must not
+ * modify shared state. Falls back to stable_sort_type() for small arrays
+ * or when executor is null.
+ */
+template<typename TYPE, typename Compare>
+status_t parallel_stable_sort_type( TYPE* a, size_t n, Compare cmp, const sp<ExecutorService>& executor )
+{
+  using sort_detail::ParallelSort;
+  const size_t numChunks = MIN( MIN( sort_detail::parallelism( executor ), n / sort_detail::kParallelGrain ),
+                                size_t( sort_detail::kMaxTasks ) );
+  if( numChunks < 2 ) {
+    return stable_sort_type( a, n, cmp );
+  }
+
+  TYPE* tmp = static_cast<TYPE*>( malloc( n * sizeof( TYPE ) ) );
+  if( !tmp ) {
+    return NO_MEMORY;
+  }
+
+  ParallelSort<TYPE, Compare> s( a, tmp, cmp );
+  for( size_t i = 0; i <= numChunks; i++ ) {
+    s.chunks[i] = s.bounds[i] = n * i / numChunks;
+  }
+
+  // sort the chunks in place, then move them into tmp
+  sort_detail::run_tasks( executor, numChunks, &ParallelSort<TYPE, Compare>::sortChunk, &s );
+  status_t err = NO_ERROR;
+  for( size_t i = 0; i < numChunks; i++ ) {
+    if( s.errors[i] != NO_ERROR ) {
+      err = s.errors[i];
+    }
+  }
+
+  size_t numRuns = err == NO_ERROR ? numChunks : 1;
+  while( numRuns > 1 ) {
+    const size_t numPairs = numRuns / 2;
+    const size_t piecesPerPair = MAX( size_t( 1 ), numChunks / numPairs );
+    size_t numPieces = 0;
+    size_t out = 0;
+    size_t r = 0;
+    for( ; r + 1 < numRuns; r += 2 ) {
+      const size_t lo = s.bounds[r];
+      const size_t len = s.bounds[r + 2] - lo;
+      for( size_t q = 0; q < piecesPerPair; q++ ) {
+        typename ParallelSort<TYPE, Compare>::Piece& p = s.pieces[numPieces++];
+        p.lo = lo;
+        p.mid = s.bounds[r + 1];
+        p.hi = s.bounds[r + 2];
+        p.k0 = len * q / piecesPerPair;
+        p.k1 = len * ( q + 1 ) / piecesPerPair;
+      }
+      s.bounds[out++] = lo;
+    }
+    if( r < numRuns ) {
+      // odd run out, a merge with an empty run carries it over
+      typename ParallelSort<TYPE, Compare>::Piece& p = s.pieces[numPieces++];
+      p.lo = s.bounds[r];
+      p.mid = p.hi = s.bounds[r + 1];
+      p.k0 = 0;
+      p.k1 = p.hi - p.lo;
+      s.bounds[out++] = p.lo;
+    }
+    s.bounds[out] = n;
+    numRuns = out;
+
+    sort_detail::run_tasks( executor, numPieces, &ParallelSort<TYPE, Compare>::mergePiece, &s );
+    TYPE* t = s.src;
+    s.src = s.dst;
+    s.dst = t;
+  }
+
+  // the result is in s.src; bring it back to a if needed and destroy tmp
+  sort_detail::run_tasks( executor, numChunks, &ParallelSort<TYPE, Compare>::finishChunk, &s );
+  free( tmp );
+  return err;
+}
+
+/*
+ * Returns whether a[0, n) is already sorted according to cmp.
+ */
+template<typename TYPE, typename Compare>
+bool is_sorted_type( const TYPE* a, size_t n, Compare cmp )
+{
+  for( size_t i = 1; i < n; i++ ) {
+    if( cmp( a[i], a[i - 1] ) < 0 ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
+
+#endif // BASELINE_SORT_H_
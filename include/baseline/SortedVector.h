@@ -39,12 +39,16 @@ public:
 
   SortedVector();
   SortedVector( const SortedVector<TYPE>& rhs );
+  SortedVector( SortedVector<TYPE>&& rhs );
   virtual ~SortedVector();
 
   /*! copy operator */
   const SortedVector<TYPE>&   operator = ( const SortedVector<TYPE>& rhs ) const;
   SortedVector<TYPE>&         operator = ( const SortedVector<TYPE>& rhs );
 
+  /*! move operator, rhs is left empty */
+  SortedVector<TYPE>&         operator = ( SortedVector<TYPE>&& rhs );
+
   /*
    * empty the vector
    */
@@ -115,10 +119,14 @@ public:
     return *( static_cast<TYPE*>( VectorImpl::editItemLocation( index ) ) );
   }
 
-  //! merges a vector into this one
+  //! merges a vector into this one, items of vector replace equal ones
   int merge( const Vector<TYPE>& vector );
   int merge( const SortedVector<TYPE>& vector );
 
+  //! same as above, spread over the threads of executor
+  int merge( const Vector<TYPE>& vector, const sp<ExecutorService>& executor );
+  int merge( const SortedVector<TYPE>& vector, const sp<ExecutorService>& executor );
+
   //! removes an item
   int remove( const TYPE& );
 
@@ -154,7 +162,8 @@ SortedVector<TYPE>::SortedVector()
   : SortedVectorImpl( sizeof( TYPE ),
                       ( ( traits<TYPE>::has_trivial_ctor   ? HAS_TRIVIAL_CTOR   : 0 )
                         | ( traits<TYPE>::has_trivial_dtor   ? HAS_TRIVIAL_DTOR   : 0 )
-                        | ( traits<TYPE>::has_trivial_copy   ? HAS_TRIVIAL_COPY   : 0 ) )
+                        | ( traits<TYPE>::has_trivial_copy   ? HAS_TRIVIAL_COPY   : 0 )
+                        | ( traits<TYPE>::has_trivial_move   ? HAS_TRIVIAL_MOVE   : 0 ) )
                     )
 {
 }
@@ -165,6 +174,12 @@ SortedVector<TYPE>::SortedVector( const SortedVector<TYPE>& rhs )
 {
 }
 
+template<class TYPE> inline
+SortedVector<TYPE>::SortedVector( SortedVector<TYPE>&& rhs )
+  : SortedVectorImpl( std::move( static_cast<VectorImpl&>( rhs ) ) )
+{
+}
+
 template<class TYPE> inline
 SortedVector<TYPE>::~SortedVector()
 {
@@ -178,6 +193,13 @@ SortedVector<TYPE>& SortedVector<TYPE>::operator = ( const SortedVector<TYPE>& r
   return *this;
 }
 
+template<class TYPE> inline
+SortedVector<TYPE>& SortedVector<TYPE>::operator = ( SortedVector<TYPE>&& rhs )
+{
+  SortedVectorImpl::operator = ( std::move( static_cast<SortedVectorImpl&>( rhs ) ) );
+  return *this;
+}
+
 template<class TYPE> inline
 const SortedVector<TYPE>& SortedVector<TYPE>::operator = ( const SortedVector<TYPE>& rhs ) const
 {
@@ -219,22 +241,33 @@ const TYPE& SortedVector<TYPE>::top() const
   return *( array() + size() - 1 );
 }
 
+// lookups search the typed array directly rather than going through
+// SortedVectorImpl and do_compare(), see lower_bound_type()
+
 template<class TYPE> inline
 int SortedVector<TYPE>::add( const TYPE& item )
 {
-  return SortedVectorImpl::add( &item );
+  const size_t order = orderOf( item );
+  if( order < size() && compare_type( array()[order], item ) == 0 ) {
+    return VectorImpl::replaceAt( &item, order );
+  }
+  return VectorImpl::insertAt( &item, order, 1 );
 }
 
 template<class TYPE> inline
 int SortedVector<TYPE>::indexOf( const TYPE& item ) const
 {
-  return SortedVectorImpl::indexOf( &item );
+  const size_t order = orderOf( item );
+  if( order < size() && compare_type( array()[order], item ) == 0 ) {
+    return int( order );
+  }
+  return NAME_NOT_FOUND;
 }
 
 template<class TYPE> inline
 size_t SortedVector<TYPE>::orderOf( const TYPE& item ) const
 {
-  return SortedVectorImpl::orderOf( &item );
+  return lower_bound_type( array(), size(), item );
 }
 
 template<class TYPE> inline
@@ -249,10 +282,26 @@ int SortedVector<TYPE>::merge( const SortedVector<TYPE>& vector )
   return SortedVectorImpl::merge( reinterpret_cast<const SortedVectorImpl&>( vector ) );
 }
 
+template<class TYPE> inline
+int SortedVector<TYPE>::merge( const Vector<TYPE>& vector, const sp<ExecutorService>& executor )
+{
+  return SortedVectorImpl::merge( reinterpret_cast<const VectorImpl&>( vector ), executor );
+}
+
+template<class TYPE> inline
+int SortedVector<TYPE>::merge( const SortedVector<TYPE>& vector, const sp<ExecutorService>& executor )
+{
+  return SortedVectorImpl::merge( reinterpret_cast<const SortedVectorImpl&>( vector ), executor );
+}
+
 template<class TYPE> inline
 int SortedVector<TYPE>::remove( const TYPE& item )
 {
-  return SortedVectorImpl::remove( &item );
+  const int index = indexOf( item );
+  if( index >= 0 ) {
+    VectorImpl::removeItemsAt( index, 1 );
+  }
+  return index;
 }
 
 template<class TYPE> inline
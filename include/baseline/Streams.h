@@ -18,10 +18,14 @@
 #ifndef BASELINE_STREAMS_H_
 #define BASELINE_STREAMS_H_
 
+#include <baseline/UniquePointer.h>
+#include <baseline/Vector.h>
 
 namespace baseline {
 
 class SharedBuffer;
+class HashFunction;
+class BaseEncoding;
 
 class InputStream
 {
@@ -116,6 +120,110 @@ private:
 
 };
 
+/**
+ * Reads from another InputStream and updates one or more HashFunctions
+ * with every byte read, so that data is checksummed on its way through
+ * (for instance in pump()) instead of in a second pass over memory. The
+ * stream and the hash functions are not owned; close() closes in.
+ */
+class HashingInputStream : public InputStream
+{
+public:
+  HashingInputStream( InputStream& in, HashFunction& hash );
+
+  //! hash is also updated from here on
+  void addHash( HashFunction& hash );
+
+  //! number of bytes that went through
+  inline uint64_t count() const {
+    return mCount;
+  }
+
+  void close();
+  int read( uint8_t* buf, size_t off, size_t len );
+
+private:
+  InputStream& mIn;
+  Vector<HashFunction*> mHashes;
+  uint64_t mCount;
+};
+
+/**
+ * Same as HashingInputStream for writes: bytes are hashed as far as out
+ * accepted them.
+ */
+class HashingOutputStream : public OutputStream
+{
+public:
+  HashingOutputStream( OutputStream& out, HashFunction& hash );
+
+  //! hash is also updated from here on
+  void addHash( HashFunction& hash );
+
+  //! number of bytes that went through
+  inline uint64_t count() const {
+    return mCount;
+  }
+
+  void close();
+  int write( uint8_t* buf, size_t off, size_t len );
+
+private:
+  OutputStream& mOut;
+  Vector<HashFunction*> mHashes;
+  uint64_t mCount;
+};
+
+/**
+ * Encodes the bytes written to it with a BaseEncoding and writes the text
+ * to out, a few KB at a time. Bytes short of a whole group are held back
+ * until more arrive; close() encodes them as the final, partial group and
+ * closes out, so close() must be called to complete the text.
+ */
+class EncodingOutputStream : public OutputStream
+{
+public:
+  EncodingOutputStream( OutputStream& out, const BaseEncoding& encoding );
+
+  void close();
+  int write( uint8_t* buf, size_t off, size_t len );
+
+private:
+  int writeText( size_t len );
+
+  OutputStream& mOut;
+  const BaseEncoding& mEncoding;
+  uint8_t mPending[8];
+  size_t mPendingLen;
+  char mText[4096];
+};
+
+/**
+ * Reads text from in and returns the bytes it decodes to with a
+ * BaseEncoding. read() returns BAD_VALUE once the text turns out not to
+ * be valid. close() closes in.
+ */
+class DecodingInputStream : public InputStream
+{
+public:
+  DecodingInputStream( InputStream& in, const BaseEncoding& encoding );
+
+  void close();
+  int read( uint8_t* buf, size_t off, size_t len );
+
+private:
+  int fill();
+
+  InputStream& mIn;
+  const BaseEncoding& mEncoding;
+  bool mEof;
+  size_t mTextLen;
+  size_t mBytesPos;
+  size_t mBytesLen;
+  char mText[4096];
+  uint8_t mBytes[4096];
+};
+
 class IOProgress
 {
 public:
@@ -125,6 +233,31 @@ public:
 
 void pump( InputStream& in, OutputStream& out, IOProgress* callback = nullptr, bool closeOutput = true, bool closeInput = true );
 
+#ifdef BASELINE_THREAD_SUPPORT
+
+/**
+ * Creates a connected pair of streams: bytes written to out can be read
+ * from in, through a lock-free ring buffer of at least capacity bytes
+ * (rounded up to a power of two). One thread may write to out while
+ * another reads from in, so memory use stays bounded no matter how much
+ * data flows through.
+ *
+ * In blocking mode, write() waits for the reader to make room until all
+ * len bytes (at most INT_MAX per call) are written, and read() waits until at least one byte is
+ * available. In non-blocking mode, write() returns how many bytes fit
+ * (WOULD_BLOCK if none did) and read() returns 0 if nothing is buffered.
+ *
+ * Closing out lets the reader drain what is buffered, after which read()
+ * returns -1. Closing in makes further writes return DEAD_OBJECT. Either
+ * end is closed when it is deleted.
+ *
+ * @returns OK, or BAD_VALUE if capacity is 0
+ */
+status_t createPipe( size_t capacity, UniquePtr<OutputStream>& out, UniquePtr<InputStream>& in,
+                     bool blocking = true );
+
+#endif
+
 
 } // namespace baseline
 
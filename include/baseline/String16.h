@@ -22,6 +22,7 @@
 #include <baseline/SharedBuffer.h>
 #include <baseline/TypeHelpers.h>
 #include <baseline/Comparable.h>
+#include <baseline/FastHash.h>
 
 namespace baseline {
 
@@ -34,6 +35,7 @@ class String16 : public Comparable<String16>
 public:
   String16();
   String16( const String16& o );
+  String16( String16&& o );
   String16( const String16& o,
             size_t len,
             size_t begin = 0 );
@@ -48,6 +50,9 @@ public:
   inline  const char16_t*     string() const;
   inline  size_t              size() const;
 
+  //! hash64() of the UTF-16 code units of the string
+  inline  uint64_t            hash() const;
+
   inline  const SharedBuffer* sharedBuffer() const;
 
   void                setTo( const String16& other );
@@ -61,6 +66,7 @@ public:
   status_t            append( const char16_t* other, size_t len );
 
   inline  String16&           operator=( const String16& other );
+  inline  String16&           operator=( String16&& other );
 
   inline  String16&           operator+=( const String16& other );
   inline  String16            operator+( const String16& other ) const;
@@ -101,6 +107,12 @@ private:
 // require any change to the underlying SharedBuffer contents or reference count.
 ANDROID_TRIVIAL_MOVE_TRAIT( String16 )
 
+template<> inline hash_t hash_type( const String16& value )
+{
+  const uint64_t hash = value.hash();
+  return hash_t( hash ^ ( hash >> 32 ) );
+}
+
 TextOutput& operator<<( TextOutput& to, const String16& val );
 
 // ---------------------------------------------------------------------------
@@ -126,6 +138,11 @@ inline size_t String16::size() const
   return SharedBuffer::sizeFromData( mString ) / sizeof( char16_t ) -1;
 }
 
+inline uint64_t String16::hash() const
+{
+  return hash64( mString, size() * sizeof( char16_t ) );
+}
+
 inline const SharedBuffer* String16::sharedBuffer() const
 {
   return SharedBuffer::bufferFromData( mString );
@@ -137,6 +154,15 @@ inline String16& String16::operator=( const String16& other )
   return *this;
 }
 
+inline String16& String16::operator=( String16&& other )
+{
+  // swap buffers, other releases ours when it goes away
+  const char16_t* str = mString;
+  mString = other.mString;
+  other.mString = str;
+  return *this;
+}
+
 inline String16& String16::operator+=( const String16& other )
 {
   append( other );
@@ -23,7 +23,7 @@
 
 #include <baseline/SharedBuffer.h>
 #include <baseline/TypeHelpers.h>
-#include <baseline/Comparable.h>
+#include <baseline/FastHash.h>
 
 namespace baseline {
 
@@ -32,11 +32,20 @@ class TextOutput;
 
 //! This is a string holding UTF-8 characters. Does not allow the value more
 // than 0x10FFFF, which is not valid unicode codepoint.
-class String8 : public Comparable<String8>
+//
+// Strings of up to kInlineCapacity bytes are kept inside the object, so
+// that making, copying and destroying them does not allocate or touch a
+// reference count. Longer ones live in a SharedBuffer that copies share
+// until one of them is changed. Either way string() stays valid until
+// the string is changed or destroyed; it points into the object for
+// short strings, which is why String8 holds no pointer to itself and can
+// still be moved with memcpy().
+class String8
 {
 public:
   String8();
   String8( const String8& o );
+  String8( String8&& o );
   explicit                    String8( const char* o );
   explicit                    String8( const char* o, size_t numChars );
 
@@ -63,6 +72,10 @@ public:
   inline  size_t              bytes() const;
   inline  bool                isEmpty() const;
 
+  //! hash64() of the bytes of the string
+  inline  uint64_t            hash() const;
+
+  //! the buffer a long string is stored in, nullptr for a short one
   inline  const SharedBuffer* sharedBuffer() const;
 
   void                clear();
@@ -94,6 +107,7 @@ public:
   void                getUtf32( char32_t* dst ) const;
 
   inline  String8&            operator=( const String8& other );
+  inline  String8&            operator=( String8&& other );
   inline  String8&            operator=( const char* other );
 
   inline  String8&            operator+=( const String8& other );
@@ -104,6 +118,13 @@ public:
 
   inline  int                 compare( const String8& other ) const;
 
+  inline  bool                operator<( const String8& other ) const;
+  inline  bool                operator<=( const String8& other ) const;
+  inline  bool                operator==( const String8& other ) const;
+  inline  bool                operator!=( const String8& other ) const;
+  inline  bool                operator>=( const String8& other ) const;
+  inline  bool                operator>( const String8& other ) const;
+
   inline  bool                operator<( const char* other ) const;
   inline  bool                operator<=( const char* other ) const;
   inline  bool                operator==( const char* other ) const;
@@ -113,6 +134,11 @@ public:
 
   inline                      operator const char* () const;
 
+  /**
+   * Returns size + 1 writable bytes holding the string as it was, cut
+   * or grown to size bytes, or NULL if that can not be allocated. The
+   * string is size bytes long until unlockBuffer() sets its length.
+   */
   char*               lockBuffer( size_t size );
   void                unlockBuffer();
   status_t            unlockBuffer( size_t size );
@@ -220,22 +246,73 @@ public:
    */
   String8& convertToResPath();
 
+  //! the longest string kept inline, not counting the terminator
+  static const size_t kInlineCapacity = 23;
+
 private:
+  friend class StringBuilder;
+
   status_t            real_append( const char* other, size_t numChars );
   char*               find_extension( void ) const;
 
-  const char* mString;
+  // the last inline byte is kInlineCapacity - length for a short string,
+  // which makes it the terminator of one that fills the space, and
+  // kHeapTag for a long one
+  static const uint8_t kHeapTag = 0xFF;
+
+  inline  bool                isInline() const;
+  inline  void                setEmpty();
+  inline  void                setInlineLength( size_t len );
+  inline  void                setHeap( const char* str );
+  void                        releaseHeap();
+  void                        initFrom( const char* other, size_t len );
+
+  union {
+    const char* mHeap;
+    char mInline[kInlineCapacity + 1];
+  };
 };
 
 // String8 can be trivially moved using memcpy() because moving does not
 // require any change to the underlying SharedBuffer contents or reference count.
 ANDROID_TRIVIAL_MOVE_TRAIT( String8 )
 
+// String8::hash() folded to 32 bits. Hash tables cache the result, so
+// a key is hashed once no matter how often the table grows.
+template<> inline hash_t hash_type( const String8& value )
+{
+  const uint64_t hash = value.hash();
+  return hash_t( hash ^ ( hash >> 32 ) );
+}
+
 TextOutput& operator<<( TextOutput& to, const String16& val );
 
 // ---------------------------------------------------------------------------
 // No user servicable parts below.
 
+inline bool String8::isInline() const
+{
+  return uint8_t( mInline[kInlineCapacity] ) != kHeapTag;
+}
+
+inline void String8::setEmpty()
+{
+  mInline[0] = '\0';
+  mInline[kInlineCapacity] = char( kInlineCapacity );
+}
+
+inline void String8::setInlineLength( size_t len )
+{
+  mInline[len] = '\0';
+  mInline[kInlineCapacity] = char( kInlineCapacity - len );
+}
+
+inline void String8::setHeap( const char* str )
+{
+  mHeap = str;
+  mInline[kInlineCapacity] = char( kHeapTag );
+}
+
 inline int compare_type( const String8& lhs, const String8& rhs )
 {
   return lhs.compare( rhs );
@@ -253,12 +330,15 @@ inline const String8 String8::empty()
 
 inline const char* String8::string() const
 {
-  return mString;
+  return isInline() ? mInline : mHeap;
 }
 
 inline size_t String8::length() const
 {
-  return SharedBuffer::sizeFromData( mString ) - 1;
+  if( isInline() ) {
+    return kInlineCapacity - uint8_t( mInline[kInlineCapacity] );
+  }
+  return SharedBuffer::sizeFromData( mHeap ) - 1;
 }
 
 inline size_t String8::size() const
@@ -266,6 +346,11 @@ inline size_t String8::size() const
   return length();
 }
 
+inline uint64_t String8::hash() const
+{
+  return hash64( string(), length() );
+}
+
 inline bool String8::isEmpty() const
 {
   return length() == 0;
@@ -273,12 +358,12 @@ inline bool String8::isEmpty() const
 
 inline size_t String8::bytes() const
 {
-  return SharedBuffer::sizeFromData( mString ) - 1;
+  return length();
 }
 
 inline const SharedBuffer* String8::sharedBuffer() const
 {
-  return SharedBuffer::bufferFromData( mString );
+  return isInline() ? nullptr : SharedBuffer::bufferFromData( mHeap );
 }
 
 inline String8& String8::operator=( const String8& other )
@@ -287,6 +372,16 @@ inline String8& String8::operator=( const String8& other )
   return *this;
 }
 
+inline String8& String8::operator=( String8&& other )
+{
+  // swap, other releases our buffer when it goes away
+  char tmp[sizeof( mInline )];
+  memcpy( tmp, mInline, sizeof( mInline ) );
+  memcpy( mInline, other.mInline, sizeof( mInline ) );
+  memcpy( other.mInline, tmp, sizeof( mInline ) );
+  return *this;
+}
+
 inline String8& String8::operator=( const char* other )
 {
   setTo( other );
@@ -321,42 +416,73 @@ inline String8 String8::operator+( const char* other ) const
 
 inline int String8::compare( const String8& other ) const
 {
-  return strcmp( mString, other.mString );
+  return strcmp( string(), other.string() );
+}
+
+inline bool String8::operator<( const String8& other ) const
+{
+  return compare( other ) < 0;
+}
+
+inline bool String8::operator<=( const String8& other ) const
+{
+  return compare( other ) <= 0;
+}
+
+inline bool String8::operator==( const String8& other ) const
+{
+  const size_t len = length();
+  return len == other.length() && memcmp( string(), other.string(), len ) == 0;
+}
+
+inline bool String8::operator!=( const String8& other ) const
+{
+  return !operator==( other );
+}
+
+inline bool String8::operator>=( const String8& other ) const
+{
+  return compare( other ) >= 0;
+}
+
+inline bool String8::operator>( const String8& other ) const
+{
+  return compare( other ) > 0;
 }
 
 inline bool String8::operator<( const char* other ) const
 {
-  return strcmp( mString, other ) < 0;
+  return strcmp( string(), other ) < 0;
 }
 
 inline bool String8::operator<=( const char* other ) const
 {
-  return strcmp( mString, other ) <= 0;
+  return strcmp( string(), other ) <= 0;
 }
 
 inline bool String8::operator==( const char* other ) const
 {
-  return strcmp( mString, other ) == 0;
+  return strcmp( string(), other ) == 0;
 }
 
 inline bool String8::operator!=( const char* other ) const
 {
-  return strcmp( mString, other ) != 0;
+  return strcmp( string(), other ) != 0;
 }
 
 inline bool String8::operator>=( const char* other ) const
 {
-  return strcmp( mString, other ) >= 0;
+  return strcmp( string(), other ) >= 0;
 }
 
 inline bool String8::operator>( const char* other ) const
 {
-  return strcmp( mString, other ) > 0;
+  return strcmp( string(), other ) > 0;
 }
 
 inline String8::operator const char* () const
 {
-  return mString;
+  return string();
 }
 
 
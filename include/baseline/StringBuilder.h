@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_STRINGBUILDER_H_
+#define BASELINE_STRINGBUILDER_H_
+
+#include <stdarg.h>
+#include <string.h>
+
+#include <baseline/String8.h>
+
+namespace baseline {
+
+/**
+ * Assembles a string from many pieces. Unlike String8, which keeps its
+ * buffer exactly as long as the string, the builder grows its buffer by
+ * half again whenever it runs out, so n appends cost O(n) copies in
+ * total. Numbers are formatted without going through printf, and
+ * appendFormat() formats straight into the spare capacity.
+ *
+ * toString8() hands the buffer over to a String8 without copying it
+ * (strings that fit inline in a String8 are copied instead, and the
+ * builder keeps its buffer for reuse).
+ *
+ * Appends return NO_MEMORY, and leave the builder as it was, if the
+ * buffer cannot grow.
+ */
+class StringBuilder
+{
+public:
+  StringBuilder();
+  explicit StringBuilder( size_t capacity );
+  StringBuilder( StringBuilder&& o );
+  ~StringBuilder();
+
+  StringBuilder& operator=( StringBuilder&& o );
+
+  //! the string so far, always terminated
+  inline const char* string() const {
+    return mData ? mData : "";
+  }
+  inline size_t length() const {
+    return mLength;
+  }
+  inline bool isEmpty() const {
+    return mLength == 0;
+  }
+  //! how long the string can get before the buffer grows
+  inline size_t capacity() const {
+    return mCapacity;
+  }
+
+  //! makes room for at least capacity bytes, not counting the terminator
+  status_t reserve( size_t capacity );
+  //! trims the buffer down to the length of the string
+  status_t shrink();
+  //! empties the string, keeping the buffer
+  void clear();
+  //! cuts the string down to length bytes
+  void truncate( size_t length );
+
+  inline status_t append( const char* str, size_t len ) {
+    if( len == 0 || len > mCapacity - mLength ) {
+      return appendSlow( str, len );
+    }
+    memcpy( mData + mLength, str, len );
+    setLength( mLength + len );
+    return NO_ERROR;
+  }
+  status_t append( const char* str );
+  status_t append( const String8& str );
+  inline status_t append( char c ) {
+    if( mLength == mCapacity ) {
+      return appendSlow( &c, 1 );
+    }
+    mData[mLength] = c;
+    setLength( mLength + 1 );
+    return NO_ERROR;
+  }
+
+  //! decimal, with a '-' for negative values
+  status_t appendInt( int64_t value );
+  status_t appendUnsigned( uint64_t value );
+  //! lower case hex without a prefix, padded with zeros to minDigits
+  status_t appendHex( uint64_t value, unsigned minDigits = 1 );
+  //! the same digits as printf( "%.*f", precision, value )
+  status_t appendDouble( double value, int precision = 6 );
+
+  status_t appendFormat( const char* fmt, ... )
+#if defined(__GNUC__) || defined(__clang__)
+  __attribute__( ( format( printf, 2, 3 ) ) )
+#endif
+  ;
+  status_t appendFormatV( const char* fmt, va_list args );
+
+  /**
+   * Moves the string into a String8 and leaves the builder empty. A long
+   * string keeps its buffer, trimmed to size.
+   */
+  String8 toString8();
+
+private:
+  char* grow( size_t extra );
+  inline void setLength( size_t length ) {
+    mLength = length;
+    mData[length] = '\0';
+  }
+  status_t appendSlow( const char* str, size_t len );
+
+  // data() of a SharedBuffer of mCapacity + 1 bytes, or NULL
+  char* mData;
+  size_t mLength;
+  size_t mCapacity;
+
+  StringBuilder( const StringBuilder& );
+  StringBuilder& operator=( const StringBuilder& );
+};
+
+}
+
+#endif // BASELINE_STRINGBUILDER_H_
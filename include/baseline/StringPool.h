@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BASELINE_STRINGPOOL_H_
+#define BASELINE_STRINGPOOL_H_
+
+#include <baseline/String8.h>
+#include <baseline/TypeHelpers.h>
+#include <baseline/Vector.h>
+
+#include <atomic>
+
+#ifdef BASELINE_THREAD_SUPPORT
+
+#include <baseline/Mutex.h>
+
+namespace baseline {
+
+namespace stringpool_detail {
+
+struct Entry {
+  uint64_t hash;
+  //! epoch of the last lookup, kDead once purged
+  std::atomic<uint32_t> epoch;
+  uint32_t length;
+  char data[1];
+};
+
+}
+
+/**
+ * A handle to a string in a StringPool. There is one handle value per
+ * distinct string in a pool, so == and != compare pointers and hash()
+ * returns a hash computed once when the string was added; copying a
+ * handle copies a pointer.
+ *
+ * The default handle stands for the empty string, which is also what
+ * interning "" returns. Handles from different pools never compare equal.
+ */
+class InternedString
+{
+public:
+  inline InternedString() : mEntry( nullptr ) {}
+
+  inline const char* string() const {
+    return mEntry ? mEntry->data : "";
+  }
+  inline size_t length() const {
+    return mEntry ? mEntry->length : 0;
+  }
+  inline bool isEmpty() const {
+    return mEntry == nullptr;
+  }
+  //! the same value String8::hash() returns for the same bytes
+  inline uint64_t hash() const {
+    return mEntry ? mEntry->hash : hash64( "", 0 );
+  }
+  inline String8 toString8() const {
+    return String8( string(), length() );
+  }
+
+  inline bool operator==( const InternedString& rhs ) const {
+    return mEntry == rhs.mEntry;
+  }
+  inline bool operator!=( const InternedString& rhs ) const {
+    return mEntry != rhs.mEntry;
+  }
+
+private:
+  friend class StringPool;
+
+  explicit inline InternedString( const stringpool_detail::Entry* entry ) : mEntry( entry ) {}
+
+  const stringpool_detail::Entry* mEntry;
+};
+
+ANDROID_TRIVIAL_DTOR_TRAIT( InternedString )
+ANDROID_TRIVIAL_COPY_TRAIT( InternedString )
+ANDROID_TRIVIAL_MOVE_TRAIT( InternedString )
+
+// folded the same way as String8, so both hash a string alike
+template<> inline hash_t hash_type( const InternedString& value )
+{
+  const uint64_t hash = value.hash();
+  return hash_t( hash ^ ( hash >> 32 ) );
+}
+
+/**
+ * Maps strings to canonical InternedString handles. Any number of
+ * threads may call intern() and find() at once.
+ *
+ * The pool is split into 64 shards by hash, each an open-addressing table
+ * of entry pointers. Lookups do not lock: they probe whichever table the
+ * shard currently publishes. Adding a string locks only its shard, and a
+ * shard that grows publishes a new table and retires the old one.
+ *
+ * Strings stay in the pool until it is destroyed, unless purge() is used.
+ * purge( maxAge ) removes the strings that no intern() or find() returned
+ * in the last maxAge epochs; handles to them, and tables replaced since,
+ * are freed by the second advanceEpoch() after that. A program that
+ * purges must therefore:
+ * - call advanceEpoch() only when every intern() and find() that started
+ *   before the previous advanceEpoch() has returned, e.g. once per tick
+ *   of a main loop that the other threads also pace themselves by.
+ * - not keep a handle for more than maxAge epochs without interning the
+ *   string again.
+ * A purged string is never returned again; interning it adds a new entry.
+ */
+class StringPool
+{
+public:
+  StringPool();
+  //! frees every string; all handles from this pool become invalid
+  ~StringPool();
+
+  //! returns the handle for str, adding it to the pool if needed
+  InternedString intern( const char* str, size_t len );
+  InternedString intern( const char* str );
+  InternedString intern( const String8& str );
+
+  //! returns the handle for str, or the empty handle if it is not pooled
+  InternedString find( const char* str, size_t len );
+  InternedString find( const char* str );
+  InternedString find( const String8& str );
+
+  //! number of strings in the pool
+  size_t size() const;
+
+  uint32_t epoch() const;
+
+  /**
+   * Starts a new epoch and frees what purge() and table growth retired
+   * two or more epochs ago. Returns the new epoch.
+   */
+  uint32_t advanceEpoch();
+
+  /**
+   * Removes the strings not returned by intern() or find() in the last
+   * maxAge epochs. Returns how many were removed.
+   */
+  size_t purge( uint32_t maxAge );
+
+private:
+  typedef stringpool_detail::Entry Entry;
+
+  enum {
+    kShardBits = 6,
+    kShards = 1 << kShardBits,
+    kInitialSlots = 16,
+    kCacheLine = 64
+  };
+  // entries keep the low 31 bits of the epoch, kDead is out of that range
+  static const uint32_t kEpochMask = 0x7FFFFFFFu;
+  static const uint32_t kDead = 0x80000000u;
+
+  struct Table {
+    uint32_t mask;
+    std::atomic<Entry*> slots[1];
+  };
+
+  struct Shard {
+    std::atomic<Table*> table;
+    std::atomic<uint32_t> count;
+    Mutex lock;
+    char pad[kCacheLine];
+  };
+
+  struct Retired {
+    void* ptr;
+    uint32_t epoch;
+  };
+
+  static Table* allocTable( uint32_t slots );
+  static Entry* probe( const Table* table, uint64_t hash, const char* str, size_t len );
+  static void place( Table* table, Entry* entry );
+
+  inline Shard& shardFor( uint64_t hash ) {
+    return mShards[hash >> ( 64 - kShardBits )];
+  }
+  bool touch( Entry* entry );
+  Entry* lookup( const char* str, size_t len, uint64_t hash, bool add );
+  void retire( void* ptr );
+
+  Shard mShards[kShards];
+  std::atomic<uint32_t> mEpoch;
+  Mutex mRetiredLock;
+  Vector<Retired> mRetired;
+
+  StringPool( const StringPool& );
+  StringPool& operator = ( const StringPool& );
+};
+
+}
+
+#endif // BASELINE_THREAD_SUPPORT
+
+#endif // BASELINE_STRINGPOOL_H_
@@ -62,8 +62,10 @@ public:
 
   sp( T* other );
   sp( const sp<T>& other );
+  sp( sp<T>&& other );
   template<typename U> sp( U* other );
   template<typename U> sp( const sp<U>& other );
+  template<typename U> sp( sp<U>&& other );
 
   ~sp();
 
@@ -71,8 +73,10 @@ public:
 
   sp& operator = ( T* other );
   sp& operator = ( const sp<T>& other );
+  sp& operator = ( sp<T>&& other );
 
   template<typename U> sp& operator = ( const sp<U>& other );
+  template<typename U> sp& operator = ( sp<U>&& other );
   template<typename U> sp& operator = ( U* other );
 
   //! Special optimization for use by ProcessState (and nobody else).
@@ -136,6 +140,13 @@ sp<T>::sp( const sp<T>& other )
   }
 }
 
+template<typename T>
+sp<T>::sp( sp<T>&& other )
+  : m_ptr( other.m_ptr )
+{
+  other.m_ptr = 0;
+}
+
 template<typename T> template<typename U>
 sp<T>::sp( U* other ) : m_ptr( other )
 {
@@ -153,6 +164,13 @@ sp<T>::sp( const sp<U>& other )
   }
 }
 
+template<typename T> template<typename U>
+sp<T>::sp( sp<U>&& other )
+  : m_ptr( other.m_ptr )
+{
+  other.m_ptr = 0;
+}
+
 template<typename T>
 sp<T>::~sp()
 {
@@ -175,6 +193,18 @@ sp<T>& sp<T>::operator = ( const sp<T>& other )
   return *this;
 }
 
+template<typename T>
+sp<T>& sp<T>::operator = ( sp<T>&& other )
+{
+  T* otherPtr( other.m_ptr );
+  other.m_ptr = 0;
+  if( m_ptr ) {
+    m_ptr->decStrong( this );
+  }
+  m_ptr = otherPtr;
+  return *this;
+}
+
 template<typename T>
 sp<T>& sp<T>::operator = ( T* other )
 {
@@ -202,6 +232,18 @@ sp<T>& sp<T>::operator = ( const sp<U>& other )
   return *this;
 }
 
+template<typename T> template<typename U>
+sp<T>& sp<T>::operator = ( sp<U>&& other )
+{
+  T* otherPtr( other.m_ptr );
+  other.m_ptr = 0;
+  if( m_ptr ) {
+    m_ptr->decStrong( this );
+  }
+  m_ptr = otherPtr;
+  return *this;
+}
+
 template<typename T> template<typename U>
 sp<T>& sp<T>::operator = ( U* other )
 {
@@ -35,6 +35,9 @@ public:
 
   static void sleep( uint32_t millisec );
 
+  //! lets other threads run, for loops waiting on another thread
+  static void yield();
+
 private:
   void* mData;
 };
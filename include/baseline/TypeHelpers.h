@@ -20,6 +20,7 @@
 #define BASELINE_TYPEHELPERS_H_
 
 #include <new>
+#include <utility>
 
 namespace baseline {
 
@@ -200,7 +201,7 @@ void move_forward_type( TYPE* d, const TYPE* s, size_t n = 1 )
     while( n-- ) {
       --d, --s;
       if( !traits<TYPE>::has_trivial_copy ) {
-        new( d ) TYPE( *s );
+        new( d ) TYPE( std::move( *const_cast<TYPE*>( s ) ) );
       } else {
         *d = *s;
       }
@@ -220,7 +221,7 @@ void move_backward_type( TYPE* d, const TYPE* s, size_t n = 1 )
   } else {
     while( n-- ) {
       if( !traits<TYPE>::has_trivial_copy ) {
-        new( d ) TYPE( *s );
+        new( d ) TYPE( std::move( *const_cast<TYPE*>( s ) ) );
       } else {
         *d = *s;
       }
@@ -163,6 +163,37 @@ extern "C" {
    */
   void utf8_to_utf16( const uint8_t* src, size_t srcLen, char16_t* dst );
 
+  /**
+   * Returns true if the src_len bytes at src are well formed UTF-8: no
+   * stray or missing continuation bytes, overlong forms, surrogates or
+   * code points above U+10FFFF. Unlike utf8_length(), src need not be
+   * null-terminated and may contain nulls.
+   */
+  bool utf8_validate( const uint8_t* src, size_t src_len );
+
+  /**
+   * Converts UTF-8 to UTF-16 in one pass, checking it as utf8_validate()
+   * does. dst must have room for src_len units, which is the most there
+   * can be. Returns the number of units written, without a null
+   * terminator, or -1 if src is not valid, in which case dst holds
+   * garbage.
+   */
+  ssize_t utf8_to_utf16_checked( const uint8_t* src, size_t src_len, char16_t* dst );
+
+  /**
+   * Same as utf8_to_utf16_checked() for UTF-32. dst must have room for
+   * src_len code points.
+   */
+  ssize_t utf8_to_utf32_checked( const uint8_t* src, size_t src_len, char32_t* dst );
+
+  /**
+   * Converts UTF-16 to UTF-8 in one pass. dst must have room for
+   * 3 * src_len bytes, which is the most there can be. Returns the number
+   * of bytes written, without a null terminator, or -1 if src has an
+   * unpaired surrogate.
+   */
+  ssize_t utf16_to_utf8_checked( const char16_t* src, size_t src_len, char* dst );
+
 
 
 }
@@ -21,6 +21,8 @@
 
 #include <baseline/VectorImpl.h>
 #include <baseline/TypeHelpers.h>
+#include <baseline/Search.h>
+#include <baseline/Sort.h>
 
 namespace baseline {
 
@@ -45,6 +47,7 @@ public:
 
   Vector();
   Vector( const Vector<TYPE>& rhs );
+  Vector( Vector<TYPE>&& rhs );
   explicit                Vector( const SortedVector<TYPE>& rhs );
   virtual                 ~Vector();
 
@@ -52,6 +55,9 @@ public:
   Vector<TYPE>&           operator = ( const Vector<TYPE>& rhs );
   Vector<TYPE>&           operator = ( const SortedVector<TYPE>& rhs );
 
+  /*! move operator, rhs is left empty */
+  Vector<TYPE>&           operator = ( Vector<TYPE>&& rhs );
+
   /*
   * empty the vector
   */
@@ -100,6 +106,8 @@ public:
   inline  const TYPE&     itemAt( size_t index ) const;
   //! stack-usage of the vector. returns the top of the stack (last element)
   const TYPE&     top() const;
+  //! index of the first item equal to item (via == operator), or NAME_NOT_FOUND
+  inline  int     indexOf( const TYPE& item ) const;
 
   /*!
    * modifying the array
@@ -141,10 +149,20 @@ public:
   inline  void            push();
   //! pushes an item on the top of the stack
   void            push( const TYPE& item );
+  //! pushes an item on the top of the stack, moving it in place
+  void            push( TYPE&& item );
   //! same as push() but returns the index the item was added at (or an error)
   inline  int         add();
   //! same as push() but returns the index the item was added at (or an error)
   int         add( const TYPE& item );
+  //! same as push() but returns the index the item was added at (or an error)
+  int         add( TYPE&& item );
+  //! insert an item constructed in place from args
+  template<typename... Args>
+  int         emplace( size_t index, Args&& ... args );
+  //! add an item constructed in place from args at the end of the vector
+  template<typename... Args>
+  int         emplace_back( Args&& ... args );
   //! replace an item with a new one initialized with its default constructor
   inline  int         replaceAt( size_t index );
   //! replace an item with a new one
@@ -171,6 +189,20 @@ public:
   inline status_t        sort( compar_t cmp );
   inline status_t        sort( compar_r_t cmp, void* state );
 
+  //! sort (stable) in natural order (via < operator)
+  inline status_t        sort();
+
+  //! sort (stable) with a functor cmp( const TYPE&, const TYPE& ) returning
+  //! <0, 0 or >0. the call is inlined, prefer this over a function pointer.
+  template<typename Compare>
+  status_t               sort( Compare cmp );
+
+  //! same as above, spread over the threads of executor. cmp is called
+  //! from several threads at once.
+  inline status_t        sort( compar_t cmp, const sp<ExecutorService>& executor );
+  template<typename Compare>
+  status_t               sort( Compare cmp, const sp<ExecutorService>& executor );
+
   // for debugging only
   inline size_t getItemSize() const {
     return itemSize();
@@ -203,7 +235,10 @@ public:
     return isEmpty();
   }
   inline void push_back( const TYPE& item )  {
-    insertAt( item, size(), 1 );
+    push( item );
+  }
+  inline void push_back( TYPE&& item )  {
+    emplace( size(), std::move( item ) );
   }
   inline void push_front( const TYPE& item ) {
     insertAt( item, 0, 1 );
@@ -219,6 +254,13 @@ protected:
   virtual void    do_splat( void* dest, const void* item, size_t num ) const;
   virtual void    do_move_forward( void* dest, const void* from, size_t num ) const;
   virtual void    do_move_backward( void* dest, const void* from, size_t num ) const;
+
+private:
+  // the common cases that need neither a copy nor a reallocation are
+  // handled here, inlined for TYPE. the rest goes through VectorImpl.
+  inline TYPE*    _owned_items() const;
+  inline TYPE*    _append_slot() const;
+  inline TYPE*    _removable_items( size_t count ) const;
 };
 
 // Vector<T> can be trivially moved using memcpy() because moving does not
@@ -236,7 +278,8 @@ Vector<TYPE>::Vector()
   : VectorImpl( sizeof( TYPE ),
                 ( ( traits<TYPE>::has_trivial_ctor   ? HAS_TRIVIAL_CTOR   : 0 )
                   | ( traits<TYPE>::has_trivial_dtor   ? HAS_TRIVIAL_DTOR   : 0 )
-                  | ( traits<TYPE>::has_trivial_copy   ? HAS_TRIVIAL_COPY   : 0 ) )
+                  | ( traits<TYPE>::has_trivial_copy   ? HAS_TRIVIAL_COPY   : 0 )
+                  | ( traits<TYPE>::has_trivial_move   ? HAS_TRIVIAL_MOVE   : 0 ) )
               )
 {
 }
@@ -247,6 +290,12 @@ Vector<TYPE>::Vector( const Vector<TYPE>& rhs )
 {
 }
 
+template<class TYPE> inline
+Vector<TYPE>::Vector( Vector<TYPE>&& rhs )
+  : VectorImpl( std::move( static_cast<VectorImpl&>( rhs ) ) )
+{
+}
+
 template<class TYPE> inline
 Vector<TYPE>::Vector( const SortedVector<TYPE>& rhs )
   : VectorImpl( static_cast<const VectorImpl&>( rhs ) )
@@ -273,16 +322,51 @@ Vector<TYPE>& Vector<TYPE>::operator = ( const SortedVector<TYPE>& rhs )
   return *this;
 }
 
+template<class TYPE> inline
+Vector<TYPE>& Vector<TYPE>::operator = ( Vector<TYPE>&& rhs )
+{
+  VectorImpl::operator = ( std::move( static_cast<VectorImpl&>( rhs ) ) );
+  return *this;
+}
+
 template<class TYPE> inline
 const TYPE* Vector<TYPE>::array() const
 {
   return static_cast<const TYPE*>( arrayImpl() );
 }
 
+template<class TYPE> inline
+TYPE* Vector<TYPE>::_owned_items() const
+{
+  return static_cast<TYPE*>( ownedStorage() );
+}
+
+template<class TYPE> inline
+TYPE* Vector<TYPE>::_append_slot() const
+{
+  TYPE* items = _owned_items();
+  if( items && storageSize() >= ( size() + 1 ) * sizeof( TYPE ) ) {
+    return items + size();
+  }
+  return 0;
+}
+
+template<class TYPE> inline
+TYPE* Vector<TYPE>::_removable_items( size_t count ) const
+{
+  // VectorImpl shrinks the storage below a third of its capacity
+  TYPE* items = _owned_items();
+  if( items && ( size() - count ) * 3 * sizeof( TYPE ) >= storageSize() ) {
+    return items;
+  }
+  return 0;
+}
+
 template<class TYPE> inline
 TYPE* Vector<TYPE>::editArray()
 {
-  return static_cast<TYPE*>( editArrayImpl() );
+  TYPE* items = _owned_items();
+  return items ? items : static_cast<TYPE*>( editArrayImpl() );
 }
 
 
@@ -307,16 +391,27 @@ const TYPE& Vector<TYPE>::top() const
   return *( array() + size() - 1 );
 }
 
+template<class TYPE> inline
+int Vector<TYPE>::indexOf( const TYPE& item ) const
+{
+  const size_t index = find_type( array(), size(), item );
+  return index < size() ? int( index ) : int( NAME_NOT_FOUND );
+}
+
 template<class TYPE> inline
 TYPE& Vector<TYPE>::editItemAt( size_t index )
 {
+  TYPE* items = _owned_items();
+  if( items ) {
+    return items[index];
+  }
   return *( static_cast<TYPE*>( editItemLocation( index ) ) );
 }
 
 template<class TYPE> inline
 TYPE& Vector<TYPE>::editTop()
 {
-  return *( static_cast<TYPE*>( editItemLocation( size() - 1 ) ) );
+  return editItemAt( size() - 1 );
 }
 
 template<class TYPE> inline
@@ -352,18 +447,71 @@ int Vector<TYPE>::insertAt( const TYPE& item, size_t index, size_t numItems )
 template<class TYPE> inline
 void Vector<TYPE>::push( const TYPE& item )
 {
-  return VectorImpl::push( &item );
+  add( item );
+}
+
+template<class TYPE> inline
+void Vector<TYPE>::push( TYPE&& item )
+{
+  emplace( size(), std::move( item ) );
 }
 
 template<class TYPE> inline
 int Vector<TYPE>::add( const TYPE& item )
 {
+  TYPE* slot = _append_slot();
+  if( slot ) {
+    new( slot ) TYPE( item );
+    setSize( size() + 1 );
+    return int( size() - 1 );
+  }
   return VectorImpl::add( &item );
 }
 
+template<class TYPE> inline
+int Vector<TYPE>::add( TYPE&& item )
+{
+  return emplace( size(), std::move( item ) );
+}
+
+template<class TYPE> template<typename... Args> inline
+int Vector<TYPE>::emplace( size_t index, Args&& ... args )
+{
+  if( index > size() ) {
+    return BAD_INDEX;
+  }
+  if( index == size() ) {
+    TYPE* slot = _append_slot();
+    if( slot ) {
+      new( slot ) TYPE( std::forward<Args>( args )... );
+      setSize( size() + 1 );
+      return int( index );
+    }
+  }
+  void* where = insertSpaceAt( index, 1 );
+  if( !where ) {
+    return NO_MEMORY;
+  }
+  new( where ) TYPE( std::forward<Args>( args )... );
+  return int( index );
+}
+
+template<class TYPE> template<typename... Args> inline
+int Vector<TYPE>::emplace_back( Args&& ... args )
+{
+  return emplace( size(), std::forward<Args>( args )... );
+}
+
 template<class TYPE> inline
 int Vector<TYPE>::replaceAt( const TYPE& item, size_t index )
 {
+  TYPE* items = _owned_items();
+  if( items && index < size() ) {
+    if( items + index != &item ) {
+      items[index] = item;
+    }
+    return int( index );
+  }
   return VectorImpl::replaceAt( &item, index );
 }
 
@@ -376,6 +524,12 @@ int Vector<TYPE>::insertAt( size_t index, size_t numItems )
 template<class TYPE> inline
 void Vector<TYPE>::pop()
 {
+  TYPE* items = size() ? _removable_items( 1 ) : 0;
+  if( items ) {
+    destroy_type( items + size() - 1, 1 );
+    setSize( size() - 1 );
+    return;
+  }
   VectorImpl::pop();
 }
 
@@ -400,19 +554,73 @@ int Vector<TYPE>::replaceAt( size_t index )
 template<class TYPE> inline
 int Vector<TYPE>::removeItemsAt( size_t index, size_t count )
 {
+  TYPE* items = ( index + count <= size() ) ? _removable_items( count ) : 0;
+  if( items ) {
+    destroy_type( items + index, count );
+    move_backward_type( items + index, items + index + count, size() - index - count );
+    setSize( size() - count );
+    return int( index );
+  }
   return VectorImpl::removeItemsAt( index, count );
 }
 
 template<class TYPE> inline
 status_t Vector<TYPE>::sort( Vector<TYPE>::compar_t cmp )
 {
-  return VectorImpl::sort( ( VectorImpl::compar_t )cmp );
+  return sort( [cmp]( const TYPE & lhs, const TYPE & rhs ) {
+    return cmp( &lhs, &rhs );
+  } );
 }
 
 template<class TYPE> inline
 status_t Vector<TYPE>::sort( Vector<TYPE>::compar_r_t cmp, void* state )
 {
-  return VectorImpl::sort( ( VectorImpl::compar_r_t )cmp, state );
+  return sort( [cmp, state]( const TYPE & lhs, const TYPE & rhs ) {
+    return cmp( &lhs, &rhs, state );
+  } );
+}
+
+template<class TYPE> inline
+status_t Vector<TYPE>::sort()
+{
+  return sort( []( const TYPE & lhs, const TYPE & rhs ) {
+    return compare_type( lhs, rhs );
+  } );
+}
+
+template<class TYPE> template<typename Compare>
+status_t Vector<TYPE>::sort( Compare cmp )
+{
+  // don't break copy-on-write if there is nothing to do
+  if( is_sorted_type( array(), size(), cmp ) ) {
+    return NO_ERROR;
+  }
+  TYPE* items = editArray();
+  if( !items ) {
+    return NO_MEMORY;
+  }
+  return stable_sort_type( items, size(), cmp );
+}
+
+template<class TYPE> inline
+status_t Vector<TYPE>::sort( Vector<TYPE>::compar_t cmp, const sp<ExecutorService>& executor )
+{
+  return sort( [cmp]( const TYPE & lhs, const TYPE & rhs ) {
+    return cmp( &lhs, &rhs );
+  }, executor );
+}
+
+template<class TYPE> template<typename Compare>
+status_t Vector<TYPE>::sort( Compare cmp, const sp<ExecutorService>& executor )
+{
+  if( is_sorted_type( array(), size(), cmp ) ) {
+    return NO_ERROR;
+  }
+  TYPE* items = editArray();
+  if( !items ) {
+    return NO_MEMORY;
+  }
+  return parallel_stable_sort_type( items, size(), cmp, executor );
 }
 
 // ---------------------------------------------------------------------------
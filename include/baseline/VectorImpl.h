@@ -19,8 +19,13 @@
 #ifndef BASELINE_VECTORIMPL_H_
 #define BASELINE_VECTORIMPL_H_
 
+#include <baseline/SharedBuffer.h>
+
 namespace baseline {
 
+class ExecutorService;
+template<typename T> class sp;
+
 class VectorImpl
 {
 public:
@@ -28,16 +33,19 @@ public:
     HAS_TRIVIAL_CTOR    = 0x00000001,
     HAS_TRIVIAL_DTOR    = 0x00000002,
     HAS_TRIVIAL_COPY    = 0x00000004,
+    HAS_TRIVIAL_MOVE    = 0x00000008,
   };
 
   VectorImpl( size_t itemSize, uint32_t flags );
   VectorImpl( const VectorImpl& rhs );
+  VectorImpl( VectorImpl&& rhs );
   virtual ~VectorImpl();
 
   /*! must be called from subclasses destructor */
   void finish_vector();
 
   VectorImpl& operator = ( const VectorImpl& rhs );
+  VectorImpl& operator = ( VectorImpl&& rhs );
 
   /*! C-style array access */
   inline  const void* arrayImpl() const       {
@@ -84,10 +92,36 @@ public:
   status_t sort( compar_t cmp );
   status_t sort( compar_r_t cmp, void* state );
 
+  /*! sort spread over the threads of executor. cmp is called from several
+   *  threads at once.
+   */
+  status_t sort( compar_r_t cmp, void* state, const sp<ExecutorService>& executor );
+
 protected:
   size_t itemSize() const;
   void release_storage();
 
+  /*! makes room for amount items at where and returns the uninitialized
+   *  space, or NULL. the caller must construct the new items in place.
+   */
+  void* insertSpaceAt( size_t where, size_t amount = 1 );
+
+  /*! for the typed fast paths of subclasses, which only use them when no
+   *  copy or reallocation is needed and go through the calls above
+   *  otherwise. returns the storage if this vector is its only owner.
+   */
+  inline void* ownedStorage() const {
+    return ( mStorage && SharedBuffer::bufferFromData( mStorage )->onlyOwner() ) ? mStorage : 0;
+  }
+  //! size of the storage in bytes
+  inline size_t storageSize() const {
+    return SharedBuffer::sizeFromData( mStorage );
+  }
+  //! after items were constructed or destroyed in ownedStorage()
+  inline void setSize( size_t count ) {
+    mCount = count;
+  }
+
   virtual void do_construct( void* storage, size_t num ) const = 0;
   virtual void do_destroy( void* storage, size_t num ) const = 0;
   virtual void do_copy( void* dest, const void* from, size_t num ) const = 0;
@@ -106,8 +140,12 @@ protected:
   virtual void reservedVectorImpl8();
 
 private:
+  friend class SortedVectorImpl;
+
   void* _grow( size_t where, size_t amount );
   void  _shrink( size_t where, size_t amount );
+  bool  _can_relocate() const;
+  void  _release_relocated();
 
   inline void _do_construct( void* storage, size_t num ) const;
   inline void _do_destroy( void* storage, size_t num ) const;
@@ -115,6 +153,7 @@ private:
   inline void _do_splat( void* dest, const void* item, size_t num ) const;
   inline void _do_move_forward( void* dest, const void* from, size_t num ) const;
   inline void _do_move_backward( void* dest, const void* from, size_t num ) const;
+  inline void _do_relocate( void* dest, const void* from, size_t num ) const;
 
   // These 2 fields are exposed in the inlines below,
   // so they're set in stone.
@@ -132,9 +171,12 @@ class SortedVectorImpl : public VectorImpl
 public:
   SortedVectorImpl( size_t itemSize, uint32_t flags );
   SortedVectorImpl( const VectorImpl& rhs );
+  SortedVectorImpl( const SortedVectorImpl& rhs );
+  SortedVectorImpl( VectorImpl&& rhs );
   virtual ~SortedVectorImpl();
 
   SortedVectorImpl& operator = ( const SortedVectorImpl& rhs );
+  SortedVectorImpl& operator = ( SortedVectorImpl&& rhs );
 
   //! finds the index of an item
   int indexOf( const void* item ) const;
@@ -145,10 +187,15 @@ public:
   //! add an item in the right place (or replaces it if there is one)
   int add( const void* item );
 
-  //! merges a vector into this one
+  //! merges a vector into this one, items of vector replace equal ones.
+  //! runs in linear time, plus sorting vector if it isn't a SortedVector
   int merge( const VectorImpl& vector );
   int merge( const SortedVectorImpl& vector );
 
+  //! same as above, spread over the threads of executor
+  int merge( const VectorImpl& vector, const sp<ExecutorService>& executor );
+  int merge( const SortedVectorImpl& vector, const sp<ExecutorService>& executor );
+
   //! removes an item
   int remove( const void* item );
 
@@ -166,7 +213,12 @@ protected:
   virtual void            reservedSortedVectorImpl8();
 
 private:
+  struct MergeState;
+
   int _indexOrderOf( const void* item, size_t* order = 0 ) const;
+  int _merge( const char* items, const void* const* order, size_t count,
+              const sp<ExecutorService>& executor );
+  static void _mergePiece( void* state, size_t index );
 
   // these are made private, because they can't be used on a SortedVector
   // (they don't have an implementation either)
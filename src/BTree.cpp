@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/BTree.h>
+
+#include <stdlib.h>
+#if defined(_WIN32)
+  #include <malloc.h>
+#endif
+
+namespace baseline {
+namespace btree_detail {
+
+void* alloc_node( size_t size )
+{
+  // nodes start on a cache line so that a search touches as few as possible
+  const size_t alignment = BTreeImpl<int, int>::kCacheLine;
+  size = ( size + alignment - 1 ) & ~( alignment - 1 );
+#if defined(_WIN32)
+  return _aligned_malloc( size, alignment );
+#else
+  void* node;
+  if( posix_memalign( &node, alignment, size ) != 0 ) {
+    return NULL;
+  }
+  return node;
+#endif
+}
+
+void free_node( void* node )
+{
+#if defined(_WIN32)
+  _aligned_free( node );
+#else
+  free( node );
+#endif
+}
+
+} // namespace btree_detail
+} // namespace baseline
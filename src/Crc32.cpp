@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Hash.h>
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+  #include <immintrin.h>
+  #define HAVE_X86_CRC
+  #define SSE42_TARGET __attribute__(( target( "sse4.2" ) ))
+  #define PCLMUL_TARGET __attribute__(( target( "sse4.2,pclmul" ) ))
+#endif
+
+namespace baseline {
+namespace crc_detail {
+
+// bit reflected generator polynomials, and the same in normal order with
+// the x^32 term, which is what the folding constants are computed from
+static const uint32_t kPolyCRC32 = 0xEDB88320;
+static const uint32_t kPolyCRC32C = 0x82F63B78;
+static const uint64_t kNormalCRC32 = 0x104C11DB7ull;
+static const uint64_t kNormalCRC32C = 0x11EDC6F41ull;
+
+static inline uint32_t load32( const uint8_t* p )
+{
+  return uint32_t( p[0] ) | uint32_t( p[1] ) << 8 | uint32_t( p[2] ) << 16 | uint32_t( p[3] ) << 24;
+}
+
+/**
+ * Slice-by-8 tables: table[0] is the classic byte at a time table and
+ * table[k][b] is the CRC of byte b followed by k zero bytes, so eight
+ * lookups advance the CRC by eight bytes at once.
+ */
+struct SliceTables {
+  uint32_t table[8][256];
+
+  SliceTables( uint32_t poly ) {
+    for( uint32_t i = 0; i < 256; i++ ) {
+      uint32_t crc = i;
+      for( int bit = 0; bit < 8; bit++ ) {
+        crc = crc & 1 ? ( crc >> 1 ) ^ poly : crc >> 1;
+      }
+      table[0][i] = crc;
+    }
+    for( uint32_t i = 0; i < 256; i++ ) {
+      for( int k = 1; k < 8; k++ ) {
+        const uint32_t prev = table[k - 1][i];
+        table[k][i] = ( prev >> 8 ) ^ table[0][prev & 0xFF];
+      }
+    }
+  }
+};
+
+static const SliceTables& crc32Tables()
+{
+  static const SliceTables tables( kPolyCRC32 );
+  return tables;
+}
+
+static const SliceTables& crc32cTables()
+{
+  static const SliceTables tables( kPolyCRC32C );
+  return tables;
+}
+
+// all kernels work on the raw CRC register: no pre or post inversion
+static uint32_t update_slice8( const SliceTables& tables, uint32_t crc, const uint8_t* data, size_t len )
+{
+  const uint32_t ( *t )[256] = tables.table;
+  while( len >= 8 ) {
+    const uint32_t one = load32( data ) ^ crc;
+    const uint32_t two = load32( data + 4 );
+    crc = t[7][one & 0xFF] ^ t[6][( one >> 8 ) & 0xFF] ^ t[5][( one >> 16 ) & 0xFF] ^ t[4][one >> 24] ^
+          t[3][two & 0xFF] ^ t[2][( two >> 8 ) & 0xFF] ^ t[1][( two >> 16 ) & 0xFF] ^ t[0][two >> 24];
+    data += 8;
+    len -= 8;
+  }
+  while( len-- > 0 ) {
+    crc = t[0][( crc ^ *data++ ) & 0xFF] ^ ( crc >> 8 );
+  }
+  return crc;
+}
+
+static uint32_t crc32_slice8( uint32_t crc, const uint8_t* data, size_t len )
+{
+  return update_slice8( crc32Tables(), crc, data, len );
+}
+
+static uint32_t crc32c_slice8( uint32_t crc, const uint8_t* data, size_t len )
+{
+  return update_slice8( crc32cTables(), crc, data, len );
+}
+
+#if defined(HAVE_X86_CRC)
+
+SSE42_TARGET static
+uint32_t crc32c_sse42( uint32_t crc, const uint8_t* data, size_t len )
+{
+  while( len > 0 && ( uintptr_t( data ) & 7 ) != 0 ) {
+    crc = _mm_crc32_u8( crc, *data++ );
+    len--;
+  }
+#if defined(__x86_64__)
+  uint64_t crc64 = crc;
+  while( len >= 8 ) {
+    uint64_t word;
+    memcpy( &word, data, 8 );
+    crc64 = _mm_crc32_u64( crc64, word );
+    data += 8;
+    len -= 8;
+  }
+  crc = uint32_t( crc64 );
+#endif
+  while( len >= 4 ) {
+    crc = _mm_crc32_u32( crc, load32( data ) );
+    data += 4;
+    len -= 4;
+  }
+  while( len-- > 0 ) {
+    crc = _mm_crc32_u8( crc, *data++ );
+  }
+  return crc;
+}
+
+/**
+ * x^n mod P for a normal order P, returned bit reflected and shifted up
+ * by one, which is the form the reflected carry-less multiply expects.
+ */
+static uint64_t fold_constant( uint64_t poly, uint32_t n )
+{
+  uint64_t r = 1;
+  for( uint32_t i = 0; i < n; i++ ) {
+    r <<= 1;
+    if( r & 0x100000000ull ) {
+      r ^= poly;
+    }
+  }
+  uint64_t reflected = 0;
+  for( int bit = 0; bit < 32; bit++ ) {
+    if( r & ( 1ull << bit ) ) {
+      reflected |= 1ull << ( 31 - bit );
+    }
+  }
+  return reflected << 1;
+}
+
+/**
+ * Constants for folding 128 bit lanes forward over 512 bits (four lanes in
+ * parallel) and over 128 bits (one lane into the next).
+ */
+struct FoldConstants {
+  uint64_t by4[2];
+  uint64_t by1[2];
+
+  FoldConstants( uint64_t poly ) {
+    by4[0] = fold_constant( poly, 512 + 32 );
+    by4[1] = fold_constant( poly, 512 - 32 );
+    by1[0] = fold_constant( poly, 128 + 32 );
+    by1[1] = fold_constant( poly, 128 - 32 );
+  }
+};
+
+PCLMUL_TARGET static inline
+__m128i fold( __m128i acc, __m128i next, __m128i k )
+{
+  const __m128i lo = _mm_clmulepi64_si128( acc, k, 0x00 );
+  const __m128i hi = _mm_clmulepi64_si128( acc, k, 0x11 );
+  return _mm_xor_si128( _mm_xor_si128( lo, hi ), next );
+}
+
+/**
+ * Folds 64 byte blocks with carry-less multiplies until less than 16 bytes
+ * are left, then hands the 16 byte remainder (which has the same CRC as
+ * everything folded into it) and the tail to finish. len must be >= 64.
+ */
+PCLMUL_TARGET static
+uint32_t update_pclmul( const FoldConstants& c, uint32_t crc, const uint8_t* data, size_t len,
+                        uint32_t ( *finish )( uint32_t, const uint8_t*, size_t ) )
+{
+  __m128i x0 = _mm_loadu_si128( ( const __m128i* )( data + 0 ) );
+  __m128i x1 = _mm_loadu_si128( ( const __m128i* )( data + 16 ) );
+  __m128i x2 = _mm_loadu_si128( ( const __m128i* )( data + 32 ) );
+  __m128i x3 = _mm_loadu_si128( ( const __m128i* )( data + 48 ) );
+  x0 = _mm_xor_si128( x0, _mm_cvtsi32_si128( int( crc ) ) );
+  data += 64;
+  len -= 64;
+
+  const __m128i k4 = _mm_set_epi64x( int64_t( c.by4[1] ), int64_t( c.by4[0] ) );
+  while( len >= 64 ) {
+    x0 = fold( x0, _mm_loadu_si128( ( const __m128i* )( data + 0 ) ), k4 );
+    x1 = fold( x1, _mm_loadu_si128( ( const __m128i* )( data + 16 ) ), k4 );
+    x2 = fold( x2, _mm_loadu_si128( ( const __m128i* )( data + 32 ) ), k4 );
+    x3 = fold( x3, _mm_loadu_si128( ( const __m128i* )( data + 48 ) ), k4 );
+    data += 64;
+    len -= 64;
+  }
+
+  const __m128i k1 = _mm_set_epi64x( int64_t( c.by1[1] ), int64_t( c.by1[0] ) );
+  x0 = fold( x0, x1, k1 );
+  x0 = fold( x0, x2, k1 );
+  x0 = fold( x0, x3, k1 );
+  while( len >= 16 ) {
+    x0 = fold( x0, _mm_loadu_si128( ( const __m128i* )data ), k1 );
+    data += 16;
+    len -= 16;
+  }
+
+  uint8_t rest[16];
+  _mm_storeu_si128( ( __m128i* )rest, x0 );
+  crc = finish( 0, rest, 16 );
+  return finish( crc, data, len );
+}
+
+static const FoldConstants& crc32Constants()
+{
+  static const FoldConstants constants( kNormalCRC32 );
+  return constants;
+}
+
+static const FoldConstants& crc32cConstants()
+{
+  static const FoldConstants constants( kNormalCRC32C );
+  return constants;
+}
+
+// below this the setup and the final 16 byte reduction do not pay off
+static const size_t kFoldThreshold = 128;
+
+static uint32_t crc32_pclmul( uint32_t crc, const uint8_t* data, size_t len )
+{
+  if( len < kFoldThreshold ) {
+    return crc32_slice8( crc, data, len );
+  }
+  return update_pclmul( crc32Constants(), crc, data, len, crc32_slice8 );
+}
+
+static uint32_t crc32c_pclmul( uint32_t crc, const uint8_t* data, size_t len )
+{
+  if( len < kFoldThreshold ) {
+    return crc32c_sse42( crc, data, len );
+  }
+  return update_pclmul( crc32cConstants(), crc, data, len, crc32c_sse42 );
+}
+
+#endif // HAVE_X86_CRC
+
+struct Kernels {
+  uint32_t ( *crc32 )( uint32_t, const uint8_t*, size_t );
+  uint32_t ( *crc32c )( uint32_t, const uint8_t*, size_t );
+};
+
+static Kernels select_kernels()
+{
+  Kernels k;
+  k.crc32 = crc32_slice8;
+  k.crc32c = crc32c_slice8;
+#if defined(HAVE_X86_CRC)
+  __builtin_cpu_init();
+  const bool sse42 = __builtin_cpu_supports( "sse4.2" );
+  const bool pclmul = sse42 && __builtin_cpu_supports( "pclmul" );
+  if( sse42 ) {
+    k.crc32c = crc32c_sse42;
+  }
+  if( pclmul ) {
+    k.crc32 = crc32_pclmul;
+    k.crc32c = crc32c_pclmul;
+  }
+#endif
+  return k;
+}
+
+static const Kernels& kernels()
+{
+  static const Kernels k = select_kernels();
+  return k;
+}
+
+/**
+ * Polynomial multiplication modulo the reflected poly, and x^(8 * len)
+ * by repeated squaring: what shifting a CRC over len zero bytes takes.
+ */
+static uint32_t multmodp( uint32_t poly, uint32_t a, uint32_t b )
+{
+  uint32_t m = uint32_t( 1 ) << 31;
+  uint32_t p = 0;
+  for( ;; ) {
+    if( a & m ) {
+      p ^= b;
+      if( ( a & ( m - 1 ) ) == 0 ) {
+        break;
+      }
+    }
+    m >>= 1;
+    b = b & 1 ? ( b >> 1 ) ^ poly : b >> 1;
+  }
+  return p;
+}
+
+static uint32_t x8nmodp( uint32_t poly, uint64_t len )
+{
+  uint32_t result = uint32_t( 1 ) << 31;  // x^0
+  uint32_t square = uint32_t( 1 ) << 23;  // x^8
+  while( len ) {
+    if( len & 1 ) {
+      result = multmodp( poly, square, result );
+    }
+    len >>= 1;
+    square = multmodp( poly, square, square );
+  }
+  return result;
+}
+
+} // namespace crc_detail
+
+uint32_t crc32( uint32_t crc, const void* buf, size_t len )
+{
+  return ~crc_detail::kernels().crc32( ~crc, ( const uint8_t* )buf, len );
+}
+
+uint32_t crc32c( uint32_t crc, const void* buf, size_t len )
+{
+  return ~crc_detail::kernels().crc32c( ~crc, ( const uint8_t* )buf, len );
+}
+
+uint32_t crc32Combine( uint32_t crcA, uint32_t crcB, uint64_t lenB )
+{
+  const uint32_t poly = crc_detail::kPolyCRC32;
+  return crc_detail::multmodp( poly, crc_detail::x8nmodp( poly, lenB ), crcA ) ^ crcB;
+}
+
+uint32_t crc32cCombine( uint32_t crcA, uint32_t crcB, uint64_t lenB )
+{
+  const uint32_t poly = crc_detail::kPolyCRC32C;
+  return crc_detail::multmodp( poly, crc_detail::x8nmodp( poly, lenB ), crcA ) ^ crcB;
+}
+
+} // namespace baseline
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/DataStreams.h>
+#include <baseline/SharedBuffer.h>
+
+namespace baseline {
+
+// room for any fixed width field or varint
+#define MIN_BUFFER_SIZE 16
+
+/////////////// DataOutputStream //////////////////////
+
+DataOutputStream::DataOutputStream( OutputStream& out, size_t bufferSize )
+  : mOut( out ), mCapacity( MAX( bufferSize, size_t( MIN_BUFFER_SIZE ) ) ), mPos( 0 ), mFlushed( 0 ), mError( OK )
+{
+  mBuffer = new uint8_t[mCapacity];
+}
+
+DataOutputStream::~DataOutputStream()
+{
+  delete[] mBuffer;
+}
+
+status_t DataOutputStream::flush()
+{
+  size_t written = 0;
+  while( mError == OK && written < mPos ) {
+    const int ret = mOut.write( mBuffer, written, mPos - written );
+    if( ret < 0 ) {
+      mError = ret;
+    } else {
+      written += ret;
+    }
+  }
+  mFlushed += written;
+  memmove( mBuffer, &mBuffer[written], mPos - written );
+  mPos -= written;
+  return mError;
+}
+
+void DataOutputStream::close()
+{
+  flush();
+  mOut.close();
+}
+
+status_t DataOutputStream::makeRoom( size_t len )
+{
+  flush();
+  if( mError == OK && mPos + len > mCapacity ) {
+    mError = NO_MEMORY;
+  }
+  return mError;
+}
+
+int DataOutputStream::write( uint8_t* buf, size_t off, size_t len )
+{
+  const status_t err = writeBytes( &buf[off], len );
+  return err == OK ? int( len ) : err;
+}
+
+status_t DataOutputStream::writeBytes( const void* data, size_t len )
+{
+  if( mError != OK ) {
+    return mError;
+  }
+  const uint8_t* src = static_cast<const uint8_t*>( data );
+  if( mPos + len <= mCapacity ) {
+    memcpy( &mBuffer[mPos], src, len );
+    mPos += len;
+    return OK;
+  }
+
+  // top up the buffer, then hand whole buffers worth to out directly
+  const size_t head = mCapacity - mPos;
+  memcpy( &mBuffer[mPos], src, head );
+  mPos = mCapacity;
+  src += head;
+  len -= head;
+  if( flush() != OK ) {
+    return mError;
+  }
+  while( len >= mCapacity ) {
+    const int ret = mOut.write( const_cast<uint8_t*>( src ), 0, len );
+    if( ret < 0 ) {
+      return mError = ret;
+    }
+    mFlushed += ret;
+    src += ret;
+    len -= ret;
+  }
+  memcpy( mBuffer, src, len );
+  mPos = len;
+  return OK;
+}
+
+status_t DataOutputStream::writeString( const String8& str )
+{
+  const status_t err = writeVarint( str.length() );
+  return err == OK ? writeBytes( str.string(), str.length() ) : err;
+}
+
+status_t DataOutputStream::writeBuffer( const SharedBuffer* buf )
+{
+  const size_t len = buf != nullptr ? buf->size() : 0;
+  const status_t err = writeVarint( len );
+  return err == OK && len > 0 ? writeBytes( buf->data(), len ) : err;
+}
+
+/////////////// DataInputStream //////////////////////
+
+DataInputStream::DataInputStream( InputStream& in, size_t bufferSize )
+  : mIn( in ), mCapacity( MAX( bufferSize, size_t( MIN_BUFFER_SIZE ) ) ), mPos( 0 ), mEnd( 0 ), mEof( false ), mError( OK )
+{
+  mBuffer = new uint8_t[mCapacity];
+}
+
+DataInputStream::~DataInputStream()
+{
+  delete[] mBuffer;
+}
+
+void DataInputStream::close()
+{
+  mIn.close();
+}
+
+status_t DataInputStream::fill( size_t len )
+{
+  if( mError != OK ) {
+    return mError;
+  }
+  if( mPos + len > mCapacity ) {
+    memmove( mBuffer, &mBuffer[mPos], mEnd - mPos );
+    mEnd -= mPos;
+    mPos = 0;
+  }
+  while( mEnd - mPos < len && !mEof ) {
+    const int ret = mIn.read( mBuffer, mEnd, mCapacity - mEnd );
+    if( ret == -1 ) {
+      mEof = true;
+    } else if( ret < 0 ) {
+      return mError = ret;
+    } else {
+      mEnd += ret;
+    }
+  }
+  return mEnd - mPos < len ? NOT_ENOUGH_DATA : OK;
+}
+
+int DataInputStream::read( uint8_t* buf, size_t off, size_t len )
+{
+  if( mError != OK ) {
+    return mError;
+  }
+  if( mPos == mEnd ) {
+    // large reads skip the buffer
+    if( len >= mCapacity ) {
+      return mEof ? -1 : mIn.read( buf, off, len );
+    }
+    fill( 1 );
+    if( mPos == mEnd ) {
+      return mError != OK ? mError : -1;
+    }
+  }
+  const size_t n = MIN( len, mEnd - mPos );
+  memcpy( &buf[off], &mBuffer[mPos], n );
+  mPos += n;
+  return n;
+}
+
+status_t DataInputStream::readBytes( void* data, size_t len )
+{
+  if( mError != OK ) {
+    return mError;
+  }
+  uint8_t* dst = static_cast<uint8_t*>( data );
+  const size_t buffered = mEnd - mPos;
+  if( len <= buffered ) {
+    memcpy( dst, &mBuffer[mPos], len );
+    mPos += len;
+    return OK;
+  }
+
+  // what is buffered, then straight from in
+  memcpy( dst, &mBuffer[mPos], buffered );
+  size_t done = buffered;
+  while( done < len && !mEof ) {
+    const int ret = mIn.read( dst, done, len - done );
+    if( ret == -1 ) {
+      mEof = true;
+    } else if( ret < 0 ) {
+      return mError = ret;
+    } else {
+      done += ret;
+    }
+  }
+  mPos = mEnd = 0;
+  // the stream ended inside the field, which is lost either way
+  return done < len ? NOT_ENOUGH_DATA : OK;
+}
+
+status_t DataInputStream::readVarintSlow( uint64_t* value )
+{
+  uint64_t result = 0;
+  for( int shift = 0; shift < 64; shift += 7 ) {
+    if( mPos == mEnd && fill( 1 ) != OK ) {
+      return mError != OK ? mError : NOT_ENOUGH_DATA;
+    }
+    const uint8_t byte = mBuffer[mPos++];
+    result |= uint64_t( byte & 0x7F ) << shift;
+    if( byte < 0x80 ) {
+      if( shift == 63 && byte > 1 ) {
+        break;
+      }
+      *value = result;
+      return OK;
+    }
+  }
+  return mError = BAD_VALUE;
+}
+
+status_t DataInputStream::readCount( uint64_t* count, size_t elementSize )
+{
+  const status_t err = readVarint( count );
+  // the count must fit a SharedBuffer, header and terminator included
+  if( err == OK && *count > ( SIZE_MAX - sizeof( SharedBuffer ) - 1 ) / elementSize ) {
+    return mError = BAD_VALUE;
+  }
+  return err;
+}
+
+status_t DataInputStream::readString( String8* str )
+{
+  uint64_t len;
+  status_t err = readCount( &len, 1 );
+  if( err != OK ) {
+    return err;
+  }
+  if( len <= mEnd - mPos ) {
+    err = str->setTo( reinterpret_cast<const char*>( &mBuffer[mPos] ), len );
+    if( err == OK ) {
+      mPos += len;
+    }
+    return err;
+  }
+  String8 result;
+  size_t done = 0;
+  while( done < len ) {
+    const size_t want = data_detail::nextChunk( done, len, 1 );
+    char* dst = result.lockBuffer( want );
+    if( dst == nullptr ) {
+      return NO_MEMORY;
+    }
+    err = readBytes( &dst[done], want - done );
+    result.unlockBuffer( want );
+    if( err != OK ) {
+      return err;
+    }
+    done = want;
+  }
+  *str = result;
+  return OK;
+}
+
+status_t DataInputStream::readBuffer( SharedBuffer** buf )
+{
+  uint64_t len;
+  status_t err = readCount( &len, 1 );
+  if( err != OK ) {
+    return err;
+  }
+  SharedBuffer* result = SharedBuffer::alloc( data_detail::nextChunk( 0, len, 1 ) );
+  if( result == nullptr ) {
+    return NO_MEMORY;
+  }
+  size_t done = 0;
+  while( true ) {
+    const size_t want = result->size();
+    err = readBytes( static_cast<uint8_t*>( result->data() ) + done, want - done );
+    if( err != OK ) {
+      result->release();
+      return err;
+    }
+    done = want;
+    if( done == len ) {
+      break;
+    }
+    SharedBuffer* grown = result->editResize( data_detail::nextChunk( done, len, 1 ) );
+    if( grown == nullptr ) {
+      result->release();
+      return NO_MEMORY;
+    }
+    result = grown;
+  }
+  *buf = result;
+  return OK;
+}
+
+} // namespace
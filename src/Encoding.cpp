@@ -19,6 +19,18 @@
 #include <baseline/BaseEncoding.h>
 #include <baseline/SharedBuffer.h>
 
+#include <ctype.h>
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+  #include <immintrin.h>
+  #define HAVE_X86_HEX
+  #define HAVE_X86_BASE64
+  #define HAVE_BMI2_BASE32
+  #define SSSE3_TARGET __attribute__(( target( "ssse3" ) ))
+  #define AVX2_TARGET __attribute__(( target( "avx2" ) ))
+  #define BMI2_TARGET __attribute__(( target( "bmi2" ) ))
+#endif
+
 namespace baseline {
 
 BaseEncoding::~BaseEncoding()
@@ -29,37 +41,263 @@ String8 BaseEncoding::encode( SharedBuffer* buf ) const
   return encode( buf->data(), buf->size() );
 }
 
-class HexBaseEncoding : public BaseEncoding
+String8 BaseEncoding::encode( const void* buf, size_t len ) const
 {
-public:
+  const size_t chars = encodedLength( len );
+  String8 string;
+  char* dst = string.lockBuffer( chars );
+  if( dst == nullptr ) {
+    return string;
+  }
+  encodeInto( buf, len, dst );
+  dst[chars] = '\0';
+  string.unlockBuffer( chars );
+  return string;
+}
+
+SharedBuffer* BaseEncoding::decode( const String8& str ) const
+{
+  SharedBuffer* buf = SharedBuffer::alloc( decodedLength( str.length() ) );
+  if( buf == nullptr ) {
+    return nullptr;
+  }
+  const ssize_t len = decodeInto( str.string(), str.length(), reinterpret_cast<uint8_t*>( buf->data() ) );
+  if( len < 0 ) {
+    buf->release();
+    return nullptr;
+  }
+  if( size_t( len ) != buf->size() ) {
+    buf = buf->editResize( len );
+  }
+  return buf;
+}
+
+namespace hex_detail {
 
-  String8 encode( void* buf, size_t len ) const override;
-  SharedBuffer* decode( const String8& ) const override;
+static const char kDigits[16 + 1] = "0123456789abcdef";
 
+/**
+ * Two characters per byte and the value of every character (-1 if it is
+ * not a hex digit, either case is accepted).
+ */
+struct Tables {
+  char pairs[256][2];
+  int8_t values[256];
+
+  Tables() {
+    for( int i = 0; i < 256; i++ ) {
+      pairs[i][0] = kDigits[i >> 4];
+      pairs[i][1] = kDigits[i & 15];
+      values[i] = -1;
+    }
+    for( int i = 0; i < 10; i++ ) {
+      values['0' + i] = int8_t( i );
+    }
+    for( int i = 0; i < 6; i++ ) {
+      values['a' + i] = int8_t( 10 + i );
+      values['A' + i] = int8_t( 10 + i );
+    }
+  }
 };
 
-String8 HexBaseEncoding::encode( void* buf, size_t len ) const
+static const Tables& tables()
 {
-  static const char dec2hex[16 + 1] = "0123456789abcdef";
-  String8 string;
-  char strbuf[2];
+  static const Tables t;
+  return t;
+}
+
+static void encode_scalar( const uint8_t* src, size_t len, char* dst )
+{
+  const Tables& t = tables();
+  for( size_t i = 0; i < len; i++ ) {
+    memcpy( &dst[2 * i], t.pairs[src[i]], 2 );
+  }
+}
 
+//! false if src has a character that is not a hex digit
+static bool decode_scalar( const char* src, size_t len, uint8_t* dst )
+{
+  const Tables& t = tables();
+  int invalid = 0;
   for( size_t i = 0; i < len; i++ ) {
-    uint8_t value = reinterpret_cast<uint8_t*>( buf )[i];
+    const int hi = t.values[uint8_t( src[2 * i] )];
+    const int lo = t.values[uint8_t( src[2 * i + 1] )];
+    invalid |= hi | lo;
+    dst[i] = uint8_t( ( unsigned( hi ) << 4 ) | unsigned( lo ) );
+  }
+  return invalid >= 0;
+}
+
+#if defined(HAVE_X86_HEX)
 
-    strbuf[0] = dec2hex[( value >> 4 ) & 15];
-    strbuf[1] = dec2hex[value        & 15];
+/*
+ * Encoding looks up both nibbles of 16 (or 32) bytes at once with pshufb
+ * and interleaves them. Decoding maps '0'-'9' and 'a'-'f' / 'A'-'F' to
+ * their values with two range checks, then joins each pair of nibbles
+ * with a multiply-add (hi * 16 + lo) and packs the results to bytes.
+ */
 
-    string.append( strbuf, 2 );
+SSSE3_TARGET
+static void encode_ssse3( const uint8_t* src, size_t len, char* dst )
+{
+  const __m128i digits = _mm_loadu_si128( ( const __m128i* )kDigits );
+  const __m128i mask = _mm_set1_epi8( 0x0F );
+  size_t i = 0;
+  for( ; i + 16 <= len; i += 16 ) {
+    const __m128i v = _mm_loadu_si128( ( const __m128i* )( src + i ) );
+    const __m128i hi = _mm_shuffle_epi8( digits, _mm_and_si128( _mm_srli_epi16( v, 4 ), mask ) );
+    const __m128i lo = _mm_shuffle_epi8( digits, _mm_and_si128( v, mask ) );
+    _mm_storeu_si128( ( __m128i* )( dst + 2 * i ), _mm_unpacklo_epi8( hi, lo ) );
+    _mm_storeu_si128( ( __m128i* )( dst + 2 * i + 16 ), _mm_unpackhi_epi8( hi, lo ) );
   }
+  encode_scalar( src + i, len - i, dst + 2 * i );
+}
 
-  return string;
+//! the value of each of 16 characters; valid gets 0xFF where it was a hex digit
+SSSE3_TARGET
+static inline __m128i nibbles_ssse3( __m128i c, __m128i& valid )
+{
+  const __m128i digit = _mm_sub_epi8( c, _mm_set1_epi8( '0' ) );
+  const __m128i letter = _mm_sub_epi8( _mm_or_si128( c, _mm_set1_epi8( 0x20 ) ), _mm_set1_epi8( 'a' ) );
+  const __m128i isDigit = _mm_cmpeq_epi8( _mm_min_epu8( digit, _mm_set1_epi8( 9 ) ), digit );
+  const __m128i isLetter = _mm_cmpeq_epi8( _mm_min_epu8( letter, _mm_set1_epi8( 5 ) ), letter );
+  valid = _mm_or_si128( isDigit, isLetter );
+  return _mm_or_si128( _mm_and_si128( isDigit, digit ),
+                       _mm_and_si128( isLetter, _mm_add_epi8( letter, _mm_set1_epi8( 10 ) ) ) );
 }
 
-SharedBuffer* HexBaseEncoding::decode( const String8& str ) const
+SSSE3_TARGET
+static bool decode_ssse3( const char* src, size_t len, uint8_t* dst )
 {
-  //TODO: implement
-  return nullptr;
+  const __m128i weights = _mm_set1_epi16( 0x0110 );
+  __m128i valid = _mm_set1_epi8( -1 );
+  size_t i = 0;
+  for( ; i + 16 <= len; i += 16 ) {
+    __m128i valid0, valid1;
+    const __m128i n0 = nibbles_ssse3( _mm_loadu_si128( ( const __m128i* )( src + 2 * i ) ), valid0 );
+    const __m128i n1 = nibbles_ssse3( _mm_loadu_si128( ( const __m128i* )( src + 2 * i + 16 ) ), valid1 );
+    valid = _mm_and_si128( valid, _mm_and_si128( valid0, valid1 ) );
+    const __m128i bytes = _mm_packus_epi16( _mm_maddubs_epi16( n0, weights ), _mm_maddubs_epi16( n1, weights ) );
+    _mm_storeu_si128( ( __m128i* )( dst + i ), bytes );
+  }
+  const bool ok = _mm_movemask_epi8( valid ) == 0xFFFF;
+  return decode_scalar( src + 2 * i, len - i, dst + i ) && ok;
+}
+
+AVX2_TARGET
+static void encode_avx2( const uint8_t* src, size_t len, char* dst )
+{
+  const __m256i digits = _mm256_broadcastsi128_si256( _mm_loadu_si128( ( const __m128i* )kDigits ) );
+  const __m256i mask = _mm256_set1_epi8( 0x0F );
+  size_t i = 0;
+  for( ; i + 32 <= len; i += 32 ) {
+    const __m256i v = _mm256_loadu_si256( ( const __m256i* )( src + i ) );
+    const __m256i hi = _mm256_shuffle_epi8( digits, _mm256_and_si256( _mm256_srli_epi16( v, 4 ), mask ) );
+    const __m256i lo = _mm256_shuffle_epi8( digits, _mm256_and_si256( v, mask ) );
+    // the unpacks work within 128 bit lanes, put the halves back in order
+    const __m256i first = _mm256_unpacklo_epi8( hi, lo );
+    const __m256i second = _mm256_unpackhi_epi8( hi, lo );
+    _mm256_storeu_si256( ( __m256i* )( dst + 2 * i ), _mm256_permute2x128_si256( first, second, 0x20 ) );
+    _mm256_storeu_si256( ( __m256i* )( dst + 2 * i + 32 ), _mm256_permute2x128_si256( first, second, 0x31 ) );
+  }
+  encode_ssse3( src + i, len - i, dst + 2 * i );
+}
+
+AVX2_TARGET
+static inline __m256i nibbles_avx2( __m256i c, __m256i& valid )
+{
+  const __m256i digit = _mm256_sub_epi8( c, _mm256_set1_epi8( '0' ) );
+  const __m256i letter = _mm256_sub_epi8( _mm256_or_si256( c, _mm256_set1_epi8( 0x20 ) ), _mm256_set1_epi8( 'a' ) );
+  const __m256i isDigit = _mm256_cmpeq_epi8( _mm256_min_epu8( digit, _mm256_set1_epi8( 9 ) ), digit );
+  const __m256i isLetter = _mm256_cmpeq_epi8( _mm256_min_epu8( letter, _mm256_set1_epi8( 5 ) ), letter );
+  valid = _mm256_or_si256( isDigit, isLetter );
+  return _mm256_or_si256( _mm256_and_si256( isDigit, digit ),
+                          _mm256_and_si256( isLetter, _mm256_add_epi8( letter, _mm256_set1_epi8( 10 ) ) ) );
+}
+
+AVX2_TARGET
+static bool decode_avx2( const char* src, size_t len, uint8_t* dst )
+{
+  const __m256i weights = _mm256_set1_epi16( 0x0110 );
+  __m256i valid = _mm256_set1_epi8( -1 );
+  size_t i = 0;
+  for( ; i + 32 <= len; i += 32 ) {
+    __m256i valid0, valid1;
+    const __m256i n0 = nibbles_avx2( _mm256_loadu_si256( ( const __m256i* )( src + 2 * i ) ), valid0 );
+    const __m256i n1 = nibbles_avx2( _mm256_loadu_si256( ( const __m256i* )( src + 2 * i + 32 ) ), valid1 );
+    valid = _mm256_and_si256( valid, _mm256_and_si256( valid0, valid1 ) );
+    // packus works within lanes too
+    const __m256i bytes = _mm256_packus_epi16( _mm256_maddubs_epi16( n0, weights ), _mm256_maddubs_epi16( n1, weights ) );
+    _mm256_storeu_si256( ( __m256i* )( dst + i ), _mm256_permute4x64_epi64( bytes, 0xD8 ) );
+  }
+  const bool ok = _mm256_movemask_epi8( valid ) == -1;
+  return decode_ssse3( src + 2 * i, len - i, dst + i ) && ok;
+}
+
+#endif // HAVE_X86_HEX
+
+struct Kernels {
+  void ( *encode )( const uint8_t* src, size_t len, char* dst );
+  bool ( *decode )( const char* src, size_t len, uint8_t* dst );
+};
+
+static Kernels select_kernels()
+{
+  Kernels k;
+  k.encode = encode_scalar;
+  k.decode = decode_scalar;
+#if defined(HAVE_X86_HEX)
+  if( __builtin_cpu_supports( "avx2" ) ) {
+    k.encode = encode_avx2;
+    k.decode = decode_avx2;
+  } else if( __builtin_cpu_supports( "ssse3" ) ) {
+    k.encode = encode_ssse3;
+    k.decode = decode_ssse3;
+  }
+#endif
+  return k;
+}
+
+static const Kernels& kernels()
+{
+  static const Kernels k = select_kernels();
+  return k;
+}
+
+} // namespace hex_detail
+
+class HexBaseEncoding : public BaseEncoding
+{
+public:
+
+  size_t encodedLength( size_t len ) const override {
+    return 2 * len;
+  }
+  size_t decodedLength( size_t len ) const override {
+    return len / 2;
+  }
+  void encodeInto( const void* src, size_t len, char* dst ) const override;
+  ssize_t decodeInto( const char* src, size_t len, uint8_t* dst ) const override;
+  size_t groupBytes() const override {
+    return 1;
+  }
+  size_t groupChars() const override {
+    return 2;
+  }
+
+};
+
+void HexBaseEncoding::encodeInto( const void* src, size_t len, char* dst ) const
+{
+  hex_detail::kernels().encode( static_cast<const uint8_t*>( src ), len, dst );
+}
+
+ssize_t HexBaseEncoding::decodeInto( const char* src, size_t len, uint8_t* dst ) const
+{
+  if( len % 2 != 0 || !hex_detail::kernels().decode( src, len / 2, dst ) ) {
+    return BAD_VALUE;
+  }
+  return len / 2;
 }
 
 HexBaseEncoding gHexEncoding;
@@ -69,4 +307,522 @@ BaseEncoding& hexEncoding()
   return gHexEncoding;
 }
 
+////////////////// Base64 //////////////////
+
+namespace base64_detail {
+
+static const char kStandard[64 + 1] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char kUrl[64 + 1] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+//! the characters of an alphabet and their values, 0xFF if not in it
+struct Alphabet {
+  const char* chars;
+  uint8_t values[256];
+
+  explicit Alphabet( const char* alphabet )
+    : chars( alphabet ) {
+    memset( values, 0xFF, sizeof( values ) );
+    for( int i = 0; i < 64; i++ ) {
+      values[uint8_t( alphabet[i] )] = uint8_t( i );
+    }
+  }
+};
+
+static const Alphabet& alphabet( bool url )
+{
+  static const Alphabet standard( kStandard );
+  static const Alphabet safe( kUrl );
+  return url ? safe : standard;
+}
+
+#if defined(HAVE_X86_BASE64)
+
+/*
+ * The AVX2 kernels follow Mula and Lemire, "Faster Base64 Encoding and
+ * Decoding Using AVX2 Instructions". Encoding spreads 24 bytes over 32
+ * lanes of 6 bits with a shuffle and two multiplies, then turns each
+ * value into a character by adding an offset looked up by its range.
+ * Decoding classifies each character by its nibbles, which rejects
+ * anything outside the alphabet, adds the offset for its range and packs
+ * 32 values back to 24 bytes with multiply-adds.
+ *
+ * Both stop short of the end, the scalar code does the rest.
+ */
+
+AVX2_TARGET
+static size_t encode_avx2( const uint8_t* src, size_t len, char* dst, bool url )
+{
+  const __m256i reshuffle = _mm256_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                              1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 );
+  const char plus = url ? '-' : '+';
+  const char slash = url ? '_' : '/';
+  const __m256i offsets = _mm256_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, plus - 62,
+                                            slash - 63, 'A', 0, 0,
+                                            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, plus - 62,
+                                            slash - 63, 'A', 0, 0 );
+  size_t i = 0;
+  // each lane reads 16 bytes and uses 12 of them
+  for( ; i + 28 <= len; i += 24, dst += 32 ) {
+    __m256i in = _mm256_castsi128_si256( _mm_loadu_si128( ( const __m128i* )( src + i ) ) );
+    in = _mm256_inserti128_si256( in, _mm_loadu_si128( ( const __m128i* )( src + i + 12 ) ), 1 );
+    in = _mm256_shuffle_epi8( in, reshuffle );
+    const __m256i t0 = _mm256_mulhi_epu16( _mm256_and_si256( in, _mm256_set1_epi32( 0x0FC0FC00 ) ),
+                                           _mm256_set1_epi32( 0x04000040 ) );
+    const __m256i t1 = _mm256_mullo_epi16( _mm256_and_si256( in, _mm256_set1_epi32( 0x003F03F0 ) ),
+                                           _mm256_set1_epi32( 0x01000010 ) );
+    const __m256i values = _mm256_or_si256( t0, t1 );
+
+    // 0 for 26-51, 1-12 for 52-63 and 13 for 0-25
+    __m256i range = _mm256_subs_epu8( values, _mm256_set1_epi8( 51 ) );
+    const __m256i upper = _mm256_cmpgt_epi8( _mm256_set1_epi8( 26 ), values );
+    range = _mm256_or_si256( range, _mm256_and_si256( upper, _mm256_set1_epi8( 13 ) ) );
+    const __m256i chars = _mm256_add_epi8( values, _mm256_shuffle_epi8( offsets, range ) );
+    _mm256_storeu_si256( ( __m256i* )dst, chars );
+  }
+  return i;
+}
+
+AVX2_TARGET
+static size_t decode_avx2( const char* src, size_t len, uint8_t* dst, bool url )
+{
+  const __m256i lutLow = _mm256_setr_epi8( 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                           0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A );
+  const __m256i lutHigh = _mm256_setr_epi8( 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 );
+  const __m256i lutRoll = _mm256_setr_epi8( 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0 );
+  const __m256i nibble = _mm256_set1_epi8( 0x0F );
+  const __m256i slash = _mm256_set1_epi8( '/' );
+  const __m256i pack = _mm256_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                         2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 );
+  size_t i = 0;
+  // 32 bytes are stored for every 24 decoded, stay clear of the end
+  for( ; i + 44 <= len; i += 32, dst += 24 ) {
+    __m256i in = _mm256_loadu_si256( ( const __m256i* )( src + i ) );
+    if( url ) {
+      // swap '-' and '_' for '+' and '/', and make those invalid
+      const __m256i standard = _mm256_or_si256( _mm256_cmpeq_epi8( in, _mm256_set1_epi8( '+' ) ),
+                                                _mm256_cmpeq_epi8( in, slash ) );
+      in = _mm256_blendv_epi8( in, _mm256_set1_epi8( '+' ), _mm256_cmpeq_epi8( in, _mm256_set1_epi8( '-' ) ) );
+      in = _mm256_blendv_epi8( in, slash, _mm256_cmpeq_epi8( in, _mm256_set1_epi8( '_' ) ) );
+      in = _mm256_or_si256( in, _mm256_and_si256( standard, _mm256_set1_epi8( char( 0x80 ) ) ) );
+    }
+    const __m256i high = _mm256_and_si256( _mm256_srli_epi32( in, 4 ), nibble );
+    const __m256i low = _mm256_shuffle_epi8( lutLow, _mm256_and_si256( in, nibble ) );
+    if( !_mm256_testz_si256( low, _mm256_shuffle_epi8( lutHigh, high ) ) ) {
+      break;
+    }
+    const __m256i roll = _mm256_shuffle_epi8( lutRoll, _mm256_add_epi8( _mm256_cmpeq_epi8( in, slash ), high ) );
+    const __m256i values = _mm256_add_epi8( in, roll );
+
+    const __m256i pairs = _mm256_maddubs_epi16( values, _mm256_set1_epi32( 0x01400140 ) );
+    __m256i out = _mm256_madd_epi16( pairs, _mm256_set1_epi32( 0x00011000 ) );
+    out = _mm256_shuffle_epi8( out, pack );
+    out = _mm256_permutevar8x32_epi32( out, _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 7, 7 ) );
+    _mm256_storeu_si256( ( __m256i* )dst, out );
+  }
+  return i;
+}
+
+#endif // HAVE_X86_BASE64
+
+static size_t encode_none( const uint8_t*, size_t, char*, bool )
+{
+  return 0;
+}
+
+static size_t decode_none( const char*, size_t, uint8_t*, bool )
+{
+  return 0;
+}
+
+/**
+ * Vector kernels that do a leading part of the work, whole groups only,
+ * and return how many bytes (characters) they consumed.
+ */
+struct Kernels {
+  size_t ( *encode )( const uint8_t* src, size_t len, char* dst, bool url );
+  size_t ( *decode )( const char* src, size_t len, uint8_t* dst, bool url );
+};
+
+static Kernels select_kernels()
+{
+  Kernels k;
+  k.encode = encode_none;
+  k.decode = decode_none;
+#if defined(HAVE_X86_BASE64)
+  if( __builtin_cpu_supports( "avx2" ) ) {
+    k.encode = encode_avx2;
+    k.decode = decode_avx2;
+  }
+#endif
+  return k;
+}
+
+static const Kernels& kernels()
+{
+  static const Kernels k = select_kernels();
+  return k;
+}
+
+static void encode( const uint8_t* src, size_t len, char* dst, bool url, bool pad )
+{
+  const size_t done = kernels().encode( src, len, dst, url );
+  const char* chars = alphabet( url ).chars;
+  dst += done / 3 * 4;
+  size_t i = done;
+  for( ; i + 3 <= len; i += 3, dst += 4 ) {
+    const uint32_t v = ( uint32_t( src[i] ) << 16 ) | ( uint32_t( src[i + 1] ) << 8 ) | src[i + 2];
+    dst[0] = chars[v >> 18];
+    dst[1] = chars[( v >> 12 ) & 63];
+    dst[2] = chars[( v >> 6 ) & 63];
+    dst[3] = chars[v & 63];
+  }
+  if( i < len ) {
+    const bool two = i + 1 < len;
+    const uint32_t v = ( uint32_t( src[i] ) << 16 ) | ( two ? uint32_t( src[i + 1] ) << 8 : 0 );
+    *dst++ = chars[v >> 18];
+    *dst++ = chars[( v >> 12 ) & 63];
+    if( two ) {
+      *dst++ = chars[( v >> 6 ) & 63];
+    } else if( pad ) {
+      *dst++ = '=';
+    }
+    if( pad ) {
+      *dst++ = '=';
+    }
+  }
+}
+
+static ssize_t decode( const char* src, size_t len, uint8_t* dst, bool url )
+{
+  if( len % 4 == 0 && len > 0 ) {
+    len -= src[len - 1] == '=';
+    len -= src[len - 1] == '=';
+  }
+  if( len % 4 == 1 ) {
+    return BAD_VALUE;
+  }
+
+  const uint8_t* values = alphabet( url ).values;
+  const size_t done = kernels().decode( src, len, dst, url );
+  uint8_t* out = dst + done / 4 * 3;
+  size_t i = done;
+  for( ; i + 4 <= len; i += 4, out += 3 ) {
+    const uint32_t a = values[uint8_t( src[i] )];
+    const uint32_t b = values[uint8_t( src[i + 1] )];
+    const uint32_t c = values[uint8_t( src[i + 2] )];
+    const uint32_t d = values[uint8_t( src[i + 3] )];
+    if( ( a | b | c | d ) & 0x80 ) {
+      return BAD_VALUE;
+    }
+    const uint32_t v = ( a << 18 ) | ( b << 12 ) | ( c << 6 ) | d;
+    out[0] = uint8_t( v >> 16 );
+    out[1] = uint8_t( v >> 8 );
+    out[2] = uint8_t( v );
+  }
+  if( i < len ) {
+    const uint32_t a = values[uint8_t( src[i] )];
+    const uint32_t b = values[uint8_t( src[i + 1] )];
+    const uint32_t c = i + 2 < len ? values[uint8_t( src[i + 2] )] : 0;
+    if( ( a | b | c ) & 0x80 ) {
+      return BAD_VALUE;
+    }
+    const uint32_t v = ( a << 18 ) | ( b << 12 ) | ( c << 6 );
+    *out++ = uint8_t( v >> 16 );
+    if( i + 2 < len ) {
+      *out++ = uint8_t( v >> 8 );
+    }
+  }
+  return out - dst;
+}
+
+} // namespace base64_detail
+
+class Base64Encoding : public BaseEncoding
+{
+public:
+  explicit Base64Encoding( bool url )
+    : mUrl( url ) {}
+
+  size_t encodedLength( size_t len ) const override {
+    if( !mUrl ) {
+      return ( len + 2 ) / 3 * 4;
+    }
+    return len / 3 * 4 + ( len % 3 == 0 ? 0 : len % 3 + 1 );
+  }
+  size_t decodedLength( size_t len ) const override {
+    return ( len + 3 ) / 4 * 3;
+  }
+  void encodeInto( const void* src, size_t len, char* dst ) const override {
+    base64_detail::encode( static_cast<const uint8_t*>( src ), len, dst, mUrl, !mUrl );
+  }
+  ssize_t decodeInto( const char* src, size_t len, uint8_t* dst ) const override {
+    return base64_detail::decode( src, len, dst, mUrl );
+  }
+  size_t groupBytes() const override {
+    return 3;
+  }
+  size_t groupChars() const override {
+    return 4;
+  }
+
+private:
+  const bool mUrl;
+};
+
+Base64Encoding gBase64Encoding( false );
+Base64Encoding gBase64UrlEncoding( true );
+
+BaseEncoding& base64Encoding()
+{
+  return gBase64Encoding;
+}
+
+BaseEncoding& base64UrlEncoding()
+{
+  return gBase64UrlEncoding;
+}
+
+////////////////// Base32 //////////////////
+
+namespace base32_detail {
+
+static const char kAlphabet[32 + 1] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+// characters for 1 to 4 trailing bytes, and bytes for 0 to 7 trailing
+// characters (0 where that many can not happen)
+static const int kTailChars[5] = { 0, 2, 4, 5, 7 };
+static const int kTailBytes[8] = { 0, 0, 1, 0, 2, 3, 0, 4 };
+
+struct Values {
+  uint8_t values[256];
+
+  Values() {
+    memset( values, 0xFF, sizeof( values ) );
+    for( int i = 0; i < 32; i++ ) {
+      values[uint8_t( kAlphabet[i] )] = uint8_t( i );
+      values[uint8_t( tolower( kAlphabet[i] ) )] = uint8_t( i );
+    }
+  }
+};
+
+static const uint8_t* values()
+{
+  static const Values v;
+  return v.values;
+}
+
+//! the 40 bits of a group, first byte highest
+static inline uint64_t load40( const uint8_t* p )
+{
+  return ( uint64_t( p[0] ) << 32 ) | ( uint64_t( p[1] ) << 24 ) | ( uint64_t( p[2] ) << 16 ) |
+         ( uint64_t( p[3] ) << 8 ) | p[4];
+}
+
+static inline void store40( uint8_t* p, uint64_t v )
+{
+  p[0] = uint8_t( v >> 32 );
+  p[1] = uint8_t( v >> 24 );
+  p[2] = uint8_t( v >> 16 );
+  p[3] = uint8_t( v >> 8 );
+  p[4] = uint8_t( v );
+}
+
+#if defined(HAVE_BMI2_BASE32)
+
+/*
+ * A group of 5 bytes is 8 characters of 5 bits, which pdep and pext
+ * spread to and gather from the bytes of a 64 bit word. The alphabet is
+ * mapped a word at a time: 'A' + value, less 41 for values of 26 and up,
+ * which are '2'-'7'.
+ */
+
+static const uint64_t kOnes = 0x0101010101010101ull;
+static const uint64_t kHighBits = 0x8080808080808080ull;
+static const uint64_t kFields = 0x1F1F1F1F1F1F1F1Full;
+
+//! high bit of each byte of w set where that byte is in [lo, hi], for ASCII
+static inline uint64_t in_range( uint64_t w, uint8_t lo, uint8_t hi )
+{
+  const uint64_t atLeast = w + kOnes * ( 0x80 - lo );
+  const uint64_t above = w + kOnes * ( 0x7F - hi );
+  return atLeast & ~above & kHighBits;
+}
+
+BMI2_TARGET
+static size_t encode_bmi2( const uint8_t* src, size_t len, char* dst )
+{
+  size_t i = 0;
+  for( ; i + 5 <= len; i += 5, dst += 8 ) {
+    const uint64_t fields = __builtin_bswap64( _pdep_u64( load40( src + i ), kFields ) );
+    const uint64_t digits = ( ( fields + kOnes * ( 0x80 - 26 ) ) & kHighBits ) >> 7;
+    const uint64_t chars = fields + kOnes * 'A' - digits * 41;
+    memcpy( dst, &chars, 8 );
+  }
+  return i;
+}
+
+BMI2_TARGET
+static size_t decode_bmi2( const char* src, size_t len, uint8_t* dst )
+{
+  size_t i = 0;
+  for( ; i + 8 <= len; i += 8, dst += 5 ) {
+    uint64_t w;
+    memcpy( &w, src + i, 8 );
+    if( w & kHighBits ) {
+      break;
+    }
+    const uint64_t lower = w | kOnes * 0x20;
+    const uint64_t letters = in_range( lower, 'a', 'z' );
+    const uint64_t digits = in_range( w, '2', '7' );
+    if( ( letters | digits ) != kHighBits ) {
+      break;
+    }
+    // no borrows between bytes with the high bits set first
+    const uint64_t letterValues = ( ( lower | kHighBits ) - kOnes * 'a' ) & ( ( letters >> 7 ) * 0xFF );
+    const uint64_t digitValues = ( ( w | kHighBits ) - kOnes * ( '2' - 26 ) ) & ( ( digits >> 7 ) * 0xFF );
+    store40( dst, _pext_u64( __builtin_bswap64( letterValues | digitValues ), kFields ) );
+  }
+  return i;
+}
+
+#endif // HAVE_BMI2_BASE32
+
+static size_t encode_none( const uint8_t*, size_t, char* )
+{
+  return 0;
+}
+
+static size_t decode_none( const char*, size_t, uint8_t* )
+{
+  return 0;
+}
+
+struct Kernels {
+  size_t ( *encode )( const uint8_t* src, size_t len, char* dst );
+  size_t ( *decode )( const char* src, size_t len, uint8_t* dst );
+};
+
+static Kernels select_kernels()
+{
+  Kernels k;
+  k.encode = encode_none;
+  k.decode = decode_none;
+#if defined(HAVE_BMI2_BASE32)
+  if( __builtin_cpu_supports( "bmi2" ) ) {
+    k.encode = encode_bmi2;
+    k.decode = decode_bmi2;
+  }
+#endif
+  return k;
+}
+
+static const Kernels& kernels()
+{
+  static const Kernels k = select_kernels();
+  return k;
+}
+
+static void encode( const uint8_t* src, size_t len, char* dst )
+{
+  const size_t done = kernels().encode( src, len, dst );
+  dst += done / 5 * 8;
+  size_t i = done;
+  for( ; i + 5 <= len; i += 5, dst += 8 ) {
+    const uint64_t v = load40( src + i );
+    for( int c = 0; c < 8; c++ ) {
+      dst[c] = kAlphabet[( v >> ( 35 - 5 * c ) ) & 31];
+    }
+  }
+  if( i < len ) {
+    uint8_t group[5] = { 0, 0, 0, 0, 0 };
+    memcpy( group, src + i, len - i );
+    const uint64_t v = load40( group );
+    const int chars = kTailChars[len - i];
+    for( int c = 0; c < 8; c++ ) {
+      dst[c] = c < chars ? kAlphabet[( v >> ( 35 - 5 * c ) ) & 31] : '=';
+    }
+  }
+}
+
+static ssize_t decode( const char* src, size_t len, uint8_t* dst )
+{
+  if( len % 8 == 0 && len > 0 ) {
+    size_t padding = 0;
+    while( padding < 6 && src[len - 1 - padding] == '=' ) {
+      padding++;
+    }
+    len -= padding;
+  }
+  if( len % 8 != 0 && kTailBytes[len % 8] == 0 ) {
+    return BAD_VALUE;
+  }
+
+  const uint8_t* table = values();
+  const size_t done = kernels().decode( src, len, dst );
+  uint8_t* out = dst + done / 8 * 5;
+  size_t i = done;
+  while( i < len ) {
+    const size_t chars = MIN( len - i, size_t( 8 ) );
+    uint64_t v = 0;
+    uint8_t invalid = 0;
+    for( size_t c = 0; c < 8; c++ ) {
+      const uint8_t value = c < chars ? table[uint8_t( src[i + c] )] : 0;
+      invalid |= value;
+      v = ( v << 5 ) | ( value & 31 );
+    }
+    if( invalid & 0x80 ) {
+      return BAD_VALUE;
+    }
+    uint8_t group[5];
+    store40( group, v );
+    const size_t bytes = chars == 8 ? 5 : kTailBytes[chars];
+    memcpy( out, group, bytes );
+    out += bytes;
+    i += chars;
+  }
+  return out - dst;
+}
+
+} // namespace base32_detail
+
+class Base32Encoding : public BaseEncoding
+{
+public:
+
+  size_t encodedLength( size_t len ) const override {
+    return ( len + 4 ) / 5 * 8;
+  }
+  size_t decodedLength( size_t len ) const override {
+    return ( len + 7 ) / 8 * 5;
+  }
+  void encodeInto( const void* src, size_t len, char* dst ) const override {
+    base32_detail::encode( static_cast<const uint8_t*>( src ), len, dst );
+  }
+  ssize_t decodeInto( const char* src, size_t len, uint8_t* dst ) const override {
+    return base32_detail::decode( src, len, dst );
+  }
+  size_t groupBytes() const override {
+    return 5;
+  }
+  size_t groupChars() const override {
+    return 8;
+  }
+
+};
+
+Base32Encoding gBase32Encoding;
+
+BaseEncoding& base32Encoding()
+{
+  return gBase32Encoding;
+}
+
 }
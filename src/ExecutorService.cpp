@@ -24,6 +24,7 @@
 #include <baseline/Mutex.h>
 #include <baseline/Condition.h>
 #include <baseline/UniquePointer.h>
+#include <baseline/Sort.h>
 
 #include <time.h>
 
@@ -86,6 +87,7 @@ public:
   sp<Future> execute( const sp<Runnable>& task ) override;
   sp<Future> schedule( const sp<Runnable>& task, uint32_t delayMS ) override;
   sp<Future> scheduleWithFixedDelay( const sp<Runnable>& task, uint32_t delayMS ) override;
+  int getNumThreads() const override;
   void start();
 
   String8 mName;
@@ -315,6 +317,10 @@ sp<Future> ExecutorServiceImpl::scheduleWithFixedDelay( const sp<Runnable>& runn
   return task;
 }
 
+int ExecutorServiceImpl::getNumThreads() const
+{
+  return mThreads.size();
+}
 
 sp<ExecutorService> ExecutorService::createExecutorService( const String8& name, int numThreads )
 {
@@ -324,4 +330,61 @@ sp<ExecutorService> ExecutorService::createExecutorService( const String8& name,
   return retval;
 }
 
-}
\ No newline at end of file
+namespace sort_detail {
+
+class DLL_LOCAL IndexedTask : public Runnable
+{
+public:
+  IndexedTask( void ( *fn )( void*, size_t ), void* state, size_t index )
+    : mFn( fn ), mState( state ), mIndex( index ) {}
+
+  void run() {
+    mFn( mState, mIndex );
+  }
+
+private:
+  void ( *mFn )( void*, size_t );
+  void* mState;
+  size_t mIndex;
+};
+
+size_t parallelism( const sp<ExecutorService>& executor )
+{
+  if( executor == nullptr ) {
+    return 1;
+  }
+  return MAX( executor->getNumThreads(), 1 );
+}
+
+void run_tasks( const sp<ExecutorService>& executor, size_t count,
+                void ( *fn )( void*, size_t ), void* state )
+{
+  Vector<sp<Future>> futures;
+  if( executor != nullptr && count > 1 ) {
+    futures.setCapacity( count - 1 );
+    for( size_t i = 1; i < count; i++ ) {
+      sp<Future> future = executor->execute( new IndexedTask( fn, state, i ) );
+      if( future == nullptr ) {
+        // not running, do it here
+        fn( state, i );
+      } else {
+        futures.push_back( future );
+      }
+    }
+  } else {
+    for( size_t i = 1; i < count; i++ ) {
+      fn( state, i );
+    }
+  }
+
+  if( count > 0 ) {
+    fn( state, 0 );
+  }
+  for( size_t i = 0; i < futures.size(); i++ ) {
+    futures[i]->wait();
+  }
+}
+
+} // namespace sort_detail
+
+}
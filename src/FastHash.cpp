@@ -0,0 +1,504 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/FastHash.h>
+#include <baseline/Hash.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define HAVE_SSE2_HASH
+#endif
+
+#if defined(HAVE_SSE2_HASH) && defined(__GNUC__)
+  #include <immintrin.h>
+  #define HAVE_AVX2_HASH
+  #define AVX2_TARGET __attribute__(( target( "avx2" ) ))
+#endif
+
+namespace baseline {
+namespace hash_detail {
+
+static const size_t kSecretSize = 192;
+static const size_t kStripeLen = 64;
+static const size_t kStripesPerBlock = ( kSecretSize - kStripeLen ) / 8;
+static const size_t kBlockLen = kStripeLen * kStripesPerBlock;
+static const size_t kMidMax = 240;
+
+// where the key for the last stripe, the scramble and the merges start
+static const size_t kLastStripeOffset = kSecretSize - kStripeLen - 7;
+static const size_t kScrambleOffset = kSecretSize - kStripeLen;
+static const size_t kMergeOffset = 11;
+static const size_t kMergeHighOffset = kSecretSize - kStripeLen - 11;
+
+static inline void write64( uint8_t* p, uint64_t value )
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64( value );
+#endif
+  memcpy( p, &value, sizeof( value ) );
+}
+
+/**
+ * The default secret: kSecretSize bytes from splitmix64. Seeded hashes of
+ * more than kMidMax bytes derive their own secret from it.
+ */
+struct Secret {
+  uint8_t bytes[kSecretSize];
+
+  Secret() {
+    uint64_t state = kPrime1;
+    for( size_t i = 0; i < kSecretSize; i += 8 ) {
+      state += 0x9E3779B97F4A7C15ull;
+      uint64_t z = state;
+      z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+      z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+      write64( &bytes[i], z ^ ( z >> 31 ) );
+    }
+  }
+};
+
+static const uint8_t* default_secret()
+{
+  static const Secret secret;
+  return secret.bytes;
+}
+
+static void derive_secret( uint8_t* secret, uint64_t seed )
+{
+  const uint8_t* base = default_secret();
+  for( size_t i = 0; i < kSecretSize; i += 16 ) {
+    write64( &secret[i], read64( &base[i] ) + seed );
+    write64( &secret[i + 8], read64( &base[i + 8] ) - seed );
+  }
+}
+
+static inline uint64_t mix16( const uint8_t* p, const uint8_t* secret, uint64_t seed )
+{
+  return mul128_fold64( read64( p ) ^ ( read64( secret ) + seed ),
+                        read64( p + 8 ) ^ ( read64( secret + 8 ) - seed ) );
+}
+
+//! inputs of 17 to kMidMax bytes
+static uint64_t hash_mid( const uint8_t* p, size_t len, const uint8_t* secret, uint64_t seed )
+{
+  uint64_t acc = len * kPrime1;
+  if( len <= 128 ) {
+    if( len > 32 ) {
+      if( len > 64 ) {
+        if( len > 96 ) {
+          acc += mix16( p + 48, secret + 96, seed );
+          acc += mix16( p + len - 64, secret + 112, seed );
+        }
+        acc += mix16( p + 32, secret + 64, seed );
+        acc += mix16( p + len - 48, secret + 80, seed );
+      }
+      acc += mix16( p + 16, secret + 32, seed );
+      acc += mix16( p + len - 32, secret + 48, seed );
+    }
+    acc += mix16( p, secret, seed );
+    acc += mix16( p + len - 16, secret + 16, seed );
+    return avalanche( acc );
+  }
+
+  for( size_t i = 0; i < 8; i++ ) {
+    acc += mix16( p + 16 * i, secret + 16 * i, seed );
+  }
+  acc = avalanche( acc );
+  const size_t rounds = len / 16;
+  for( size_t i = 8; i < rounds; i++ ) {
+    acc += mix16( p + 16 * i, secret + 16 * ( i - 8 ) + 3, seed );
+  }
+  acc += mix16( p + len - 16, secret + 136 - 17, seed );
+  return avalanche( acc );
+}
+
+/////////////// accumulator loop ///////////////////
+
+/*
+ * Inputs over kMidMax bytes are consumed in 64 byte stripes by eight 64
+ * bit lanes. Each lane adds the 32x32 bit product of its keyed input word
+ * and the plain input word of its neighbour; every kStripesPerBlock
+ * stripes the lanes are scrambled so that the key can be reused.
+ */
+
+static void accumulate_scalar( uint64_t* acc, const uint8_t* p, const uint8_t* secret, size_t stripes )
+{
+  for( ; stripes > 0; stripes--, p += kStripeLen, secret += 8 ) {
+    for( size_t i = 0; i < 8; i++ ) {
+      const uint64_t data = read64( p + 8 * i );
+      const uint64_t keyed = data ^ read64( secret + 8 * i );
+      acc[i ^ 1] += data;
+      acc[i] += ( keyed & 0xFFFFFFFF ) * ( keyed >> 32 );
+    }
+  }
+}
+
+static void scramble_scalar( uint64_t* acc, const uint8_t* secret )
+{
+  for( size_t i = 0; i < 8; i++ ) {
+    uint64_t a = acc[i];
+    a ^= a >> 47;
+    a ^= read64( secret + 8 * i );
+    acc[i] = a * 0x9E3779B1u;
+  }
+}
+
+#if defined(HAVE_SSE2_HASH)
+
+static void accumulate_sse2( uint64_t* acc, const uint8_t* p, const uint8_t* secret, size_t stripes )
+{
+  __m128i* lanes = reinterpret_cast<__m128i*>( acc );
+  __m128i a0 = _mm_loadu_si128( lanes + 0 );
+  __m128i a1 = _mm_loadu_si128( lanes + 1 );
+  __m128i a2 = _mm_loadu_si128( lanes + 2 );
+  __m128i a3 = _mm_loadu_si128( lanes + 3 );
+  for( ; stripes > 0; stripes--, p += kStripeLen, secret += 8 ) {
+    __m128i* lane[4] = { &a0, &a1, &a2, &a3 };
+    for( int i = 0; i < 4; i++ ) {
+      const __m128i data = _mm_loadu_si128( ( const __m128i* )( p + 16 * i ) );
+      const __m128i keyed = _mm_xor_si128( data, _mm_loadu_si128( ( const __m128i* )( secret + 16 * i ) ) );
+      const __m128i product = _mm_mul_epu32( keyed, _mm_shuffle_epi32( keyed, _MM_SHUFFLE( 0, 3, 0, 1 ) ) );
+      const __m128i swapped = _mm_shuffle_epi32( data, _MM_SHUFFLE( 1, 0, 3, 2 ) );
+      *lane[i] = _mm_add_epi64( *lane[i], _mm_add_epi64( product, swapped ) );
+    }
+  }
+  _mm_storeu_si128( lanes + 0, a0 );
+  _mm_storeu_si128( lanes + 1, a1 );
+  _mm_storeu_si128( lanes + 2, a2 );
+  _mm_storeu_si128( lanes + 3, a3 );
+}
+
+static void scramble_sse2( uint64_t* acc, const uint8_t* secret )
+{
+  const __m128i prime = _mm_set1_epi32( int( 0x9E3779B1u ) );
+  __m128i* lanes = reinterpret_cast<__m128i*>( acc );
+  for( int i = 0; i < 4; i++ ) {
+    __m128i a = _mm_loadu_si128( lanes + i );
+    a = _mm_xor_si128( a, _mm_srli_epi64( a, 47 ) );
+    a = _mm_xor_si128( a, _mm_loadu_si128( ( const __m128i* )( secret + 16 * i ) ) );
+    // 64x32 bit multiply from two 32x32 bit ones
+    const __m128i low = _mm_mul_epu32( a, prime );
+    const __m128i high = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), prime );
+    _mm_storeu_si128( lanes + i, _mm_add_epi64( low, _mm_slli_epi64( high, 32 ) ) );
+  }
+}
+
+#endif // HAVE_SSE2_HASH
+
+#if defined(HAVE_AVX2_HASH)
+
+AVX2_TARGET
+static void accumulate_avx2( uint64_t* acc, const uint8_t* p, const uint8_t* secret, size_t stripes )
+{
+  __m256i* lanes = reinterpret_cast<__m256i*>( acc );
+  __m256i a0 = _mm256_loadu_si256( lanes + 0 );
+  __m256i a1 = _mm256_loadu_si256( lanes + 1 );
+  for( ; stripes > 0; stripes--, p += kStripeLen, secret += 8 ) {
+    const __m256i d0 = _mm256_loadu_si256( ( const __m256i* )p );
+    const __m256i d1 = _mm256_loadu_si256( ( const __m256i* )( p + 32 ) );
+    const __m256i k0 = _mm256_xor_si256( d0, _mm256_loadu_si256( ( const __m256i* )secret ) );
+    const __m256i k1 = _mm256_xor_si256( d1, _mm256_loadu_si256( ( const __m256i* )( secret + 32 ) ) );
+    const __m256i p0 = _mm256_mul_epu32( k0, _mm256_shuffle_epi32( k0, _MM_SHUFFLE( 0, 3, 0, 1 ) ) );
+    const __m256i p1 = _mm256_mul_epu32( k1, _mm256_shuffle_epi32( k1, _MM_SHUFFLE( 0, 3, 0, 1 ) ) );
+    a0 = _mm256_add_epi64( a0, _mm256_add_epi64( p0, _mm256_shuffle_epi32( d0, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ) );
+    a1 = _mm256_add_epi64( a1, _mm256_add_epi64( p1, _mm256_shuffle_epi32( d1, _MM_SHUFFLE( 1, 0, 3, 2 ) ) ) );
+  }
+  _mm256_storeu_si256( lanes + 0, a0 );
+  _mm256_storeu_si256( lanes + 1, a1 );
+}
+
+AVX2_TARGET
+static void scramble_avx2( uint64_t* acc, const uint8_t* secret )
+{
+  const __m256i prime = _mm256_set1_epi32( int( 0x9E3779B1u ) );
+  __m256i* lanes = reinterpret_cast<__m256i*>( acc );
+  for( int i = 0; i < 2; i++ ) {
+    __m256i a = _mm256_loadu_si256( lanes + i );
+    a = _mm256_xor_si256( a, _mm256_srli_epi64( a, 47 ) );
+    a = _mm256_xor_si256( a, _mm256_loadu_si256( ( const __m256i* )( secret + 32 * i ) ) );
+    const __m256i low = _mm256_mul_epu32( a, prime );
+    const __m256i high = _mm256_mul_epu32( _mm256_srli_epi64( a, 32 ), prime );
+    _mm256_storeu_si256( lanes + i, _mm256_add_epi64( low, _mm256_slli_epi64( high, 32 ) ) );
+  }
+}
+
+#endif // HAVE_AVX2_HASH
+
+struct Kernels {
+  void ( *accumulate )( uint64_t* acc, const uint8_t* p, const uint8_t* secret, size_t stripes );
+  void ( *scramble )( uint64_t* acc, const uint8_t* secret );
+};
+
+static Kernels select_kernels()
+{
+  Kernels k;
+  k.accumulate = accumulate_scalar;
+  k.scramble = scramble_scalar;
+#if defined(HAVE_SSE2_HASH)
+  k.accumulate = accumulate_sse2;
+  k.scramble = scramble_sse2;
+#endif
+#if defined(HAVE_AVX2_HASH)
+  if( __builtin_cpu_supports( "avx2" ) ) {
+    k.accumulate = accumulate_avx2;
+    k.scramble = scramble_avx2;
+  }
+#endif
+  return k;
+}
+
+static const Kernels& kernels()
+{
+  static const Kernels k = select_kernels();
+  return k;
+}
+
+static void init_acc( uint64_t* acc )
+{
+  acc[0] = 0xC2B2AE3Du;
+  acc[1] = kPrime1;
+  acc[2] = kPrime2;
+  acc[3] = kPrime3;
+  acc[4] = kPrime4;
+  acc[5] = 0x85EBCA77u;
+  acc[6] = kPrime5;
+  acc[7] = 0x9E3779B1u;
+}
+
+/**
+ * Feeds stripes whole stripes, continuing a block that already has
+ * *stripesInBlock stripes in it.
+ */
+static void consume_stripes( uint64_t* acc, size_t* stripesInBlock, const uint8_t* p, size_t stripes,
+                             const uint8_t* secret )
+{
+  const Kernels& k = kernels();
+  while( stripes > 0 ) {
+    const size_t n = MIN( stripes, kStripesPerBlock - *stripesInBlock );
+    k.accumulate( acc, p, secret + 8 * *stripesInBlock, n );
+    *stripesInBlock += n;
+    p += n * kStripeLen;
+    stripes -= n;
+    if( *stripesInBlock == kStripesPerBlock ) {
+      k.scramble( acc, secret + kScrambleOffset );
+      *stripesInBlock = 0;
+    }
+  }
+}
+
+//! the accumulators after all of a > kMidMax byte input
+static void hash_long( uint64_t* acc, const uint8_t* p, size_t len, const uint8_t* secret )
+{
+  init_acc( acc );
+  size_t stripesInBlock = 0;
+  consume_stripes( acc, &stripesInBlock, p, ( len - 1 ) / kStripeLen, secret );
+  kernels().accumulate( acc, p + len - kStripeLen, secret + kLastStripeOffset, 1 );
+}
+
+static uint64_t merge( const uint64_t* acc, const uint8_t* secret, uint64_t start )
+{
+  uint64_t result = start;
+  for( size_t i = 0; i < 4; i++ ) {
+    result += mul128_fold64( acc[2 * i] ^ read64( secret + 16 * i ), acc[2 * i + 1] ^ read64( secret + 16 * i + 8 ) );
+  }
+  return avalanche( result );
+}
+
+static const uint8_t* secret_for( uint64_t seed, uint8_t* buffer )
+{
+  if( seed == 0 ) {
+    return default_secret();
+  }
+  derive_secret( buffer, seed );
+  return buffer;
+}
+
+static uint64_t high_seed( uint64_t seed )
+{
+  return rotl64( seed, 32 ) ^ kHighSeed;
+}
+
+uint64_t hash_long64( const uint8_t* p, size_t len, uint64_t seed )
+{
+  if( len <= kMidMax ) {
+    return hash_mid( p, len, default_secret(), seed );
+  }
+  uint8_t buffer[kSecretSize];
+  const uint8_t* secret = secret_for( seed, buffer );
+  uint64_t acc[8];
+  hash_long( acc, p, len, secret );
+  return merge( acc, secret + kMergeOffset, len * kPrime1 );
+}
+
+Hash128 hash_long128( const uint8_t* p, size_t len, uint64_t seed )
+{
+  Hash128 result;
+  if( len <= kMidMax ) {
+    result.low = hash_mid( p, len, default_secret(), seed );
+    result.high = hash_mid( p, len, default_secret(), high_seed( seed ) );
+    return result;
+  }
+  uint8_t buffer[kSecretSize];
+  const uint8_t* secret = secret_for( seed, buffer );
+  uint64_t acc[8];
+  hash_long( acc, p, len, secret );
+  result.low = merge( acc, secret + kMergeOffset, len * kPrime1 );
+  result.high = merge( acc, secret + kMergeHighOffset, ~( len * kPrime2 ) );
+  return result;
+}
+
+/////////////// streaming ///////////////////
+
+/**
+ * HashFunction for hash64() and hash128(). Input is buffered 256 bytes
+ * at a time; large updates are fed to the accumulators straight from the
+ * caller's buffer. The last byte seen always stays buffered, because the
+ * final stripe is treated differently and short inputs use another
+ * algorithm altogether.
+ */
+class FastHash : public HashFunction
+{
+public:
+  FastHash( uint64_t seed, bool wide );
+
+  void update( void* buf, size_t len ) override;
+  size_t finalizeInto( void* out ) override;
+  void reset() override;
+
+private:
+  enum {
+    kBufferSize = 4 * kStripeLen
+  };
+
+  const uint64_t mSeed;
+  const bool mWide;
+  uint8_t mSecret[kSecretSize];
+  uint64_t mAcc[8];
+  size_t mStripesInBlock;
+  uint64_t mTotal;
+  size_t mBuffered;
+  uint8_t mBuffer[kBufferSize];
+  // the last stripe consumed, for when fewer than kStripeLen bytes follow
+  uint8_t mLastStripe[kStripeLen];
+};
+
+FastHash::FastHash( uint64_t seed, bool wide )
+  : mSeed( seed ), mWide( wide )
+{
+  if( seed == 0 ) {
+    memcpy( mSecret, default_secret(), kSecretSize );
+  } else {
+    derive_secret( mSecret, seed );
+  }
+  reset();
+}
+
+void FastHash::reset()
+{
+  init_acc( mAcc );
+  mStripesInBlock = 0;
+  mTotal = 0;
+  mBuffered = 0;
+}
+
+void FastHash::update( void* buf, size_t len )
+{
+  const uint8_t* input = reinterpret_cast<const uint8_t*>( buf );
+  mTotal += len;
+
+  while( len > 0 ) {
+    if( mBuffered == kBufferSize ) {
+      consume_stripes( mAcc, &mStripesInBlock, mBuffer, kBufferSize / kStripeLen, mSecret );
+      memcpy( mLastStripe, mBuffer + kBufferSize - kStripeLen, kStripeLen );
+      mBuffered = 0;
+    }
+    if( mBuffered == 0 && len > kBufferSize ) {
+      const size_t stripes = ( len - 1 ) / kStripeLen;
+      consume_stripes( mAcc, &mStripesInBlock, input, stripes, mSecret );
+      memcpy( mLastStripe, input + stripes * kStripeLen - kStripeLen, kStripeLen );
+      input += stripes * kStripeLen;
+      len -= stripes * kStripeLen;
+    }
+    const size_t n = MIN( len, kBufferSize - mBuffered );
+    memcpy( &mBuffer[mBuffered], input, n );
+    mBuffered += n;
+    input += n;
+    len -= n;
+  }
+}
+
+size_t FastHash::finalizeInto( void* out )
+{
+  uint64_t low;
+  uint64_t high = 0;
+  if( mTotal <= kMidMax ) {
+    // never flushed, the whole input is in the buffer
+    if( mWide ) {
+      Hash128 h = hash128( mBuffer, mBuffered, mSeed );
+      low = h.low;
+      high = h.high;
+    } else {
+      low = hash64( mBuffer, mBuffered, mSeed );
+    }
+  } else {
+    uint64_t acc[8];
+    memcpy( acc, mAcc, sizeof( acc ) );
+    size_t stripesInBlock = mStripesInBlock;
+    consume_stripes( acc, &stripesInBlock, mBuffer, ( mBuffered - 1 ) / kStripeLen, mSecret );
+
+    uint8_t last[kStripeLen];
+    if( mBuffered >= kStripeLen ) {
+      memcpy( last, mBuffer + mBuffered - kStripeLen, kStripeLen );
+    } else {
+      const size_t older = kStripeLen - mBuffered;
+      memcpy( last, mLastStripe + kStripeLen - older, older );
+      memcpy( last + older, mBuffer, mBuffered );
+    }
+    kernels().accumulate( acc, last, mSecret + kLastStripeOffset, 1 );
+
+    low = merge( acc, mSecret + kMergeOffset, mTotal * kPrime1 );
+    if( mWide ) {
+      high = merge( acc, mSecret + kMergeHighOffset, ~( mTotal * kPrime2 ) );
+    }
+  }
+
+  uint8_t* values = static_cast<uint8_t*>( out );
+  if( mWide ) {
+    for( int i = 7; i >= 0; i-- ) {
+      *values++ = uint8_t( high >> ( 8 * i ) );
+    }
+  }
+  for( int i = 7; i >= 0; i-- ) {
+    *values++ = uint8_t( low >> ( 8 * i ) );
+  }
+  return mWide ? 16 : 8;
+}
+
+} // namespace hash_detail
+
+up<HashFunction> createHash64( uint64_t seed )
+{
+  return up<HashFunction>( new hash_detail::FastHash( seed, false ) );
+}
+
+up<HashFunction> createHash128( uint64_t seed )
+{
+  return up<HashFunction>( new hash_detail::FastHash( seed, true ) );
+}
+
+} // namespace baseline
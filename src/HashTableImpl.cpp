@@ -0,0 +1,504 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/SharedBuffer.h>
+#include <baseline/HashTableImpl.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define HAVE_SSE2_GROUPS
+#endif
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+namespace baseline {
+
+static const uint8_t kEmpty = 0x80;
+static const uint8_t kDeleted = 0xfe;
+
+// full slots hold 7 bits of the hash, so kEmpty and kDeleted are the only
+// control bytes with the high bit set
+static inline bool isFull( uint8_t ctrl )
+{
+  return !( ctrl & 0x80 );
+}
+
+static inline size_t lowestBit( uint32_t bits )
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward( &index, bits );
+  return index;
+#else
+  return __builtin_ctz( bits );
+#endif
+}
+
+/*
+ * The control bytes of one group, matched all at once. Every match
+ * returns a mask with bit i set for slot i of the group.
+ */
+class DLL_LOCAL ControlGroup
+{
+public:
+#if defined(HAVE_SSE2_GROUPS)
+  explicit ControlGroup( const uint8_t* ctrl )
+    : mCtrl( _mm_loadu_si128( reinterpret_cast<const __m128i*>( ctrl ) ) ) {}
+
+  inline uint32_t match( uint8_t h2 ) const {
+    return _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_set1_epi8( char( h2 ) ), mCtrl ) );
+  }
+  inline uint32_t matchEmpty() const {
+    return match( kEmpty );
+  }
+  inline uint32_t matchFree() const {
+    return _mm_movemask_epi8( mCtrl );
+  }
+
+private:
+  __m128i mCtrl;
+#else
+  // two 64-bit words, byte i of a word is slot i
+  explicit ControlGroup( const uint8_t* ctrl ) {
+    mLo = load( ctrl );
+    mHi = load( ctrl + 8 );
+  }
+
+  // may report full slots next to a real match, they are filtered out by
+  // comparing the cached hash. never reports empty or deleted slots.
+  inline uint32_t match( uint8_t h2 ) const {
+    return bits( zeroBytes( mLo ^ ( kLsbs * h2 ) ) ) |
+           bits( zeroBytes( mHi ^ ( kLsbs * h2 ) ) ) << 8;
+  }
+  inline uint32_t matchEmpty() const {
+    // high bit set and bit 1 clear
+    return bits( mLo & ( ~mLo << 6 ) & kMsbs ) | bits( mHi & ( ~mHi << 6 ) & kMsbs ) << 8;
+  }
+  inline uint32_t matchFree() const {
+    return bits( mLo & kMsbs ) | bits( mHi & kMsbs ) << 8;
+  }
+
+private:
+  static const uint64_t kLsbs = 0x0101010101010101ull;
+  static const uint64_t kMsbs = 0x8080808080808080ull;
+
+  static inline uint64_t load( const uint8_t* p ) {
+    uint64_t v = 0;
+    for( int i = 7; i >= 0; i-- ) {
+      v = ( v << 8 ) | p[i];
+    }
+    return v;
+  }
+  static inline uint64_t zeroBytes( uint64_t x ) {
+    return ( x - kLsbs ) & ~x & kMsbs;
+  }
+  static inline uint32_t bits( uint64_t msbs ) {
+    // gathers the high bit of every byte into the low byte
+    return uint32_t( ( ( msbs >> 7 ) * 0x0102040810204080ull ) >> 56 );
+  }
+
+  uint64_t mLo;
+  uint64_t mHi;
+#endif
+};
+
+static inline size_t h1( hash_t hash )
+{
+  return size_t( ( uint64_t( hash ) * 0x9e3779b97f4a7c15ull ) >> 32 );
+}
+
+static inline uint8_t h2( hash_t hash )
+{
+  return uint8_t( ( uint64_t( hash ) * 0x9e3779b97f4a7c15ull ) >> 57 );
+}
+
+static inline size_t capacityForSlots( size_t slots )
+{
+  // a maximum load factor of 7/8 keeps probe sequences short
+  return slots - slots / 8;
+}
+
+static inline size_t bufferSize( size_t slots, size_t entrySize )
+{
+  return slots * ( 1 + sizeof( hash_t ) + entrySize );
+}
+
+// first empty or deleted slot on the probe sequence of hash
+static size_t findFree( const uint8_t* ctrl, size_t slots, hash_t hash )
+{
+  const size_t groupMask = slots / HashTableImpl::kGroupSize - 1;
+  size_t g = h1( hash ) & groupMask;
+  for( size_t step = 1; ; step++ ) {
+    const uint32_t avail = ControlGroup( ctrl + g * HashTableImpl::kGroupSize ).matchFree();
+    if( avail ) {
+      return g * HashTableImpl::kGroupSize + lowestBit( avail );
+    }
+    g = ( g + step ) & groupMask;
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+uint8_t* HashTableImpl::_ctrl() const
+{
+  return reinterpret_cast<uint8_t*>( mStorage );
+}
+
+hash_t* HashTableImpl::_hashes() const
+{
+  return reinterpret_cast<hash_t*>( _ctrl() + mSlots );
+}
+
+char* HashTableImpl::_entries() const
+{
+  return reinterpret_cast<char*>( _hashes() + mSlots );
+}
+
+HashTableImpl::HashTableImpl( size_t entrySize, uint32_t flags )
+  : mStorage( 0 ), mSlots( 0 ), mSize( 0 ), mGrowthLeft( 0 ),
+    mFlags( flags ), mEntrySize( entrySize )
+{
+}
+
+HashTableImpl::HashTableImpl( const HashTableImpl& rhs )
+  : mStorage( rhs.mStorage ), mSlots( rhs.mSlots ), mSize( rhs.mSize ),
+    mGrowthLeft( rhs.mGrowthLeft ), mFlags( rhs.mFlags ), mEntrySize( rhs.mEntrySize )
+{
+  if( mStorage ) {
+    SharedBuffer::bufferFromData( mStorage )->acquire();
+  }
+}
+
+HashTableImpl::HashTableImpl( HashTableImpl&& rhs )
+  : mStorage( rhs.mStorage ), mSlots( rhs.mSlots ), mSize( rhs.mSize ),
+    mGrowthLeft( rhs.mGrowthLeft ), mFlags( rhs.mFlags ), mEntrySize( rhs.mEntrySize )
+{
+  rhs.mStorage = 0;
+  rhs.mSlots = 0;
+  rhs.mSize = 0;
+  rhs.mGrowthLeft = 0;
+}
+
+HashTableImpl::~HashTableImpl()
+{
+  ALOGW_IF( mSize,
+            "[%p] subclasses of HashTableImpl must call finish_table()"
+            " in their destructor. Leaking %d bytes.",
+            this, ( int )( mSize * mEntrySize ) );
+  // We can't call do_destroy() here because the vtable is already gone.
+}
+
+HashTableImpl& HashTableImpl::operator = ( const HashTableImpl& rhs )
+{
+  LOG_ALWAYS_FATAL_IF( mEntrySize != rhs.mEntrySize,
+                       "HashTable<> have different types (this=%p, rhs=%p)", this, &rhs );
+  if( this != &rhs ) {
+    _release_storage();
+    mStorage = rhs.mStorage;
+    mSlots = rhs.mSlots;
+    mSize = rhs.mSize;
+    mGrowthLeft = rhs.mGrowthLeft;
+    if( mStorage ) {
+      SharedBuffer::bufferFromData( mStorage )->acquire();
+    }
+  }
+  return *this;
+}
+
+HashTableImpl& HashTableImpl::operator = ( HashTableImpl&& rhs )
+{
+  LOG_ALWAYS_FATAL_IF( mEntrySize != rhs.mEntrySize,
+                       "HashTable<> have different types (this=%p, rhs=%p)", this, &rhs );
+  if( this != &rhs ) {
+    _release_storage();
+    mStorage = rhs.mStorage;
+    mSlots = rhs.mSlots;
+    mSize = rhs.mSize;
+    mGrowthLeft = rhs.mGrowthLeft;
+    rhs.mStorage = 0;
+    rhs.mSlots = 0;
+    rhs.mSize = 0;
+    rhs.mGrowthLeft = 0;
+  }
+  return *this;
+}
+
+void HashTableImpl::finish_table()
+{
+  _release_storage();
+  mStorage = 0;
+  mSlots = 0;
+  mSize = 0;
+  mGrowthLeft = 0;
+}
+
+size_t HashTableImpl::capacity() const
+{
+  return capacityForSlots( mSlots );
+}
+
+int HashTableImpl::setCapacity( size_t size )
+{
+  size = MAX( size, mSize );
+  size_t slots = kGroupSize;
+  while( capacityForSlots( slots ) < size ) {
+    slots *= 2;
+  }
+  if( slots != mSlots && _resize( slots ) != NO_ERROR ) {
+    return NO_MEMORY;
+  }
+  return capacity();
+}
+
+void HashTableImpl::clear()
+{
+  if( !_can_relocate() ) {
+    finish_table();
+    return;
+  }
+  // only owner, keep the storage
+  uint8_t* ctrl = _ctrl();
+  if( !( mFlags & HAS_TRIVIAL_DTOR ) ) {
+    for( size_t i = 0; i < mSlots; i++ ) {
+      if( isFull( ctrl[i] ) ) {
+        do_destroy( _entries() + i * mEntrySize, 1 );
+      }
+    }
+  }
+  memset( ctrl, kEmpty, mSlots );
+  mSize = 0;
+  mGrowthLeft = capacityForSlots( mSlots );
+}
+
+int HashTableImpl::next( int index ) const
+{
+  const uint8_t* ctrl = _ctrl();
+  size_t i = size_t( index + 1 );
+  while( i < mSlots ) {
+    const size_t g = i & ~size_t( kGroupSize - 1 );
+    const uint32_t full = ~ControlGroup( ctrl + g ).matchFree() & ( 0xffffu << ( i - g ) );
+    if( full & 0xffff ) {
+      return int( g + lowestBit( full ) );
+    }
+    i = g + kGroupSize;
+  }
+  return -1;
+}
+
+int HashTableImpl::find( hash_t hash, const void* key ) const
+{
+  if( mSize == 0 ) {
+    return NAME_NOT_FOUND;
+  }
+  const uint8_t* ctrl = _ctrl();
+  const hash_t* hashes = _hashes();
+  const char* entries = _entries();
+  const uint8_t tag = h2( hash );
+  const size_t groupMask = mSlots / kGroupSize - 1;
+  size_t g = h1( hash ) & groupMask;
+  for( size_t step = 1; ; step++ ) {
+    const ControlGroup group( ctrl + g * kGroupSize );
+    for( uint32_t bits = group.match( tag ); bits; bits &= bits - 1 ) {
+      const size_t i = g * kGroupSize + lowestBit( bits );
+      if( hashes[i] == hash && do_equals( entries + i * mEntrySize, key ) ) {
+        return int( i );
+      }
+    }
+    if( group.matchEmpty() ) {
+      return NAME_NOT_FOUND;
+    }
+    g = ( g + step ) & groupMask;
+  }
+}
+
+int HashTableImpl::insert( hash_t hash, const void* key, bool* created )
+{
+  int index = find( hash, key );
+  if( index >= 0 ) {
+    *created = false;
+    return _edit() == NO_ERROR ? index : int( NO_MEMORY );
+  }
+
+  size_t i = mSlots ? findFree( _ctrl(), mSlots, hash ) : 0;
+  if( !mSlots || ( _ctrl()[i] == kEmpty && mGrowthLeft == 0 ) ) {
+    // out of empty slots. grow, or only drop the deleted ones if there
+    // are enough of them to make it worth it.
+    size_t slots = kGroupSize;
+    if( mSlots ) {
+      slots = ( mSize + 1 ) * 2 > capacityForSlots( mSlots ) ? mSlots * 2 : mSlots;
+    }
+    if( _resize( slots ) != NO_ERROR ) {
+      return NO_MEMORY;
+    }
+    i = findFree( _ctrl(), mSlots, hash );
+  } else if( _edit() != NO_ERROR ) {
+    return NO_MEMORY;
+  }
+
+  uint8_t* ctrl = _ctrl();
+  if( ctrl[i] == kEmpty ) {
+    mGrowthLeft--;
+  }
+  ctrl[i] = h2( hash );
+  _hashes()[i] = hash;
+  mSize++;
+  *created = true;
+  return int( i );
+}
+
+void HashTableImpl::removeAt( size_t index )
+{
+  ALOG_ASSERT( index < mSlots && isFull( _ctrl()[index] ),
+               "[%p] removeAt: index=%d is not an entry", this, ( int )index );
+  if( _edit() != NO_ERROR ) {
+    return;
+  }
+  if( !( mFlags & HAS_TRIVIAL_DTOR ) ) {
+    do_destroy( _entries() + index * mEntrySize, 1 );
+  }
+
+  // no probe sequence ever went past a group that still has an empty
+  // slot, so the slot can be made empty again instead of deleted
+  uint8_t* ctrl = _ctrl();
+  const size_t g = index & ~size_t( kGroupSize - 1 );
+  if( ControlGroup( ctrl + g ).matchEmpty() ) {
+    ctrl[index] = kEmpty;
+    mGrowthLeft++;
+  } else {
+    ctrl[index] = kDeleted;
+  }
+  mSize--;
+}
+
+const void* HashTableImpl::entryAt( size_t index ) const
+{
+  return _entries() + index * mEntrySize;
+}
+
+void* HashTableImpl::editEntryAt( size_t index )
+{
+  if( _edit() != NO_ERROR ) {
+    return 0;
+  }
+  return _entries() + index * mEntrySize;
+}
+
+status_t HashTableImpl::_edit()
+{
+  if( !mStorage || SharedBuffer::bufferFromData( mStorage )->onlyOwner() ) {
+    return NO_ERROR;
+  }
+
+  // same layout, so indices stay valid
+  SharedBuffer* sb = SharedBuffer::alloc( bufferSize( mSlots, mEntrySize ) );
+  if( !sb ) {
+    return NO_MEMORY;
+  }
+  char* storage = reinterpret_cast<char*>( sb->data() );
+  memcpy( storage, mStorage, mSlots * ( 1 + sizeof( hash_t ) ) );
+  const uint8_t* ctrl = _ctrl();
+  char* entries = storage + mSlots * ( 1 + sizeof( hash_t ) );
+  if( mFlags & HAS_TRIVIAL_COPY ) {
+    memcpy( entries, _entries(), mSlots * mEntrySize );
+  } else {
+    for( size_t i = 0; i < mSlots; i++ ) {
+      if( isFull( ctrl[i] ) ) {
+        do_copy( entries + i * mEntrySize, _entries() + i * mEntrySize, 1 );
+      }
+    }
+  }
+  _release_storage();
+  mStorage = storage;
+  return NO_ERROR;
+}
+
+status_t HashTableImpl::_resize( size_t slots )
+{
+  SharedBuffer* sb = SharedBuffer::alloc( bufferSize( slots, mEntrySize ) );
+  if( !sb ) {
+    return NO_MEMORY;
+  }
+  uint8_t* ctrl = reinterpret_cast<uint8_t*>( sb->data() );
+  hash_t* hashes = reinterpret_cast<hash_t*>( ctrl + slots );
+  char* entries = reinterpret_cast<char*>( hashes + slots );
+  memset( ctrl, kEmpty, slots );
+
+  // the cached hashes place the entries, nothing is hashed again
+  const bool relocate = _can_relocate();
+  const bool trivial = relocate ?
+                       ( mFlags & HAS_TRIVIAL_MOVE ) || ( ( mFlags & HAS_TRIVIAL_COPY ) && ( mFlags & HAS_TRIVIAL_DTOR ) ) :
+                       ( mFlags & HAS_TRIVIAL_COPY );
+  const uint8_t* oldCtrl = _ctrl();
+  for( size_t i = 0; i < mSlots; i++ ) {
+    if( !isFull( oldCtrl[i] ) ) {
+      continue;
+    }
+    const hash_t hash = _hashes()[i];
+    const size_t j = findFree( ctrl, slots, hash );
+    ctrl[j] = h2( hash );
+    hashes[j] = hash;
+    char* dest = entries + j * mEntrySize;
+    const char* from = _entries() + i * mEntrySize;
+    if( trivial ) {
+      memcpy( dest, from, mEntrySize );
+    } else if( relocate ) {
+      do_move( dest, from, 1 );
+    } else {
+      do_copy( dest, from, 1 );
+    }
+  }
+
+  if( relocate ) {
+    // the entries have been moved out, free the storage without destroying them
+    SharedBuffer::bufferFromData( mStorage )->release();
+  } else {
+    _release_storage();
+  }
+  mStorage = ctrl;
+  mSlots = slots;
+  mGrowthLeft = capacityForSlots( slots ) - mSize;
+  return NO_ERROR;
+}
+
+void HashTableImpl::_release_storage()
+{
+  if( mStorage ) {
+    const SharedBuffer* sb = SharedBuffer::bufferFromData( mStorage );
+    if( sb->release( SharedBuffer::eKeepStorage ) == 1 ) {
+      if( !( mFlags & HAS_TRIVIAL_DTOR ) ) {
+        const uint8_t* ctrl = _ctrl();
+        for( size_t i = 0; i < mSlots; i++ ) {
+          if( isFull( ctrl[i] ) ) {
+            do_destroy( _entries() + i * mEntrySize, 1 );
+          }
+        }
+      }
+      SharedBuffer::dealloc( sb );
+    }
+  }
+}
+
+bool HashTableImpl::_can_relocate() const
+{
+  // entries can be moved out of the storage only if nobody else sees them
+  return mStorage && SharedBuffer::bufferFromData( mStorage )->onlyOwner();
+}
+
+}
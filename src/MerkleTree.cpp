@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/MerkleTree.h>
+#include <baseline/ExecutorService.h>
+#include <baseline/Sort.h>
+#include <baseline/Streams.h>
+
+#include <atomic>
+#include <limits.h>
+
+namespace baseline {
+
+static const uint8_t kLeafTag = 0;
+static const uint8_t kNodeTag = 1;
+
+static void hash_leaf( HashFunction& h, const uint8_t* chunk, size_t len, uint8_t* out )
+{
+  h.reset();
+  h.update( const_cast<uint8_t*>( &kLeafTag ), 1 );
+  if( len > 0 ) {
+    h.update( const_cast<uint8_t*>( chunk ), len );
+  }
+  uint8_t digest[HashCode::kMaxSize];
+  memcpy( out, digest, h.finalizeInto( digest ) );
+}
+
+static void hash_node( HashFunction& h, const uint8_t* left, const uint8_t* right, size_t size, uint8_t* out )
+{
+  h.reset();
+  h.update( const_cast<uint8_t*>( &kNodeTag ), 1 );
+  h.update( const_cast<uint8_t*>( left ), size );
+  h.update( const_cast<uint8_t*>( right ), size );
+  uint8_t digest[HashCode::kMaxSize];
+  memcpy( out, digest, h.finalizeInto( digest ) );
+}
+
+struct MerkleTree::BuildState {
+  MerkleTree* tree;
+  const uint8_t* data;
+  size_t len;
+  size_t firstLeaf;
+  size_t chunks;
+  // chunks are handed out one at a time so that no task runs long
+  std::atomic<size_t> next;
+};
+
+MerkleTree::MerkleTree( Factory factory, size_t chunkSize )
+  : mFactory( factory ), mChunkSize( chunkSize ), mDigestSize( 0 ), mLength( 0 )
+{}
+
+status_t MerkleTree::prepare()
+{
+  if( mChunkSize == 0 ) {
+    return BAD_VALUE;
+  }
+  up<HashFunction> h = mFactory();
+  if( h.get() == nullptr ) {
+    return NO_MEMORY;
+  }
+  mDigestSize = h->finalize().size();
+  mLength = 0;
+  mNodes.clear();
+  // the leaves start at node 0; buildLevels() adds the rest once they are in
+  mLevelStart.clear();
+  mLevelStart.add( 0 );
+  return OK;
+}
+
+void MerkleTree::leafTask( void* state, size_t )
+{
+  BuildState* s = static_cast<BuildState*>( state );
+  MerkleTree* tree = s->tree;
+  up<HashFunction> h = tree->mFactory();
+  for( ;; ) {
+    const size_t i = s->next.fetch_add( 1 );
+    if( i >= s->chunks ) {
+      break;
+    }
+    const size_t offset = i * tree->mChunkSize;
+    hash_leaf( *h, s->data + offset, MIN( tree->mChunkSize, s->len - offset ),
+               tree->node( 0, s->firstLeaf + i ) );
+  }
+}
+
+void MerkleTree::hashLeaves( const uint8_t* data, size_t len, size_t firstLeaf, const sp<ExecutorService>& executor )
+{
+  BuildState state;
+  state.tree = this;
+  state.data = data;
+  state.len = len;
+  state.firstLeaf = firstLeaf;
+  state.chunks = len == 0 ? 1 : ( len - 1 ) / mChunkSize + 1;
+  state.next = 0;
+  size_t tasks = 1;
+  if( executor != nullptr ) {
+    // the calling thread takes a share as well
+    tasks = MIN( state.chunks, sort_detail::parallelism( executor ) + 1 );
+  }
+  sort_detail::run_tasks( executor, tasks, &MerkleTree::leafTask, &state );
+}
+
+void MerkleTree::buildLevels( size_t leaves )
+{
+  mLevelStart.clear();
+  mLevelStart.add( 0 );
+  mLevelStart.add( leaves );
+
+  up<HashFunction> h = mFactory();
+  size_t count = leaves;
+  for( size_t level = 0; count > 1; level++ ) {
+    const size_t parents = ( count + 1 ) / 2;
+    mNodes.insertAt( mNodes.size(), parents * mDigestSize );
+    mLevelStart.add( mLevelStart[level + 1] + parents );
+    for( size_t i = 0; i < parents; i++ ) {
+      if( 2 * i + 1 < count ) {
+        hash_node( *h, node( level, 2 * i ), node( level, 2 * i + 1 ), mDigestSize, node( level + 1, i ) );
+      } else {
+        memcpy( node( level + 1, i ), node( level, 2 * i ), mDigestSize );
+      }
+    }
+    count = parents;
+  }
+}
+
+status_t MerkleTree::build( const void* data, size_t len, const sp<ExecutorService>& executor )
+{
+  status_t err = prepare();
+  if( err != OK ) {
+    return err;
+  }
+  const size_t leaves = len == 0 ? 1 : ( len - 1 ) / mChunkSize + 1;
+  // a tree has fewer than twice as many nodes as leaves
+  mNodes.setCapacity( 2 * leaves * mDigestSize );
+  if( mNodes.insertAt( uint8_t( 0 ), 0, leaves * mDigestSize ) < 0 ) {
+    return NO_MEMORY;
+  }
+  mLength = len;
+  hashLeaves( static_cast<const uint8_t*>( data ), len, 0, executor );
+  buildLevels( leaves );
+  return OK;
+}
+
+status_t MerkleTree::build( InputStream& in, const sp<ExecutorService>& executor )
+{
+  status_t err = prepare();
+  if( err != OK ) {
+    return err;
+  }
+
+  const size_t batch = executor != nullptr ? sort_detail::parallelism( executor ) + 1 : 1;
+  Vector<uint8_t> buffer;
+  if( buffer.insertAt( uint8_t( 0 ), 0, batch * mChunkSize ) < 0 ) {
+    return NO_MEMORY;
+  }
+
+  size_t leaves = 0;
+  bool eof = false;
+  while( !eof ) {
+    size_t filled = 0;
+    while( filled < buffer.size() ) {
+      const int bytesRead = in.read( buffer.editArray(), filled, MIN( buffer.size() - filled, size_t( INT_MAX ) ) );
+      if( bytesRead == -1 ) {
+        eof = true;
+        break;
+      }
+      if( bytesRead < 0 ) {
+        // leave the tree unbuilt rather than give a root for part of in
+        mNodes.clear();
+        mLevelStart.clear();
+        mLength = 0;
+        return bytesRead;
+      }
+      filled += bytesRead;
+    }
+    if( filled == 0 && leaves > 0 ) {
+      break;
+    }
+
+    const size_t chunks = filled == 0 ? 1 : ( filled - 1 ) / mChunkSize + 1;
+    if( mNodes.insertAt( mNodes.size(), chunks * mDigestSize ) < 0 ) {
+      return NO_MEMORY;
+    }
+    hashLeaves( buffer.array(), filled, leaves, executor );
+    leaves += chunks;
+    mLength += filled;
+  }
+
+  buildLevels( leaves );
+  return OK;
+}
+
+status_t MerkleTree::update( size_t index, const void* chunk, size_t len )
+{
+  if( mLevelStart.size() < 2 ) {
+    return NO_INIT;
+  }
+  const size_t count = chunkCount();
+  if( index >= count ) {
+    return BAD_VALUE;
+  }
+  const uint64_t expected = index + 1 < count ? mChunkSize : mLength - uint64_t( index ) * mChunkSize;
+  if( len != expected ) {
+    return BAD_VALUE;
+  }
+
+  up<HashFunction> h = mFactory();
+  hash_leaf( *h, static_cast<const uint8_t*>( chunk ), len, node( 0, index ) );
+  size_t i = index;
+  for( size_t level = 0; level + 2 < mLevelStart.size(); level++ ) {
+    const size_t left = i & ~size_t( 1 );
+    if( left + 1 < levelSize( level ) ) {
+      hash_node( *h, node( level, left ), node( level, left + 1 ), mDigestSize, node( level + 1, i / 2 ) );
+    } else {
+      memcpy( node( level + 1, i / 2 ), node( level, left ), mDigestSize );
+    }
+    i /= 2;
+  }
+  return OK;
+}
+
+HashCode MerkleTree::root() const
+{
+  if( mLevelStart.size() < 2 ) {
+    return HashCode();
+  }
+  return HashCode( node( mLevelStart.size() - 2, 0 ), mDigestSize );
+}
+
+HashCode MerkleTree::leaf( size_t index ) const
+{
+  if( index >= chunkCount() ) {
+    return HashCode();
+  }
+  return HashCode( node( 0, index ), mDigestSize );
+}
+
+status_t MerkleTree::proof( size_t index, Vector<uint8_t>& siblings ) const
+{
+  if( mLevelStart.size() < 2 ) {
+    return NO_INIT;
+  }
+  if( index >= chunkCount() ) {
+    return BAD_VALUE;
+  }
+  siblings.clear();
+  size_t i = index;
+  for( size_t level = 0; level + 2 < mLevelStart.size(); level++ ) {
+    if( ( i ^ 1 ) < levelSize( level ) ) {
+      siblings.appendArray( node( level, i ^ 1 ), mDigestSize );
+    }
+    i /= 2;
+  }
+  return OK;
+}
+
+bool MerkleTree::verify( Factory factory, const HashCode& root, size_t index, size_t chunkCount,
+                         const void* chunk, size_t len, const Vector<uint8_t>& siblings )
+{
+  if( index >= chunkCount ) {
+    return false;
+  }
+  up<HashFunction> h = factory();
+  if( h.get() == nullptr ) {
+    return false;
+  }
+  const size_t size = h->finalize().size();
+  if( root.size() != size ) {
+    return false;
+  }
+  uint8_t current[HashCode::kMaxSize];
+  hash_leaf( *h, static_cast<const uint8_t*>( chunk ), len, current );
+
+  size_t used = 0;
+  for( size_t i = index, count = chunkCount; count > 1; i /= 2, count = ( count + 1 ) / 2 ) {
+    if( ( i ^ 1 ) >= count ) {
+      continue;
+    }
+    if( siblings.size() - used < size ) {
+      return false;
+    }
+    const uint8_t* sibling = siblings.array() + used;
+    used += size;
+    if( i & 1 ) {
+      hash_node( *h, sibling, current, size, current );
+    } else {
+      hash_node( *h, current, sibling, size, current );
+    }
+  }
+  return used == siblings.size() && memcmp( current, root.data(), size ) == 0;
+}
+
+} // namespace baseline
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/MirroredByteRing.h>
+
+#include <string.h>
+
+#ifdef WIN32
+  #include <windows.h>
+#else
+  #include <stdlib.h>
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  #ifndef MAP_ANONYMOUS
+    #define MAP_ANONYMOUS MAP_ANON
+  #endif
+#endif
+
+namespace baseline {
+
+#ifdef WIN32
+
+static size_t granularity()
+{
+  SYSTEM_INFO info;
+  GetSystemInfo( &info );
+  return info.dwAllocationGranularity;
+}
+
+static status_t mapMirrored( size_t capacity, uint8_t** data, void** handle )
+{
+  HANDLE mapping = CreateFileMapping( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                      DWORD( uint64_t( capacity ) >> 32 ), DWORD( capacity ), NULL );
+  if( mapping == NULL ) {
+    return NO_MEMORY;
+  }
+
+  // find a free range big enough for both views, then map into it. another
+  // thread may take the range in between, so retry a few times
+  for( int attempt = 0; attempt < 16; attempt++ ) {
+    uint8_t* base = ( uint8_t* )VirtualAlloc( NULL, 2 * capacity, MEM_RESERVE, PAGE_NOACCESS );
+    if( base == NULL ) {
+      break;
+    }
+    VirtualFree( base, 0, MEM_RELEASE );
+
+    void* first = MapViewOfFileEx( mapping, FILE_MAP_ALL_ACCESS, 0, 0, capacity, base );
+    void* second = MapViewOfFileEx( mapping, FILE_MAP_ALL_ACCESS, 0, 0, capacity, base + capacity );
+    if( first == base && second == base + capacity ) {
+      *data = base;
+      *handle = mapping;
+      return OK;
+    }
+    if( first != NULL ) {
+      UnmapViewOfFile( first );
+    }
+    if( second != NULL ) {
+      UnmapViewOfFile( second );
+    }
+  }
+  CloseHandle( mapping );
+  return NO_MEMORY;
+}
+
+static void unmapMirrored( uint8_t* data, size_t capacity, void* handle )
+{
+  UnmapViewOfFile( data );
+  UnmapViewOfFile( data + capacity );
+  CloseHandle( ( HANDLE )handle );
+}
+
+#else
+
+static size_t granularity()
+{
+  return size_t( sysconf( _SC_PAGESIZE ) );
+}
+
+static int createBackingFile()
+{
+#if defined(__linux__) && defined(SYS_memfd_create)
+  int memfd = int( syscall( SYS_memfd_create, "baseline-ring", 1 /* MFD_CLOEXEC */ ) );
+  if( memfd >= 0 ) {
+    return memfd;
+  }
+#endif
+  char path[] = "/tmp/baseline-ring-XXXXXX";
+  int fd = mkstemp( path );
+  if( fd >= 0 ) {
+    unlink( path );
+  }
+  return fd;
+}
+
+static status_t mapMirrored( size_t capacity, uint8_t** data, void** handle )
+{
+  int fd = createBackingFile();
+  if( fd < 0 ) {
+    return NO_MEMORY;
+  }
+  if( ftruncate( fd, off_t( capacity ) ) != 0 ) {
+    close( fd );
+    return NO_MEMORY;
+  }
+
+  // reserve both halves at once so nothing else can land in between, then
+  // map the file over each half
+  void* reserved = mmap( NULL, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  if( reserved == MAP_FAILED ) {
+    close( fd );
+    return NO_MEMORY;
+  }
+  uint8_t* base = ( uint8_t* )reserved;
+  void* first = mmap( base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 );
+  void* second = mmap( base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0 );
+  close( fd );
+  if( first != base || second != base + capacity ) {
+    munmap( base, 2 * capacity );
+    return NO_MEMORY;
+  }
+
+  *data = base;
+  *handle = NULL;
+  return OK;
+}
+
+static void unmapMirrored( uint8_t* data, size_t capacity, void* )
+{
+  munmap( data, 2 * capacity );
+}
+
+#endif
+
+MirroredByteRing::MirroredByteRing( size_t capacity )
+  : mData( NULL ), mCapacity( 0 ), mTail( 0 ), mSize( 0 ), mStatus( NO_INIT ), mHandle( NULL )
+{
+  const size_t unit = granularity();
+  if( capacity == 0 ) {
+    capacity = unit;
+  }
+  if( capacity > SIZE_MAX / 2 - unit ) {
+    mStatus = BAD_VALUE;
+    return;
+  }
+  capacity = ( capacity + unit - 1 ) / unit * unit;
+
+  mStatus = mapMirrored( capacity, &mData, &mHandle );
+  if( mStatus == OK ) {
+    mCapacity = capacity;
+  } else {
+    mData = NULL;
+    LOG_ERROR( "MirroredByteRing", "could not map %zu byte ring", capacity );
+  }
+}
+
+MirroredByteRing::~MirroredByteRing()
+{
+  if( mData != NULL ) {
+    unmapMirrored( mData, mCapacity, mHandle );
+  }
+}
+
+status_t MirroredByteRing::initCheck() const
+{
+  return mStatus;
+}
+
+void MirroredByteRing::consume( size_t len )
+{
+  LOG_FATAL_IF( len > mSize, "consume(%zu) past size %zu", len, mSize );
+  len = MIN( len, mSize );
+  mTail += len;
+  if( mTail >= mCapacity ) {
+    mTail -= mCapacity;
+  }
+  mSize -= len;
+}
+
+void MirroredByteRing::commit( size_t len )
+{
+  LOG_FATAL_IF( len > available(), "commit(%zu) past available %zu", len, available() );
+  mSize += MIN( len, available() );
+}
+
+size_t MirroredByteRing::write( const uint8_t* buf, size_t len )
+{
+  len = MIN( len, available() );
+  if( len > 0 ) {
+    memcpy( writePtr(), buf, len );
+    mSize += len;
+  }
+  return len;
+}
+
+size_t MirroredByteRing::read( uint8_t* buf, size_t len )
+{
+  len = MIN( len, mSize );
+  if( len > 0 ) {
+    memcpy( buf, readPtr(), len );
+    consume( len );
+  }
+  return len;
+}
+
+} // namespace baseline
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Streams.h>
+#include <baseline/SPSCRing.h>
+#include <baseline/RefBase.h>
+#include <baseline/StrongPointer.h>
+#include <baseline/Mutex.h>
+#include <baseline/Condition.h>
+
+#include <atomic>
+#include <limits.h>
+
+namespace baseline {
+
+/**
+ * State shared by both ends of a pipe. Bytes move through the ring
+ * without locking; the mutex and condition are only used by an end that
+ * has to wait, and the other end only takes the mutex to wake it when
+ * there are waiters.
+ */
+class Pipe : public LightRefBase<Pipe>
+{
+public:
+  Pipe( uint32_t capacity, bool blocking )
+    : mRing( capacity ), mBlocking( blocking ), mWriterClosed( false ), mReaderClosed( false ),
+      mWaiters( 0 ) {}
+
+  int write( const uint8_t* buf, size_t len );
+  int read( uint8_t* buf, size_t len );
+  void closeWriter();
+  void closeReader();
+
+private:
+  void wake();
+
+  // ring.full() or ring.empty(), with the flag telling whether the other
+  // side is gone for good
+  template<typename Predicate>
+  void waitWhile( Predicate blocked );
+
+  SPSCRing<uint8_t> mRing;
+  const bool mBlocking;
+  std::atomic<bool> mWriterClosed;
+  std::atomic<bool> mReaderClosed;
+  std::atomic<int> mWaiters;
+  Mutex mMutex;
+  Condition mCondition;
+};
+
+void Pipe::wake()
+{
+  // pairs with the fence in waitWhile(): either the waiter sees our ring
+  // update, or we see it counted and signal it under the mutex
+  std::atomic_thread_fence( std::memory_order_seq_cst );
+  if( mWaiters.load( std::memory_order_relaxed ) > 0 ) {
+    Mutex::Autolock lock( mMutex );
+    mCondition.signalAll();
+  }
+}
+
+template<typename Predicate>
+void Pipe::waitWhile( Predicate blocked )
+{
+  Mutex::Autolock lock( mMutex );
+  mWaiters.fetch_add( 1, std::memory_order_relaxed );
+  std::atomic_thread_fence( std::memory_order_seq_cst );
+  while( blocked() ) {
+    mCondition.wait( mMutex );
+  }
+  mWaiters.fetch_sub( 1, std::memory_order_relaxed );
+}
+
+int Pipe::write( const uint8_t* buf, size_t len )
+{
+  // the count has to come back as a non-negative int
+  len = MIN( len, size_t( INT_MAX ) );
+  size_t done = 0;
+  while( done < len ) {
+    if( mReaderClosed.load( std::memory_order_acquire ) ) {
+      return done > 0 ? int( done ) : DEAD_OBJECT;
+    }
+    const uint32_t chunk = uint32_t( MIN( len - done, size_t( mRing.capacity() ) ) );
+    const uint32_t written = mRing.write( buf + done, chunk );
+    if( written > 0 ) {
+      done += written;
+      wake();
+    } else if( !mBlocking ) {
+      break;
+    } else {
+      waitWhile( [this]() {
+        return mRing.full() && !mReaderClosed.load( std::memory_order_acquire );
+      } );
+    }
+  }
+  return done > 0 || len == 0 ? int( done ) : WOULD_BLOCK;
+}
+
+int Pipe::read( uint8_t* buf, size_t len )
+{
+  const uint32_t want = uint32_t( MIN( len, size_t( mRing.capacity() ) ) );
+  if( want == 0 ) {
+    return 0;
+  }
+  for( ;; ) {
+    uint32_t n = mRing.read( buf, want );
+    if( n == 0 && mWriterClosed.load( std::memory_order_acquire ) ) {
+      // the writer may have written its last bytes just before closing
+      n = mRing.read( buf, want );
+      if( n == 0 ) {
+        return -1;
+      }
+    }
+    if( n > 0 ) {
+      wake();
+      return int( n );
+    }
+    if( !mBlocking ) {
+      return 0;
+    }
+    waitWhile( [this]() {
+      return mRing.empty() && !mWriterClosed.load( std::memory_order_acquire );
+    } );
+  }
+}
+
+void Pipe::closeWriter()
+{
+  mWriterClosed.store( true, std::memory_order_release );
+  wake();
+}
+
+void Pipe::closeReader()
+{
+  mReaderClosed.store( true, std::memory_order_release );
+  wake();
+}
+
+class PipeOutputStream : public OutputStream
+{
+public:
+  PipeOutputStream( const sp<Pipe>& pipe ) : mPipe( pipe ) {}
+
+  ~PipeOutputStream() {
+    close();
+  }
+
+  void close() {
+    if( mPipe != nullptr ) {
+      mPipe->closeWriter();
+      mPipe.clear();
+    }
+  }
+
+  int write( uint8_t* buf, size_t off, size_t len ) {
+    if( mPipe == nullptr ) {
+      return DEAD_OBJECT;
+    }
+    return mPipe->write( &buf[off], len );
+  }
+
+private:
+  sp<Pipe> mPipe;
+};
+
+class PipeInputStream : public InputStream
+{
+public:
+  PipeInputStream( const sp<Pipe>& pipe ) : mPipe( pipe ) {}
+
+  ~PipeInputStream() {
+    close();
+  }
+
+  void close() {
+    if( mPipe != nullptr ) {
+      mPipe->closeReader();
+      mPipe.clear();
+    }
+  }
+
+  int read( uint8_t* buf, size_t off, size_t len ) {
+    if( mPipe == nullptr ) {
+      return -1;
+    }
+    return mPipe->read( &buf[off], len );
+  }
+
+private:
+  sp<Pipe> mPipe;
+};
+
+status_t createPipe( size_t capacity, UniquePtr<OutputStream>& out, UniquePtr<InputStream>& in,
+                     bool blocking )
+{
+  if( capacity == 0 ) {
+    return BAD_VALUE;
+  }
+  // read() and write() return int, so cap a single transfer at 1GB
+  capacity = MIN( capacity, size_t( 1 ) << 30 );
+
+  sp<Pipe> pipe( new Pipe( uint32_t( capacity ), blocking ) );
+  out.reset( new PipeOutputStream( pipe ) );
+  in.reset( new PipeInputStream( pipe ) );
+  return OK;
+}
+
+} // namespace baseline
@@ -0,0 +1,522 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Hash.h>
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+  #include <cpuid.h>
+  #include <immintrin.h>
+  #define HAVE_SHA_NI
+  #define SHA_NI_TARGET __attribute__(( target( "sha,sse4.1,ssse3" ) ))
+#endif
+
+namespace baseline {
+namespace sha_detail {
+
+#define SHA_BLOCKSIZE 64
+
+/**
+ * Compresses blocks consecutive 64 byte blocks from data into state.
+ */
+typedef void ( *BlockFunction )( uint32_t* state, const uint8_t* data, size_t blocks );
+
+static inline uint32_t load_be32( const uint8_t* p )
+{
+  return ( uint32_t( p[0] ) << 24 ) | ( uint32_t( p[1] ) << 16 ) | ( uint32_t( p[2] ) << 8 ) | uint32_t( p[3] );
+}
+
+static inline void store_be32( uint8_t* p, uint32_t value )
+{
+  p[0] = uint8_t( value >> 24 );
+  p[1] = uint8_t( value >> 16 );
+  p[2] = uint8_t( value >> 8 );
+  p[3] = uint8_t( value );
+}
+
+///////////// SHA1 /////////////////////
+
+/* Help macros */
+#define SHA1_ROL(value, bits) (((value) << (bits)) | (((value) & 0xffffffff) >> (32 - (bits))))
+#define SHA1_BLK(i) (block[i&15] = SHA1_ROL(block[(i+13)&15] ^ block[(i+8)&15] ^ block[(i+2)&15] ^ block[i&15],1))
+
+/* (R0+R1), R2, R3, R4 are the different operations used in SHA1 */
+#define SHA1_R0(v,w,x,y,z,i) z += ((w&(x^y))^y)     + block[i]    + 0x5a827999 + SHA1_ROL(v,5); w=SHA1_ROL(w,30);
+#define SHA1_R1(v,w,x,y,z,i) z += ((w&(x^y))^y)     + SHA1_BLK(i) + 0x5a827999 + SHA1_ROL(v,5); w=SHA1_ROL(w,30);
+#define SHA1_R2(v,w,x,y,z,i) z += (w^x^y)           + SHA1_BLK(i) + 0x6ed9eba1 + SHA1_ROL(v,5); w=SHA1_ROL(w,30);
+#define SHA1_R3(v,w,x,y,z,i) z += (((w|x)&y)|(w&x)) + SHA1_BLK(i) + 0x8f1bbcdc + SHA1_ROL(v,5); w=SHA1_ROL(w,30);
+#define SHA1_R4(v,w,x,y,z,i) z += (w^x^y)           + SHA1_BLK(i) + 0xca62c1d6 + SHA1_ROL(v,5); w=SHA1_ROL(w,30);
+
+static void sha1_blocks( uint32_t* digest, const uint8_t* data, size_t blocks )
+{
+  for( ; blocks > 0; blocks--, data += SHA_BLOCKSIZE ) {
+    /* Copy digest[] to working vars */
+    uint32_t a = digest[0];
+    uint32_t b = digest[1];
+    uint32_t c = digest[2];
+    uint32_t d = digest[3];
+    uint32_t e = digest[4];
+
+    uint32_t block[16];
+    for( int i = 0; i < 16; i++ ) {
+      block[i] = load_be32( &data[i * 4] );
+    }
+
+    /* 4 rounds of 20 operations each. Loop unrolled. */
+    SHA1_R0( a, b, c, d, e, 0 );
+    SHA1_R0( e, a, b, c, d, 1 );
+    SHA1_R0( d, e, a, b, c, 2 );
+    SHA1_R0( c, d, e, a, b, 3 );
+    SHA1_R0( b, c, d, e, a, 4 );
+    SHA1_R0( a, b, c, d, e, 5 );
+    SHA1_R0( e, a, b, c, d, 6 );
+    SHA1_R0( d, e, a, b, c, 7 );
+    SHA1_R0( c, d, e, a, b, 8 );
+    SHA1_R0( b, c, d, e, a, 9 );
+    SHA1_R0( a, b, c, d, e, 10 );
+    SHA1_R0( e, a, b, c, d, 11 );
+    SHA1_R0( d, e, a, b, c, 12 );
+    SHA1_R0( c, d, e, a, b, 13 );
+    SHA1_R0( b, c, d, e, a, 14 );
+    SHA1_R0( a, b, c, d, e, 15 );
+    SHA1_R1( e, a, b, c, d, 16 );
+    SHA1_R1( d, e, a, b, c, 17 );
+    SHA1_R1( c, d, e, a, b, 18 );
+    SHA1_R1( b, c, d, e, a, 19 );
+    SHA1_R2( a, b, c, d, e, 20 );
+    SHA1_R2( e, a, b, c, d, 21 );
+    SHA1_R2( d, e, a, b, c, 22 );
+    SHA1_R2( c, d, e, a, b, 23 );
+    SHA1_R2( b, c, d, e, a, 24 );
+    SHA1_R2( a, b, c, d, e, 25 );
+    SHA1_R2( e, a, b, c, d, 26 );
+    SHA1_R2( d, e, a, b, c, 27 );
+    SHA1_R2( c, d, e, a, b, 28 );
+    SHA1_R2( b, c, d, e, a, 29 );
+    SHA1_R2( a, b, c, d, e, 30 );
+    SHA1_R2( e, a, b, c, d, 31 );
+    SHA1_R2( d, e, a, b, c, 32 );
+    SHA1_R2( c, d, e, a, b, 33 );
+    SHA1_R2( b, c, d, e, a, 34 );
+    SHA1_R2( a, b, c, d, e, 35 );
+    SHA1_R2( e, a, b, c, d, 36 );
+    SHA1_R2( d, e, a, b, c, 37 );
+    SHA1_R2( c, d, e, a, b, 38 );
+    SHA1_R2( b, c, d, e, a, 39 );
+    SHA1_R3( a, b, c, d, e, 40 );
+    SHA1_R3( e, a, b, c, d, 41 );
+    SHA1_R3( d, e, a, b, c, 42 );
+    SHA1_R3( c, d, e, a, b, 43 );
+    SHA1_R3( b, c, d, e, a, 44 );
+    SHA1_R3( a, b, c, d, e, 45 );
+    SHA1_R3( e, a, b, c, d, 46 );
+    SHA1_R3( d, e, a, b, c, 47 );
+    SHA1_R3( c, d, e, a, b, 48 );
+    SHA1_R3( b, c, d, e, a, 49 );
+    SHA1_R3( a, b, c, d, e, 50 );
+    SHA1_R3( e, a, b, c, d, 51 );
+    SHA1_R3( d, e, a, b, c, 52 );
+    SHA1_R3( c, d, e, a, b, 53 );
+    SHA1_R3( b, c, d, e, a, 54 );
+    SHA1_R3( a, b, c, d, e, 55 );
+    SHA1_R3( e, a, b, c, d, 56 );
+    SHA1_R3( d, e, a, b, c, 57 );
+    SHA1_R3( c, d, e, a, b, 58 );
+    SHA1_R3( b, c, d, e, a, 59 );
+    SHA1_R4( a, b, c, d, e, 60 );
+    SHA1_R4( e, a, b, c, d, 61 );
+    SHA1_R4( d, e, a, b, c, 62 );
+    SHA1_R4( c, d, e, a, b, 63 );
+    SHA1_R4( b, c, d, e, a, 64 );
+    SHA1_R4( a, b, c, d, e, 65 );
+    SHA1_R4( e, a, b, c, d, 66 );
+    SHA1_R4( d, e, a, b, c, 67 );
+    SHA1_R4( c, d, e, a, b, 68 );
+    SHA1_R4( b, c, d, e, a, 69 );
+    SHA1_R4( a, b, c, d, e, 70 );
+    SHA1_R4( e, a, b, c, d, 71 );
+    SHA1_R4( d, e, a, b, c, 72 );
+    SHA1_R4( c, d, e, a, b, 73 );
+    SHA1_R4( b, c, d, e, a, 74 );
+    SHA1_R4( a, b, c, d, e, 75 );
+    SHA1_R4( e, a, b, c, d, 76 );
+    SHA1_R4( d, e, a, b, c, 77 );
+    SHA1_R4( c, d, e, a, b, 78 );
+    SHA1_R4( b, c, d, e, a, 79 );
+
+    /* Add the working vars back into digest[] */
+    digest[0] += a;
+    digest[1] += b;
+    digest[2] += c;
+    digest[3] += d;
+    digest[4] += e;
+  }
+}
+
+#if defined(HAVE_SHA_NI)
+
+/*
+ * Four rounds with the SHA extensions. The message schedule lives in
+ * msg[0..3] and is extended four words at a time, interleaved with the
+ * rounds that consume it; the two e registers alternate between holding
+ * the next rounds' input and the copy of abcd that sha1nexte derives e
+ * from. g is the group of four rounds, a constant in every expansion.
+ */
+#define SHA1_NI_ROUNDS( g ) \
+  do { \
+    __m128i& ecur = ( ( g ) & 1 ) ? e1 : e0; \
+    __m128i& enext = ( ( g ) & 1 ) ? e0 : e1; \
+    if( ( g ) < 4 ) { \
+      msg[( g ) & 3] = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* )( data + 16 * ( g ) ) ), mask ); \
+    } \
+    ecur = ( g ) == 0 ? _mm_add_epi32( ecur, msg[0] ) : _mm_sha1nexte_epu32( ecur, msg[( g ) & 3] ); \
+    enext = abcd; \
+    if( ( g ) >= 3 && ( g ) <= 18 ) { \
+      msg[( ( g ) + 1 ) & 3] = _mm_sha1msg2_epu32( msg[( ( g ) + 1 ) & 3], msg[( g ) & 3] ); \
+    } \
+    abcd = _mm_sha1rnds4_epu32( abcd, ecur, ( g ) / 5 ); \
+    if( ( g ) >= 1 && ( g ) <= 16 ) { \
+      msg[( ( g ) + 3 ) & 3] = _mm_sha1msg1_epu32( msg[( ( g ) + 3 ) & 3], msg[( g ) & 3] ); \
+    } \
+    if( ( g ) >= 2 && ( g ) <= 17 ) { \
+      msg[( ( g ) + 2 ) & 3] = _mm_xor_si128( msg[( ( g ) + 2 ) & 3], msg[( g ) & 3] ); \
+    } \
+  } while( 0 )
+
+SHA_NI_TARGET
+static void sha1_blocks_ni( uint32_t* digest, const uint8_t* data, size_t blocks )
+{
+  const __m128i mask = _mm_set_epi64x( 0x0001020304050607ull, 0x08090a0b0c0d0e0full );
+  __m128i abcd = _mm_shuffle_epi32( _mm_loadu_si128( ( const __m128i* )digest ), 0x1B );
+  __m128i e0 = _mm_set_epi32( int( digest[4] ), 0, 0, 0 );
+  __m128i e1;
+  __m128i msg[4];
+
+  for( ; blocks > 0; blocks--, data += SHA_BLOCKSIZE ) {
+    const __m128i abcdSave = abcd;
+    const __m128i eSave = e0;
+
+    SHA1_NI_ROUNDS( 0 );
+    SHA1_NI_ROUNDS( 1 );
+    SHA1_NI_ROUNDS( 2 );
+    SHA1_NI_ROUNDS( 3 );
+    SHA1_NI_ROUNDS( 4 );
+    SHA1_NI_ROUNDS( 5 );
+    SHA1_NI_ROUNDS( 6 );
+    SHA1_NI_ROUNDS( 7 );
+    SHA1_NI_ROUNDS( 8 );
+    SHA1_NI_ROUNDS( 9 );
+    SHA1_NI_ROUNDS( 10 );
+    SHA1_NI_ROUNDS( 11 );
+    SHA1_NI_ROUNDS( 12 );
+    SHA1_NI_ROUNDS( 13 );
+    SHA1_NI_ROUNDS( 14 );
+    SHA1_NI_ROUNDS( 15 );
+    SHA1_NI_ROUNDS( 16 );
+    SHA1_NI_ROUNDS( 17 );
+    SHA1_NI_ROUNDS( 18 );
+    SHA1_NI_ROUNDS( 19 );
+
+    e0 = _mm_sha1nexte_epu32( e0, eSave );
+    abcd = _mm_add_epi32( abcd, abcdSave );
+  }
+
+  _mm_storeu_si128( ( __m128i* )digest, _mm_shuffle_epi32( abcd, 0x1B ) );
+  digest[4] = uint32_t( _mm_extract_epi32( e0, 3 ) );
+}
+
+#endif // HAVE_SHA_NI
+
+///////////// SHA256 /////////////////////
+
+static const uint32_t sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define SHA256_ROR(value, bits) (((value) >> (bits)) | ((value) << (32 - (bits))))
+
+static void sha256_blocks( uint32_t* state, const uint8_t* data, size_t blocks )
+{
+  for( ; blocks > 0; blocks--, data += SHA_BLOCKSIZE ) {
+    uint32_t w[64];
+    for( int i = 0; i < 16; i++ ) {
+      w[i] = load_be32( &data[i * 4] );
+    }
+    for( int i = 16; i < 64; i++ ) {
+      const uint32_t s0 = SHA256_ROR( w[i - 15], 7 ) ^ SHA256_ROR( w[i - 15], 18 ) ^ ( w[i - 15] >> 3 );
+      const uint32_t s1 = SHA256_ROR( w[i - 2], 17 ) ^ SHA256_ROR( w[i - 2], 19 ) ^ ( w[i - 2] >> 10 );
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0];
+    uint32_t b = state[1];
+    uint32_t c = state[2];
+    uint32_t d = state[3];
+    uint32_t e = state[4];
+    uint32_t f = state[5];
+    uint32_t g = state[6];
+    uint32_t h = state[7];
+
+    for( int i = 0; i < 64; i++ ) {
+      const uint32_t s1 = SHA256_ROR( e, 6 ) ^ SHA256_ROR( e, 11 ) ^ SHA256_ROR( e, 25 );
+      const uint32_t ch = ( e & f ) ^ ( ~e & g );
+      const uint32_t t1 = h + s1 + ch + sha256_k[i] + w[i];
+      const uint32_t s0 = SHA256_ROR( a, 2 ) ^ SHA256_ROR( a, 13 ) ^ SHA256_ROR( a, 22 );
+      const uint32_t maj = ( a & b ) ^ ( a & c ) ^ ( b & c );
+      const uint32_t t2 = s0 + maj;
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+}
+
+#if defined(HAVE_SHA_NI)
+
+/*
+ * Four rounds with the SHA extensions, as two sha256rnds2. The schedule
+ * in msg[0..3] is extended alongside, the same way as for SHA1.
+ */
+#define SHA256_NI_ROUNDS( g ) \
+  do { \
+    if( ( g ) < 4 ) { \
+      msg[( g ) & 3] = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* )( data + 16 * ( g ) ) ), mask ); \
+    } \
+    __m128i wk = _mm_add_epi32( msg[( g ) & 3], _mm_loadu_si128( ( const __m128i* )&sha256_k[4 * ( g )] ) ); \
+    cdgh = _mm_sha256rnds2_epu32( cdgh, abef, wk ); \
+    if( ( g ) >= 3 && ( g ) <= 14 ) { \
+      const __m128i tmp = _mm_alignr_epi8( msg[( g ) & 3], msg[( ( g ) + 3 ) & 3], 4 ); \
+      msg[( ( g ) + 1 ) & 3] = _mm_add_epi32( msg[( ( g ) + 1 ) & 3], tmp ); \
+      msg[( ( g ) + 1 ) & 3] = _mm_sha256msg2_epu32( msg[( ( g ) + 1 ) & 3], msg[( g ) & 3] ); \
+    } \
+    wk = _mm_shuffle_epi32( wk, 0x0E ); \
+    abef = _mm_sha256rnds2_epu32( abef, cdgh, wk ); \
+    if( ( g ) >= 1 && ( g ) <= 12 ) { \
+      msg[( ( g ) + 3 ) & 3] = _mm_sha256msg1_epu32( msg[( ( g ) + 3 ) & 3], msg[( g ) & 3] ); \
+    } \
+  } while( 0 )
+
+SHA_NI_TARGET
+static void sha256_blocks_ni( uint32_t* state, const uint8_t* data, size_t blocks )
+{
+  const __m128i mask = _mm_set_epi64x( 0x0c0d0e0f08090a0bull, 0x0405060700010203ull );
+
+  // the instructions want the state as ABEF and CDGH
+  __m128i tmp = _mm_shuffle_epi32( _mm_loadu_si128( ( const __m128i* )&state[0] ), 0xB1 );
+  __m128i cdgh = _mm_shuffle_epi32( _mm_loadu_si128( ( const __m128i* )&state[4] ), 0x1B );
+  __m128i abef = _mm_alignr_epi8( tmp, cdgh, 8 );
+  cdgh = _mm_blend_epi16( cdgh, tmp, 0xF0 );
+  __m128i msg[4];
+
+  for( ; blocks > 0; blocks--, data += SHA_BLOCKSIZE ) {
+    const __m128i abefSave = abef;
+    const __m128i cdghSave = cdgh;
+
+    SHA256_NI_ROUNDS( 0 );
+    SHA256_NI_ROUNDS( 1 );
+    SHA256_NI_ROUNDS( 2 );
+    SHA256_NI_ROUNDS( 3 );
+    SHA256_NI_ROUNDS( 4 );
+    SHA256_NI_ROUNDS( 5 );
+    SHA256_NI_ROUNDS( 6 );
+    SHA256_NI_ROUNDS( 7 );
+    SHA256_NI_ROUNDS( 8 );
+    SHA256_NI_ROUNDS( 9 );
+    SHA256_NI_ROUNDS( 10 );
+    SHA256_NI_ROUNDS( 11 );
+    SHA256_NI_ROUNDS( 12 );
+    SHA256_NI_ROUNDS( 13 );
+    SHA256_NI_ROUNDS( 14 );
+    SHA256_NI_ROUNDS( 15 );
+
+    abef = _mm_add_epi32( abef, abefSave );
+    cdgh = _mm_add_epi32( cdgh, cdghSave );
+  }
+
+  tmp = _mm_shuffle_epi32( abef, 0x1B );
+  cdgh = _mm_shuffle_epi32( cdgh, 0xB1 );
+  _mm_storeu_si128( ( __m128i* )&state[0], _mm_blend_epi16( tmp, cdgh, 0xF0 ) );
+  _mm_storeu_si128( ( __m128i* )&state[4], _mm_alignr_epi8( cdgh, tmp, 8 ) );
+}
+
+#endif // HAVE_SHA_NI
+
+struct Kernels {
+  BlockFunction sha1;
+  BlockFunction sha256;
+};
+
+static Kernels select_kernels()
+{
+  Kernels k;
+  k.sha1 = sha1_blocks;
+  k.sha256 = sha256_blocks;
+#if defined(HAVE_SHA_NI)
+  // __builtin_cpu_supports() does not know about SHA on older compilers
+  unsigned int eax, ebx, ecx, edx;
+  bool sse41 = false;
+  bool sha = false;
+  if( __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) ) {
+    sse41 = ( ecx & bit_SSE4_1 ) != 0 && ( ecx & bit_SSSE3 ) != 0;
+  }
+  if( __get_cpuid_max( 0, NULL ) >= 7 ) {
+    __cpuid_count( 7, 0, eax, ebx, ecx, edx );
+    sha = ( ebx & ( 1u << 29 ) ) != 0;
+  }
+  if( sse41 && sha ) {
+    k.sha1 = sha1_blocks_ni;
+    k.sha256 = sha256_blocks_ni;
+  }
+#endif
+  return k;
+}
+
+static const Kernels& kernels()
+{
+  static const Kernels k = select_kernels();
+  return k;
+}
+
+/**
+ * The Merkle-Damgard part shared by SHA1 and SHA256: whole blocks go
+ * straight from the caller's buffer to the compression function, only a
+ * partial block is buffered.
+ */
+class SHA : public HashFunction
+{
+public:
+  SHA( BlockFunction blocks, const uint32_t* init, int words );
+
+  void update( void* buf, size_t len ) override;
+  size_t finalizeInto( void* out ) override;
+  void reset() override;
+
+private:
+  const BlockFunction mBlocks;
+  const uint32_t* mInit;
+  const int mWords;
+  uint32_t mState[8];
+  uint8_t mBuffer[SHA_BLOCKSIZE];
+  size_t mBuffered;
+  uint64_t mLength;
+};
+
+SHA::SHA( BlockFunction blocks, const uint32_t* init, int words )
+  : mBlocks( blocks ), mInit( init ), mWords( words )
+{
+  reset();
+}
+
+void SHA::reset()
+{
+  memcpy( mState, mInit, mWords * sizeof( uint32_t ) );
+  mBuffered = 0;
+  mLength = 0;
+}
+
+void SHA::update( void* buf, size_t len )
+{
+  const uint8_t* input = reinterpret_cast<const uint8_t*>( buf );
+  mLength += len;
+
+  if( mBuffered > 0 ) {
+    const size_t n = MIN( len, SHA_BLOCKSIZE - mBuffered );
+    memcpy( &mBuffer[mBuffered], input, n );
+    mBuffered += n;
+    input += n;
+    len -= n;
+    if( mBuffered < SHA_BLOCKSIZE ) {
+      return;
+    }
+    mBlocks( mState, mBuffer, 1 );
+    mBuffered = 0;
+  }
+
+  const size_t blocks = len / SHA_BLOCKSIZE;
+  if( blocks > 0 ) {
+    mBlocks( mState, input, blocks );
+    input += blocks * SHA_BLOCKSIZE;
+    len -= blocks * SHA_BLOCKSIZE;
+  }
+
+  memcpy( mBuffer, input, len );
+  mBuffered = len;
+}
+
+size_t SHA::finalizeInto( void* out )
+{
+  //hashed text ends with 0x80, some padding 0x00 and the lenth in bits
+  uint8_t padding[2 * SHA_BLOCKSIZE];
+  memcpy( padding, mBuffer, mBuffered );
+  size_t size = mBuffered;
+  padding[size++] = 0x80;
+  const size_t end = size <= SHA_BLOCKSIZE - 8 ? SHA_BLOCKSIZE : 2 * SHA_BLOCKSIZE;
+  memset( &padding[size], 0, end - 8 - size );
+  const uint64_t bits = mLength * 8;
+  store_be32( &padding[end - 8], uint32_t( bits >> 32 ) );
+  store_be32( &padding[end - 4], uint32_t( bits ) );
+  mBlocks( mState, padding, end / SHA_BLOCKSIZE );
+
+  uint8_t* values = static_cast<uint8_t*>( out );
+  for( int i = 0; i < mWords; i++ ) {
+    store_be32( &values[i * 4], mState[i] );
+  }
+  return mWords * 4;
+}
+
+static const uint32_t sha1_init[5] = {
+  0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+static const uint32_t sha256_init[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+} // namespace sha_detail
+
+up<HashFunction> createSHA1()
+{
+  return up<HashFunction>( new sha_detail::SHA( sha_detail::kernels().sha1, sha_detail::sha1_init, 5 ) );
+}
+
+up<HashFunction> createSHA256()
+{
+  return up<HashFunction>( new sha_detail::SHA( sha_detail::kernels().sha256, sha_detail::sha256_init, 8 ) );
+}
+
+} // namespace baseline
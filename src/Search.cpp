@@ -0,0 +1,579 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/Search.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define HAVE_SSE2_SEARCH
+#endif
+
+#if defined(HAVE_SSE2_SEARCH) && defined(__GNUC__)
+  #include <immintrin.h>
+  #define HAVE_AVX2_SEARCH
+  #define AVX2_TARGET __attribute__(( target( "avx2" ) ))
+#endif
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+namespace baseline {
+namespace search_detail {
+
+// binary search narrows down to this many bytes, which are then counted
+static const size_t kWindowBytes = 128;
+
+static inline size_t bit_count( uint32_t mask )
+{
+#if defined(__GNUC__)
+  return __builtin_popcount( mask );
+#else
+  size_t count = 0;
+  for( ; mask; mask &= mask - 1 ) {
+    count++;
+  }
+  return count;
+#endif
+}
+
+static inline size_t lowest_bit( uint32_t mask )
+{
+#if defined(__GNUC__)
+  return __builtin_ctz( mask );
+#elif defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward( &index, mask );
+  return index;
+#else
+  size_t index = 0;
+  while( !( mask & 1 ) ) {
+    mask >>= 1;
+    index++;
+  }
+  return index;
+#endif
+}
+
+static inline void prefetch( const void* p )
+{
+#if defined(__GNUC__)
+  __builtin_prefetch( p );
+#elif defined(HAVE_SSE2_SEARCH)
+  _mm_prefetch( static_cast<const char*>( p ), _MM_HINT_T0 );
+#endif
+}
+
+// Signed<U>::type orders the biased lanes
+template<typename U> struct Signed;
+template<> struct Signed<uint32_t> {
+  typedef int32_t type;
+};
+template<> struct Signed<uint64_t> {
+  typedef int64_t type;
+};
+
+template<typename U> static inline
+bool less( U lhs, U rhs, U bias )
+{
+  typedef typename Signed<U>::type S;
+  return S( lhs ^ bias ) < S( rhs ^ bias );
+}
+
+// ---------------------------------------------------------------------------
+// portable versions, and the tails of the SIMD ones
+
+template<typename U> static
+size_t find_scalar( const U* a, size_t n, U value )
+{
+  for( size_t i = 0; i < n; i++ ) {
+    if( a[i] == value ) {
+      return i;
+    }
+  }
+  return n;
+}
+
+template<typename U> static
+size_t count_scalar( const U* a, size_t n, U value )
+{
+  size_t count = 0;
+  for( size_t i = 0; i < n; i++ ) {
+    count += a[i] == value;
+  }
+  return count;
+}
+
+template<typename U> static
+size_t count_less_scalar( const U* a, size_t n, U value, U bias )
+{
+  size_t count = 0;
+  for( size_t i = 0; i < n; i++ ) {
+    count += less( a[i], value, bias );
+  }
+  return count;
+}
+
+template<typename U> static
+U min_scalar( const U* a, size_t n, U bias )
+{
+  U m = a[0];
+  for( size_t i = 1; i < n; i++ ) {
+    m = less( a[i], m, bias ) ? a[i] : m;
+  }
+  return m;
+}
+
+template<typename U> static
+U max_scalar( const U* a, size_t n, U bias )
+{
+  U m = a[0];
+  for( size_t i = 1; i < n; i++ ) {
+    m = less( m, a[i], bias ) ? a[i] : m;
+  }
+  return m;
+}
+
+// ---------------------------------------------------------------------------
+// SSE2. there are no 64 bit ordered compares before SSE4.2, so those stay
+// scalar.
+
+#if defined(HAVE_SSE2_SEARCH)
+
+static size_t find32_sse2( const uint32_t* a, size_t n, uint32_t value )
+{
+  const __m128i k = _mm_set1_epi32( int32_t( value ) );
+  size_t i = 0;
+  for( ; i + 8 <= n; i += 8 ) {
+    const __m128i x0 = _mm_cmpeq_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) ), k );
+    const __m128i x1 = _mm_cmpeq_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i + 4 ) ), k );
+    const uint32_t mask = _mm_movemask_ps( _mm_castsi128_ps( x0 ) ) | ( _mm_movemask_ps( _mm_castsi128_ps( x1 ) ) << 4 );
+    if( mask ) {
+      return i + lowest_bit( mask );
+    }
+  }
+  return i + find_scalar( a + i, n - i, value );
+}
+
+static inline __m128i cmpeq64_sse2( __m128i x, __m128i k )
+{
+  const __m128i eq = _mm_cmpeq_epi32( x, k );
+  return _mm_and_si128( eq, _mm_shuffle_epi32( eq, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+}
+
+static size_t find64_sse2( const uint64_t* a, size_t n, uint64_t value )
+{
+  const __m128i k = _mm_set1_epi64x( int64_t( value ) );
+  size_t i = 0;
+  for( ; i + 4 <= n; i += 4 ) {
+    const __m128i x0 = cmpeq64_sse2( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) ), k );
+    const __m128i x1 = cmpeq64_sse2( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i + 2 ) ), k );
+    const uint32_t mask = _mm_movemask_pd( _mm_castsi128_pd( x0 ) ) | ( _mm_movemask_pd( _mm_castsi128_pd( x1 ) ) << 2 );
+    if( mask ) {
+      return i + lowest_bit( mask );
+    }
+  }
+  return i + find_scalar( a + i, n - i, value );
+}
+
+static size_t count32_sse2( const uint32_t* a, size_t n, uint32_t value )
+{
+  const __m128i k = _mm_set1_epi32( int32_t( value ) );
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+  size_t count = 0;
+  while( i + 4 <= n ) {
+    // the lanes count down from 0, flush them before they can overflow
+    const size_t end = MIN( n & ~size_t( 3 ), i + 4 * size_t( 0x7fffffff ) );
+    for( ; i < end; i += 4 ) {
+      acc = _mm_add_epi32( acc, _mm_cmpeq_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) ), k ) );
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( lanes ), acc );
+    count -= int64_t( lanes[0] ) + lanes[1] + lanes[2] + lanes[3];
+    acc = _mm_setzero_si128();
+  }
+  return count + count_scalar( a + i, n - i, value );
+}
+
+static size_t count64_sse2( const uint64_t* a, size_t n, uint64_t value )
+{
+  const __m128i k = _mm_set1_epi64x( int64_t( value ) );
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+  for( ; i + 2 <= n; i += 2 ) {
+    acc = _mm_add_epi64( acc, _mm_srli_epi64( cmpeq64_sse2( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) ), k ), 63 ) );
+  }
+  int64_t lanes[2];
+  _mm_storeu_si128( reinterpret_cast<__m128i*>( lanes ), acc );
+  return size_t( lanes[0] + lanes[1] ) + count_scalar( a + i, n - i, value );
+}
+
+static size_t count_less32_sse2( const uint32_t* a, size_t n, uint32_t value, uint32_t bias )
+{
+  const __m128i b = _mm_set1_epi32( int32_t( bias ) );
+  const __m128i k = _mm_set1_epi32( int32_t( value ^ bias ) );
+  size_t count = 0;
+  size_t i = 0;
+  for( ; i + 4 <= n; i += 4 ) {
+    const __m128i x = _mm_xor_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) ), b );
+    count += bit_count( _mm_movemask_ps( _mm_castsi128_ps( _mm_cmplt_epi32( x, k ) ) ) );
+  }
+  return count + count_less_scalar( a + i, n - i, value, bias );
+}
+
+static uint32_t min32_sse2( const uint32_t* a, size_t n, uint32_t bias )
+{
+  if( n < 4 ) {
+    return min_scalar( a, n, bias );
+  }
+  const __m128i b = _mm_set1_epi32( int32_t( bias ) );
+  __m128i m = _mm_xor_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a ) ), b );
+  size_t i = 4;
+  for( ; i + 4 <= n; i += 4 ) {
+    const __m128i x = _mm_xor_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) ), b );
+    const __m128i lt = _mm_cmplt_epi32( x, m );
+    m = _mm_or_si128( _mm_and_si128( lt, x ), _mm_andnot_si128( lt, m ) );
+  }
+  uint32_t lanes[5];
+  _mm_storeu_si128( reinterpret_cast<__m128i*>( lanes ), _mm_xor_si128( m, b ) );
+  lanes[4] = i < n ? min_scalar( a + i, n - i, bias ) : lanes[0];
+  return min_scalar( lanes, 5, bias );
+}
+
+static uint32_t max32_sse2( const uint32_t* a, size_t n, uint32_t bias )
+{
+  if( n < 4 ) {
+    return max_scalar( a, n, bias );
+  }
+  const __m128i b = _mm_set1_epi32( int32_t( bias ) );
+  __m128i m = _mm_xor_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a ) ), b );
+  size_t i = 4;
+  for( ; i + 4 <= n; i += 4 ) {
+    const __m128i x = _mm_xor_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) ), b );
+    const __m128i gt = _mm_cmpgt_epi32( x, m );
+    m = _mm_or_si128( _mm_and_si128( gt, x ), _mm_andnot_si128( gt, m ) );
+  }
+  uint32_t lanes[5];
+  _mm_storeu_si128( reinterpret_cast<__m128i*>( lanes ), _mm_xor_si128( m, b ) );
+  lanes[4] = i < n ? max_scalar( a + i, n - i, bias ) : lanes[0];
+  return max_scalar( lanes, 5, bias );
+}
+
+#endif // HAVE_SSE2_SEARCH
+
+// ---------------------------------------------------------------------------
+// AVX2, only called when the CPU has it
+
+#if defined(HAVE_AVX2_SEARCH)
+
+AVX2_TARGET static size_t find32_avx2( const uint32_t* a, size_t n, uint32_t value )
+{
+  const __m256i k = _mm256_set1_epi32( int32_t( value ) );
+  size_t i = 0;
+  for( ; i + 16 <= n; i += 16 ) {
+    const __m256i x0 = _mm256_cmpeq_epi32( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) ), k );
+    const __m256i x1 = _mm256_cmpeq_epi32( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i + 8 ) ), k );
+    const uint32_t mask = _mm256_movemask_ps( _mm256_castsi256_ps( x0 ) ) | ( _mm256_movemask_ps( _mm256_castsi256_ps( x1 ) ) << 8 );
+    if( mask ) {
+      return i + lowest_bit( mask );
+    }
+  }
+  return i + find_scalar( a + i, n - i, value );
+}
+
+AVX2_TARGET static size_t find64_avx2( const uint64_t* a, size_t n, uint64_t value )
+{
+  const __m256i k = _mm256_set1_epi64x( int64_t( value ) );
+  size_t i = 0;
+  for( ; i + 8 <= n; i += 8 ) {
+    const __m256i x0 = _mm256_cmpeq_epi64( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) ), k );
+    const __m256i x1 = _mm256_cmpeq_epi64( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i + 4 ) ), k );
+    const uint32_t mask = _mm256_movemask_pd( _mm256_castsi256_pd( x0 ) ) | ( _mm256_movemask_pd( _mm256_castsi256_pd( x1 ) ) << 4 );
+    if( mask ) {
+      return i + lowest_bit( mask );
+    }
+  }
+  return i + find_scalar( a + i, n - i, value );
+}
+
+AVX2_TARGET static size_t count32_avx2( const uint32_t* a, size_t n, uint32_t value )
+{
+  const __m256i k = _mm256_set1_epi32( int32_t( value ) );
+  size_t i = 0;
+  size_t count = 0;
+  while( i + 8 <= n ) {
+    // the lanes count down from 0, flush them before they can overflow
+    __m256i acc = _mm256_setzero_si256();
+    const size_t end = MIN( n & ~size_t( 7 ), i + 8 * size_t( 0x7fffffff ) );
+    for( ; i < end; i += 8 ) {
+      acc = _mm256_add_epi32( acc, _mm256_cmpeq_epi32( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) ), k ) );
+    }
+    int32_t lanes[8];
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes ), acc );
+    for( int j = 0; j < 8; j++ ) {
+      count -= int64_t( lanes[j] );
+    }
+  }
+  return count + count_scalar( a + i, n - i, value );
+}
+
+AVX2_TARGET static size_t count64_avx2( const uint64_t* a, size_t n, uint64_t value )
+{
+  const __m256i k = _mm256_set1_epi64x( int64_t( value ) );
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+  for( ; i + 4 <= n; i += 4 ) {
+    acc = _mm256_sub_epi64( acc, _mm256_cmpeq_epi64( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) ), k ) );
+  }
+  int64_t lanes[4];
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes ), acc );
+  return size_t( lanes[0] + lanes[1] + lanes[2] + lanes[3] ) + count_scalar( a + i, n - i, value );
+}
+
+AVX2_TARGET static size_t count_less32_avx2( const uint32_t* a, size_t n, uint32_t value, uint32_t bias )
+{
+  const __m256i b = _mm256_set1_epi32( int32_t( bias ) );
+  const __m256i k = _mm256_set1_epi32( int32_t( value ^ bias ) );
+  size_t count = 0;
+  size_t i = 0;
+  for( ; i + 8 <= n; i += 8 ) {
+    const __m256i x = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) ), b );
+    count += bit_count( _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpgt_epi32( k, x ) ) ) );
+  }
+  return count + count_less_scalar( a + i, n - i, value, bias );
+}
+
+AVX2_TARGET static size_t count_less64_avx2( const uint64_t* a, size_t n, uint64_t value, uint64_t bias )
+{
+  const __m256i b = _mm256_set1_epi64x( int64_t( bias ) );
+  const __m256i k = _mm256_set1_epi64x( int64_t( value ^ bias ) );
+  size_t count = 0;
+  size_t i = 0;
+  for( ; i + 4 <= n; i += 4 ) {
+    const __m256i x = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) ), b );
+    count += bit_count( _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_cmpgt_epi64( k, x ) ) ) );
+  }
+  return count + count_less_scalar( a + i, n - i, value, bias );
+}
+
+AVX2_TARGET static uint32_t min32_avx2( const uint32_t* a, size_t n, uint32_t bias )
+{
+  if( n < 8 ) {
+    return min_scalar( a, n, bias );
+  }
+  const __m256i b = _mm256_set1_epi32( int32_t( bias ) );
+  __m256i m = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a ) ), b );
+  size_t i = 8;
+  for( ; i + 8 <= n; i += 8 ) {
+    m = _mm256_min_epi32( m, _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) ), b ) );
+  }
+  uint32_t lanes[9];
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes ), _mm256_xor_si256( m, b ) );
+  lanes[8] = i < n ? min_scalar( a + i, n - i, bias ) : lanes[0];
+  return min_scalar( lanes, 9, bias );
+}
+
+AVX2_TARGET static uint32_t max32_avx2( const uint32_t* a, size_t n, uint32_t bias )
+{
+  if( n < 8 ) {
+    return max_scalar( a, n, bias );
+  }
+  const __m256i b = _mm256_set1_epi32( int32_t( bias ) );
+  __m256i m = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a ) ), b );
+  size_t i = 8;
+  for( ; i + 8 <= n; i += 8 ) {
+    m = _mm256_max_epi32( m, _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) ), b ) );
+  }
+  uint32_t lanes[9];
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes ), _mm256_xor_si256( m, b ) );
+  lanes[8] = i < n ? max_scalar( a + i, n - i, bias ) : lanes[0];
+  return max_scalar( lanes, 9, bias );
+}
+
+AVX2_TARGET static uint64_t min64_avx2( const uint64_t* a, size_t n, uint64_t bias )
+{
+  if( n < 4 ) {
+    return min_scalar( a, n, bias );
+  }
+  const __m256i b = _mm256_set1_epi64x( int64_t( bias ) );
+  __m256i m = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a ) ), b );
+  size_t i = 4;
+  for( ; i + 4 <= n; i += 4 ) {
+    const __m256i x = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) ), b );
+    m = _mm256_blendv_epi8( m, x, _mm256_cmpgt_epi64( m, x ) );
+  }
+  uint64_t lanes[5];
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes ), _mm256_xor_si256( m, b ) );
+  lanes[4] = i < n ? min_scalar( a + i, n - i, bias ) : lanes[0];
+  return min_scalar( lanes, 5, bias );
+}
+
+AVX2_TARGET static uint64_t max64_avx2( const uint64_t* a, size_t n, uint64_t bias )
+{
+  if( n < 4 ) {
+    return max_scalar( a, n, bias );
+  }
+  const __m256i b = _mm256_set1_epi64x( int64_t( bias ) );
+  __m256i m = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a ) ), b );
+  size_t i = 4;
+  for( ; i + 4 <= n; i += 4 ) {
+    const __m256i x = _mm256_xor_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( a + i ) ), b );
+    m = _mm256_blendv_epi8( m, x, _mm256_cmpgt_epi64( x, m ) );
+  }
+  uint64_t lanes[5];
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes ), _mm256_xor_si256( m, b ) );
+  lanes[4] = i < n ? max_scalar( a + i, n - i, bias ) : lanes[0];
+  return max_scalar( lanes, 5, bias );
+}
+
+#endif // HAVE_AVX2_SEARCH
+
+// ---------------------------------------------------------------------------
+// dispatch
+
+struct Kernels {
+  size_t ( *find32 )( const uint32_t* a, size_t n, uint32_t value );
+  size_t ( *find64 )( const uint64_t* a, size_t n, uint64_t value );
+  size_t ( *count32 )( const uint32_t* a, size_t n, uint32_t value );
+  size_t ( *count64 )( const uint64_t* a, size_t n, uint64_t value );
+  size_t ( *countLess32 )( const uint32_t* a, size_t n, uint32_t value, uint32_t bias );
+  size_t ( *countLess64 )( const uint64_t* a, size_t n, uint64_t value, uint64_t bias );
+  uint32_t ( *min32 )( const uint32_t* a, size_t n, uint32_t bias );
+  uint64_t ( *min64 )( const uint64_t* a, size_t n, uint64_t bias );
+  uint32_t ( *max32 )( const uint32_t* a, size_t n, uint32_t bias );
+  uint64_t ( *max64 )( const uint64_t* a, size_t n, uint64_t bias );
+};
+
+static Kernels select_kernels()
+{
+  Kernels k;
+  k.find32 = find_scalar<uint32_t>;
+  k.find64 = find_scalar<uint64_t>;
+  k.count32 = count_scalar<uint32_t>;
+  k.count64 = count_scalar<uint64_t>;
+  k.countLess32 = count_less_scalar<uint32_t>;
+  k.countLess64 = count_less_scalar<uint64_t>;
+  k.min32 = min_scalar<uint32_t>;
+  k.min64 = min_scalar<uint64_t>;
+  k.max32 = max_scalar<uint32_t>;
+  k.max64 = max_scalar<uint64_t>;
+#if defined(HAVE_SSE2_SEARCH)
+  k.find32 = find32_sse2;
+  k.find64 = find64_sse2;
+  k.count32 = count32_sse2;
+  k.count64 = count64_sse2;
+  k.countLess32 = count_less32_sse2;
+  k.min32 = min32_sse2;
+  k.max32 = max32_sse2;
+#endif
+#if defined(HAVE_AVX2_SEARCH)
+  if( __builtin_cpu_supports( "avx2" ) ) {
+    k.find32 = find32_avx2;
+    k.find64 = find64_avx2;
+    k.count32 = count32_avx2;
+    k.count64 = count64_avx2;
+    k.countLess32 = count_less32_avx2;
+    k.countLess64 = count_less64_avx2;
+    k.min32 = min32_avx2;
+    k.min64 = min64_avx2;
+    k.max32 = max32_avx2;
+    k.max64 = max64_avx2;
+  }
+#endif
+  return k;
+}
+
+static const Kernels& kernels()
+{
+  static const Kernels k = select_kernels();
+  return k;
+}
+
+template<typename U> static inline
+size_t lower_bound( const U* a, size_t n, U value, U bias, size_t ( *countLess )( const U*, size_t, U, U ) )
+{
+  // the answer stays within [base, base + n]
+  const U* base = a;
+  const size_t window = kWindowBytes / sizeof( U );
+  while( n > window ) {
+    const size_t half = n / 2;
+    prefetch( base + half / 2 );
+    prefetch( base + half + half / 2 );
+    base = less( base[half], value, bias ) ? base + half : base;
+    n -= half;
+  }
+  return ( base - a ) + countLess( base, n, value, bias );
+}
+
+size_t find32( const uint32_t* a, size_t n, uint32_t value )
+{
+  return kernels().find32( a, n, value );
+}
+
+size_t find64( const uint64_t* a, size_t n, uint64_t value )
+{
+  return kernels().find64( a, n, value );
+}
+
+size_t count32( const uint32_t* a, size_t n, uint32_t value )
+{
+  return kernels().count32( a, n, value );
+}
+
+size_t count64( const uint64_t* a, size_t n, uint64_t value )
+{
+  return kernels().count64( a, n, value );
+}
+
+size_t lower_bound32( const uint32_t* a, size_t n, uint32_t value, uint32_t bias )
+{
+  return lower_bound( a, n, value, bias, kernels().countLess32 );
+}
+
+size_t lower_bound64( const uint64_t* a, size_t n, uint64_t value, uint64_t bias )
+{
+  return lower_bound( a, n, value, bias, kernels().countLess64 );
+}
+
+size_t min32( const uint32_t* a, size_t n, uint32_t bias )
+{
+  const Kernels& k = kernels();
+  return k.find32( a, n, k.min32( a, n, bias ) );
+}
+
+size_t min64( const uint64_t* a, size_t n, uint64_t bias )
+{
+  const Kernels& k = kernels();
+  return k.find64( a, n, k.min64( a, n, bias ) );
+}
+
+size_t max32( const uint32_t* a, size_t n, uint32_t bias )
+{
+  const Kernels& k = kernels();
+  return k.find32( a, n, k.max32( a, n, bias ) );
+}
+
+size_t max64( const uint64_t* a, size_t n, uint64_t bias )
+{
+  const Kernels& k = kernels();
+  return k.find64( a, n, k.max64( a, n, bias ) );
+}
+
+} // namespace search_detail
+} // namespace baseline
@@ -20,25 +20,108 @@
 #include <baseline/Atomic.h>
 #include <baseline/SharedBuffer.h>
 
+#include <atomic>
+
+#if defined(__linux__)
+  #include <sys/mman.h>
+  #include <unistd.h>
+  #define HAVE_MAPPED_BUFFERS
+#endif
+
 namespace baseline {
 
+static std::atomic<size_t> gMapThreshold( SharedBuffer::kDefaultMapThreshold );
+
+void SharedBuffer::setMapThreshold( size_t size )
+{
+  gMapThreshold.store( size, std::memory_order_relaxed );
+}
+
+size_t SharedBuffer::mapThreshold()
+{
+  return gMapThreshold.load( std::memory_order_relaxed );
+}
+
+static size_t page_size()
+{
+#ifdef HAVE_MAPPED_BUFFERS
+  static const size_t pageSize = sysconf( _SC_PAGESIZE );
+  return pageSize;
+#else
+  return 4096;
+#endif
+}
+
+// the header plus size, rounded up to a page, must not wrap around
+static inline bool size_fits( size_t size )
+{
+  return size <= SIZE_MAX - sizeof( SharedBuffer ) - page_size();
+}
+
+#ifdef HAVE_MAPPED_BUFFERS
+
+static size_t mapped_length( size_t size )
+{
+  const size_t pageSize = page_size();
+  return ( size + pageSize - 1 ) & ~( pageSize - 1 );
+}
+
+static void* map_storage( size_t length )
+{
+  void* addr = mmap( NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  if( addr == MAP_FAILED ) {
+    return NULL;
+  }
+#ifdef MADV_HUGEPAGE
+  madvise( addr, length, MADV_HUGEPAGE );
+#endif
+  return addr;
+}
+
+#endif // HAVE_MAPPED_BUFFERS
+
 SharedBuffer* SharedBuffer::alloc( size_t size )
 {
-  SharedBuffer* sb = static_cast<SharedBuffer*>( malloc( sizeof( SharedBuffer ) + size ) );
+  if( !size_fits( size ) ) {
+    return NULL;
+  }
+  SharedBuffer* sb = NULL;
+  uint32_t flags = 0;
+#ifdef HAVE_MAPPED_BUFFERS
+  if( size >= mapThreshold() ) {
+    sb = static_cast<SharedBuffer*>( map_storage( mapped_length( sizeof( SharedBuffer ) + size ) ) );
+    flags = eMapped;
+  }
+#endif
+  if( sb == NULL ) {
+    sb = static_cast<SharedBuffer*>( malloc( sizeof( SharedBuffer ) + size ) );
+    flags = 0;
+  }
   if( sb ) {
     sb->mRefs = 1;
     sb->mSize = size;
+    sb->mFlags = flags;
   }
   return sb;
 }
 
+void SharedBuffer::free_storage( SharedBuffer* buf )
+{
+#ifdef HAVE_MAPPED_BUFFERS
+  if( buf->isMapped() ) {
+    munmap( buf, mapped_length( sizeof( SharedBuffer ) + buf->mSize ) );
+    return;
+  }
+#endif
+  free( buf );
+}
 
 int SharedBuffer::dealloc( const SharedBuffer* released )
 {
   if( released->mRefs != 0 ) {
     return -1;  // XXX: invalid operation
   }
-  free( const_cast<SharedBuffer*>( released ) );
+  free_storage( const_cast<SharedBuffer*>( released ) );
   return 0;
 }
 
@@ -57,15 +140,44 @@ SharedBuffer* SharedBuffer::edit() const
 
 SharedBuffer* SharedBuffer::editResize( size_t newSize ) const
 {
+  if( !size_fits( newSize ) ) {
+    return NULL;
+  }
   if( onlyOwner() ) {
     SharedBuffer* buf = const_cast<SharedBuffer*>( this );
     if( buf->mSize == newSize ) {
       return buf;
     }
-    buf = ( SharedBuffer* )realloc( buf, sizeof( SharedBuffer ) + newSize );
-    if( buf != NULL ) {
-      buf->mSize = newSize;
-      return buf;
+#ifdef HAVE_MAPPED_BUFFERS
+    if( buf->isMapped() ) {
+      // let the kernel move the page tables instead of copying the data
+      const size_t oldLength = mapped_length( sizeof( SharedBuffer ) + buf->mSize );
+      const size_t newLength = mapped_length( sizeof( SharedBuffer ) + newSize );
+      void* addr = buf;
+      if( oldLength != newLength ) {
+        addr = mremap( buf, oldLength, newLength, MREMAP_MAYMOVE );
+      }
+      if( addr != MAP_FAILED ) {
+        buf = static_cast<SharedBuffer*>( addr );
+        buf->mSize = newSize;
+        return buf;
+      }
+    } else if( newSize >= mapThreshold() ) {
+      // crossing the threshold, move the data over to a mapping once
+      SharedBuffer* sb = alloc( newSize );
+      if( sb ) {
+        memcpy( sb->data(), data(), MIN( newSize, mSize ) );
+        free( buf );
+        return sb;
+      }
+    } else
+#endif
+    {
+      buf = ( SharedBuffer* )realloc( buf, sizeof( SharedBuffer ) + newSize );
+      if( buf != NULL ) {
+        buf->mSize = newSize;
+        return buf;
+      }
     }
   }
   SharedBuffer* sb = alloc( newSize );
@@ -106,7 +218,7 @@ int32_t SharedBuffer::release( uint32_t flags ) const
   if( onlyOwner() || ( ( prev = atomic_dec( &mRefs ) ) == 1 ) ) {
     mRefs = 0;
     if( ( flags & eKeepStorage ) == 0 ) {
-      free( const_cast<SharedBuffer*>( this ) );
+      free_storage( const_cast<SharedBuffer*>( this ) );
     }
   }
   return prev;
@@ -19,6 +19,8 @@
 #include <baseline/Log.h>
 #include <baseline/Streams.h>
 #include <baseline/SharedBuffer.h>
+#include <baseline/BaseEncoding.h>
+#include <baseline/Hash.h>
 
 namespace baseline {
 
@@ -126,6 +128,193 @@ int ByteArrayInputStream::read( uint8_t* buf, size_t off, size_t len )
   }
 }
 
+/////////////// HashingInputStream //////////////////////
+
+HashingInputStream::HashingInputStream( InputStream& in, HashFunction& hash )
+  : mIn( in ), mCount( 0 )
+{
+  mHashes.add( &hash );
+}
+
+void HashingInputStream::addHash( HashFunction& hash )
+{
+  mHashes.add( &hash );
+}
+
+void HashingInputStream::close()
+{
+  mIn.close();
+}
+
+int HashingInputStream::read( uint8_t* buf, size_t off, size_t len )
+{
+  const int bytesRead = mIn.read( buf, off, len );
+  if( bytesRead > 0 ) {
+    for( size_t i = 0; i < mHashes.size(); i++ ) {
+      mHashes[i]->update( &buf[off], bytesRead );
+    }
+    mCount += bytesRead;
+  }
+  return bytesRead;
+}
+
+/////////////// HashingOutputStream //////////////////////
+
+HashingOutputStream::HashingOutputStream( OutputStream& out, HashFunction& hash )
+  : mOut( out ), mCount( 0 )
+{
+  mHashes.add( &hash );
+}
+
+void HashingOutputStream::addHash( HashFunction& hash )
+{
+  mHashes.add( &hash );
+}
+
+void HashingOutputStream::close()
+{
+  mOut.close();
+}
+
+int HashingOutputStream::write( uint8_t* buf, size_t off, size_t len )
+{
+  const int bytesWritten = mOut.write( buf, off, len );
+  if( bytesWritten > 0 ) {
+    for( size_t i = 0; i < mHashes.size(); i++ ) {
+      mHashes[i]->update( &buf[off], bytesWritten );
+    }
+    mCount += bytesWritten;
+  }
+  return bytesWritten;
+}
+
+/////////////// EncodingOutputStream //////////////////////
+
+EncodingOutputStream::EncodingOutputStream( OutputStream& out, const BaseEncoding& encoding )
+  : mOut( out ), mEncoding( encoding ), mPendingLen( 0 )
+{}
+
+int EncodingOutputStream::writeText( size_t len )
+{
+  size_t written = 0;
+  while( written < len ) {
+    const int ret = mOut.write( reinterpret_cast<uint8_t*>( mText ), written, len - written );
+    if( ret < 0 ) {
+      return ret;
+    }
+    written += ret;
+  }
+  return OK;
+}
+
+void EncodingOutputStream::close()
+{
+  if( mPendingLen > 0 ) {
+    mEncoding.encodeInto( mPending, mPendingLen, mText );
+    writeText( mEncoding.encodedLength( mPendingLen ) );
+    mPendingLen = 0;
+  }
+  mOut.close();
+}
+
+int EncodingOutputStream::write( uint8_t* buf, size_t off, size_t len )
+{
+  const size_t groupBytes = mEncoding.groupBytes();
+  const size_t groupChars = mEncoding.groupChars();
+  const uint8_t* src = &buf[off];
+  size_t remaining = len;
+  int ret;
+
+  if( mPendingLen > 0 ) {
+    const size_t n = MIN( groupBytes - mPendingLen, remaining );
+    memcpy( &mPending[mPendingLen], src, n );
+    mPendingLen += n;
+    src += n;
+    remaining -= n;
+    if( mPendingLen < groupBytes ) {
+      return len;
+    }
+    mEncoding.encodeInto( mPending, groupBytes, mText );
+    mPendingLen = 0;
+    if( ( ret = writeText( groupChars ) ) != OK ) {
+      return ret;
+    }
+  }
+
+  const size_t maxGroups = sizeof( mText ) / groupChars;
+  while( remaining >= groupBytes ) {
+    const size_t groups = MIN( remaining / groupBytes, maxGroups );
+    mEncoding.encodeInto( src, groups * groupBytes, mText );
+    if( ( ret = writeText( groups * groupChars ) ) != OK ) {
+      return ret;
+    }
+    src += groups * groupBytes;
+    remaining -= groups * groupBytes;
+  }
+
+  memcpy( mPending, src, remaining );
+  mPendingLen = remaining;
+  return len;
+}
+
+/////////////// DecodingInputStream //////////////////////
+
+DecodingInputStream::DecodingInputStream( InputStream& in, const BaseEncoding& encoding )
+  : mIn( in ), mEncoding( encoding ), mEof( false ), mTextLen( 0 ), mBytesPos( 0 ), mBytesLen( 0 )
+{}
+
+void DecodingInputStream::close()
+{
+  mIn.close();
+}
+
+int DecodingInputStream::fill()
+{
+  const size_t groupChars = mEncoding.groupChars();
+  while( mBytesPos == mBytesLen ) {
+    if( !mEof ) {
+      const int ret = mIn.read( reinterpret_cast<uint8_t*>( mText ), mTextLen, sizeof( mText ) - mTextLen );
+      if( ret == -1 ) {
+        mEof = true;
+      } else if( ret < 0 ) {
+        return ret;
+      } else {
+        mTextLen += ret;
+      }
+    }
+    if( mEof && mTextLen == 0 ) {
+      return -1;
+    }
+
+    // everything at the end, whole groups before it
+    const size_t usable = mEof ? mTextLen : mTextLen / groupChars * groupChars;
+    if( usable == 0 ) {
+      continue;
+    }
+    const ssize_t decoded = mEncoding.decodeInto( mText, usable, mBytes );
+    if( decoded < 0 ) {
+      return BAD_VALUE;
+    }
+    memmove( mText, &mText[usable], mTextLen - usable );
+    mTextLen -= usable;
+    mBytesPos = 0;
+    mBytesLen = decoded;
+  }
+  return OK;
+}
+
+int DecodingInputStream::read( uint8_t* buf, size_t off, size_t len )
+{
+  const int ret = fill();
+  if( ret != OK ) {
+    return ret;
+  }
+  const size_t n = MIN( len, mBytesLen - mBytesPos );
+  memcpy( &buf[off], &mBytes[mBytesPos], n );
+  mBytesPos += n;
+  return n;
+}
+
 ////////////////// Others ///////////////////////
 
 IOProgress::~IOProgress()
@@ -62,6 +62,24 @@ static char16_t* allocFromUTF8( const char* u8str, size_t u8len )
 
   const uint8_t* u8cur = ( const uint8_t* ) u8str;
 
+  // there are never more units than bytes: convert, then give back the rest
+  SharedBuffer* whole = SharedBuffer::alloc( sizeof( char16_t ) * ( u8len + 1 ) );
+  if( !whole ) {
+    return getEmptyString();
+  }
+  const ssize_t converted = utf8_to_utf16_checked( u8cur, u8len, ( char16_t* )whole->data() );
+  if( converted >= 0 ) {
+    SharedBuffer* trimmed = whole->editResize( sizeof( char16_t ) * ( converted + 1 ) );
+    if( trimmed ) {
+      whole = trimmed;
+    }
+    char16_t* u16str = ( char16_t* )whole->data();
+    u16str[converted] = 0;
+    return u16str;
+  }
+  whole->release();
+
+  // not valid UTF-8, converted as leniently as it always was
   const int u16len = utf8_to_utf16_length( u8cur, u8len );
   if( u16len < 0 ) {
     return getEmptyString();
@@ -99,6 +117,12 @@ String16::String16( const String16& o )
   SharedBuffer::bufferFromData( mString )->acquire();
 }
 
+String16::String16( String16&& o )
+  : mString( o.mString )
+{
+  o.mString = getEmptyString();
+}
+
 String16::String16( const String16& o, size_t len, size_t begin )
   : mString( getEmptyString() )
 {
@@ -33,17 +33,11 @@ namespace baseline {
 // to OS_PATH_SEPARATOR.
 #define RES_PATH_SEPARATOR '/'
 
-static SharedBuffer* gEmptyStringBuf = NULL;
-static char* gEmptyString = NULL;
-
 extern int gDarwinCantLoadAllObjects;
 int gDarwinIsReallyAnnoying;
 
-static inline char* getEmptyString()
-{
-  gEmptyStringBuf->acquire();
-  return gEmptyString;
-}
+const size_t String8::kInlineCapacity;
+const uint8_t String8::kHeapTag;
 
 void initialize_string8()
 {
@@ -52,55 +46,63 @@ void initialize_string8()
   // These variables are named for Darwin, but are needed elsewhere too,
   // including static linking on any platform.
   gDarwinIsReallyAnnoying = gDarwinCantLoadAllObjects;
-
-  SharedBuffer* buf = SharedBuffer::alloc( 1 );
-  char* str = ( char* )buf->data();
-  *str = 0;
-  gEmptyStringBuf = buf;
-  gEmptyString = str;
 }
 
 void terminate_string8()
 {
-  SharedBuffer::bufferFromData( gEmptyString )->release();
-  gEmptyStringBuf = NULL;
-  gEmptyString = NULL;
 }
 
 // ---------------------------------------------------------------------------
 
 static char* allocFromUTF8( const char* in, size_t len )
 {
-  if( len > 0 ) {
-    SharedBuffer* buf = SharedBuffer::alloc( len + 1 );
-    ALOG_ASSERT( buf, "Unable to allocate shared buffer" );
-    if( buf ) {
-      char* str = ( char* )buf->data();
-      memcpy( str, in, len );
-      str[len] = 0;
-      return str;
-    }
-    return NULL;
+  SharedBuffer* buf = SharedBuffer::alloc( len + 1 );
+  ALOG_ASSERT( buf, "Unable to allocate shared buffer" );
+  if( buf ) {
+    char* str = ( char* )buf->data();
+    memcpy( str, in, len );
+    str[len] = 0;
+    return str;
   }
-
-  return getEmptyString();
+  return NULL;
 }
 
+// the functions below return NULL for an empty result, and when they fail
+
 static char* allocFromUTF16( const char16_t* in, size_t len )
 {
   if( len == 0 ) {
-    return getEmptyString();
+    return NULL;
+  }
+
+  // convert into room for the longest result, then give back the rest
+  SharedBuffer* buf = SharedBuffer::alloc( 3 * len + 1 );
+  ALOG_ASSERT( buf, "Unable to allocate shared buffer" );
+  if( !buf ) {
+    return NULL;
+  }
+  const ssize_t converted = utf16_to_utf8_checked( in, len, ( char* )buf->data() );
+  if( converted >= 0 ) {
+    SharedBuffer* trimmed = buf->editResize( converted + 1 );
+    if( trimmed ) {
+      buf = trimmed;
+    }
+    char* str = ( char* )buf->data();
+    str[converted] = 0;
+    return str;
   }
+  buf->release();
 
+  // unpaired surrogates, converted the way they always were
   const int bytes = utf16_to_utf8_length( in, len );
   if( bytes < 0 ) {
-    return getEmptyString();
+    return NULL;
   }
 
-  SharedBuffer* buf = SharedBuffer::alloc( bytes + 1 );
+  buf = SharedBuffer::alloc( bytes + 1 );
   ALOG_ASSERT( buf, "Unable to allocate shared buffer" );
   if( !buf ) {
-    return getEmptyString();
+    return NULL;
   }
 
   char* str = ( char* )buf->data();
@@ -111,18 +113,18 @@ static char* allocFromUTF16( const char16_t* in, size_t len )
 static char* allocFromUTF32( const char32_t* in, size_t len )
 {
   if( len == 0 ) {
-    return getEmptyString();
+    return NULL;
   }
 
   const int bytes = utf32_to_utf8_length( in, len );
   if( bytes < 0 ) {
-    return getEmptyString();
+    return NULL;
   }
 
   SharedBuffer* buf = SharedBuffer::alloc( bytes + 1 );
   ALOG_ASSERT( buf, "Unable to allocate shared buffer" );
   if( !buf ) {
-    return getEmptyString();
+    return NULL;
   }
 
   char* str = ( char* ) buf->data();
@@ -133,61 +135,90 @@ static char* allocFromUTF32( const char32_t* in, size_t len )
 
 // ---------------------------------------------------------------------------
 
+void String8::releaseHeap()
+{
+  if( !isInline() ) {
+    SharedBuffer::bufferFromData( mHeap )->release();
+  }
+}
+
+void String8::initFrom( const char* other, size_t len )
+{
+  if( len <= kInlineCapacity ) {
+    memcpy( mInline, other, len );
+    setInlineLength( len );
+    return;
+  }
+  const char* str = allocFromUTF8( other, len );
+  if( str ) {
+    setHeap( str );
+  } else {
+    setEmpty();
+  }
+}
+
 String8::String8()
-  : mString( getEmptyString() )
 {
+  setEmpty();
 }
 
 String8::String8( const String8& o )
-  : mString( o.mString )
 {
-  SharedBuffer::bufferFromData( mString )->acquire();
+  memcpy( mInline, o.mInline, sizeof( mInline ) );
+  if( !isInline() ) {
+    SharedBuffer::bufferFromData( mHeap )->acquire();
+  }
+}
+
+String8::String8( String8&& o )
+{
+  memcpy( mInline, o.mInline, sizeof( mInline ) );
+  o.setEmpty();
 }
 
 String8::String8( const char* o )
-  : mString( allocFromUTF8( o, strlen( o ) ) )
 {
-  if( mString == NULL ) {
-    mString = getEmptyString();
-  }
+  initFrom( o, strlen( o ) );
 }
 
 String8::String8( const char* o, size_t len )
-  : mString( allocFromUTF8( o, len ) )
 {
-  if( mString == NULL ) {
-    mString = getEmptyString();
-  }
+  initFrom( o, len );
 }
 
 String8::String8( const String16& o )
-  : mString( allocFromUTF16( o.string(), o.size() ) )
 {
+  setEmpty();
+  setTo( o.string(), o.size() );
 }
 
 String8::String8( const char16_t* o )
-  : mString( allocFromUTF16( o, strlen16( o ) ) )
 {
+  setEmpty();
+  setTo( o, strlen16( o ) );
 }
 
 String8::String8( const char16_t* o, size_t len )
-  : mString( allocFromUTF16( o, len ) )
 {
+  setEmpty();
+  setTo( o, len );
 }
 
 String8::String8( const char32_t* o )
-  : mString( allocFromUTF32( o, strlen32( o ) ) )
 {
+  setEmpty();
+  setTo( o, strlen32( o ) );
 }
 
 String8::String8( const char32_t* o, size_t len )
-  : mString( allocFromUTF32( o, len ) )
 {
+  setEmpty();
+  setTo( o, len );
 }
 
 String8::~String8()
 {
-  SharedBuffer::bufferFromData( mString )->release();
+  releaseHeap();
 }
 
 String8 String8::format( const char* fmt, ... )
@@ -210,67 +241,97 @@ String8 String8::formatV( const char* fmt, va_list args )
 
 void String8::clear()
 {
-  SharedBuffer::bufferFromData( mString )->release();
-  mString = getEmptyString();
+  releaseHeap();
+  setEmpty();
 }
 
 void String8::setTo( const String8& other )
 {
-  SharedBuffer::bufferFromData( other.mString )->acquire();
-  SharedBuffer::bufferFromData( mString )->release();
-  mString = other.mString;
+  if( this == &other ) {
+    return;
+  }
+  if( !other.isInline() ) {
+    SharedBuffer::bufferFromData( other.mHeap )->acquire();
+  }
+  releaseHeap();
+  memcpy( mInline, other.mInline, sizeof( mInline ) );
 }
 
 status_t String8::setTo( const char* other )
 {
-  const char* newString = allocFromUTF8( other, strlen( other ) );
-  SharedBuffer::bufferFromData( mString )->release();
-  mString = newString;
-  if( mString ) {
-    return NO_ERROR;
-  }
-
-  mString = getEmptyString();
-  return NO_MEMORY;
+  return setTo( other, strlen( other ) );
 }
 
 status_t String8::setTo( const char* other, size_t len )
 {
+  // other may point into this string
+  if( len <= kInlineCapacity ) {
+    const char* heap = isInline() ? NULL : mHeap;
+    memmove( mInline, other, len );
+    setInlineLength( len );
+    if( heap ) {
+      SharedBuffer::bufferFromData( heap )->release();
+    }
+    return NO_ERROR;
+  }
+
   const char* newString = allocFromUTF8( other, len );
-  SharedBuffer::bufferFromData( mString )->release();
-  mString = newString;
-  if( mString ) {
+  releaseHeap();
+  if( newString ) {
+    setHeap( newString );
     return NO_ERROR;
   }
 
-  mString = getEmptyString();
+  setEmpty();
   return NO_MEMORY;
 }
 
 status_t String8::setTo( const char16_t* other, size_t len )
 {
-  const char* newString = allocFromUTF16( other, len );
-  SharedBuffer::bufferFromData( mString )->release();
-  mString = newString;
-  if( mString ) {
-    return NO_ERROR;
+  // at least a byte per unit, so only short input can end up inline
+  if( len > 0 && len <= kInlineCapacity ) {
+    char str[3 * kInlineCapacity + 1];
+    const ssize_t converted = utf16_to_utf8_checked( other, len, str );
+    if( converted >= 0 && size_t( converted ) <= kInlineCapacity ) {
+      releaseHeap();
+      memcpy( mInline, str, converted );
+      setInlineLength( converted );
+      return NO_ERROR;
+    }
   }
 
-  mString = getEmptyString();
-  return NO_MEMORY;
+  const char* newString = allocFromUTF16( other, len );
+  releaseHeap();
+  if( newString ) {
+    setHeap( newString );
+  } else {
+    setEmpty();
+  }
+  return NO_ERROR;
 }
 
 status_t String8::setTo( const char32_t* other, size_t len )
 {
-  const char* newString = allocFromUTF32( other, len );
-  SharedBuffer::bufferFromData( mString )->release();
-  mString = newString;
-  if( mString ) {
-    return NO_ERROR;
+  if( len > 0 && len <= kInlineCapacity ) {
+    const int bytes = utf32_to_utf8_length( other, len );
+    if( bytes >= 0 && size_t( bytes ) <= kInlineCapacity ) {
+      char str[kInlineCapacity + 1];
+      utf32_to_utf8( other, len, str );
+      releaseHeap();
+      memcpy( mInline, str, bytes );
+      setInlineLength( bytes );
+      return NO_ERROR;
+    }
   }
 
-  mString = getEmptyString();
-  return NO_MEMORY;
+  const char* newString = allocFromUTF32( other, len );
+  releaseHeap();
+  if( newString ) {
+    setHeap( newString );
+  } else {
+    setEmpty();
+  }
+  return NO_ERROR;
 }
 
 status_t String8::append( const String8& other )
@@ -316,7 +377,14 @@ status_t String8::appendFormat( const char* fmt, ... )
 status_t String8::appendFormatV( const char* fmt, va_list args )
 {
   int result = NO_ERROR;
-  int n = vsnprintf( NULL, 0, fmt, args );
+  // measuring consumes the arguments, so measure with a copy of them
+  va_list copy;
+  va_copy( copy, args );
+  int n = vsnprintf( NULL, 0, fmt, copy );
+  va_end( copy );
+  if( n < 0 ) {
+    return BAD_VALUE;
+  }
   if( n != 0 ) {
     size_t oldLength = length();
     char* buf = lockBuffer( oldLength + n );
@@ -333,11 +401,30 @@ status_t String8::real_append( const char* other, size_t otherLen )
 {
   const size_t myLen = bytes();
 
-  SharedBuffer* buf = SharedBuffer::bufferFromData( mString )
+  if( isInline() ) {
+    if( myLen + otherLen <= kInlineCapacity ) {
+      memmove( mInline + myLen, other, otherLen );
+      setInlineLength( myLen + otherLen );
+      return NO_ERROR;
+    }
+    // outgrowing the inline space, other may point into it
+    SharedBuffer* buf = SharedBuffer::alloc( myLen + otherLen + 1 );
+    if( !buf ) {
+      return NO_MEMORY;
+    }
+    char* str = ( char* )buf->data();
+    memcpy( str, mInline, myLen );
+    memcpy( str + myLen, other, otherLen );
+    str[myLen + otherLen] = '\0';
+    setHeap( str );
+    return NO_ERROR;
+  }
+
+  SharedBuffer* buf = SharedBuffer::bufferFromData( mHeap )
                       ->editResize( myLen + otherLen + 1 );
   if( buf ) {
     char* str = ( char* )buf->data();
-    mString = str;
+    mHeap = str;
     str += myLen;
     memcpy( str, other, otherLen );
     str[otherLen] = '\0';
@@ -348,11 +435,28 @@ status_t String8::real_append( const char* other, size_t otherLen )
 
 char* String8::lockBuffer( size_t size )
 {
-  SharedBuffer* buf = SharedBuffer::bufferFromData( mString )
+  if( isInline() ) {
+    const size_t len = length();
+    if( size <= kInlineCapacity ) {
+      setInlineLength( size );
+      return mInline;
+    }
+    SharedBuffer* buf = SharedBuffer::alloc( size + 1 );
+    if( !buf ) {
+      return NULL;
+    }
+    char* str = ( char* )buf->data();
+    memcpy( str, mInline, len + 1 );
+    str[size] = '\0';
+    setHeap( str );
+    return str;
+  }
+
+  SharedBuffer* buf = SharedBuffer::bufferFromData( mHeap )
                       ->editResize( size + 1 );
   if( buf ) {
     char* str = ( char* )buf->data();
-    mString = str;
+    mHeap = str;
     return str;
   }
   return NULL;
@@ -360,22 +464,37 @@ char* String8::lockBuffer( size_t size )
 
 void String8::unlockBuffer()
 {
-  unlockBuffer( strlen( mString ) );
+  unlockBuffer( strlen( string() ) );
 }
 
 status_t String8::unlockBuffer( size_t size )
 {
+  if( isInline() ) {
+    if( size <= kInlineCapacity ) {
+      setInlineLength( size );
+      return NO_ERROR;
+    }
+    // grown past the inline space, as lockBuffer() would have
+    SharedBuffer* buf = SharedBuffer::alloc( size + 1 );
+    if( !buf ) {
+      return NO_MEMORY;
+    }
+    char* str = ( char* )buf->data();
+    memcpy( str, mInline, kInlineCapacity );
+    str[size] = '\0';
+    setHeap( str );
+    return NO_ERROR;
+  }
+
   if( size != this->size() ) {
-    SharedBuffer* buf = SharedBuffer::bufferFromData( mString )
+    SharedBuffer* buf = SharedBuffer::bufferFromData( mHeap )
                         ->editResize( size + 1 );
     if( ! buf ) {
       return NO_MEMORY;
     }
-
-    char* str = ( char* )buf->data();
-    str[size] = 0;
-    mString = str;
+    mHeap = ( char* )buf->data();
   }
+  const_cast<char*>( mHeap )[size] = 0;
 
   return NO_ERROR;
 }
@@ -386,9 +505,10 @@ int String8::find( const char* other, size_t start ) const
   if( start >= len ) {
     return -1;
   }
-  const char* s = mString + start;
+  const char* const str = string();
+  const char* s = str + start;
   const char* p = strstr( s, other );
-  return p ? p - mString : -1;
+  return p ? p - str : -1;
 }
 
 void String8::toLower()
@@ -441,17 +561,17 @@ void String8::toUpper( size_t start, size_t length )
 
 size_t String8::getUtf32Length() const
 {
-  return utf8_to_utf32_length( mString, length() );
+  return utf8_to_utf32_length( string(), length() );
 }
 
 int32_t String8::getUtf32At( size_t index, size_t* next_index ) const
 {
-  return utf32_from_utf8_at( mString, length(), index, next_index );
+  return utf32_from_utf8_at( string(), length(), index, next_index );
 }
 
 void String8::getUtf32( char32_t* dst ) const
 {
-  utf8_to_utf32( mString, length(), dst );
+  utf8_to_utf32( string(), length(), dst );
 }
 
 TextOutput& operator<<( TextOutput& to, const String8& val )
@@ -487,7 +607,7 @@ void String8::setPathName( const char* name, size_t len )
 String8 String8::getPathLeaf( void ) const
 {
   const char* cp;
-  const char* const buf = mString;
+  const char* const buf = string();
 
   cp = strrchr( buf, OS_PATH_SEPARATOR );
   if( cp == NULL ) {
@@ -500,7 +620,7 @@ String8 String8::getPathLeaf( void ) const
 String8 String8::getPathDir( void ) const
 {
   const char* cp;
-  const char* const str = mString;
+  const char* const str = string();
 
   cp = strrchr( str, OS_PATH_SEPARATOR );
   if( cp == NULL ) {
@@ -513,7 +633,7 @@ String8 String8::getPathDir( void ) const
 String8 String8::walkPath( String8* outRemains ) const
 {
   const char* cp;
-  const char* const str = mString;
+  const char* const str = string();
   const char* buf = str;
 
   cp = strchr( buf, OS_PATH_SEPARATOR );
@@ -541,14 +661,14 @@ String8 String8::walkPath( String8* outRemains ) const
 /*
  * Helper function for finding the start of an extension in a pathname.
  *
- * Returns a pointer inside mString, or NULL if no extension was found.
+ * Returns a pointer inside string(), or NULL if no extension was found.
  */
 char* String8::find_extension( void ) const
 {
   const char* lastSlash;
   const char* lastDot;
   int extLen;
-  const char* const str = mString;
+  const char* const str = string();
 
   // only look at the filename
   lastSlash = strrchr( str, OS_PATH_SEPARATOR );
@@ -583,7 +703,7 @@ String8 String8::getPathExtension( void ) const
 String8 String8::getBasePath( void ) const
 {
   char* ext;
-  const char* const str = mString;
+  const char* const str = string();
 
   ext = find_extension();
   if( ext == NULL ) {
@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/StringBuilder.h>
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+namespace baseline {
+
+//! the smallest buffer worth allocating, a 64 byte block with the terminator
+static const size_t kMinCapacity = 63;
+
+static const char kDigitPairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+static const uint64_t kPow10[] = {
+  1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull
+};
+
+static const int kMaxFastPrecision = 9;
+
+static size_t countDigits( uint64_t value )
+{
+  size_t digits = 1;
+  for( ;; ) {
+    if( value < 10 ) {
+      return digits;
+    }
+    if( value < 100 ) {
+      return digits + 1;
+    }
+    if( value < 1000 ) {
+      return digits + 2;
+    }
+    if( value < 10000 ) {
+      return digits + 3;
+    }
+    value /= 10000;
+    digits += 4;
+  }
+}
+
+//! writes the decimal digits of value so that they end just before end
+static void writeDigits( char* end, uint64_t value )
+{
+  while( value >= 100 ) {
+    const size_t pair = size_t( value % 100 ) * 2;
+    value /= 100;
+    end -= 2;
+    memcpy( end, kDigitPairs + pair, 2 );
+  }
+  if( value >= 10 ) {
+    memcpy( end - 2, kDigitPairs + value * 2, 2 );
+  } else {
+    end[-1] = char( '0' + value );
+  }
+}
+
+
+StringBuilder::StringBuilder()
+  : mData( NULL ), mLength( 0 ), mCapacity( 0 )
+{
+}
+
+StringBuilder::StringBuilder( size_t capacity )
+  : mData( NULL ), mLength( 0 ), mCapacity( 0 )
+{
+  reserve( capacity );
+}
+
+StringBuilder::StringBuilder( StringBuilder&& o )
+  : mData( o.mData ), mLength( o.mLength ), mCapacity( o.mCapacity )
+{
+  o.mData = NULL;
+  o.mLength = 0;
+  o.mCapacity = 0;
+}
+
+StringBuilder::~StringBuilder()
+{
+  if( mData ) {
+    SharedBuffer::bufferFromData( mData )->release();
+  }
+}
+
+StringBuilder& StringBuilder::operator=( StringBuilder&& o )
+{
+  if( this != &o ) {
+    if( mData ) {
+      SharedBuffer::bufferFromData( mData )->release();
+    }
+    mData = o.mData;
+    mLength = o.mLength;
+    mCapacity = o.mCapacity;
+    o.mData = NULL;
+    o.mLength = 0;
+    o.mCapacity = 0;
+  }
+  return *this;
+}
+
+status_t StringBuilder::reserve( size_t capacity )
+{
+  if( capacity <= mCapacity ) {
+    return NO_ERROR;
+  }
+  SharedBuffer* buf = mData ? SharedBuffer::bufferFromData( mData )->editResize( capacity + 1 )
+                      : SharedBuffer::alloc( capacity + 1 );
+  if( !buf ) {
+    return NO_MEMORY;
+  }
+  mData = ( char* )buf->data();
+  mCapacity = capacity;
+  mData[mLength] = '\0';
+  return NO_ERROR;
+}
+
+status_t StringBuilder::shrink()
+{
+  if( mLength == mCapacity ) {
+    return NO_ERROR;
+  }
+  if( mLength == 0 ) {
+    SharedBuffer::bufferFromData( mData )->release();
+    mData = NULL;
+    mCapacity = 0;
+    return NO_ERROR;
+  }
+  SharedBuffer* buf = SharedBuffer::bufferFromData( mData )->editResize( mLength + 1 );
+  if( !buf ) {
+    return NO_MEMORY;
+  }
+  mData = ( char* )buf->data();
+  mCapacity = mLength;
+  return NO_ERROR;
+}
+
+void StringBuilder::clear()
+{
+  if( mData ) {
+    setLength( 0 );
+  }
+}
+
+void StringBuilder::truncate( size_t length )
+{
+  if( length < mLength ) {
+    setLength( length );
+  }
+}
+
+/**
+ * Returns where the next extra bytes go, growing the buffer by at least
+ * half if they do not fit, or NULL if it cannot grow.
+ */
+char* StringBuilder::grow( size_t extra )
+{
+  if( extra <= mCapacity - mLength ) {
+    return mData + mLength;
+  }
+  if( extra > SIZE_MAX / 2 - mLength ) {
+    return NULL;
+  }
+  size_t capacity = MAX( mLength + extra, mCapacity + mCapacity / 2 );
+  capacity = MAX( capacity, kMinCapacity );
+  return reserve( capacity ) == NO_ERROR ? mData + mLength : NULL;
+}
+
+status_t StringBuilder::appendSlow( const char* str, size_t len )
+{
+  if( len == 0 ) {
+    return NO_ERROR;
+  }
+  // str may point into the buffer that is about to move
+  const uintptr_t offset = uintptr_t( str ) - uintptr_t( mData );
+  const bool inside = mData && offset < mLength;
+  char* dest = grow( len );
+  if( !dest ) {
+    return NO_MEMORY;
+  }
+  if( inside ) {
+    str = mData + offset;
+  }
+  memmove( dest, str, len );
+  setLength( mLength + len );
+  return NO_ERROR;
+}
+
+status_t StringBuilder::append( const char* str )
+{
+  return append( str, strlen( str ) );
+}
+
+status_t StringBuilder::append( const String8& str )
+{
+  return append( str.string(), str.length() );
+}
+
+status_t StringBuilder::appendUnsigned( uint64_t value )
+{
+  const size_t digits = countDigits( value );
+  char* dest = grow( digits );
+  if( !dest ) {
+    return NO_MEMORY;
+  }
+  writeDigits( dest + digits, value );
+  setLength( mLength + digits );
+  return NO_ERROR;
+}
+
+status_t StringBuilder::appendInt( int64_t value )
+{
+  if( value >= 0 ) {
+    return appendUnsigned( uint64_t( value ) );
+  }
+  const uint64_t magnitude = 0 - uint64_t( value );
+  const size_t digits = countDigits( magnitude );
+  char* dest = grow( digits + 1 );
+  if( !dest ) {
+    return NO_MEMORY;
+  }
+  dest[0] = '-';
+  writeDigits( dest + 1 + digits, magnitude );
+  setLength( mLength + 1 + digits );
+  return NO_ERROR;
+}
+
+status_t StringBuilder::appendHex( uint64_t value, unsigned minDigits )
+{
+  static const char kHex[] = "0123456789abcdef";
+  size_t digits = 1;
+  while( digits < 16 && ( value >> ( 4 * digits ) ) ) {
+    digits++;
+  }
+  digits = MAX( digits, size_t( minDigits ) );
+  char* dest = grow( digits );
+  if( !dest ) {
+    return NO_MEMORY;
+  }
+  for( size_t i = digits; i > 0; i-- ) {
+    dest[i - 1] = kHex[value & 15];
+    value >>= 4;
+  }
+  setLength( mLength + digits );
+  return NO_ERROR;
+}
+
+/**
+ * Scales the value to an integer number of units of the last digit and
+ * rounds that once. The scaled product is off from the exact one by at
+ * most half an ulp, so unless it lies that close to a rounding tie it
+ * rounds the way printf's exact decimal expansion does; the rest (ties,
+ * large values, long precisions, inf and nan) go through printf.
+ */
+status_t StringBuilder::appendDouble( double value, int precision )
+{
+  if( precision < 0 ) {
+    precision = 6;
+  }
+  if( precision > kMaxFastPrecision || !isfinite( value ) ) {
+    return appendFormat( "%.*f", precision, value );
+  }
+  const bool negative = signbit( value );
+  const double scaled = fabs( value ) * double( kPow10[precision] );
+  // below 2^52 floor() and the subtraction are exact
+  if( scaled >= 4503599627370496.0 ) {
+    return appendFormat( "%.*f", precision, value );
+  }
+  const double whole = floor( scaled );
+  const double fraction = scaled - whole;
+  if( fabs( fraction - 0.5 ) <= scaled * DBL_EPSILON ) {
+    return appendFormat( "%.*f", precision, value );
+  }
+
+  const uint64_t units = uint64_t( whole ) + ( fraction > 0.5 );
+  const uint64_t integer = units / kPow10[precision];
+  uint64_t decimals = units % kPow10[precision];
+  const size_t digits = countDigits( integer );
+  const size_t len = ( negative ? 1 : 0 ) + digits + ( precision ? 1 + precision : 0 );
+  char* dest = grow( len );
+  if( !dest ) {
+    return NO_MEMORY;
+  }
+  if( negative ) {
+    *dest++ = '-';
+  }
+  writeDigits( dest + digits, integer );
+  if( precision ) {
+    dest += digits;
+    *dest = '.';
+    for( int i = precision; i > 0; i-- ) {
+      dest[i] = char( '0' + decimals % 10 );
+      decimals /= 10;
+    }
+  }
+  setLength( mLength + len );
+  return NO_ERROR;
+}
+
+status_t StringBuilder::appendFormat( const char* fmt, ... )
+{
+  va_list args;
+  va_start( args, fmt );
+  status_t result = appendFormatV( fmt, args );
+  va_end( args );
+  return result;
+}
+
+status_t StringBuilder::appendFormatV( const char* fmt, va_list args )
+{
+  // format into the spare room first, and again only if it did not fit
+  const size_t spare = mCapacity - mLength;
+  va_list copy;
+  va_copy( copy, args );
+  const int n = vsnprintf( mData ? mData + mLength : NULL, mData ? spare + 1 : 0, fmt, copy );
+  va_end( copy );
+  if( n < 0 ) {
+    if( mData ) {
+      mData[mLength] = '\0';
+    }
+    return BAD_VALUE;
+  }
+  if( size_t( n ) > spare ) {
+    char* dest = grow( n );
+    if( !dest ) {
+      if( mData ) {
+        mData[mLength] = '\0';
+      }
+      return NO_MEMORY;
+    }
+    vsnprintf( dest, n + 1, fmt, args );
+  }
+  if( mData ) {
+    setLength( mLength + n );
+  }
+  return NO_ERROR;
+}
+
+String8 StringBuilder::toString8()
+{
+  String8 result;
+  if( mLength <= String8::kInlineCapacity ) {
+    result.setTo( string(), mLength );
+    clear();
+    return result;
+  }
+  SharedBuffer* buf = SharedBuffer::bufferFromData( mData )->editResize( mLength + 1 );
+  if( !buf ) {
+    result.setTo( mData, mLength );
+    clear();
+    return result;
+  }
+  result.setHeap( ( const char* )buf->data() );
+  mData = NULL;
+  mLength = 0;
+  mCapacity = 0;
+  return result;
+}
+
+}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <baseline/Baseline.h>
+#include <baseline/StringPool.h>
+
+#include <new>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace baseline {
+
+const uint32_t StringPool::kEpochMask;
+const uint32_t StringPool::kDead;
+
+StringPool::StringPool()
+  : mEpoch( 0 )
+{
+  for( size_t i = 0; i < kShards; i++ ) {
+    mShards[i].table.store( allocTable( kInitialSlots ), std::memory_order_relaxed );
+    mShards[i].count.store( 0, std::memory_order_relaxed );
+  }
+}
+
+StringPool::~StringPool()
+{
+  for( size_t i = 0; i < kShards; i++ ) {
+    Table* table = mShards[i].table.load( std::memory_order_relaxed );
+    for( uint32_t j = 0; j <= table->mask; j++ ) {
+      free( table->slots[j].load( std::memory_order_relaxed ) );
+    }
+    free( table );
+  }
+  for( size_t i = 0; i < mRetired.size(); i++ ) {
+    free( mRetired[i].ptr );
+  }
+}
+
+StringPool::Table* StringPool::allocTable( uint32_t slots )
+{
+  Table* table = ( Table* )malloc( offsetof( Table, slots ) + slots * sizeof( std::atomic<Entry*> ) );
+  table->mask = slots - 1;
+  for( uint32_t i = 0; i < slots; i++ ) {
+    new( &table->slots[i] ) std::atomic<Entry*>( nullptr );
+  }
+  return table;
+}
+
+StringPool::Entry* StringPool::probe( const Table* table, uint64_t hash, const char* str, size_t len )
+{
+  // tables are at most half full, so there is always an empty slot
+  for( uint32_t i = uint32_t( hash ) & table->mask;; i = ( i + 1 ) & table->mask ) {
+    Entry* entry = table->slots[i].load( std::memory_order_acquire );
+    if( !entry ) {
+      return nullptr;
+    }
+    if( entry->hash == hash && entry->length == len && memcmp( entry->data, str, len ) == 0 ) {
+      return entry;
+    }
+  }
+}
+
+void StringPool::place( Table* table, Entry* entry )
+{
+  uint32_t i = uint32_t( entry->hash ) & table->mask;
+  while( table->slots[i].load( std::memory_order_relaxed ) ) {
+    i = ( i + 1 ) & table->mask;
+  }
+  table->slots[i].store( entry, std::memory_order_release );
+}
+
+/**
+ * Records that entry was looked up in this epoch. Only writes when the
+ * epoch changed, so hot strings stay shared in every reader's cache.
+ * Returns false if purge() got to the entry first.
+ */
+bool StringPool::touch( Entry* entry )
+{
+  const uint32_t now = mEpoch.load( std::memory_order_relaxed ) & kEpochMask;
+  uint32_t seen = entry->epoch.load( std::memory_order_relaxed );
+  while( seen != now ) {
+    if( seen == kDead ) {
+      return false;
+    }
+    if( entry->epoch.compare_exchange_weak( seen, now, std::memory_order_relaxed ) ) {
+      break;
+    }
+  }
+  return true;
+}
+
+StringPool::Entry* StringPool::lookup( const char* str, size_t len, uint64_t hash, bool add )
+{
+  Shard& shard = shardFor( hash );
+  Entry* entry = probe( shard.table.load( std::memory_order_acquire ), hash, str, len );
+  if( entry && touch( entry ) ) {
+    return entry;
+  }
+  if( !entry && !add ) {
+    return nullptr;
+  }
+
+  // missing, or purged and about to be unlinked: purge() holds the lock
+  // while it does that, so the table seen under it has neither
+  Mutex::Autolock lock( shard.lock );
+  Table* table = shard.table.load( std::memory_order_relaxed );
+  entry = probe( table, hash, str, len );
+  if( entry ) {
+    touch( entry );
+    return entry;
+  }
+  if( !add ) {
+    return nullptr;
+  }
+
+  const uint32_t count = shard.count.load( std::memory_order_relaxed );
+  if( ( count + 1 ) * 2 > table->mask + 1 ) {
+    Table* bigger = allocTable( ( table->mask + 1 ) * 2 );
+    for( uint32_t i = 0; i <= table->mask; i++ ) {
+      Entry* e = table->slots[i].load( std::memory_order_relaxed );
+      if( e ) {
+        place( bigger, e );
+      }
+    }
+    shard.table.store( bigger, std::memory_order_release );
+    retire( table );
+    table = bigger;
+  }
+
+  entry = ( Entry* )malloc( offsetof( Entry, data ) + len + 1 );
+  entry->hash = hash;
+  new( &entry->epoch ) std::atomic<uint32_t>( mEpoch.load( std::memory_order_relaxed ) & kEpochMask );
+  entry->length = uint32_t( len );
+  memcpy( entry->data, str, len );
+  entry->data[len] = '\0';
+  place( table, entry );
+  shard.count.store( count + 1, std::memory_order_relaxed );
+  return entry;
+}
+
+InternedString StringPool::intern( const char* str, size_t len )
+{
+  if( len == 0 ) {
+    return InternedString();
+  }
+  return InternedString( lookup( str, len, hash64( str, len ), true ) );
+}
+
+InternedString StringPool::intern( const char* str )
+{
+  return str ? intern( str, strlen( str ) ) : InternedString();
+}
+
+InternedString StringPool::intern( const String8& str )
+{
+  return intern( str.string(), str.length() );
+}
+
+InternedString StringPool::find( const char* str, size_t len )
+{
+  if( len == 0 ) {
+    return InternedString();
+  }
+  return InternedString( lookup( str, len, hash64( str, len ), false ) );
+}
+
+InternedString StringPool::find( const char* str )
+{
+  return str ? find( str, strlen( str ) ) : InternedString();
+}
+
+InternedString StringPool::find( const String8& str )
+{
+  return find( str.string(), str.length() );
+}
+
+size_t StringPool::size() const
+{
+  size_t size = 0;
+  for( size_t i = 0; i < kShards; i++ ) {
+    size += mShards[i].count.load( std::memory_order_relaxed );
+  }
+  return size;
+}
+
+uint32_t StringPool::epoch() const
+{
+  return mEpoch.load( std::memory_order_relaxed );
+}
+
+void StringPool::retire( void* ptr )
+{
+  Mutex::Autolock lock( mRetiredLock );
+  Retired retired;
+  retired.ptr = ptr;
+  retired.epoch = mEpoch.load( std::memory_order_relaxed );
+  mRetired.add( retired );
+}
+
+uint32_t StringPool::advanceEpoch()
+{
+  Mutex::Autolock lock( mRetiredLock );
+  const uint32_t now = mEpoch.load( std::memory_order_relaxed ) + 1;
+  mEpoch.store( now, std::memory_order_relaxed );
+
+  size_t kept = 0;
+  for( size_t i = 0; i < mRetired.size(); i++ ) {
+    const Retired& retired = mRetired[i];
+    if( now - retired.epoch >= 2 ) {
+      free( retired.ptr );
+    } else {
+      mRetired.editItemAt( kept++ ) = retired;
+    }
+  }
+  if( kept < mRetired.size() ) {
+    mRetired.removeItemsAt( kept, mRetired.size() - kept );
+  }
+  return now;
+}
+
+size_t StringPool::purge( uint32_t maxAge )
+{
+  size_t removed = 0;
+  for( size_t i = 0; i < kShards; i++ ) {
+    Shard& shard = mShards[i];
+    Mutex::Autolock lock( shard.lock );
+    const uint32_t now = mEpoch.load( std::memory_order_relaxed ) & kEpochMask;
+    Table* table = shard.table.load( std::memory_order_relaxed );
+
+    // marking an entry dead races with touch(); whoever swaps the epoch first wins
+    uint32_t dead = 0;
+    for( uint32_t j = 0; j <= table->mask; j++ ) {
+      Entry* entry = table->slots[j].load( std::memory_order_relaxed );
+      if( !entry ) {
+        continue;
+      }
+      uint32_t seen = entry->epoch.load( std::memory_order_relaxed );
+      for( ;; ) {
+        // an age in the top half of the range is a lookup from an epoch
+        // that started after now was read
+        const uint32_t age = ( now - seen ) & kEpochMask;
+        if( age <= maxAge || age > ( kEpochMask >> 1 ) ) {
+          break;
+        }
+        if( entry->epoch.compare_exchange_weak( seen, kDead, std::memory_order_relaxed ) ) {
+          dead++;
+          break;
+        }
+      }
+    }
+    if( !dead ) {
+      continue;
+    }
+
+    Table* fresh = allocTable( table->mask + 1 );
+    for( uint32_t j = 0; j <= table->mask; j++ ) {
+      Entry* entry = table->slots[j].load( std::memory_order_relaxed );
+      if( !entry ) {
+        continue;
+      }
+      if( entry->epoch.load( std::memory_order_relaxed ) == kDead ) {
+        retire( entry );
+      } else {
+        place( fresh, entry );
+      }
+    }
+    shard.table.store( fresh, std::memory_order_release );
+    retire( table );
+    shard.count.store( shard.count.load( std::memory_order_relaxed ) - dead, std::memory_order_relaxed );
+    removed += dead;
+  }
+  return removed;
+}
+
+}
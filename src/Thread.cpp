@@ -24,6 +24,7 @@
 #ifdef WIN32
   #include <process.h>
 #else
+  #include <sched.h>
   #include <unistd.h>
 #endif
 
@@ -129,5 +130,14 @@ void Thread::sleep( uint32_t millisec )
 
 }
 
+void Thread::yield()
+{
+#ifdef WIN32
+  SwitchToThread();
+#else
+  sched_yield();
+#endif
+}
+
 
 }
\ No newline at end of file
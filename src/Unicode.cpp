@@ -17,9 +17,19 @@
  */
 
 #include <stddef.h>
+#include <string.h>
+#include <sys/types.h>
 #include <cstddef>
 #include <cstdint>
 
+#include <baseline/Unicode.h>
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+  #include <immintrin.h>
+  #define HAVE_X86_UTF8
+  #define AVX2_TARGET __attribute__(( target( "avx2" ) ))
+#endif
+
 #ifdef WIN32
   #include <Winsock2.h>
 #endif
@@ -45,6 +55,276 @@
   #include <netinet/in.h>
 #endif
 
+namespace unicode_detail {
+
+/**
+ * Decodes the code point at p, which is before end, into *out. Returns
+ * its length in bytes, or 0 if it is not well formed UTF-8: a stray
+ * continuation byte, a truncated sequence, an overlong form, a surrogate
+ * or a value above U+10FFFF.
+ */
+static inline size_t decode_strict( const uint8_t* p, const uint8_t* end, char32_t* out )
+{
+  const uint32_t b0 = p[0];
+  if( b0 < 0x80 ) {
+    *out = b0;
+    return 1;
+  }
+  if( b0 < 0xC2 ) {
+    return 0;
+  }
+  if( b0 < 0xE0 ) {
+    if( end - p < 2 || ( p[1] & 0xC0 ) != 0x80 ) {
+      return 0;
+    }
+    *out = ( ( b0 & 0x1F ) << 6 ) | ( p[1] & 0x3F );
+    return 2;
+  }
+  if( b0 < 0xF0 ) {
+    if( end - p < 3 || ( p[1] & 0xC0 ) != 0x80 || ( p[2] & 0xC0 ) != 0x80 ) {
+      return 0;
+    }
+    const char32_t cp = ( ( b0 & 0x0F ) << 12 ) | ( ( p[1] & 0x3F ) << 6 ) | ( p[2] & 0x3F );
+    if( cp < 0x800 || ( cp >= 0xD800 && cp <= 0xDFFF ) ) {
+      return 0;
+    }
+    *out = cp;
+    return 3;
+  }
+  if( b0 < 0xF5 ) {
+    if( end - p < 4 || ( p[1] & 0xC0 ) != 0x80 || ( p[2] & 0xC0 ) != 0x80 || ( p[3] & 0xC0 ) != 0x80 ) {
+      return 0;
+    }
+    const char32_t cp = ( ( b0 & 0x07 ) << 18 ) | ( ( p[1] & 0x3F ) << 12 ) | ( ( p[2] & 0x3F ) << 6 ) | ( p[3] & 0x3F );
+    if( cp < 0x10000 || cp > 0x10FFFF ) {
+      return 0;
+    }
+    *out = cp;
+    return 4;
+  }
+  return 0;
+}
+
+#if defined(HAVE_X86_UTF8)
+
+/*
+ * Validation follows Keiser and Lemire, "Validating UTF-8 In Less Than
+ * One Instruction Per Byte": every error shows up in the high nibble of
+ * a byte, the high nibble of the byte before it, or the low nibble of
+ * the byte before it, so three table lookups classify 32 byte pairs at a
+ * time. Whether the third and fourth bytes of 3 and 4 byte sequences are
+ * continuations is checked separately from the bytes two and three back.
+ */
+
+enum {
+  TOO_SHORT = 1 << 0,       // 11______ 0_______ or 11______ 11______
+  TOO_LONG = 1 << 1,        // 0_______ 10______
+  OVERLONG_3 = 1 << 2,      // 11100000 100_____
+  TOO_LARGE = 1 << 3,       // 11110100 1001____ and up
+  SURROGATE = 1 << 4,       // 11101101 101_____
+  OVERLONG_2 = 1 << 5,      // 1100000_ 10______
+  TOO_LARGE_1000 = 1 << 6,  // 11110101 1000____ and up
+  OVERLONG_4 = 1 << 6,      // 11110000 1000____
+  TWO_CONTS = 1 << 7,       // 10______ 10______
+  CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS
+};
+
+AVX2_TARGET
+static inline __m256i high_nibbles( __m256i v )
+{
+  return _mm256_and_si256( _mm256_srli_epi16( v, 4 ), _mm256_set1_epi8( 0x0F ) );
+}
+
+AVX2_TARGET
+static size_t validate_avx2( const uint8_t* src, size_t len, bool* valid )
+{
+  const __m256i byte1High = _mm256_setr_epi8(
+                              TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                              TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                              TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+                              TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+                              TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                              TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                              TOO_SHORT | OVERLONG_2, TOO_SHORT, TOO_SHORT | OVERLONG_3 | SURROGATE,
+                              TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4 );
+  const __m256i byte1Low = _mm256_setr_epi8(
+                             CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+                             CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                             CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                             CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                             CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                             CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+                             CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                             CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4, CARRY | OVERLONG_2, CARRY, CARRY,
+                             CARRY | TOO_LARGE, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                             CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                             CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                             CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000,
+                             CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+                             CARRY | TOO_LARGE | TOO_LARGE_1000, CARRY | TOO_LARGE | TOO_LARGE_1000 );
+  const int cont80 = TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4;
+  const int cont90 = TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE;
+  const int contA0 = TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE;
+  const __m256i byte2High = _mm256_setr_epi8(
+                              TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                              cont80, cont90, contA0, contA0, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                              TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                              cont80, cont90, contA0, contA0, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT );
+  // anything above these starts a sequence that does not fit
+  const __m256i maxValue = _mm256_setr_epi8( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                             -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                             char( 0xF0 - 1 ), char( 0xE0 - 1 ), char( 0xC0 - 1 ) );
+  const __m256i highBit = _mm256_set1_epi8( char( 0x80 ) );
+
+  __m256i prev = _mm256_setzero_si256();
+  __m256i prevIncomplete = _mm256_setzero_si256();
+  __m256i error = _mm256_setzero_si256();
+  size_t i = 0;
+  for( ; i + 32 <= len; i += 32 ) {
+    const __m256i input = _mm256_loadu_si256( ( const __m256i* )( src + i ) );
+    if( _mm256_testz_si256( input, highBit ) ) {
+      error = _mm256_or_si256( error, prevIncomplete );
+      prevIncomplete = _mm256_setzero_si256();
+      prev = input;
+      continue;
+    }
+    // the last bytes of prev, then input
+    const __m256i shifted = _mm256_permute2x128_si256( prev, input, 0x21 );
+    const __m256i prev1 = _mm256_alignr_epi8( input, shifted, 15 );
+    const __m256i prev2 = _mm256_alignr_epi8( input, shifted, 14 );
+    const __m256i prev3 = _mm256_alignr_epi8( input, shifted, 13 );
+
+    const __m256i special = _mm256_and_si256(
+                              _mm256_and_si256( _mm256_shuffle_epi8( byte1High, high_nibbles( prev1 ) ),
+                                                _mm256_shuffle_epi8( byte1Low, _mm256_and_si256( prev1, _mm256_set1_epi8( 0x0F ) ) ) ),
+                              _mm256_shuffle_epi8( byte2High, high_nibbles( input ) ) );
+    const __m256i third = _mm256_subs_epu8( prev2, _mm256_set1_epi8( char( 0xE0 - 0x80 ) ) );
+    const __m256i fourth = _mm256_subs_epu8( prev3, _mm256_set1_epi8( char( 0xF0 - 0x80 ) ) );
+    const __m256i must23 = _mm256_and_si256( _mm256_or_si256( third, fourth ), highBit );
+    error = _mm256_or_si256( error, _mm256_xor_si256( must23, special ) );
+
+    prevIncomplete = _mm256_subs_epu8( input, maxValue );
+    prev = input;
+  }
+  *valid = _mm256_testz_si256( error, error );
+  return i;
+}
+
+//! widens the leading ASCII of src, returns how many bytes that was
+AVX2_TARGET
+static size_t ascii_to_utf16_avx2( const uint8_t* src, size_t len, char16_t* dst )
+{
+  size_t i = 0;
+  for( ; i + 32 <= len; i += 32 ) {
+    const __m256i input = _mm256_loadu_si256( ( const __m256i* )( src + i ) );
+    // whole blocks are stored, whatever is not ASCII is overwritten later
+    _mm256_storeu_si256( ( __m256i* )( dst + i ), _mm256_cvtepu8_epi16( _mm256_castsi256_si128( input ) ) );
+    _mm256_storeu_si256( ( __m256i* )( dst + i + 16 ), _mm256_cvtepu8_epi16( _mm256_extracti128_si256( input, 1 ) ) );
+    const uint32_t mask = _mm256_movemask_epi8( input );
+    if( mask != 0 ) {
+      return i + __builtin_ctz( mask );
+    }
+  }
+  return i;
+}
+
+AVX2_TARGET
+static size_t ascii_to_utf32_avx2( const uint8_t* src, size_t len, char32_t* dst )
+{
+  size_t i = 0;
+  for( ; i + 16 <= len; i += 16 ) {
+    const __m128i input = _mm_loadu_si128( ( const __m128i* )( src + i ) );
+    _mm256_storeu_si256( ( __m256i* )( dst + i ), _mm256_cvtepu8_epi32( input ) );
+    _mm256_storeu_si256( ( __m256i* )( dst + i + 8 ), _mm256_cvtepu8_epi32( _mm_srli_si128( input, 8 ) ) );
+    const uint32_t mask = _mm_movemask_epi8( input );
+    if( mask != 0 ) {
+      return i + __builtin_ctz( mask );
+    }
+  }
+  return i;
+}
+
+//! narrows the leading UTF-16 units below 0x80, returns how many
+AVX2_TARGET
+static size_t utf16_ascii_avx2( const char16_t* src, size_t len, char* dst )
+{
+  const __m256i notAscii = _mm256_set1_epi16( short( 0xFF80 ) );
+  size_t i = 0;
+  for( ; i + 16 <= len; i += 16 ) {
+    const __m256i input = _mm256_loadu_si256( ( const __m256i* )( src + i ) );
+    const __m128i packed = _mm_packus_epi16( _mm256_castsi256_si128( input ), _mm256_extracti128_si256( input, 1 ) );
+    _mm_storeu_si128( ( __m128i* )( dst + i ), packed );
+    const __m256i ascii = _mm256_cmpeq_epi16( _mm256_and_si256( input, notAscii ), _mm256_setzero_si256() );
+    const uint32_t mask = ~uint32_t( _mm256_movemask_epi8( ascii ) );
+    if( mask != 0 ) {
+      return i + __builtin_ctz( mask ) / 2;
+    }
+  }
+  return i;
+}
+
+#endif // HAVE_X86_UTF8
+
+static size_t validate_none( const uint8_t*, size_t, bool* valid )
+{
+  *valid = true;
+  return 0;
+}
+
+static size_t ascii_to_utf16_none( const uint8_t*, size_t, char16_t* )
+{
+  return 0;
+}
+
+static size_t ascii_to_utf32_none( const uint8_t*, size_t, char32_t* )
+{
+  return 0;
+}
+
+static size_t utf16_ascii_none( const char16_t*, size_t, char* )
+{
+  return 0;
+}
+
+/**
+ * Vector kernels that do a leading part of the work and return how much
+ * of src that was; the scalar code does the rest.
+ */
+struct Kernels {
+  size_t ( *validate )( const uint8_t* src, size_t len, bool* valid );
+  size_t ( *asciiToUtf16 )( const uint8_t* src, size_t len, char16_t* dst );
+  size_t ( *asciiToUtf32 )( const uint8_t* src, size_t len, char32_t* dst );
+  size_t ( *utf16Ascii )( const char16_t* src, size_t len, char* dst );
+};
+
+static Kernels select_kernels()
+{
+  Kernels k;
+  k.validate = validate_none;
+  k.asciiToUtf16 = ascii_to_utf16_none;
+  k.asciiToUtf32 = ascii_to_utf32_none;
+  k.utf16Ascii = utf16_ascii_none;
+#if defined(HAVE_X86_UTF8)
+  if( __builtin_cpu_supports( "avx2" ) ) {
+    k.validate = validate_avx2;
+    k.asciiToUtf16 = ascii_to_utf16_avx2;
+    k.asciiToUtf32 = ascii_to_utf32_avx2;
+    k.utf16Ascii = utf16_ascii_avx2;
+  }
+#endif
+  return k;
+}
+
+static const Kernels& kernels()
+{
+  static const Kernels k = select_kernels();
+  return k;
+}
+
+} // namespace unicode_detail
+
+using namespace unicode_detail;
+
 extern "C" {
 
   static const char32_t kByteMask = 0x000000BF;
@@ -380,45 +660,8 @@ extern "C" {
 
   int utf8_length( const char* src )
   {
-    const char* cur = src;
-    size_t ret = 0;
-    while( *cur != '\0' ) {
-      const char first_char = *cur++;
-      if( ( first_char & 0x80 ) == 0 ) { // ASCII
-        ret += 1;
-        continue;
-      }
-      // (UTF-8's character must not be like 10xxxxxx,
-      //  but 110xxxxx, 1110xxxx, ... or 1111110x)
-      if( ( first_char & 0x40 ) == 0 ) {
-        return -1;
-      }
-
-      int32_t mask, to_ignore_mask;
-      size_t num_to_read = 0;
-      char32_t utf32 = 0;
-      for( num_to_read = 1, mask = 0x40, to_ignore_mask = 0x80;
-           num_to_read < 5 && ( first_char & mask );
-           num_to_read++, to_ignore_mask |= mask, mask >>= 1 ) {
-        if( ( *cur & 0xC0 ) != 0x80 ) { // must be 10xxxxxx
-          return -1;
-        }
-        // 0x3F == 00111111
-        utf32 = ( utf32 << 6 ) + ( *cur++ & 0x3F );
-      }
-      // "first_char" must be (110xxxxx - 11110xxx)
-      if( num_to_read == 5 ) {
-        return -1;
-      }
-      to_ignore_mask |= mask;
-      utf32 |= ( ( ~to_ignore_mask ) & first_char ) << ( 6 * ( num_to_read - 1 ) );
-      if( utf32 > kUnicodeMaxCodepoint ) {
-        return -1;
-      }
-
-      ret += num_to_read;
-    }
-    return ret;
+    const size_t len = strlen( src );
+    return utf8_validate( reinterpret_cast<const uint8_t*>( src ), len ) ? int( len ) : -1;
   }
 
   int utf16_to_utf8_length( const char16_t* src, size_t src_len )
@@ -593,4 +836,127 @@ extern "C" {
     *end = 0;
   }
 
+  bool utf8_validate( const uint8_t* src, size_t src_len )
+  {
+    bool valid;
+    const size_t done = kernels().validate( src, src_len, &valid );
+    if( !valid ) {
+      return false;
+    }
+    // a sequence the vector code only saw the start of is checked again
+    size_t start = done;
+    for( size_t back = 1; back <= 3 && back <= done; back++ ) {
+      const uint8_t ch = src[done - back];
+      if( ch < 0x80 ) {
+        break;
+      }
+      if( ch >= 0xC0 ) {
+        if( utf8_codepoint_len( ch ) > back ) {
+          start = done - back;
+        }
+        break;
+      }
+    }
+
+    const uint8_t* cur = src + start;
+    const uint8_t* const end = src + src_len;
+    while( cur < end ) {
+      char32_t cp;
+      const size_t len = decode_strict( cur, end, &cp );
+      if( len == 0 ) {
+        return false;
+      }
+      cur += len;
+    }
+    return true;
+  }
+
+  ssize_t utf8_to_utf16_checked( const uint8_t* src, size_t src_len, char16_t* dst )
+  {
+    const uint8_t* cur = src;
+    const uint8_t* const end = src + src_len;
+    char16_t* out = dst;
+    const Kernels& k = kernels();
+    while( cur < end ) {
+      const size_t ascii = k.asciiToUtf16( cur, end - cur, out );
+      cur += ascii;
+      out += ascii;
+      if( cur == end ) {
+        break;
+      }
+      // one code point, and any that follow it up to the next ASCII
+      do {
+        char32_t cp;
+        const size_t len = decode_strict( cur, end, &cp );
+        if( len == 0 ) {
+          return -1;
+        }
+        if( cp <= 0xFFFF ) {
+          *out++ = char16_t( cp );
+        } else {
+          cp -= 0x10000;
+          *out++ = char16_t( ( cp >> 10 ) + 0xD800 );
+          *out++ = char16_t( ( cp & 0x3FF ) + 0xDC00 );
+        }
+        cur += len;
+      } while( cur < end && *cur >= 0x80 );
+    }
+    return out - dst;
+  }
+
+  ssize_t utf8_to_utf32_checked( const uint8_t* src, size_t src_len, char32_t* dst )
+  {
+    const uint8_t* cur = src;
+    const uint8_t* const end = src + src_len;
+    char32_t* out = dst;
+    const Kernels& k = kernels();
+    while( cur < end ) {
+      const size_t ascii = k.asciiToUtf32( cur, end - cur, out );
+      cur += ascii;
+      out += ascii;
+      if( cur == end ) {
+        break;
+      }
+      do {
+        const size_t len = decode_strict( cur, end, out );
+        if( len == 0 ) {
+          return -1;
+        }
+        out++;
+        cur += len;
+      } while( cur < end && *cur >= 0x80 );
+    }
+    return out - dst;
+  }
+
+  ssize_t utf16_to_utf8_checked( const char16_t* src, size_t src_len, char* dst )
+  {
+    const char16_t* cur = src;
+    const char16_t* const end = src + src_len;
+    uint8_t* out = reinterpret_cast<uint8_t*>( dst );
+    const Kernels& k = kernels();
+    while( cur < end ) {
+      const size_t ascii = k.utf16Ascii( cur, end - cur, reinterpret_cast<char*>( out ) );
+      cur += ascii;
+      out += ascii;
+      if( cur == end ) {
+        break;
+      }
+      do {
+        char32_t cp = *cur++;
+        if( ( cp & 0xF800 ) == 0xD800 ) {
+          // a high surrogate, then a low one
+          if( cp > 0xDBFF || cur == end || ( *cur & 0xFC00 ) != 0xDC00 ) {
+            return -1;
+          }
+          cp = ( ( cp - 0xD800 ) << 10 ) + ( *cur++ - 0xDC00 ) + 0x10000;
+        }
+        const size_t len = utf32_codepoint_utf8_length( cp );
+        utf32_codepoint_to_utf8( out, cp, len );
+        out += len;
+      } while( cur < end && *cur >= 0x80 );
+    }
+    return reinterpret_cast<char*>( out ) - dst;
+  }
+
 }
\ No newline at end of file
@@ -19,7 +19,9 @@
 #include <baseline/Baseline.h>
 #include <baseline/SharedBuffer.h>
 #include <baseline/TypeHelpers.h>
+#include <baseline/Sort.h>
 #include <baseline/Vector.h>
+#include <baseline/ExecutorService.h>
 
 namespace baseline {
 
@@ -41,6 +43,14 @@ VectorImpl::VectorImpl( const VectorImpl& rhs )
   }
 }
 
+VectorImpl::VectorImpl( VectorImpl&& rhs )
+  :   mStorage( rhs.mStorage ), mCount( rhs.mCount ),
+      mFlags( rhs.mFlags ), mItemSize( rhs.mItemSize )
+{
+  rhs.mStorage = 0;
+  rhs.mCount = 0;
+}
+
 VectorImpl::~VectorImpl()
 {
   ALOGW_IF( mCount,
@@ -68,6 +78,20 @@ VectorImpl& VectorImpl::operator = ( const VectorImpl& rhs )
   return *this;
 }
 
+VectorImpl& VectorImpl::operator = ( VectorImpl&& rhs )
+{
+  LOG_ALWAYS_FATAL_IF( mItemSize != rhs.mItemSize,
+                       "Vector<> have different types (this=%p, rhs=%p)", this, &rhs );
+  if( this != &rhs ) {
+    release_storage();
+    mStorage = rhs.mStorage;
+    mCount = rhs.mCount;
+    rhs.mStorage = 0;
+    rhs.mCount = 0;
+  }
+  return *this;
+}
+
 void* VectorImpl::editArrayImpl()
 {
   if( mStorage ) {
@@ -140,6 +164,14 @@ int VectorImpl::insertAt( const void* item, size_t index, size_t numItems )
   return where ? index : ( int )NO_MEMORY;
 }
 
+void* VectorImpl::insertSpaceAt( size_t index, size_t amount )
+{
+  if( index > size() ) {
+    return 0;
+  }
+  return _grow( index, amount );
+}
+
 static int sortProxy( const void* lhs, const void* rhs, void* func )
 {
   return ( *( VectorImpl::compar_t )func )( lhs, rhs );
@@ -152,58 +184,71 @@ status_t VectorImpl::sort( VectorImpl::compar_t cmp )
 
 status_t VectorImpl::sort( VectorImpl::compar_r_t cmp, void* state )
 {
-  // the sort must be stable. we're using insertion sort which
-  // is well suited for small and already sorted arrays
-  // for big arrays, it could be better to use mergesort
-  const int count = size();
-  if( count > 1 ) {
-    void* array = const_cast<void*>( arrayImpl() );
-    void* temp = 0;
-    int i = 1;
-    while( i < count ) {
-      void* item = reinterpret_cast<char*>( array ) + mItemSize * ( i );
-      void* curr = reinterpret_cast<char*>( array ) + mItemSize * ( i - 1 );
-      if( cmp( curr, item, state ) > 0 ) {
-
-        if( !temp ) {
-          // we're going to have to modify the array...
-          array = editArrayImpl();
-          if( !array ) {
-            return NO_MEMORY;
-          }
-          temp = malloc( mItemSize );
-          if( !temp ) {
-            return NO_MEMORY;
-          }
-          item = reinterpret_cast<char*>( array ) + mItemSize * ( i );
-          curr = reinterpret_cast<char*>( array ) + mItemSize * ( i - 1 );
-        } else {
-          _do_destroy( temp, 1 );
-        }
+  return sort( cmp, state, nullptr );
+}
 
-        _do_copy( temp, item, 1 );
+status_t VectorImpl::sort( VectorImpl::compar_r_t cmp, void* state, const sp<ExecutorService>& executor )
+{
+  // the sort must be stable. we sort the item addresses with a merge sort,
+  // which leaves already sorted arrays untouched, and then move the items
+  // into a new buffer in their final order.
+  const size_t count = size();
+  if( count < 2 ) {
+    return NO_ERROR;
+  }
 
-        int j = i - 1;
-        void* next = reinterpret_cast<char*>( array ) + mItemSize * ( i );
-        do {
-          _do_destroy( next, 1 );
-          _do_copy( next, curr, 1 );
-          next = curr;
-          --j;
-          curr = reinterpret_cast<char*>( array ) + mItemSize * ( j );
-        } while( j >= 0 && ( cmp( curr, temp, state ) > 0 ) );
+  const char* array = reinterpret_cast<const char*>( arrayImpl() );
+  const size_t s = mItemSize;
+  const void** order = static_cast<const void**>( malloc( count * sizeof( void* ) ) );
+  if( !order ) {
+    return NO_MEMORY;
+  }
+  for( size_t i = 0; i < count; i++ ) {
+    order[i] = array + i * s;
+  }
 
-        _do_destroy( next, 1 );
-        _do_copy( next, temp, 1 );
-      }
-      i++;
-    }
+  status_t err = parallel_stable_sort_type( order, count, [cmp, state]( const void* lhs, const void* rhs ) {
+    return cmp( lhs, rhs, state );
+  }, executor );
+
+  size_t i = 0;
+  while( err == NO_ERROR && i < count && order[i] == array + i * s ) {
+    i++;
+  }
+  if( err != NO_ERROR || i == count ) {
+    free( order );
+    return err;
+  }
 
-    if( temp ) {
-      _do_destroy( temp, 1 );
-      free( temp );
+  SharedBuffer* sb = SharedBuffer::alloc( capacity() * s );
+  if( !sb ) {
+    free( order );
+    return NO_MEMORY;
+  }
+  char* dest = reinterpret_cast<char*>( sb->data() );
+  const bool relocate = _can_relocate();
+  i = 0;
+  while( i < count ) {
+    // items that stay adjacent are handled in one call
+    size_t n = 1;
+    while( i + n < count &&
+           order[i + n] == reinterpret_cast<const char*>( order[i] ) + n * s ) {
+      n++;
     }
+    if( relocate ) {
+      _do_relocate( dest + i * s, order[i], n );
+    } else {
+      _do_copy( dest + i * s, order[i], n );
+    }
+    i += n;
   }
+  if( relocate ) {
+    _release_relocated();
+  } else {
+    release_storage();
+  }
+  mStorage = dest;
+  free( order );
   return NO_ERROR;
 }
 
@@ -329,8 +374,13 @@ int VectorImpl::setCapacity( size_t new_capacity )
   SharedBuffer* sb = SharedBuffer::alloc( new_capacity * mItemSize );
   if( sb ) {
     void* array = sb->data();
-    _do_copy( array, mStorage, size() );
-    release_storage();
+    if( _can_relocate() ) {
+      _do_relocate( array, mStorage, size() );
+      _release_relocated();
+    } else {
+      _do_copy( array, mStorage, size() );
+      release_storage();
+    }
     mStorage = const_cast<void*>( array );
   } else {
     return NO_MEMORY;
@@ -349,6 +399,18 @@ void VectorImpl::release_storage()
   }
 }
 
+bool VectorImpl::_can_relocate() const
+{
+  // items can be moved out of the storage only if nobody else sees them
+  return mStorage && SharedBuffer::bufferFromData( mStorage )->onlyOwner();
+}
+
+void VectorImpl::_release_relocated()
+{
+  // the items have been moved out, free the storage without destroying them
+  SharedBuffer::bufferFromData( mStorage )->release();
+}
+
 void* VectorImpl::_grow( size_t where, size_t amount )
 {
 //    ALOGV("_grow(this=%p, where=%d, amount=%d) count=%d, capacity=%d",
@@ -362,10 +424,11 @@ void* VectorImpl::_grow( size_t where, size_t amount )
   if( capacity() < new_size ) {
     const size_t new_capacity = MAX( kMinVectorCapacity, ( ( new_size * 3 ) + 1 ) / 2 );
 //        ALOGV("grow vector %p, new_capacity=%d", this, (int)new_capacity);
+    const bool relocate = _can_relocate();
     if( ( mStorage ) &&
         ( mCount == where ) &&
-        ( mFlags & HAS_TRIVIAL_COPY ) &&
-        ( mFlags & HAS_TRIVIAL_DTOR ) ) {
+        ( ( ( mFlags & HAS_TRIVIAL_COPY ) && ( mFlags & HAS_TRIVIAL_DTOR ) ) ||
+          ( ( mFlags & HAS_TRIVIAL_MOVE ) && relocate ) ) ) {
       const SharedBuffer* cur_sb = SharedBuffer::bufferFromData( mStorage );
       SharedBuffer* sb = cur_sb->editResize( new_capacity * mItemSize );
       mStorage = sb->data();
@@ -373,15 +436,21 @@ void* VectorImpl::_grow( size_t where, size_t amount )
       SharedBuffer* sb = SharedBuffer::alloc( new_capacity * mItemSize );
       if( sb ) {
         void* array = sb->data();
-        if( where != 0 ) {
-          _do_copy( array, mStorage, where );
-        }
-        if( where != mCount ) {
-          const void* from = reinterpret_cast<const uint8_t*>( mStorage ) + where * mItemSize;
-          void* dest = reinterpret_cast<uint8_t*>( array ) + ( where + amount ) * mItemSize;
-          _do_copy( dest, from, mCount - where );
+        const void* from = reinterpret_cast<const uint8_t*>( mStorage ) + where * mItemSize;
+        void* dest = reinterpret_cast<uint8_t*>( array ) + ( where + amount ) * mItemSize;
+        if( relocate ) {
+          _do_relocate( array, mStorage, where );
+          _do_relocate( dest, from, mCount - where );
+          _release_relocated();
+        } else {
+          if( where != 0 ) {
+            _do_copy( array, mStorage, where );
+          }
+          if( where != mCount ) {
+            _do_copy( dest, from, mCount - where );
+          }
+          release_storage();
         }
-        release_storage();
         mStorage = const_cast<void*>( array );
       }
     }
@@ -425,15 +494,23 @@ void VectorImpl::_shrink( size_t where, size_t amount )
       SharedBuffer* sb = SharedBuffer::alloc( new_capacity * mItemSize );
       if( sb ) {
         void* array = sb->data();
-        if( where != 0 ) {
-          _do_copy( array, mStorage, where );
-        }
-        if( where != new_size ) {
-          const void* from = reinterpret_cast<const uint8_t*>( mStorage ) + ( where + amount ) * mItemSize;
-          void* dest = reinterpret_cast<uint8_t*>( array ) + where * mItemSize;
-          _do_copy( dest, from, new_size - where );
+        const void* from = reinterpret_cast<const uint8_t*>( mStorage ) + ( where + amount ) * mItemSize;
+        void* dest = reinterpret_cast<uint8_t*>( array ) + where * mItemSize;
+        if( _can_relocate() ) {
+          void* removed = reinterpret_cast<uint8_t*>( mStorage ) + where * mItemSize;
+          _do_destroy( removed, amount );
+          _do_relocate( array, mStorage, where );
+          _do_relocate( dest, from, new_size - where );
+          _release_relocated();
+        } else {
+          if( where != 0 ) {
+            _do_copy( array, mStorage, where );
+          }
+          if( where != new_size ) {
+            _do_copy( dest, from, new_size - where );
+          }
+          release_storage();
         }
-        release_storage();
         mStorage = const_cast<void*>( array );
       }
     }
@@ -492,6 +569,17 @@ void VectorImpl::_do_move_backward( void* dest, const void* from, size_t num ) c
   do_move_backward( dest, from, num );
 }
 
+void VectorImpl::_do_relocate( void* dest, const void* from, size_t num ) const
+{
+  // move items into a different buffer, leaving the source uninitialized
+  if( ( mFlags & HAS_TRIVIAL_MOVE ) ||
+      ( ( mFlags & HAS_TRIVIAL_COPY ) && ( mFlags & HAS_TRIVIAL_DTOR ) ) ) {
+    memcpy( dest, from, num * itemSize() );
+  } else if( num ) {
+    do_move_backward( dest, from, num );
+  }
+}
+
 void VectorImpl::reservedVectorImpl1() { }
 void VectorImpl::reservedVectorImpl2() { }
 void VectorImpl::reservedVectorImpl3() { }
@@ -513,6 +601,16 @@ SortedVectorImpl::SortedVectorImpl( const VectorImpl& rhs )
 {
 }
 
+SortedVectorImpl::SortedVectorImpl( const SortedVectorImpl& rhs )
+  : VectorImpl( rhs )
+{
+}
+
+SortedVectorImpl::SortedVectorImpl( VectorImpl&& rhs )
+  : VectorImpl( std::move( rhs ) )
+{
+}
+
 SortedVectorImpl::~SortedVectorImpl()
 {
 }
@@ -522,6 +620,11 @@ SortedVectorImpl& SortedVectorImpl::operator = ( const SortedVectorImpl& rhs )
   return static_cast<SortedVectorImpl&>( VectorImpl::operator = ( static_cast<const VectorImpl&>( rhs ) ) );
 }
 
+SortedVectorImpl& SortedVectorImpl::operator = ( SortedVectorImpl&& rhs )
+{
+  return static_cast<SortedVectorImpl&>( VectorImpl::operator = ( static_cast<VectorImpl&&>( rhs ) ) );
+}
+
 int SortedVectorImpl::indexOf( const void* item ) const
 {
   return _indexOrderOf( item );
@@ -576,37 +679,224 @@ int SortedVectorImpl::add( const void* item )
 
 int SortedVectorImpl::merge( const VectorImpl& vector )
 {
-  // naive merge...
-  if( !vector.isEmpty() ) {
-    const void* buffer = vector.arrayImpl();
-    const size_t is = itemSize();
-    size_t s = vector.size();
-    for( size_t i = 0 ; i < s ; i++ ) {
-      int err = add( reinterpret_cast<const char*>( buffer ) + i * is );
-      if( err < 0 ) {
-        return err;
+  return merge( vector, nullptr );
+}
+
+int SortedVectorImpl::merge( const SortedVectorImpl& vector )
+{
+  return merge( vector, nullptr );
+}
+
+int SortedVectorImpl::merge( const VectorImpl& vector, const sp<ExecutorService>& executor )
+{
+  const size_t count = vector.size();
+  if( count == 0 ) {
+    return NO_ERROR;
+  }
+
+  const char* array = reinterpret_cast<const char*>( vector.arrayImpl() );
+  const size_t s = itemSize();
+  const void** order = static_cast<const void**>( malloc( count * sizeof( void* ) ) );
+  if( !order ) {
+    return NO_MEMORY;
+  }
+  for( size_t i = 0; i < count; i++ ) {
+    order[i] = array + i * s;
+  }
+
+  status_t err = parallel_stable_sort_type( order, count, [this]( const void* lhs, const void* rhs ) {
+    return do_compare( lhs, rhs );
+  }, executor );
+
+  if( err == NO_ERROR ) {
+    // keep the last of equal items, as adding them one by one would
+    size_t n = 0;
+    for( size_t i = 0; i < count; i++ ) {
+      if( n > 0 && do_compare( order[n - 1], order[i] ) == 0 ) {
+        order[n - 1] = order[i];
+      } else {
+        order[n++] = order[i];
       }
     }
+    err = _merge( nullptr, order, n, executor );
   }
-  return NO_ERROR;
+  free( order );
+  return err;
 }
 
-int SortedVectorImpl::merge( const SortedVectorImpl& vector )
+int SortedVectorImpl::merge( const SortedVectorImpl& vector, const sp<ExecutorService>& executor )
 {
-  // we've merging a sorted vector... nice!
-  int err = NO_ERROR;
-  if( !vector.isEmpty() ) {
-    // first take care of the case where the vectors are sorted together
-    if( do_compare( vector.itemLocation( vector.size() - 1 ), arrayImpl() ) <= 0 ) {
-      err = VectorImpl::insertVectorAt( static_cast<const VectorImpl&>( vector ), 0 );
-    } else if( do_compare( vector.arrayImpl(), itemLocation( size() - 1 ) ) >= 0 ) {
-      err = VectorImpl::appendVector( static_cast<const VectorImpl&>( vector ) );
+  if( vector.isEmpty() || &vector == this ) {
+    return NO_ERROR;
+  }
+
+  // first take care of the case where the vectors are sorted together
+  int err;
+  if( isEmpty() ) {
+    err = VectorImpl::appendVector( static_cast<const VectorImpl&>( vector ) );
+  } else if( do_compare( vector.itemLocation( vector.size() - 1 ), arrayImpl() ) < 0 ) {
+    err = VectorImpl::insertVectorAt( static_cast<const VectorImpl&>( vector ), 0 );
+  } else if( do_compare( vector.arrayImpl(), itemLocation( size() - 1 ) ) > 0 ) {
+    err = VectorImpl::appendVector( static_cast<const VectorImpl&>( vector ) );
+  } else {
+    err = _merge( reinterpret_cast<const char*>( vector.arrayImpl() ), nullptr, vector.size(), executor );
+  }
+  return err < 0 ? err : NO_ERROR;
+}
+
+/*
+ * The items of this vector are merged with count items, which are either
+ * contiguous at items or pointed to by order, into a new buffer. Both
+ * sides are strictly sorted.
+ *
+ * To merge in parallel, the output is cut into pieces at co-ranks, moving
+ * a cut by one when it would separate two equal items. Each piece writes
+ * at the offset it would have without any equal items, then the pieces
+ * are slid down over the gaps left by the replaced items.
+ */
+struct SortedVectorImpl::MergeState {
+  const SortedVectorImpl* self;
+  const char* items;
+  const void* const* order;
+  char* dest;
+  bool relocate;
+  size_t splitA[sort_detail::kMaxTasks + 1];
+  size_t splitB[sort_detail::kMaxTasks + 1];
+  size_t written[sort_detail::kMaxTasks];
+
+  inline const void* at( size_t j ) const {
+    return order ? order[j] : items + j * self->itemSize();
+  }
+};
+
+void SortedVectorImpl::_mergePiece( void* state, size_t index )
+{
+  const MergeState& m = *static_cast<const MergeState*>( state );
+  const SortedVectorImpl* self = m.self;
+  const char* a = reinterpret_cast<const char*>( self->arrayImpl() );
+  const size_t s = self->itemSize();
+  size_t i = m.splitA[index];
+  size_t j = m.splitB[index];
+  const size_t iEnd = m.splitA[index + 1];
+  const size_t jEnd = m.splitB[index + 1];
+  char* const start = m.dest + ( i + j ) * s;
+  char* out = start;
+
+  // items of this vector are taken in runs, as are the others when contiguous
+  auto takeA = [&]( size_t n ) {
+    if( m.relocate ) {
+      self->_do_relocate( out, a + i * s, n );
     } else {
-      // this could be made a little better
-      err = merge( static_cast<const VectorImpl&>( vector ) );
+      self->_do_copy( out, a + i * s, n );
+    }
+    out += n * s;
+    i += n;
+  };
+  auto takeB = [&]( size_t n ) {
+    if( m.order ) {
+      for( size_t k = 0; k < n; k++ ) {
+        self->_do_copy( out + k * s, m.order[j + k], 1 );
+      }
+    } else {
+      self->_do_copy( out, m.items + j * s, n );
+    }
+    out += n * s;
+    j += n;
+  };
+
+  while( i < iEnd && j < jEnd ) {
+    int c = 0;
+    size_t n = 0;
+    while( i + n < iEnd && ( c = self->do_compare( a + ( i + n ) * s, m.at( j ) ) ) < 0 ) {
+      n++;
     }
+    takeA( n );
+    if( i == iEnd ) {
+      break;
+    }
+    if( c == 0 ) {
+      // replaced by the item from the other side
+      if( m.relocate ) {
+        self->_do_destroy( const_cast<char*>( a ) + i * s, 1 );
+      }
+      i++;
+    }
+    n = 1;
+    while( i < iEnd && j + n < jEnd && self->do_compare( a + i * s, m.at( j + n ) ) > 0 ) {
+      n++;
+    }
+    takeB( n );
   }
-  return err;
+  takeA( iEnd - i );
+  takeB( jEnd - j );
+
+  const_cast<MergeState&>( m ).written[index] = ( out - start ) / s;
+}
+
+int SortedVectorImpl::_merge( const char* items, const void* const* order, size_t count,
+                              const sp<ExecutorService>& executor )
+{
+  const size_t na = size();
+  const size_t total = na + count;
+  const size_t s = itemSize();
+  SharedBuffer* sb = SharedBuffer::alloc( total * s );
+  if( !sb ) {
+    return NO_MEMORY;
+  }
+
+  MergeState m;
+  m.self = this;
+  m.items = items;
+  m.order = order;
+  m.dest = reinterpret_cast<char*>( sb->data() );
+  m.relocate = _can_relocate();
+
+  const size_t numPieces = MAX( size_t( 1 ), MIN( MIN( sort_detail::parallelism( executor ),
+                                total / sort_detail::kParallelGrain ), size_t( sort_detail::kMaxTasks ) ) );
+  const char* a = reinterpret_cast<const char*>( arrayImpl() );
+  m.splitA[0] = m.splitB[0] = 0;
+  m.splitA[numPieces] = na;
+  m.splitB[numPieces] = count;
+  for( size_t p = 1; p < numPieces; p++ ) {
+    // co-rank of output position k, items of this vector going first
+    const size_t k = total * p / numPieces;
+    size_t lo = k > count ? k - count : 0;
+    size_t hi = MIN( k, na );
+    while( lo < hi ) {
+      const size_t mid = lo + ( hi - lo ) / 2;
+      if( do_compare( m.at( k - mid - 1 ), a + mid * s ) < 0 ) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    size_t j = k - lo;
+    if( lo > 0 && j < count && do_compare( a + ( lo - 1 ) * s, m.at( j ) ) == 0 ) {
+      j++;
+    }
+    m.splitA[p] = lo;
+    m.splitB[p] = j;
+  }
+
+  sort_detail::run_tasks( executor, numPieces, &SortedVectorImpl::_mergePiece, &m );
+
+  size_t n = 0;
+  for( size_t p = 0; p < numPieces; p++ ) {
+    const size_t start = m.splitA[p] + m.splitB[p];
+    if( start != n && m.written[p] ) {
+      _do_move_backward( m.dest + n * s, m.dest + start * s, m.written[p] );
+    }
+    n += m.written[p];
+  }
+
+  if( m.relocate ) {
+    _release_relocated();
+  } else {
+    release_storage();
+  }
+  mStorage = m.dest;
+  mCount = n;
+  return NO_ERROR;
 }
 
 int SortedVectorImpl::remove( const void* item )
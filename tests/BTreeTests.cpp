@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <baseline/Baseline.h>
+#include <baseline/BTreeMap.h>
+#include <baseline/BTreeSet.h>
+#include <baseline/String8.h>
+
+#include <map>
+#include <set>
+
+using namespace baseline;
+
+static String8 number( int value )
+{
+  char buf[32];
+  snprintf( buf, sizeof( buf ), "key-%06d", value );
+  return String8( buf );
+}
+
+template<typename TKey, typename TValue>
+static void checkSame( const BTreeMap<TKey, TValue>& map, const std::map<TKey, TValue>& expected )
+{
+  REQUIRE( map.size() == expected.size() );
+  typename BTreeMap<TKey, TValue>::Iterator it = map.begin();
+  for( typename std::map<TKey, TValue>::const_iterator e = expected.begin(); e != expected.end(); ++e ) {
+    REQUIRE( it.isValid() );
+    REQUIRE( it.key() == e->first );
+    REQUIRE( it.value() == e->second );
+    it.next();
+  }
+  REQUIRE( !it.isValid() );
+
+  it = map.last();
+  for( typename std::map<TKey, TValue>::const_reverse_iterator e = expected.rbegin(); e != expected.rend(); ++e ) {
+    REQUIRE( it.isValid() );
+    REQUIRE( it.key() == e->first );
+    it.prev();
+  }
+  REQUIRE( !it.isValid() );
+}
+
+TEST_CASE( "btree map add, find and remove", "[BTree]" )
+{
+  BTreeMap<int32_t, int> map;
+  std::map<int32_t, int> expected;
+  REQUIRE( map.isEmpty() );
+  REQUIRE( !map.find( 1 ).isValid() );
+  REQUIRE( map.removeItem( 1 ) == NAME_NOT_FOUND );
+
+  uint32_t seed = 1;
+  for( int i = 0; i < 20000; i++ ) {
+    seed = seed * 1103515245 + 12345;
+    const int32_t key = int32_t( seed >> 8 ) % 5000 - 2500;
+    REQUIRE( map.add( key, i ) == NO_ERROR );
+    expected[key] = i;
+  }
+  checkSame( map, expected );
+  for( int32_t key = -2600; key < 2600; key++ ) {
+    REQUIRE( map.hasKey( key ) == ( expected.count( key ) == 1 ) );
+  }
+  map.editValueFor( expected.begin()->first ) = -1;
+  expected.begin()->second = -1;
+  REQUIRE( map.valueFor( expected.begin()->first ) == -1 );
+
+  // remove everything, in an order unrelated to the keys
+  for( int i = 0; i < 20000; i++ ) {
+    seed = seed * 1103515245 + 12345;
+    const int32_t key = int32_t( seed >> 8 ) % 5000 - 2500;
+    REQUIRE( map.removeItem( key ) == ( expected.erase( key ) ? NO_ERROR : NAME_NOT_FOUND ) );
+    if( i % 1000 == 0 ) {
+      checkSame( map, expected );
+    }
+  }
+  for( std::map<int32_t, int>::iterator e = expected.begin(); e != expected.end(); ++e ) {
+    REQUIRE( map.removeItem( e->first ) == NO_ERROR );
+  }
+  REQUIRE( map.isEmpty() );
+  REQUIRE( !map.begin().isValid() );
+
+  // the tree grows back from nothing
+  REQUIRE( map.add( 7, 7 ) == NO_ERROR );
+  REQUIRE( map.valueFor( 7 ) == 7 );
+}
+
+TEST_CASE( "btree map with object keys", "[BTree]" )
+{
+  BTreeMap<String8, String8> map;
+  std::map<String8, String8> expected;
+  for( int i = 0; i < 3000; i++ ) {
+    const int value = ( i * 7919 ) % 3000;
+    REQUIRE( map.add( number( value ), number( i ) ) == NO_ERROR );
+    expected[number( value )] = number( i );
+  }
+  checkSame( map, expected );
+  for( int i = 0; i < 3000; i += 3 ) {
+    REQUIRE( map.removeItem( number( i ) ) == NO_ERROR );
+    expected.erase( number( i ) );
+  }
+  checkSame( map, expected );
+
+  // copies are deep, moves leave the source empty
+  BTreeMap<String8, String8> copy( map );
+  REQUIRE( copy.removeItem( number( 1 ) ) == NO_ERROR );
+  REQUIRE( map.hasKey( number( 1 ) ) );
+  BTreeMap<String8, String8> moved( std::move( map ) );
+  REQUIRE( map.isEmpty() );
+  checkSame( moved, expected );
+  map = moved;
+  checkSame( map, expected );
+}
+
+TEST_CASE( "btree range iteration", "[BTree]" )
+{
+  BTreeMap<int64_t, int64_t> map;
+  for( int64_t i = 0; i < 10000; i++ ) {
+    REQUIRE( map.add( i * 10, i ) == NO_ERROR );
+  }
+
+  // [1005, 2000) holds 1010 ... 1990
+  int64_t count = 0;
+  for( BTreeMap<int64_t, int64_t>::Iterator it = map.lowerBound( 1005 );
+       it.isValid() && it.key() < 2000; it.next() ) {
+    REQUIRE( it.key() == 1010 + count * 10 );
+    count++;
+  }
+  REQUIRE( count == 99 );
+
+  REQUIRE( map.lowerBound( 1000 ).key() == 1000 );
+  REQUIRE( map.upperBound( 1000 ).key() == 1010 );
+  REQUIRE( map.lowerBound( -5 ).key() == 0 );
+  REQUIRE( !map.lowerBound( 99991 ).isValid() );
+  REQUIRE( !map.upperBound( 99990 ).isValid() );
+}
+
+TEST_CASE( "btree bulk load", "[BTree]" )
+{
+  for( size_t n = 0; n < 3000; n = n * 3 + 1 ) {
+    Vector<key_value_pair_t<int, int> > entries;
+    std::map<int, int> expected;
+    for( size_t i = 0; i < n; i++ ) {
+      entries.add( key_value_pair_t<int, int>( int( i * 2 ), int( i ) ) );
+      expected[int( i * 2 )] = int( i );
+    }
+    BTreeMap<int, int> map;
+    map.add( -1, -1 );
+    REQUIRE( map.bulkLoad( entries ) == NO_ERROR );
+    checkSame( map, expected );
+
+    // the loaded tree takes inserts and removals like any other
+    for( size_t i = 0; i < n; i++ ) {
+      REQUIRE( map.add( int( i * 2 + 1 ), 0 ) == NO_ERROR );
+      expected[int( i * 2 + 1 )] = 0;
+    }
+    for( size_t i = 0; i < n; i += 2 ) {
+      REQUIRE( map.removeItem( int( i ) ) == NO_ERROR );
+      expected.erase( int( i ) );
+    }
+    checkSame( map, expected );
+  }
+
+  // keys must be strictly ascending
+  Vector<key_value_pair_t<int, int> > entries;
+  entries.add( key_value_pair_t<int, int>( 1, 1 ) );
+  entries.add( key_value_pair_t<int, int>( 1, 2 ) );
+  BTreeMap<int, int> map;
+  map.add( 5, 5 );
+  REQUIRE( map.bulkLoad( entries ) == BAD_VALUE );
+  REQUIRE( map.size() == 1 );
+  REQUIRE( map.valueFor( 5 ) == 5 );
+}
+
+TEST_CASE( "btree set", "[BTree]" )
+{
+  SortedVector<String8> items;
+  for( int i = 0; i < 2000; i++ ) {
+    items.add( number( i * 3 ) );
+  }
+  BTreeSet<String8> set;
+  REQUIRE( set.bulkLoad( items ) == NO_ERROR );
+  REQUIRE( set.size() == 2000 );
+  REQUIRE( set.contains( number( 300 ) ) );
+  REQUIRE( !set.contains( number( 301 ) ) );
+  REQUIRE( set.add( number( 301 ) ) == NO_ERROR );
+  REQUIRE( set.add( number( 301 ) ) == NO_ERROR );
+  REQUIRE( set.size() == 2001 );
+  REQUIRE( set.upperBound( number( 300 ) ).key() == number( 301 ) );
+  REQUIRE( set.remove( number( 300 ) ) == NO_ERROR );
+  REQUIRE( set.remove( number( 300 ) ) == NAME_NOT_FOUND );
+
+  std::set<String8> expected( items.array(), items.array() + items.size() );
+  expected.insert( number( 301 ) );
+  expected.erase( number( 300 ) );
+  BTreeSet<String8>::Iterator it = set.begin();
+  for( std::set<String8>::iterator e = expected.begin(); e != expected.end(); ++e ) {
+    REQUIRE( it.key() == *e );
+    it.next();
+  }
+  REQUIRE( !it.isValid() );
+}
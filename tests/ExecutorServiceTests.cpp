@@ -20,6 +20,9 @@
 
 #include <baseline/Baseline.h>
 #include <baseline/ExecutorService.h>
+#include <baseline/MerkleTree.h>
+#include <baseline/SharedBuffer.h>
+#include <baseline/Streams.h>
 
 using namespace baseline;
 
@@ -68,4 +71,101 @@ TEST_CASE( "repeating runs tasks", "[ExecutorService]" )
 
   REQUIRE( count == 5 );
   exe->shutdown();
-}
\ No newline at end of file
+}
+
+TEST_CASE( "merkle tree builds in parallel, updates and proves chunks", "[MerkleTree]" )
+{
+  const size_t chunkSize = 1000;
+  SharedBuffer* buf = SharedBuffer::alloc( 37 * chunkSize + 123 );
+  uint8_t* data = static_cast<uint8_t*>( buf->data() );
+  for( size_t i = 0; i < buf->size(); i++ ) {
+    data[i] = uint8_t( i * 131 >> 5 );
+  }
+  sp<ExecutorService> exe = ExecutorService::createExecutorService( String8( "merkle" ), 4 );
+
+  // every chunk count from 1 up, so that every level has an odd node
+  // somewhere
+  for( size_t len = 0; len <= buf->size(); len += len < 9000 ? 500 : 7000 ) {
+    MerkleTree serial( createSHA256, chunkSize );
+    MerkleTree parallel( createSHA256, chunkSize );
+    REQUIRE( serial.build( data, len ) == OK );
+    REQUIRE( parallel.build( data, len, exe ) == OK );
+    REQUIRE( parallel.root() == serial.root() );
+    REQUIRE( serial.chunkCount() == MAX( ( len + chunkSize - 1 ) / chunkSize, size_t( 1 ) ) );
+
+    ByteArrayInputStream in( buf, 0, len );
+    MerkleTree streamed( createSHA256, chunkSize );
+    REQUIRE( streamed.build( in, exe ) == OK );
+    REQUIRE( streamed.root() == serial.root() );
+    REQUIRE( streamed.length() == len );
+
+    Vector<uint8_t> siblings;
+    for( size_t i = 0; i < serial.chunkCount(); i++ ) {
+      const size_t chunkLen = MIN( chunkSize, len - i * chunkSize );
+      REQUIRE( serial.proof( i, siblings ) == OK );
+      REQUIRE( MerkleTree::verify( createSHA256, serial.root(), i, serial.chunkCount(), data + i * chunkSize,
+                                   chunkLen, siblings ) );
+      if( chunkLen > 0 ) {
+        data[i * chunkSize] ^= 1;
+        REQUIRE_FALSE( MerkleTree::verify( createSHA256, serial.root(), i, serial.chunkCount(),
+                                           data + i * chunkSize, chunkLen, siblings ) );
+        data[i * chunkSize] ^= 1;
+      }
+    }
+  }
+
+  MerkleTree tree( createCRC32C, chunkSize );
+  REQUIRE( tree.update( 0, data, chunkSize ) == NO_INIT );
+  REQUIRE( tree.build( data, buf->size(), exe ) == OK );
+  const HashCode before = tree.root();
+  data[20 * chunkSize + 7] ^= 0x80;
+  REQUIRE( tree.update( 20, data + 20 * chunkSize, chunkSize - 1 ) == BAD_VALUE );
+  REQUIRE( tree.update( 20, data + 20 * chunkSize, chunkSize ) == OK );
+  REQUIRE( tree.root() != before );
+  MerkleTree rebuilt( createCRC32C, chunkSize );
+  REQUIRE( rebuilt.build( data, buf->size() ) == OK );
+  REQUIRE( rebuilt.root() == tree.root() );
+  REQUIRE( tree.update( 37, data + 37 * chunkSize, 123 ) == OK );
+  REQUIRE( tree.update( 38, data, 0 ) == BAD_VALUE );
+
+  exe->shutdown();
+  buf->release();
+}
+
+TEST_CASE( "merkle tree rejects bad roots and failed reads", "[MerkleTree]" )
+{
+  class FailingInputStream : public InputStream
+  {
+  public:
+    FailingInputStream() : mReads( 0 ) {}
+    void close() {}
+    int read( uint8_t* buf, size_t off, size_t len ) {
+      if( mReads++ == 2 ) {
+        return DEAD_OBJECT;
+      }
+      len = MIN( len, size_t( 700 ) );
+      memset( &buf[off], mReads, len );
+      return len;
+    }
+    int mReads;
+  };
+
+  const size_t chunkSize = 1000;
+  const uint8_t chunk[10] = { 1, 2, 3 };
+  Vector<uint8_t> siblings;
+
+  MerkleTree tree( createSHA256, chunkSize );
+  REQUIRE( tree.root().size() == 0 );
+  REQUIRE_FALSE( MerkleTree::verify( createSHA256, tree.root(), 0, 1, chunk, sizeof( chunk ), siblings ) );
+
+  REQUIRE( tree.build( chunk, sizeof( chunk ) ) == OK );
+  REQUIRE( MerkleTree::verify( createSHA256, tree.root(), 0, 1, chunk, sizeof( chunk ), siblings ) );
+  const HashCode shortRoot( tree.root().data(), 16 );
+  REQUIRE_FALSE( MerkleTree::verify( createSHA256, shortRoot, 0, 1, chunk, sizeof( chunk ), siblings ) );
+  REQUIRE_FALSE( MerkleTree::verify( createSHA1, tree.root(), 0, 1, chunk, sizeof( chunk ), siblings ) );
+
+  FailingInputStream in;
+  REQUIRE( tree.build( in ) == DEAD_OBJECT );
+  REQUIRE( tree.root().size() == 0 );
+  REQUIRE( tree.length() == 0 );
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2018 Baseline
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <baseline/Baseline.h>
+#include <baseline/HashMap.h>
+#include <baseline/HashSet.h>
+#include <baseline/String8.h>
+#include <baseline/Unicode.h>
+#include <baseline/String16.h>
+
+#include <map>
+
+using namespace baseline;
+
+static String8 number( int value )
+{
+  char buf[32];
+  snprintf( buf, sizeof( buf ), "key-%d", value );
+  return String8( buf );
+}
+
+TEST_CASE( "hash map add, find and replace", "[HashMap]" )
+{
+  HashMap<String8, int> map;
+  REQUIRE( map.isEmpty() );
+  REQUIRE( map.indexOfKey( String8( "nothing" ) ) == NAME_NOT_FOUND );
+
+  for( int i = 0; i < 1000; i++ ) {
+    REQUIRE( map.add( number( i ), i ) >= 0 );
+  }
+  REQUIRE( map.size() == 1000 );
+  REQUIRE( map.capacity() >= 1000 );
+  for( int i = 0; i < 1000; i++ ) {
+    REQUIRE( map.valueFor( number( i ) ) == i );
+  }
+  REQUIRE( map.indexOfKey( number( 1000 ) ) == NAME_NOT_FOUND );
+
+  // adding an existing key replaces the value
+  const int index = map.indexOfKey( number( 10 ) );
+  REQUIRE( map.add( number( 10 ), -10 ) == index );
+  REQUIRE( map.size() == 1000 );
+  REQUIRE( map.valueAt( index ) == -10 );
+  map.editValueFor( number( 10 ) ) = 10;
+  REQUIRE( map.valueFor( number( 10 ) ) == 10 );
+
+  // walking through the map visits every entry once
+  int count = 0;
+  int sum = 0;
+  for( int i = map.next( -1 ); i >= 0; i = map.next( i ) ) {
+    REQUIRE( map.keyAt( i ) == number( map.valueAt( i ) ) );
+    sum += map.valueAt( i );
+    count++;
+  }
+  REQUIRE( count == 1000 );
+  REQUIRE( sum == 999 * 1000 / 2 );
+}
+
+TEST_CASE( "hash map remove", "[HashMap]" )
+{
+  HashMap<int, int> map;
+  std::map<int, int> expected;
+  uint32_t seed = 3;
+  for( int i = 0; i < 20000; i++ ) {
+    seed = seed * 1103515245 + 12345;
+    const int key = ( seed >> 8 ) % 2000;
+    if( seed & 0x10000 ) {
+      const int removed = map.removeItem( key );
+      REQUIRE( ( removed >= 0 ) == ( expected.erase( key ) == 1 ) );
+    } else {
+      REQUIRE( map.add( key, i ) >= 0 );
+      expected[key] = i;
+    }
+  }
+  REQUIRE( map.size() == expected.size() );
+  for( int key = 0; key < 2000; key++ ) {
+    const int index = map.indexOfKey( key );
+    if( expected.count( key ) ) {
+      REQUIRE( index >= 0 );
+      REQUIRE( map.valueAt( index ) == expected[key] );
+    } else {
+      REQUIRE( index == NAME_NOT_FOUND );
+    }
+  }
+
+  map.clear();
+  REQUIRE( map.isEmpty() );
+  REQUIRE( map.indexOfKey( 1 ) == NAME_NOT_FOUND );
+  REQUIRE( map.next( -1 ) == -1 );
+}
+
+TEST_CASE( "hash map copy on write", "[HashMap]" )
+{
+  HashMap<String8, String8> map;
+  for( int i = 0; i < 100; i++ ) {
+    map.add( number( i ), number( i * 2 ) );
+  }
+
+  HashMap<String8, String8> copy = map;
+  copy.add( String8( "extra" ), String8( "value" ) );
+  copy.editValueFor( number( 1 ) ) = String8( "changed" );
+  copy.removeItem( number( 2 ) );
+
+  REQUIRE( map.size() == 100 );
+  REQUIRE( map.indexOfKey( String8( "extra" ) ) == NAME_NOT_FOUND );
+  REQUIRE( map.valueFor( number( 1 ) ) == number( 2 ) );
+  REQUIRE( map.indexOfKey( number( 2 ) ) >= 0 );
+  REQUIRE( copy.size() == 100 );
+  REQUIRE( copy.valueFor( number( 1 ) ) == "changed" );
+
+  HashMap<String8, String8> moved = std::move( copy );
+  REQUIRE( copy.isEmpty() );
+  REQUIRE( moved.valueFor( String8( "extra" ) ) == "value" );
+
+  // growing a shared map leaves the other one alone
+  HashMap<String8, String8> grown = map;
+  for( int i = 100; i < 1000; i++ ) {
+    grown.add( number( i ), number( i ) );
+  }
+  REQUIRE( map.size() == 100 );
+  REQUIRE( grown.size() == 1000 );
+  REQUIRE( grown.valueFor( number( 99 ) ) == number( 198 ) );
+}
+
+TEST_CASE( "hash set", "[HashSet]" )
+{
+  HashSet<String8> set;
+  REQUIRE( set.setCapacity( 500 ) >= 500 );
+  for( int i = 0; i < 500; i++ ) {
+    REQUIRE( set.add( number( i % 250 ) ) >= 0 );
+  }
+  REQUIRE( set.size() == 250 );
+  REQUIRE( set.indexOf( number( 249 ) ) >= 0 );
+  REQUIRE( set.indexOf( number( 250 ) ) == NAME_NOT_FOUND );
+  REQUIRE( set.itemAt( set.indexOf( number( 7 ) ) ) == number( 7 ) );
+
+  for( int i = 0; i < 250; i += 2 ) {
+    REQUIRE( set.remove( number( i ) ) >= 0 );
+  }
+  REQUIRE( set.remove( number( 0 ) ) == NAME_NOT_FOUND );
+  REQUIRE( set.size() == 125 );
+
+  // deleted slots are reused
+  const size_t capacity = set.capacity();
+  for( int round = 0; round < 20; round++ ) {
+    for( int i = 0; i < 250; i += 2 ) {
+      set.add( number( i ) );
+    }
+    for( int i = 0; i < 250; i += 2 ) {
+      set.remove( number( i ) );
+    }
+  }
+  REQUIRE( set.size() == 125 );
+  REQUIRE( set.capacity() == capacity );
+}
+
+TEST_CASE( "hash map with String16 keys", "[HashMap]" )
+{
+  HashMap<String16, int> map;
+  for( int i = 0; i < 300; i++ ) {
+    map.add( String16( number( i ) ), i );
+  }
+  REQUIRE( map.size() == 300 );
+  for( int i = 0; i < 300; i++ ) {
+    REQUIRE( map.valueFor( String16( number( i ) ) ) == i );
+  }
+  REQUIRE( map.indexOfKey( String16( "key-300" ) ) == NAME_NOT_FOUND );
+}
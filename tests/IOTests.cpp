@@ -21,11 +21,23 @@
 #include <baseline/Baseline.h>
 #include <baseline/Atomic.h>
 #include <baseline/CircleBuffer.h>
+#include <baseline/DataStreams.h>
+#include <baseline/FastHash.h>
+#include <baseline/MirroredByteRing.h>
+#include <baseline/SPSCRing.h>
+#include <baseline/SortedVector.h>
 #include <baseline/Streams.h>
+#include <baseline/String8.h>
+#include <baseline/StringBuilder.h>
+#include <baseline/Unicode.h>
+#include <baseline/String16.h>
+#include <baseline/Vector.h>
 #include <baseline/SharedBuffer.h>
 #include <baseline/Hash.h>
 #include <baseline/BaseEncoding.h>
 
+#include <type_traits>
+
 using namespace baseline;
 
 TEST_CASE( "circle buffer put single", "[CircleBuffer]" )
@@ -57,6 +69,120 @@ TEST_CASE( "circle buffer put multiple", "[CircleBuffer]" )
   REQUIRE( buffer.available() == 5 - n );
 }
 
+TEST_CASE( "circle buffer bulk transfer wraps around", "[CircleBuffer]" )
+{
+  CircleBuffer<int> buffer( 5 );
+  int in[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+  int out[8];
+  REQUIRE( buffer.write( in, 3 ) == 3 );
+  REQUIRE( buffer.read( out, 2 ) == 2 );
+
+  // head is at 3, so this write fills 3, 4, 0 and 1
+  REQUIRE( buffer.write( in + 3, 8 ) == 4 );
+  REQUIRE( buffer.full() );
+  REQUIRE( buffer.read( out, 8 ) == 5 );
+  for( int i = 0; i < 5; i++ ) {
+    REQUIRE( out[i] == i + 2 );
+  }
+  REQUIRE( buffer.empty() );
+
+  CircleBuffer<String8> strings( 3 );
+  String8 strs[3] = { String8( "a" ), String8( "b" ), String8( "c" ) };
+  String8 outStrs[3];
+  REQUIRE( strings.write( strs, 2 ) == 2 );
+  REQUIRE( strings.read( outStrs, 1 ) == 1 );
+  REQUIRE( strings.write( strs, 3 ) == 2 );
+  REQUIRE( strings.read( outStrs, 3 ) == 3 );
+  REQUIRE( outStrs[0] == "b" );
+  REQUIRE( outStrs[1] == "a" );
+  REQUIRE( outStrs[2] == "b" );
+}
+
+TEST_CASE( "mirrored byte ring is contiguous across the end", "[MirroredByteRing]" )
+{
+  MirroredByteRing ring( 100 );
+  REQUIRE( ring.initCheck() == OK );
+  REQUIRE( ring.capacity() >= 100 );
+
+  const size_t capacity = ring.capacity();
+  Vector<uint8_t> data;
+  for( size_t i = 0; i < capacity; i++ ) {
+    data.add( uint8_t( i * 7 ) );
+  }
+
+  // move the tail close to the end so the next record wraps around
+  REQUIRE( ring.write( data.array(), capacity - 10 ) == capacity - 10 );
+  ring.consume( capacity - 10 );
+  REQUIRE( ring.empty() );
+
+  uint8_t* dest = ring.writePtr();
+  memcpy( dest, data.array(), 30 );
+  ring.commit( 30 );
+  REQUIRE( ring.size() == 30 );
+  REQUIRE( memcmp( ring.readPtr(), data.array(), 30 ) == 0 );
+
+  uint8_t out[30];
+  REQUIRE( ring.read( out, 5 ) == 5 );
+  REQUIRE( ring.readPtr()[0] == data[5] );
+  REQUIRE( ring.write( data.array(), capacity ) == capacity - 25 );
+  REQUIRE( ring.full() );
+  REQUIRE( ring.read( out, 30 ) == 30 );
+  REQUIRE( memcmp( out, data.array() + 5, 25 ) == 0 );
+  REQUIRE( memcmp( out + 25, data.array(), 5 ) == 0 );
+}
+
+TEST_CASE( "spsc ring wraps around", "[SPSCRing]" )
+{
+  SPSCRing<int> ring( 5 );
+  REQUIRE( ring.capacity() == 8 );
+  REQUIRE( ring.empty() );
+
+  int in[20];
+  int out[20];
+  for( int i = 0; i < 20; i++ ) {
+    in[i] = i;
+  }
+  REQUIRE( ring.write( in, 6 ) == 6 );
+  REQUIRE( ring.read( out, 4 ) == 4 );
+  REQUIRE( out[3] == 3 );
+
+  // the next write and read both wrap past the end
+  REQUIRE( ring.write( in + 6, 20 ) == 6 );
+  REQUIRE( ring.full() );
+  REQUIRE( !ring.put( 99 ) );
+  REQUIRE( ring.read( out, 20 ) == 8 );
+  for( int i = 0; i < 8; i++ ) {
+    REQUIRE( out[i] == i + 4 );
+  }
+  REQUIRE( ring.empty() );
+  int v;
+  REQUIRE( !ring.get( &v ) );
+  REQUIRE( ring.put( 42 ) );
+  REQUIRE( ring.get( &v ) );
+  REQUIRE( v == 42 );
+
+  SPSCRing<String8> strings( 2 );
+  REQUIRE( strings.put( String8( "a" ) ) );
+  REQUIRE( strings.put( String8( "b" ) ) );
+  String8 str;
+  REQUIRE( strings.get( &str ) );
+  REQUIRE( str == "a" );
+  REQUIRE( strings.put( String8( "c" ) ) );
+  String8 strs[2];
+  REQUIRE( strings.read( strs, 2 ) == 2 );
+  REQUIRE( strs[0] == "b" );
+  REQUIRE( strs[1] == "c" );
+
+  // reading moves a string out, so the ring holds no reference to it
+  {
+    const String8 big( "a string too long to be kept inline" );
+    REQUIRE( strings.put( big ) );
+  }
+  REQUIRE( strings.get( &str ) );
+  REQUIRE( str == "a string too long to be kept inline" );
+  REQUIRE( str.sharedBuffer()->onlyOwner() );
+}
+
 TEST_CASE( "atomic inc", "[Atomic]" )
 {
   int32_t value = 0;
@@ -123,6 +249,40 @@ TEST_CASE( "ByteArrayInputStream outputs correct data", "[ByteArrayInputStream]"
   buf->release();
 }
 
+#ifdef BASELINE_THREAD_SUPPORT
+TEST_CASE( "non-blocking pipe reports full, empty and closed", "[Pipe]" )
+{
+  UniquePtr<OutputStream> out;
+  UniquePtr<InputStream> in;
+  REQUIRE( createPipe( 0, out, in ) == BAD_VALUE );
+  REQUIRE( createPipe( 6, out, in, false ) == OK );
+
+  uint8_t buf[16];
+  for( int i = 0; i < 16; i++ ) {
+    buf[i] = uint8_t( i );
+  }
+  REQUIRE( in->read( buf, 0, 16 ) == 0 );
+  REQUIRE( out->write( buf, 0, 10 ) == 8 );
+  REQUIRE( out->write( buf, 0, 1 ) == WOULD_BLOCK );
+
+  uint8_t dest[16];
+  REQUIRE( in->read( dest, 0, 5 ) == 5 );
+  REQUIRE( out->write( buf, 8, 4 ) == 4 );
+  out->close();
+  REQUIRE( in->read( dest, 5, 11 ) == 7 );
+  for( int i = 0; i < 12; i++ ) {
+    REQUIRE( dest[i] == i );
+  }
+  REQUIRE( in->read( dest, 0, 16 ) == -1 );
+  in->close();
+
+  REQUIRE( createPipe( 8, out, in, false ) == OK );
+  in->close();
+  REQUIRE( out->write( buf, 0, 1 ) == DEAD_OBJECT );
+  out->close();
+}
+#endif
+
 TEST_CASE( "hex encoding works", "[HexEncoding]" )
 {
   uint8_t data[] {
@@ -138,6 +298,360 @@ TEST_CASE( "hex encoding works", "[HexEncoding]" )
 
 }
 
+TEST_CASE( "hex decoding round trips and rejects bad input", "[HexEncoding]" )
+{
+  BaseEncoding& hex = hexEncoding();
+  uint8_t data[200];
+  for( size_t i = 0; i < sizeof( data ); i++ ) {
+    data[i] = uint8_t( i * 167 + 13 );
+  }
+
+  // every length around the 16 and 32 byte vector widths
+  for( size_t len = 0; len <= sizeof( data ); len++ ) {
+    String8 str = hex.encode( data, len );
+    REQUIRE( str.length() == 2 * len );
+    SharedBuffer* decoded = hex.decode( str );
+    REQUIRE( decoded != nullptr );
+    REQUIRE( decoded->size() == len );
+    REQUIRE( memcmp( decoded->data(), data, len ) == 0 );
+    decoded->release();
+
+    str.toUpper();
+    decoded = hex.decode( str );
+    REQUIRE( decoded != nullptr );
+    REQUIRE( memcmp( decoded->data(), data, len ) == 0 );
+    decoded->release();
+  }
+
+  String8 str = hex.encode( data, 100 );
+  const char bad[] = { 'g', 'G', '/', ':', '@', '`', ' ', '\x80' };
+  for( size_t i = 0; i < str.length(); i += 7 ) {
+    for( size_t b = 0; b < sizeof( bad ); b++ ) {
+      String8 corrupt( str );
+      corrupt.lockBuffer( corrupt.length() )[i] = bad[b];
+      corrupt.unlockBuffer();
+      REQUIRE( hex.decode( corrupt ) == nullptr );
+    }
+  }
+  REQUIRE( hex.decode( String8( "abc" ) ) == nullptr );
+}
+
+static String8 decodeToString( BaseEncoding& encoding, const char* text )
+{
+  SharedBuffer* decoded = encoding.decode( String8( text ) );
+  if( decoded == nullptr ) {
+    return String8( "(invalid)" );
+  }
+  String8 str( static_cast<const char*>( decoded->data() ), decoded->size() );
+  decoded->release();
+  return str;
+}
+
+TEST_CASE( "base64 and base32 match RFC 4648", "[BaseEncoding]" )
+{
+  const char* input[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+  const char* base64[] = { "", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy" };
+  const char* base32[] = { "", "MY======", "MZXQ====", "MZXW6===", "MZXW6YQ=", "MZXW6YTB", "MZXW6YTBOI======" };
+
+  for( size_t i = 0; i < sizeof( input ) / sizeof( input[0] ); i++ ) {
+    const size_t len = strlen( input[i] );
+    REQUIRE( base64Encoding().encode( input[i], len ) == base64[i] );
+    REQUIRE( base32Encoding().encode( input[i], len ) == base32[i] );
+    REQUIRE( decodeToString( base64Encoding(), base64[i] ) == input[i] );
+    REQUIRE( decodeToString( base32Encoding(), base32[i] ) == input[i] );
+  }
+
+  REQUIRE( base64UrlEncoding().encode( "\xfb\xff\xbf", 3 ) == "-_-_" );
+  REQUIRE( base64Encoding().encode( "\xfb\xff\xbf", 3 ) == "+/+/" );
+  REQUIRE( base64UrlEncoding().encode( "foob", 4 ) == "Zm9vYg" );
+
+  // padding is optional when decoding, base32 is case insensitive
+  REQUIRE( decodeToString( base64Encoding(), "Zm9vYg" ) == "foob" );
+  REQUIRE( decodeToString( base64UrlEncoding(), "Zm9vYg==" ) == "foob" );
+  REQUIRE( decodeToString( base32Encoding(), "mzxw6yq" ) == "foob" );
+
+  REQUIRE( decodeToString( base64Encoding(), "Zm9vY" ) == "(invalid)" );
+  REQUIRE( decodeToString( base64Encoding(), "Zm9v-_-_" ) == "(invalid)" );
+  REQUIRE( decodeToString( base64UrlEncoding(), "Zm9v+/+/" ) == "(invalid)" );
+  REQUIRE( decodeToString( base64Encoding(), "Zg=A" ) == "(invalid)" );
+  REQUIRE( decodeToString( base32Encoding(), "MZXW6YQ1" ) == "(invalid)" );
+  REQUIRE( decodeToString( base32Encoding(), "MZX" ) == "(invalid)" );
+}
+
+TEST_CASE( "base encodings round trip at every length", "[BaseEncoding]" )
+{
+  BaseEncoding* encodings[] = { &hexEncoding(), &base64Encoding(), &base64UrlEncoding(), &base32Encoding() };
+  uint8_t data[300];
+  for( size_t i = 0; i < sizeof( data ); i++ ) {
+    data[i] = uint8_t( i * 167 + 13 );
+  }
+
+  for( size_t e = 0; e < sizeof( encodings ) / sizeof( encodings[0] ); e++ ) {
+    BaseEncoding& encoding = *encodings[e];
+    for( size_t len = 0; len <= sizeof( data ); len++ ) {
+      String8 str = encoding.encode( data, len );
+      REQUIRE( str.length() == encoding.encodedLength( len ) );
+      SharedBuffer* decoded = encoding.decode( str );
+      REQUIRE( decoded != nullptr );
+      REQUIRE( decoded->size() == len );
+      REQUIRE( memcmp( decoded->data(), data, len ) == 0 );
+      decoded->release();
+    }
+
+    // a bad character anywhere, including where the vector code reads it
+    String8 str = encoding.encode( data, 240 );
+    for( size_t i = 0; i < str.length(); i += 5 ) {
+      String8 corrupt( str );
+      corrupt.lockBuffer( corrupt.length() )[i] = '*';
+      corrupt.unlockBuffer();
+      REQUIRE( encoding.decode( corrupt ) == nullptr );
+    }
+  }
+}
+
+//! collects what is written to it, close() does not throw it away
+class StringOutputStream : public OutputStream
+{
+public:
+  void close() {}
+  int write( uint8_t* buf, size_t off, size_t len ) {
+    mString.append( reinterpret_cast<const char*>( &buf[off] ), len );
+    return len;
+  }
+
+  String8 mString;
+};
+
+TEST_CASE( "encoding streams round trip", "[BaseEncoding]" )
+{
+  BaseEncoding* encodings[] = { &hexEncoding(), &base64Encoding(), &base64UrlEncoding(), &base32Encoding() };
+  const size_t len = 10007;
+  SharedBuffer* buf = SharedBuffer::alloc( len );
+  uint8_t* data = static_cast<uint8_t*>( buf->data() );
+  for( size_t i = 0; i < len; i++ ) {
+    data[i] = uint8_t( i * 31 + ( i >> 7 ) );
+  }
+
+  for( size_t e = 0; e < sizeof( encodings ) / sizeof( encodings[0] ); e++ ) {
+    BaseEncoding& encoding = *encodings[e];
+
+    // odd sized writes leave partial groups between them
+    StringOutputStream text;
+    EncodingOutputStream encoder( text, encoding );
+    for( size_t off = 0, n = 1; off < len; off += n, n = n * 3 % 1777 + 1 ) {
+      const size_t chunk = MIN( n, len - off );
+      REQUIRE( encoder.write( data, off, chunk ) == int( chunk ) );
+      n = chunk;
+    }
+    encoder.close();
+    REQUIRE( text.mString == encoding.encode( data, len ) );
+
+    SharedBuffer* textBuf = SharedBuffer::alloc( text.mString.length() );
+    memcpy( textBuf->data(), text.mString.string(), text.mString.length() );
+    ByteArrayInputStream textIn( textBuf, 0, textBuf->size() );
+    DecodingInputStream decoder( textIn, encoding );
+    ByteArrayOutputStream bytes;
+    pump( decoder, bytes, nullptr, false, true );
+    REQUIRE( bytes.size() == len );
+    REQUIRE( memcmp( bytes.toSharedBuffer(), data, len ) == 0 );
+    bytes.close();
+    textBuf->release();
+  }
+  buf->release();
+
+  const char bad[] = "Zm9vYmFy*m9v";
+  SharedBuffer* badBuf = SharedBuffer::alloc( sizeof( bad ) - 1 );
+  memcpy( badBuf->data(), bad, badBuf->size() );
+  ByteArrayInputStream badIn( badBuf, 0, badBuf->size() );
+  DecodingInputStream decoder( badIn, base64Encoding() );
+  uint8_t out[16];
+  REQUIRE( decoder.read( out, 0, sizeof( out ) ) == BAD_VALUE );
+  decoder.close();
+  badBuf->release();
+}
+
+//! hands out what it holds a few bytes at a time
+class TrickleInputStream : public InputStream
+{
+public:
+  TrickleInputStream( const uint8_t* data, size_t len )
+    : mData( data ), mLen( len ), mPos( 0 ) {}
+
+  void close() {}
+  int read( uint8_t* buf, size_t off, size_t len ) {
+    if( mPos == mLen ) {
+      return -1;
+    }
+    const size_t n = MIN( MIN( len, mLen - mPos ), size_t( 3 ) );
+    memcpy( &buf[off], &mData[mPos], n );
+    mPos += n;
+    return n;
+  }
+
+private:
+  const uint8_t* mData;
+  size_t mLen;
+  size_t mPos;
+};
+
+TEST_CASE( "data streams use the documented encodings", "[DataStreams]" )
+{
+  StringOutputStream sink;
+  DataOutputStream out( sink, 16 );
+  REQUIRE( out.writeLE<uint32_t>( 0x01020304 ) == OK );
+  REQUIRE( out.writeBE<uint16_t>( 0x0506 ) == OK );
+  REQUIRE( out.writeVarint( 0 ) == OK );
+  REQUIRE( out.writeVarint( 300 ) == OK );
+  REQUIRE( out.writeZigzag( -1 ) == OK );
+  REQUIRE( out.writeZigzag( 1 ) == OK );
+  REQUIRE( out.writeZigzag( -64 ) == OK );
+  REQUIRE( out.writeString( String8( "hi" ) ) == OK );
+  REQUIRE( out.count() == 15 );
+  REQUIRE( out.flush() == OK );
+
+  const uint8_t expected[] = { 4, 3, 2, 1, 5, 6, 0, 0xAC, 0x02, 1, 2, 0x7F, 2, 'h', 'i' };
+  REQUIRE( sink.mString.length() == sizeof( expected ) );
+  REQUIRE( memcmp( sink.mString.string(), expected, sizeof( expected ) ) == 0 );
+}
+
+TEST_CASE( "data streams round trip through small reads", "[DataStreams]" )
+{
+  StringOutputStream sink;
+  DataOutputStream out( sink, 32 );
+  Vector<int32_t> ints;
+  Vector<double> doubles;
+  for( int i = 0; i < 1000; i++ ) {
+    ints.add( i * 7919 - 500000 );
+    doubles.add( i / 3.0 );
+  }
+  SharedBuffer* blob = SharedBuffer::alloc( 100 );
+  memset( blob->data(), 0x5A, blob->size() );
+
+  for( int shift = 0; shift < 64; shift++ ) {
+    REQUIRE( out.writeVarint( uint64_t( 1 ) << shift ) == OK );
+    REQUIRE( out.writeZigzag( int64_t( 0 - ( uint64_t( 1 ) << shift ) ) ) == OK );
+  }
+  REQUIRE( out.writeVarint( UINT64_MAX ) == OK );
+  REQUIRE( out.writeZigzag( INT64_MIN ) == OK );
+  REQUIRE( out.writeBE<uint64_t>( 0x0102030405060708ull ) == OK );
+  REQUIRE( out.writeLE<int16_t>( -2 ) == OK );
+  REQUIRE( out.writeBE( 2.5f ) == OK );
+  REQUIRE( out.writeLE( -1.25 ) == OK );
+  REQUIRE( out.writeString( String8() ) == OK );
+  REQUIRE( out.writeString( String8( "a longer string than the buffer holds" ) ) == OK );
+  REQUIRE( out.writeBuffer( blob ) == OK );
+  REQUIRE( out.writeArray( ints ) == OK );
+  REQUIRE( out.writeArray( doubles ) == OK );
+  out.close();
+
+  TrickleInputStream source( reinterpret_cast<const uint8_t*>( sink.mString.string() ), sink.mString.length() );
+  DataInputStream in( source, 24 );
+  uint64_t u;
+  int64_t s;
+  for( int shift = 0; shift < 64; shift++ ) {
+    REQUIRE( in.readVarint( &u ) == OK );
+    REQUIRE( u == uint64_t( 1 ) << shift );
+    REQUIRE( in.readZigzag( &s ) == OK );
+    REQUIRE( s == int64_t( 0 - ( uint64_t( 1 ) << shift ) ) );
+  }
+  REQUIRE( in.readVarint( &u ) == OK );
+  REQUIRE( u == UINT64_MAX );
+  REQUIRE( in.readZigzag( &s ) == OK );
+  REQUIRE( s == INT64_MIN );
+  REQUIRE( in.readBE( &u ) == OK );
+  REQUIRE( u == 0x0102030405060708ull );
+  int16_t i16;
+  REQUIRE( in.readLE( &i16 ) == OK );
+  REQUIRE( i16 == -2 );
+  float f;
+  REQUIRE( in.readBE( &f ) == OK );
+  REQUIRE( f == 2.5f );
+  double d;
+  REQUIRE( in.readLE( &d ) == OK );
+  REQUIRE( d == -1.25 );
+  String8 str( "not empty" );
+  REQUIRE( in.readString( &str ) == OK );
+  REQUIRE( str.length() == 0 );
+  REQUIRE( in.readString( &str ) == OK );
+  REQUIRE( str == "a longer string than the buffer holds" );
+  SharedBuffer* readBlob = nullptr;
+  REQUIRE( in.readBuffer( &readBlob ) == OK );
+  REQUIRE( readBlob->size() == blob->size() );
+  REQUIRE( memcmp( readBlob->data(), blob->data(), blob->size() ) == 0 );
+  readBlob->release();
+  Vector<int32_t> readInts;
+  REQUIRE( in.readArray( &readInts ) == OK );
+  REQUIRE( readInts.size() == ints.size() );
+  REQUIRE( memcmp( readInts.array(), ints.array(), ints.size() * sizeof( int32_t ) ) == 0 );
+  Vector<double> readDoubles;
+  REQUIRE( in.readArray( &readDoubles ) == OK );
+  REQUIRE( readDoubles.size() == doubles.size() );
+  REQUIRE( readDoubles[999] == doubles[999] );
+
+  uint8_t byte;
+  REQUIRE( in.readLE( &byte ) == NOT_ENOUGH_DATA );
+  REQUIRE( in.read( &byte, 0, 1 ) == -1 );
+  blob->release();
+}
+
+TEST_CASE( "data streams reject truncated and overlong input", "[DataStreams]" )
+{
+  const uint8_t overlong[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02, 0, 0, 0, 0, 0, 0 };
+  TrickleInputStream source1( overlong, sizeof( overlong ) );
+  DataInputStream in1( source1 );
+  uint64_t u;
+  REQUIRE( in1.readVarint( &u ) == BAD_VALUE );
+
+  const uint8_t truncated[] = { 5, 'a', 'b' };
+  TrickleInputStream source2( truncated, sizeof( truncated ) );
+  DataInputStream in2( source2 );
+  String8 str( "kept" );
+  REQUIRE( in2.readString( &str ) == NOT_ENOUGH_DATA );
+  REQUIRE( str == "kept" );
+
+  const uint8_t partial[] = { 0x80, 0x80 };
+  TrickleInputStream source3( partial, sizeof( partial ) );
+  DataInputStream in3( source3 );
+  REQUIRE( in3.readVarint( &u ) == NOT_ENOUGH_DATA );
+}
+
+TEST_CASE( "data streams reject huge counts without allocating them", "[DataStreams]" )
+{
+  // each too large to allocate as bytes, as uint32_t's, or neither
+  const uint64_t counts[] = { SIZE_MAX - 9, SIZE_MAX / 2, uint64_t( 1 ) << 40 };
+  for( size_t i = 0; i < 3; i++ ) {
+    StringOutputStream sink;
+    DataOutputStream out( sink );
+    for( int field = 0; field < 3; field++ ) {
+      REQUIRE( out.writeVarint( counts[i] ) == OK );
+      REQUIRE( out.writeBytes( "abc", 3 ) == OK );
+    }
+    REQUIRE( out.flush() == OK );
+    const uint8_t* data = reinterpret_cast<const uint8_t*>( sink.mString.string() );
+    const size_t fieldSize = sink.mString.length() / 3;
+    const status_t expected = i < 1 ? BAD_VALUE : NOT_ENOUGH_DATA;
+
+    TrickleInputStream source1( data, fieldSize );
+    DataInputStream in1( source1 );
+    String8 str( "kept" );
+    REQUIRE( in1.readString( &str ) == expected );
+    REQUIRE( str == "kept" );
+
+    TrickleInputStream source2( data, fieldSize );
+    DataInputStream in2( source2 );
+    SharedBuffer* buf = nullptr;
+    REQUIRE( in2.readBuffer( &buf ) == expected );
+    REQUIRE( buf == nullptr );
+
+    TrickleInputStream source3( data, fieldSize );
+    DataInputStream in3( source3 );
+    Vector<uint32_t> array;
+    const status_t arrayExpected = i < 2 ? BAD_VALUE : NOT_ENOUGH_DATA;
+    REQUIRE( in3.readArray( &array ) == arrayExpected );
+    REQUIRE( array.size() == 0 );
+  }
+}
+
 struct IntT : public Comparable<IntT> {
   int compare( const IntT& rhs ) const {
     return mValue - rhs.mValue;
@@ -181,6 +695,376 @@ TEST_CASE( "string compare works", "[String8]" )
 
 }
 
+//! appends cp as UTF-8, including forms that are not allowed
+static void appendUtf8( String8& str, uint32_t cp, size_t len )
+{
+  char buf[4];
+  static const uint8_t leads[] = { 0, 0, 0xC0, 0xE0, 0xF0 };
+  for( size_t i = len - 1; i > 0; i-- ) {
+    buf[i] = char( 0x80 | ( cp & 0x3F ) );
+    cp >>= 6;
+  }
+  buf[0] = char( leads[len] | cp );
+  str.append( buf, len );
+}
+
+TEST_CASE( "utf8 validation finds every kind of error at every offset", "[Unicode]" )
+{
+  static const struct {
+    const char* bytes;
+    bool valid;
+  } cases[] = {
+    { "\xC3\xA9", true },                 // U+00E9
+    { "\xE2\x82\xAC", true },             // U+20AC
+    { "\xF0\x9F\x98\x80", true },         // U+1F600
+    { "\xEF\xBF\xBF", true },             // U+FFFF
+    { "\xF4\x8F\xBF\xBF", true },         // U+10FFFF
+    { "\x80", false },                    // stray continuation
+    { "\xC3", false },                    // truncated
+    { "\xE2\x82", false },
+    { "\xF0\x9F\x98", false },
+    { "\xC3\x41", false },                // continuation missing
+    { "\xC0\xAF", false },                // overlong '/'
+    { "\xC1\xBF", false },
+    { "\xE0\x9F\xBF", false },            // overlong U+07FF
+    { "\xF0\x8F\xBF\xBF", false },        // overlong U+FFFF
+    { "\xED\xA0\x80", false },            // U+D800
+    { "\xED\xBF\xBF", false },            // U+DFFF
+    { "\xF4\x90\x80\x80", false },        // U+110000
+    { "\xF5\x80\x80\x80", false },
+    { "\xF8\x88\x80\x80\x80", false },
+    { "\xFF", false },
+    { "\xC3\xA9\xA9", false },            // one continuation too many
+  };
+
+  for( size_t c = 0; c < sizeof( cases ) / sizeof( cases[0] ); c++ ) {
+    // around the 32 byte blocks, after ASCII and after multibyte text
+    for( size_t offset = 0; offset < 70; offset++ ) {
+      for( int multibyte = 0; multibyte < 2; multibyte++ ) {
+        String8 str;
+        for( size_t i = 0; i < offset; ) {
+          if( multibyte && i + 2 <= offset ) {
+            str.append( "\xC3\xA9" );
+            i += 2;
+          } else {
+            str.append( "a" );
+            i++;
+          }
+        }
+        str.append( cases[c].bytes );
+        const size_t end = str.length();
+        INFO( "case " << c << " at " << offset );
+        REQUIRE( utf8_validate( ( const uint8_t* )str.string(), end ) == cases[c].valid );
+        str.append( "tail that is long enough for another block" );
+        REQUIRE( utf8_validate( ( const uint8_t* )str.string(), str.length() ) == cases[c].valid );
+
+        Vector<char16_t> utf16;
+        utf16.insertAt( char16_t( 0 ), 0, str.length() );
+        REQUIRE( ( utf8_to_utf16_checked( ( const uint8_t* )str.string(), str.length(), utf16.editArray() ) >= 0 ) ==
+                 cases[c].valid );
+      }
+    }
+  }
+
+  REQUIRE( utf8_length( "caf\xC3\xA9" ) == 5 );
+  REQUIRE( utf8_length( "caf\xC3" ) == -1 );
+
+  // every code point, encoded at every length
+  for( uint32_t cp = 0; cp <= 0x10FFFF + 1; cp += ( cp < 0x11000 ? 1 : 61 ) ) {
+    for( size_t len = 1; len <= 4; len++ ) {
+      if( cp >= ( len == 1 ? 0x80u : 1u << ( 5 * len + 1 ) ) ) {
+        continue;
+      }
+      const size_t shortest = cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+      const bool valid = len == shortest && ( cp < 0xD800 || cp > 0xDFFF ) && cp <= 0x10FFFF;
+      String8 str( "0123456789012345678901234567890" );
+      appendUtf8( str, cp, len );
+      if( utf8_validate( ( const uint8_t* )str.string(), str.length() ) != valid ) {
+        FAIL( "U+" << std::hex << cp << " in " << len << " bytes" );
+      }
+    }
+  }
+}
+
+TEST_CASE( "strings convert between UTF-8 and UTF-16 in one pass", "[Unicode]" )
+{
+  static const char* pieces[] = { "plain ASCII text, ", "caf\xC3\xA9 ", "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E",
+                                  "\xF0\x9F\x98\x80", "x"
+                                };
+  String8 str;
+  for( int i = 0; i < 200; i++ ) {
+    str.append( pieces[( i * 7 ) % 5] );
+
+    const String16 utf16( str );
+    const String8 back( utf16 );
+    REQUIRE( back == str );
+
+    Vector<char32_t> utf32;
+    utf32.insertAt( char32_t( 0 ), 0, str.length() );
+    const ssize_t count = utf8_to_utf32_checked( ( const uint8_t* )str.string(), str.length(), utf32.editArray() );
+    REQUIRE( count == ssize_t( utf8_to_utf32_length( str.string(), str.length() ) ) );
+    REQUIRE( String8( utf32.array(), count ) == str );
+  }
+
+  // an unpaired surrogate is an error for the checked conversion
+  const char16_t lone[] = { 'a', 0xD83D, 'b' };
+  char out[3 * 3];
+  REQUIRE( utf16_to_utf8_checked( lone, 3, out ) == -1 );
+  REQUIRE( utf16_to_utf8_checked( lone + 1, 1, out ) == -1 );
+  const char16_t pair[] = { 0xD83D, 0xDE00 };
+  REQUIRE( utf16_to_utf8_checked( pair, 2, out ) == 4 );
+  REQUIRE( memcmp( out, "\xF0\x9F\x98\x80", 4 ) == 0 );
+}
+
+TEST_CASE( "short strings are stored inline", "[String8]" )
+{
+  REQUIRE( sizeof( String8 ) == String8::kInlineCapacity + 1 );
+  const char* text = "abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+  for( size_t len = 0; len < 60; len++ ) {
+    String8 str( text, len );
+    REQUIRE( str.length() == len );
+    REQUIRE( strlen( str.string() ) == len );
+    REQUIRE( memcmp( str.string(), text, len ) == 0 );
+    REQUIRE( ( str.sharedBuffer() == nullptr ) == ( len <= String8::kInlineCapacity ) );
+
+    String8 copy( str );
+    REQUIRE( copy == str );
+    String8 moved( std::move( copy ) );
+    REQUIRE( moved == str );
+    REQUIRE( copy.length() == 0 );
+
+    // growing one piece at a time crosses into a buffer
+    String8 built;
+    for( size_t i = 0; i < len; i++ ) {
+      built.append( &text[i], 1 );
+    }
+    REQUIRE( built == str );
+
+    // appending a string to itself
+    String8 twice( str );
+    twice.append( twice.string(), twice.length() );
+    REQUIRE( twice.length() == 2 * len );
+    REQUIRE( memcmp( twice.string() + len, text, len ) == 0 );
+
+    // setting a string to part of itself
+    String8 tail( str );
+    if( len > 0 ) {
+      tail.setTo( tail.string() + 1, len - 1 );
+      REQUIRE( tail == String8( text + 1, len - 1 ) );
+    }
+
+    // lockBuffer() keeps what was there, up to the new size
+    for( size_t size = 0; size < 40; size += 7 ) {
+      String8 locked( str );
+      char* buf = locked.lockBuffer( size );
+      REQUIRE( buf != nullptr );
+      REQUIRE( memcmp( buf, text, MIN( len, size ) ) == 0 );
+      memset( buf, 'x', size );
+      locked.unlockBuffer( size );
+      REQUIRE( locked.length() == size );
+      REQUIRE( strlen( locked.string() ) == size );
+      REQUIRE( str == String8( text, len ) );
+    }
+
+    // unlockBuffer() past the inline space moves the string to a buffer
+    String8 unlocked( str );
+    REQUIRE( unlocked.unlockBuffer( len + 30 ) == NO_ERROR );
+    REQUIRE( unlocked.length() == len + 30 );
+    REQUIRE( unlocked.string()[len + 30] == '\0' );
+    REQUIRE( memcmp( unlocked.string(), text, len ) == 0 );
+    REQUIRE( str == String8( text, len ) );
+
+    // so are short strings converted from UTF-16 and UTF-32
+    const String16 utf16( str );
+    const String8 fromUtf16( utf16 );
+    REQUIRE( fromUtf16 == str );
+    REQUIRE( ( fromUtf16.sharedBuffer() == nullptr ) == ( len <= String8::kInlineCapacity ) );
+  }
+
+  const String8 fromUtf16( u"caf\u00e9 \u65e5\u672c \U0001F600" );
+  REQUIRE( fromUtf16 == "caf\xC3\xA9 \xE6\x97\xA5\xE6\x9C\xAC \xF0\x9F\x98\x80" );
+  REQUIRE( fromUtf16.sharedBuffer() == nullptr );
+  const String8 fromUtf32( U"caf\u00e9 \u65e5\u672c \U0001F600" );
+  REQUIRE( fromUtf32 == fromUtf16 );
+  REQUIRE( fromUtf32.sharedBuffer() == nullptr );
+  String8 longer( U"\u65e5\u672c\u65e5\u672c\u65e5\u672c\u65e5\u672c" );
+  REQUIRE( longer.length() == 24 );
+  REQUIRE( longer.sharedBuffer() != nullptr );
+  longer.setTo( u"abc", 3 );
+  REQUIRE( longer == "abc" );
+  REQUIRE( longer.sharedBuffer() == nullptr );
+
+  // vectors move strings around with memcpy()
+  Vector<String8> strings;
+  for( size_t i = 0; i < 100; i++ ) {
+    strings.insertAt( String8( text, i % 50 ), 0 );
+  }
+  for( size_t i = 0; i < 100; i++ ) {
+    REQUIRE( strings[99 - i] == String8( text, i % 50 ) );
+  }
+}
+
+TEST_CASE( "appendFormat can be called repeatedly", "[String8]" )
+{
+  String8 formatted;
+  REQUIRE( formatted.appendFormat( "%s-%d", "tag", 7 ) == NO_ERROR );
+  REQUIRE( formatted == "tag-7" );
+  REQUIRE( formatted.appendFormat( " and a much longer %s", "suffix that spills over" ) == NO_ERROR );
+  REQUIRE( formatted == "tag-7 and a much longer suffix that spills over" );
+  REQUIRE( String8::format( "%d/%s", 42, "x" ) == "42/x" );
+  REQUIRE( String8::format( "%s %s %s %s %s %s %s %d", "a", "b", "c", "d", "e", "f", "g", 8 ) ==
+           "a b c d e f g 8" );
+
+  // a format vsnprintf fails on leaves the string alone
+  REQUIRE( formatted.appendFormat( "%ls", L"\u00e9" ) == BAD_VALUE );
+  REQUIRE( formatted == "tag-7 and a much longer suffix that spills over" );
+}
+
+TEST_CASE( "string builder grows geometrically", "[StringBuilder]" )
+{
+  StringBuilder builder;
+  REQUIRE( builder.isEmpty() );
+  REQUIRE( strcmp( builder.string(), "" ) == 0 );
+
+  bool appended = true;
+  size_t growths = 0;
+  size_t capacity = builder.capacity();
+  for( size_t i = 0; i < 1000000; i++ ) {
+    appended = appended && builder.append( char( 'a' + i % 26 ) ) == NO_ERROR;
+    if( builder.capacity() != capacity ) {
+      growths++;
+      capacity = builder.capacity();
+    }
+  }
+  REQUIRE( appended );
+  REQUIRE( growths < 40 );
+  REQUIRE( builder.length() == 1000000 );
+  REQUIRE( strlen( builder.string() ) == 1000000 );
+  REQUIRE( builder.string()[999999] == char( 'a' + 999999 % 26 ) );
+
+  // appending the builder to itself while it grows
+  builder.truncate( 26 );
+  builder.shrink();
+  REQUIRE( builder.capacity() == 26 );
+  REQUIRE( builder.append( builder.string(), builder.length() ) == NO_ERROR );
+  REQUIRE( builder.append( builder.string() + 26, 10 ) == NO_ERROR );
+  REQUIRE( String8( builder.string() ) ==
+           "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghij" );
+
+  builder.clear();
+  REQUIRE( builder.length() == 0 );
+  REQUIRE( builder.reserve( 5000 ) == NO_ERROR );
+  REQUIRE( builder.capacity() >= 5000 );
+  REQUIRE( builder.appendFormat( "%s=%d;", "key", -12 ) == NO_ERROR );
+  REQUIRE( builder.append( String8( "tail" ) ) == NO_ERROR );
+  REQUIRE( strcmp( builder.string(), "key=-12;tail" ) == 0 );
+
+  StringBuilder moved( std::move( builder ) );
+  REQUIRE( builder.length() == 0 );
+  REQUIRE( strcmp( moved.string(), "key=-12;tail" ) == 0 );
+}
+
+TEST_CASE( "string builder formats numbers like printf", "[StringBuilder]" )
+{
+  char expected[512];
+  StringBuilder builder;
+
+  static const int64_t ints[] = { 0, 1, -1, 9, 10, 99, 100, -100, 12345678, INT64_MAX, INT64_MIN,
+                                  999999999999LL, -1000000000000LL };
+  for( size_t i = 0; i < sizeof( ints ) / sizeof( ints[0] ); i++ ) {
+    builder.clear();
+    builder.appendInt( ints[i] );
+    snprintf( expected, sizeof( expected ), "%lld", ( long long )ints[i] );
+    REQUIRE( strcmp( builder.string(), expected ) == 0 );
+  }
+
+  bool same = true;
+  uint64_t value = 1;
+  for( int i = 0; i < 64; i++, value *= 3 ) {
+    builder.clear();
+    builder.appendUnsigned( value );
+    builder.append( ' ' );
+    builder.appendUnsigned( value - 1 );
+    builder.append( ' ' );
+    builder.appendHex( value );
+    builder.append( ' ' );
+    builder.appendHex( value, 20 );
+    snprintf( expected, sizeof( expected ), "%llu %llu %llx %020llx", ( unsigned long long )value,
+              ( unsigned long long )( value - 1 ), ( unsigned long long )value, ( unsigned long long )value );
+    same = same && strcmp( builder.string(), expected ) == 0;
+  }
+  REQUIRE( same );
+
+  static const double specials[] = { 0.0, -0.0, 0.125, 0.5, 1.5, 2.5, -2.5, 0.045, 1e-7, -1e-7, 1e15, 1e22,
+                                     1e300, 123456.789, INFINITY, -INFINITY, NAN };
+  for( size_t i = 0; i < sizeof( specials ) / sizeof( specials[0] ); i++ ) {
+    for( int precision = 0; precision <= 12; precision++ ) {
+      builder.clear();
+      builder.appendDouble( specials[i], precision );
+      snprintf( expected, sizeof( expected ), "%.*f", precision, specials[i] );
+      REQUIRE( strcmp( builder.string(), expected ) == 0 );
+    }
+  }
+
+  uint32_t seed = 1;
+  for( int i = 0; i < 200000; i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    const uint32_t mantissa = seed;
+    seed = seed * 1664525 + 1013904223;
+    const int exponent = int( seed % 40 ) - 25;
+    const int precision = int( ( seed >> 8 ) % 11 );
+    double d = ldexp( double( mantissa ), exponent );
+    // values that print to a tie at the last digit
+    if( ( seed >> 16 ) % 8 == 0 ) {
+      d = double( mantissa % 100000 ) / 1000 + 0.0005;
+    }
+    if( seed & 0x80000000u ) {
+      d = -d;
+    }
+    builder.clear();
+    builder.appendDouble( d, precision );
+    snprintf( expected, sizeof( expected ), "%.*f", precision, d );
+    if( strcmp( builder.string(), expected ) != 0 ) {
+      FAIL( "appendDouble( " << d << ", " << precision << " ) gave " << builder.string() << ", expected " << expected );
+    }
+  }
+  builder.clear();
+  builder.appendDouble( 3.14159 );
+  REQUIRE( strcmp( builder.string(), "3.141590" ) == 0 );
+}
+
+TEST_CASE( "string builder hands its buffer to String8", "[StringBuilder]" )
+{
+  StringBuilder builder;
+  builder.append( "short" );
+  const size_t capacity = builder.capacity();
+  String8 small = builder.toString8();
+  REQUIRE( small == "short" );
+  REQUIRE( small.sharedBuffer() == nullptr );
+  REQUIRE( builder.isEmpty() );
+  REQUIRE( builder.capacity() == capacity );
+
+  for( int i = 0; i < 100; i++ ) {
+    builder.appendInt( i );
+    builder.append( ',' );
+  }
+  const String8 expected( builder.string() );
+  String8 big = builder.toString8();
+  REQUIRE( big == expected );
+  REQUIRE( big.sharedBuffer() != nullptr );
+  REQUIRE( builder.capacity() == 0 );
+  REQUIRE( strcmp( builder.string(), "" ) == 0 );
+
+  // the handed over string behaves like any other
+  big.append( "end" );
+  REQUIRE( big.length() == expected.length() + 3 );
+  String8 copy( big );
+  REQUIRE( copy == big );
+  REQUIRE( builder.append( "reused" ) == NO_ERROR );
+  REQUIRE( strcmp( builder.string(), "reused" ) == 0 );
+}
+
 TEST_CASE( "HashCode compare works", "[HashCode]" )
 {
   uint8_t buf[] = {
@@ -210,6 +1094,57 @@ TEST_CASE( "crc32 works", "[CRC32]" )
 
 }
 
+static uint32_t bitwise_crc( uint32_t poly, const uint8_t* data, size_t len )
+{
+  uint32_t crc = 0xFFFFFFFF;
+  for( size_t i = 0; i < len; i++ ) {
+    crc ^= data[i];
+    for( int bit = 0; bit < 8; bit++ ) {
+      crc = crc & 1 ? ( crc >> 1 ) ^ poly : crc >> 1;
+    }
+  }
+  return ~crc;
+}
+
+TEST_CASE( "crc32 and crc32c match the reference at every length", "[CRC32]" )
+{
+  const char* check = "123456789";
+  REQUIRE( crc32( 0, check, 9 ) == 0xCBF43926 );
+  REQUIRE( crc32c( 0, check, 9 ) == 0xE3069283 );
+  REQUIRE( crc32( 0, check, 0 ) == 0 );
+
+  up<HashFunction> hash = createCRC32C();
+  hash->update( ( void* )check, 4 );
+  hash->update( ( void* )( check + 4 ), 5 );
+  REQUIRE( hash->finalize().toHexString() == "e3069283" );
+
+  Vector<uint8_t> data;
+  uint32_t seed = 1;
+  for( int i = 0; i < 5000; i++ ) {
+    seed = seed * 1664525 + 1013904223;
+    data.add( uint8_t( seed >> 24 ) );
+  }
+
+  // every alignment and every length around the cut-overs between kernels
+  for( size_t offset = 0; offset < 8; offset++ ) {
+    for( size_t len = 0; len < 300; len += 1 + len / 16 ) {
+      const uint8_t* p = data.array() + offset;
+      REQUIRE( crc32( 0, p, len ) == bitwise_crc( 0xEDB88320, p, len ) );
+      REQUIRE( crc32c( 0, p, len ) == bitwise_crc( 0x82F63B78, p, len ) );
+    }
+  }
+  REQUIRE( crc32( 0, data.array(), 4999 ) == bitwise_crc( 0xEDB88320, data.array(), 4999 ) );
+  REQUIRE( crc32c( 0, data.array(), 4999 ) == bitwise_crc( 0x82F63B78, data.array(), 4999 ) );
+
+  // chunked updates and combine agree with one pass
+  const uint32_t whole = crc32( 0, data.array(), 5000 );
+  const uint32_t wholeC = crc32c( 0, data.array(), 5000 );
+  REQUIRE( crc32( crc32( 0, data.array(), 1234 ), data.array() + 1234, 3766 ) == whole );
+  REQUIRE( crc32Combine( crc32( 0, data.array(), 1234 ), crc32( 0, data.array() + 1234, 3766 ), 3766 ) == whole );
+  REQUIRE( crc32cCombine( crc32c( 0, data.array(), 3 ), crc32c( 0, data.array() + 3, 4997 ), 4997 ) == wholeC );
+  REQUIRE( crc32Combine( whole, 0, 0 ) == whole );
+}
+
 TEST_CASE( "SHA1 works", "[SHA1]" )
 {
   uint8_t buf[] = {
@@ -225,3 +1160,193 @@ TEST_CASE( "SHA1 works", "[SHA1]" )
   REQUIRE( str == String8( "66b27417d37e024c46526c2f6d358a754fc552f3" ) );
 }
 
+static String8 hexDigest( HashFunction& hash, const void* data, size_t len )
+{
+  hash.reset();
+  hash.update( const_cast<void*>( data ), len );
+  String8 str = hash.finalize().toHexString();
+  str.toLower();
+  return str;
+}
+
+TEST_CASE( "SHA1 and SHA256 match the test vectors", "[SHA256]" )
+{
+  up<HashFunction> sha1 = createSHA1();
+  up<HashFunction> sha256 = createSHA256();
+
+  const char* abc = "abc";
+  const char* twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  REQUIRE( hexDigest( *sha1, abc, 3 ) == "a9993e364706816aba3e25717850c26c9cd0d89d" );
+  REQUIRE( hexDigest( *sha1, twoBlocks, 56 ) == "84983e441c3bd26ebaae4aa1f95129e5e54670f1" );
+  REQUIRE( hexDigest( *sha256, "", 0 ) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" );
+  REQUIRE( hexDigest( *sha256, abc, 3 ) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" );
+  REQUIRE( hexDigest( *sha256, twoBlocks, 56 ) == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" );
+
+  // a million 'a's, fed in uneven pieces so that both the buffered and
+  // the whole block paths run
+  Vector<uint8_t> million;
+  million.insertAt( uint8_t( 'a' ), 0, 1000000 );
+  sha1->reset();
+  sha256->reset();
+  for( size_t off = 0, step = 1; off < million.size(); off += step, step = step * 3 % 1000 + 1 ) {
+    const size_t n = MIN( step, million.size() - off );
+    sha1->update( million.editArray() + off, n );
+    sha256->update( million.editArray() + off, n );
+  }
+  REQUIRE( sha1->finalize().toHexString() == "34aa973cd4c4daa4f61eeb2bdbad27316534016f" );
+  REQUIRE( sha256->finalize().toHexString() == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" );
+}
+
+static uint64_t digest64( HashFunction& hash )
+{
+  String8 hex = hash.finalize().toHexString();
+  uint64_t value = 0;
+  for( size_t i = 0; i < hex.length(); i++ ) {
+    const char c = hex.string()[i];
+    value = value << 4 | uint64_t( c <= '9' ? c - '0' : ( c | 0x20 ) - 'a' + 10 );
+  }
+  return value;
+}
+
+TEST_CASE( "hash64 streams and seeds consistently", "[FastHash]" )
+{
+  Vector<uint8_t> data;
+  for( size_t i = 0; i < 5000; i++ ) {
+    data.add( uint8_t( i * 2654435761u >> 13 ) );
+  }
+  uint8_t* p = data.editArray();
+
+  up<HashFunction> stream = createHash64( 42 );
+  up<HashFunction> wide = createHash128( 42 );
+  // every size class: 0-3, 4-8, 9-16, 17-128, 129-240, then one or more
+  // 1024 byte blocks with and without a partial last stripe
+  const size_t lengths[] = { 0, 1, 3, 4, 8, 9, 16, 17, 33, 64, 65, 97, 128, 129, 200, 240, 241,
+                             255, 256, 257, 300, 1023, 1024, 1025, 1088, 2048, 2049, 4999 };
+  for( size_t i = 0; i < sizeof( lengths ) / sizeof( lengths[0] ); i++ ) {
+    const size_t len = lengths[i];
+    const uint64_t expected = hash64( p, len, 42 );
+    const Hash128 expected128 = hash128( p, len, 42 );
+    REQUIRE( expected128.low == expected );
+    REQUIRE( expected != hash64( p, len, 43 ) );
+    REQUIRE( expected != hash64( p, len ) );
+
+    const size_t steps[] = { 1, 7, 64, 100, 257, 5000 };
+    for( size_t s = 0; s < sizeof( steps ) / sizeof( steps[0] ); s++ ) {
+      stream->reset();
+      wide->reset();
+      for( size_t off = 0; off < len; off += steps[s] ) {
+        stream->update( p + off, MIN( steps[s], len - off ) );
+        wide->update( p + off, MIN( steps[s], len - off ) );
+      }
+      REQUIRE( digest64( *stream ) == expected );
+      char hex[40];
+      snprintf( hex, sizeof( hex ), "%016llx%016llx", ( unsigned long long )expected128.high,
+                ( unsigned long long )expected128.low );
+      REQUIRE( wide->finalize().toHexString() == hex );
+    }
+  }
+
+  // a changed byte anywhere changes the result
+  const uint64_t whole = hash64( p, 3000 );
+  for( size_t i = 0; i < 3000; i += 37 ) {
+    p[i] ^= 1;
+    REQUIRE( hash64( p, 3000 ) != whole );
+    p[i] ^= 1;
+  }
+}
+
+TEST_CASE( "hash64 has no collisions over short keys", "[FastHash]" )
+{
+  SortedVector<uint64_t> seen;
+  seen.setCapacity( 100000 );
+  char key[32];
+  for( int i = 0; i < 100000; i++ ) {
+    const int len = snprintf( key, sizeof( key ), "key-%d", i );
+    seen.add( hash64( key, len ) );
+  }
+  // and the integers as 4 and 8 byte keys
+  for( uint32_t i = 0; i < 50000; i++ ) {
+    const uint64_t wide = i;
+    seen.add( hash64( &i, sizeof( i ) ) );
+    seen.add( hash64( &wide, sizeof( wide ) ) );
+  }
+  REQUIRE( seen.size() == 200000 );
+
+  String8 str( "the quick brown fox" );
+  REQUIRE( str.hash() == hash64( "the quick brown fox", 19 ) );
+  String16 str16( "fox" );
+  REQUIRE( str16.hash() == hash64( u"fox", 6 ) );
+}
+
+TEST_CASE( "HashCode is an inline value", "[HashCode]" )
+{
+  REQUIRE( std::is_trivially_copyable<HashCode>::value );
+
+  up<HashFunction> sha256 = createSHA256();
+  sha256->update( ( void* )"abc", 3 );
+  uint8_t digest[HashCode::kMaxSize];
+  REQUIRE( sha256->finalizeInto( digest ) == 32 );
+  sha256->reset();
+  sha256->update( ( void* )"abc", 3 );
+  const HashCode code = sha256->finalize();
+  REQUIRE( code.size() == 32 );
+  REQUIRE( memcmp( code.data(), digest, 32 ) == 0 );
+  REQUIRE( code == HashCode( digest, 32 ) );
+
+  // shorter digests order first, then by bytes
+  const uint8_t low[] = { 1, 2, 3, 4 };
+  const uint8_t high[] = { 1, 2, 3, 5 };
+  REQUIRE( HashCode( low, 4 ) < HashCode( high, 4 ) );
+  REQUIRE( HashCode( high, 4 ) < code );
+  REQUIRE( HashCode( low, 4 ) != HashCode( low, 3 ) );
+  REQUIRE( HashCode().size() == 0 );
+
+  // copies survive the original going out of scope
+  Vector<HashCode> codes;
+  up<HashFunction> crc = createCRC32C();
+  for( uint32_t i = 0; i < 100; i++ ) {
+    crc->reset();
+    crc->update( &i, sizeof( i ) );
+    codes.add( crc->finalize() );
+  }
+  codes.sort();
+  for( size_t i = 1; i < codes.size(); i++ ) {
+    REQUIRE( codes[i - 1] < codes[i] );
+  }
+}
+
+TEST_CASE( "hashing streams checksum what pump() copies", "[Streams]" )
+{
+  SharedBuffer* buf = SharedBuffer::alloc( 10000 );
+  uint8_t* data = static_cast<uint8_t*>( buf->data() );
+  for( size_t i = 0; i < buf->size(); i++ ) {
+    data[i] = uint8_t( i * 31 >> 2 );
+  }
+  const uint32_t expectedCrc = crc32c( 0, data, buf->size() );
+  const uint64_t expectedHash = hash64( data, buf->size() );
+
+  up<HashFunction> crc = createCRC32C();
+  up<HashFunction> fast = createHash64();
+  ByteArrayInputStream source( buf, 0, buf->size() );
+  HashingInputStream in( source, *crc );
+  in.addHash( *fast );
+  ByteArrayOutputStream sink;
+  up<HashFunction> written = createCRC32C();
+  HashingOutputStream out( sink, *written );
+
+  // closing the output would free the copy before it can be checked
+  pump( in, out, nullptr, false, true );
+  REQUIRE( sink.size() == buf->size() );
+  REQUIRE( memcmp( sink.toSharedBuffer(), data, buf->size() ) == 0 );
+  out.close();
+
+  REQUIRE( in.count() == buf->size() );
+  REQUIRE( out.count() == buf->size() );
+  uint8_t expected[4] = {
+    uint8_t( expectedCrc >> 24 ), uint8_t( expectedCrc >> 16 ), uint8_t( expectedCrc >> 8 ), uint8_t( expectedCrc )
+  };
+  REQUIRE( crc->finalize() == HashCode( expected, 4 ) );
+  REQUIRE( written->finalize() == HashCode( expected, 4 ) );
+  REQUIRE( digest64( *fast ) == expectedHash );
+  buf->release();
+}
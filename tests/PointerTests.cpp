@@ -59,6 +59,24 @@ TEST_CASE( "strong pointer", "[StrongPointer]" )
 
 }
 
+TEST_CASE( "strong pointer move", "[StrongPointer]" )
+{
+  struct MyStruct : public LightRefBase<MyStruct> {
+  };
+
+  sp<MyStruct> p1( new MyStruct );
+  REQUIRE( p1->getStrongCount() == 1 );
+
+  sp<MyStruct> p2( std::move( p1 ) );
+  REQUIRE( p1.get() == NULL );
+  REQUIRE( p2->getStrongCount() == 1 );
+
+  sp<MyStruct> p3( new MyStruct );
+  p3 = std::move( p2 );
+  REQUIRE( p2.get() == NULL );
+  REQUIRE( p3->getStrongCount() == 1 );
+}
+
 TEST_CASE( "does free single obj?", "[UniquePointer]" )
 {
   static int count = 0;
@@ -22,6 +22,9 @@
 #include <baseline/Thread.h>
 #include <baseline/Condition.h>
 #include <baseline/Mutex.h>
+#include <baseline/SPSCRing.h>
+#include <baseline/Streams.h>
+#include <baseline/StringPool.h>
 
 using namespace baseline;
 
@@ -92,4 +95,200 @@ TEST_CASE( "condition var timeout return OK when signaled before timeout", "[Con
   t->join();
 
   REQUIRE( retval == OK );
-}
\ No newline at end of file
+}
+
+TEST_CASE( "spsc ring passes items between threads", "[SPSCRing]" )
+{
+  static const uint32_t kCount = 200000;
+  static SPSCRing<uint32_t> ring( 64 );
+
+  class Producer : public Thread
+  {
+  public:
+    void run() {
+      uint32_t batch[7];
+      uint32_t next = 0;
+      while( next < kCount ) {
+        const uint32_t n = MIN( uint32_t( 7 ), kCount - next );
+        for( uint32_t i = 0; i < n; i++ ) {
+          batch[i] = next + i;
+        }
+        uint32_t done = 0;
+        while( done < n ) {
+          const uint32_t written = ring.write( batch + done, n - done );
+          if( !written ) {
+            Thread::yield();
+          }
+          done += written;
+        }
+        next += n;
+      }
+    }
+  };
+
+  sp<Producer> t( new Producer() );
+  t->start();
+
+  bool inOrder = true;
+  uint32_t expected = 0;
+  uint32_t batch[13];
+  while( expected < kCount ) {
+    const uint32_t n = ring.read( batch, 13 );
+    if( !n ) {
+      Thread::yield();
+    }
+    for( uint32_t i = 0; i < n; i++ ) {
+      inOrder = inOrder && batch[i] == expected;
+      expected++;
+    }
+  }
+  t->join();
+
+  REQUIRE( inOrder );
+  REQUIRE( ring.empty() );
+}
+
+TEST_CASE( "pipe streams more than its capacity between threads", "[Pipe]" )
+{
+  static const size_t kTotal = 1000000;
+  static UniquePtr<OutputStream> out;
+  UniquePtr<InputStream> in;
+  REQUIRE( createPipe( 256, out, in ) == OK );
+
+  class Producer : public Thread
+  {
+  public:
+    void run() {
+      uint8_t buf[1000];
+      for( size_t sent = 0; sent < kTotal; sent += sizeof( buf ) ) {
+        for( size_t i = 0; i < sizeof( buf ); i++ ) {
+          buf[i] = uint8_t( ( sent + i ) % 251 );
+        }
+        out->write( buf, 0, sizeof( buf ) );
+      }
+      out->close();
+    }
+  };
+
+  sp<Producer> t( new Producer() );
+  t->start();
+
+  bool inOrder = true;
+  size_t received = 0;
+  uint8_t buf[333];
+  int n;
+  while( ( n = in->read( buf, 0, sizeof( buf ) ) ) > 0 ) {
+    for( int i = 0; i < n; i++ ) {
+      inOrder = inOrder && buf[i] == uint8_t( ( received + i ) % 251 );
+    }
+    received += n;
+  }
+  t->join();
+  in->close();
+  out.reset();
+
+  REQUIRE( n == -1 );
+  REQUIRE( inOrder );
+  REQUIRE( received == kTotal );
+}
+
+TEST_CASE( "string pool hands out one handle per string", "[StringPool]" )
+{
+  StringPool pool;
+  InternedString a = pool.intern( "camera" );
+  REQUIRE( a == pool.intern( String8( "camera" ) ) );
+  REQUIRE( a == pool.intern( "cameras", 6 ) );
+  REQUIRE( a != pool.intern( "Camera" ) );
+  REQUIRE( strcmp( a.string(), "camera" ) == 0 );
+  REQUIRE( a.length() == 6 );
+  REQUIRE( a.hash() == String8( "camera" ).hash() );
+  REQUIRE( a.toString8() == String8( "camera" ) );
+
+  REQUIRE( pool.intern( "" ) == InternedString() );
+  REQUIRE( pool.intern( ( const char* )nullptr ).isEmpty() );
+  REQUIRE( InternedString().hash() == String8().hash() );
+  REQUIRE( pool.find( "audio" ).isEmpty() );
+  REQUIRE( pool.size() == 2 );
+
+  // enough strings for every shard to grow a few times
+  Vector<InternedString> handles;
+  char name[32];
+  for( int i = 0; i < 5000; i++ ) {
+    snprintf( name, sizeof( name ), "field.%d", i );
+    handles.add( pool.intern( name ) );
+  }
+  REQUIRE( pool.size() == 5002 );
+  bool same = true;
+  for( int i = 0; i < 5000; i++ ) {
+    snprintf( name, sizeof( name ), "field.%d", i );
+    same = same && pool.find( name ) == handles[i] && strcmp( handles[i].string(), name ) == 0;
+  }
+  REQUIRE( same );
+}
+
+TEST_CASE( "string pool interns from many threads", "[StringPool]" )
+{
+  static const int kStrings = 3000;
+  static const int kThreads = 8;
+  static StringPool* pool;
+  static InternedString seen[kThreads][kStrings];
+
+  class Interner : public Thread
+  {
+  public:
+    Interner( int id ) : mId( id ) {}
+    void run() {
+      char name[32];
+      for( int i = 0; i < kStrings; i++ ) {
+        // each thread walks the strings in a different order
+        const int n = ( i * 7 + mId * 389 ) % kStrings;
+        snprintf( name, sizeof( name ), "tag.%d", n );
+        seen[mId][n] = pool->intern( name );
+      }
+    }
+  private:
+    int mId;
+  };
+
+  StringPool shared;
+  pool = &shared;
+  sp<Interner> threads[kThreads];
+  for( int t = 0; t < kThreads; t++ ) {
+    threads[t] = new Interner( t );
+    threads[t]->start();
+  }
+  for( int t = 0; t < kThreads; t++ ) {
+    threads[t]->join();
+  }
+
+  bool same = true;
+  for( int i = 0; i < kStrings; i++ ) {
+    for( int t = 1; t < kThreads; t++ ) {
+      same = same && seen[t][i] == seen[0][i];
+    }
+  }
+  REQUIRE( same );
+  REQUIRE( shared.size() == size_t( kStrings ) );
+}
+
+TEST_CASE( "string pool purges strings not used for a while", "[StringPool]" )
+{
+  StringPool pool;
+  InternedString kept = pool.intern( "kept" );
+  pool.intern( "dropped" );
+  REQUIRE( pool.advanceEpoch() == 1 );
+  REQUIRE( pool.intern( "kept" ) == kept );
+
+  REQUIRE( pool.purge( 1 ) == 0 );
+  REQUIRE( pool.purge( 0 ) == 1 );
+  REQUIRE( pool.size() == 1 );
+  REQUIRE( pool.find( "dropped" ).isEmpty() );
+  REQUIRE( pool.find( "kept" ) == kept );
+
+  pool.advanceEpoch();
+  pool.advanceEpoch();
+  InternedString again = pool.intern( "dropped" );
+  REQUIRE( strcmp( again.string(), "dropped" ) == 0 );
+  REQUIRE( pool.size() == 2 );
+  REQUIRE( pool.intern( "kept" ) == kept );
+}
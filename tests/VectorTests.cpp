@@ -21,10 +21,22 @@
 #include <baseline/Baseline.h>
 #include <baseline/Vector.h>
 #include <baseline/SortedVector.h>
+#include <baseline/SmallVector.h>
+#include <baseline/SharedBuffer.h>
+#include <baseline/String8.h>
+#include <baseline/RefBase.h>
+#include <baseline/ExecutorService.h>
 
 using namespace baseline;
 
 
+static String8 number( const char* fmt, int value )
+{
+  char buf[32];
+  snprintf( buf, sizeof( buf ), fmt, value );
+  return String8( buf );
+}
+
 TEST_CASE( "copy on write", "[Vector]" )
 {
   Vector<int> vector;
@@ -61,6 +73,44 @@ TEST_CASE( "copy on write", "[Vector]" )
   REQUIRE( other[3] == 5 );
 }
 
+TEST_CASE( "in-place edits keep copy on write", "[Vector]" )
+{
+  Vector<String8> vector;
+  vector.setCapacity( 16 );
+  for( int i = 0; i < 8; i++ ) {
+    vector.add( number( "%d", i ) );
+  }
+  Vector<String8> other = vector;
+
+  // each of these has room in place, but the storage is shared
+  vector.editItemAt( 0 ) = "edited";
+  REQUIRE( other[0] == "0" );
+  other = vector;
+  vector.pop();
+  REQUIRE( other.size() == 8 );
+  other = vector;
+  vector.removeItemsAt( 1, 2 );
+  REQUIRE( other[1] == "1" );
+  other = vector;
+  vector.replaceAt( String8( "replaced" ), 1 );
+  REQUIRE( other[1] == "3" );
+  other = vector;
+  vector.emplace_back( "new" );
+  REQUIRE( other.size() == 5 );
+
+  REQUIRE( vector.size() == 6 );
+  REQUIRE( vector[0] == "edited" );
+  REQUIRE( vector[1] == "replaced" );
+  REQUIRE( vector[4] == "6" );
+  REQUIRE( vector[5] == "new" );
+
+  // removing most items still gives memory back
+  const size_t capacity = vector.capacity();
+  vector.removeItemsAt( 0, 5 );
+  REQUIRE( vector.capacity() < capacity );
+  REQUIRE( vector[0] == "new" );
+}
+
 TEST_CASE( "trivial sorted vector", "[SortedVector]" )
 {
   SortedVector<int> vector;
@@ -108,4 +158,506 @@ TEST_CASE( "vector of pointers", "[Vector]" )
 
   Vector<MyStruct*> vector;
   //vector.add( new MyStruct2 );
-}
\ No newline at end of file
+}
+
+//! sets the map threshold for a scope, so that a failed REQUIRE puts it back
+class MapThresholdGuard
+{
+public:
+  explicit MapThresholdGuard( size_t threshold ) : mSaved( SharedBuffer::mapThreshold() ) {
+    SharedBuffer::setMapThreshold( threshold );
+  }
+  ~MapThresholdGuard() {
+    SharedBuffer::setMapThreshold( mSaved );
+  }
+
+private:
+  size_t mSaved;
+};
+
+TEST_CASE( "page mapped storage", "[Vector]" )
+{
+  MapThresholdGuard guard( 64 * 1024 );
+
+  Vector<uint32_t> vector;
+  for( uint32_t i = 0; i < 100000; i++ ) {
+    vector.add( i );
+  }
+#if defined(__linux__)
+  REQUIRE( SharedBuffer::bufferFromData( vector.array() )->isMapped() );
+#endif
+
+  Vector<uint32_t> other = vector;
+  other.add( 100000 );
+
+  // appending past the threshold keeps the items in place
+  REQUIRE( vector.size() == 100000 );
+  REQUIRE( other.size() == 100001 );
+  for( uint32_t i = 0; i < 100000; i++ ) {
+    REQUIRE( vector[i] == i );
+  }
+  REQUIRE( other[100000] == 100000 );
+
+  // shrink back down through mremap
+  vector.removeItemsAt( 10, vector.size() - 10 );
+  REQUIRE( vector.size() == 10 );
+  REQUIRE( vector[9] == 9 );
+}
+
+TEST_CASE( "shared buffers refuse sizes that wrap around", "[SharedBuffer]" )
+{
+  MapThresholdGuard guard( 64 * 1024 );
+  REQUIRE( SharedBuffer::alloc( SIZE_MAX ) == NULL );
+  REQUIRE( SharedBuffer::alloc( SIZE_MAX - sizeof( SharedBuffer ) ) == NULL );
+
+  SharedBuffer* buf = SharedBuffer::alloc( 16 );
+  REQUIRE( buf != NULL );
+  REQUIRE( buf->editResize( SIZE_MAX - 8 ) == NULL );
+  REQUIRE( buf->size() == 16 );
+  buf->release();
+}
+
+TEST_CASE( "move leaves source empty", "[Vector]" )
+{
+  Vector<String8> vector;
+  vector.add( String8( "a" ) );
+  vector.push_back( String8( "b" ) );
+  vector.emplace_back( "c" );
+  vector.emplace( 0, "z" );
+
+  REQUIRE( vector.size() == 4 );
+  REQUIRE( vector[0] == "z" );
+  REQUIRE( vector[3] == "c" );
+
+  Vector<String8> other( std::move( vector ) );
+  REQUIRE( vector.size() == 0 );
+  REQUIRE( other.size() == 4 );
+
+  vector = std::move( other );
+  REQUIRE( other.size() == 0 );
+  REQUIRE( vector[1] == "a" );
+
+  String8 str( "hello" );
+  String8 moved( std::move( str ) );
+  REQUIRE( str.isEmpty() );
+  REQUIRE( moved == "hello" );
+}
+
+TEST_CASE( "growth relocates strong pointers", "[Vector]" )
+{
+  struct MyStruct : public LightRefBase<MyStruct> {
+  };
+
+  Vector<sp<MyStruct>> vector;
+  sp<MyStruct> first( new MyStruct );
+  vector.push_back( first );
+  for( int i = 0; i < 100; i++ ) {
+    vector.push_back( new MyStruct );
+  }
+  vector.insertAt( first, 50 );
+  for( int i = 0; i < 90; i++ ) {
+    vector.removeAt( 1 );
+  }
+
+  REQUIRE( vector.size() == 12 );
+  REQUIRE( vector[0] == first );
+  REQUIRE( first->getStrongCount() == 2 );
+  REQUIRE( vector[11]->getStrongCount() == 1 );
+
+  // a shared copy must not be moved out from under the other owner
+  Vector<sp<MyStruct>> other = vector;
+  vector.setCapacity( 100 );
+  REQUIRE( first->getStrongCount() == 3 );
+}
+
+struct SortItem {
+  int mKey;
+  int mSeq;
+};
+
+static int compareSortItem( const SortItem* lhs, const SortItem* rhs )
+{
+  return lhs->mKey - rhs->mKey;
+}
+
+static bool operator< ( const SortItem& lhs, const SortItem& rhs )
+{
+  return lhs.mKey < rhs.mKey;
+}
+
+TEST_CASE( "sort is stable", "[Vector]" )
+{
+  Vector<SortItem> vector;
+  uint32_t seed = 1;
+  for( int i = 0; i < 5000; i++ ) {
+    seed = seed * 1103515245 + 12345;
+    vector.add( { int( ( seed >> 16 ) % 100 ), i } );
+  }
+
+  Vector<SortItem> other = vector;
+  REQUIRE( vector.sort( compareSortItem ) == NO_ERROR );
+
+  for( size_t i = 1; i < vector.size(); i++ ) {
+    REQUIRE( vector[i - 1].mKey <= vector[i].mKey );
+    if( vector[i - 1].mKey == vector[i].mKey ) {
+      REQUIRE( vector[i - 1].mSeq < vector[i].mSeq );
+    }
+  }
+
+  // the copy still has the original order
+  REQUIRE( other[0].mSeq == 0 );
+  REQUIRE( other[4999].mSeq == 4999 );
+}
+
+TEST_CASE( "sort natural order and functors", "[Vector]" )
+{
+  Vector<String8> strings;
+  for( int i = 999; i >= 0; i-- ) {
+    strings.add( number( "%04d", i ) );
+  }
+  REQUIRE( strings.sort() == NO_ERROR );
+  for( int i = 0; i < 1000; i++ ) {
+    REQUIRE( strings[i] == number( "%04d", i ) );
+  }
+
+  Vector<int> ints;
+  for( int i = 0; i < 1000; i++ ) {
+    ints.add( ( i * 7919 ) % 1000 );
+  }
+  REQUIRE( ints.sort( []( const int& lhs, const int& rhs ) {
+    return rhs - lhs;
+  } ) == NO_ERROR );
+  for( int i = 0; i < 1000; i++ ) {
+    REQUIRE( ints[i] == 999 - i );
+  }
+}
+
+static int compareString8( const void* lhs, const void* rhs, void* state )
+{
+  ( *reinterpret_cast<int*>( state ) )++;
+  return reinterpret_cast<const String8*>( lhs )->compare( *reinterpret_cast<const String8*>( rhs ) );
+}
+
+TEST_CASE( "type-erased sort", "[VectorImpl]" )
+{
+  Vector<String8> strings;
+  for( int i = 0; i < 500; i++ ) {
+    strings.add( number( "%03d", ( i * 37 ) % 500 ) );
+  }
+  Vector<String8> shared = strings;
+
+  // Vector<> shares its layout with VectorImpl, exercise the ABI entry point
+  int calls = 0;
+  VectorImpl& impl = reinterpret_cast<VectorImpl&>( strings );
+  REQUIRE( impl.sort( compareString8, &calls ) == NO_ERROR );
+  REQUIRE( calls > 0 );
+  for( int i = 0; i < 500; i++ ) {
+    REQUIRE( strings[i] == number( "%03d", i ) );
+  }
+  REQUIRE( shared[1] == "037" );
+
+  // sorting again is a no-op that only compares neighbours
+  calls = 0;
+  REQUIRE( impl.sort( compareString8, &calls ) == NO_ERROR );
+  REQUIRE( calls == 499 );
+
+  // the only owner relocates instead of copying
+  Vector<String8> single;
+  single.add( String8( "b" ) );
+  single.add( String8( "a" ) );
+  REQUIRE( reinterpret_cast<VectorImpl&>( single ).sort( compareString8, &calls ) == NO_ERROR );
+  REQUIRE( single[0] == "a" );
+  REQUIRE( single[1] == "b" );
+}
+
+TEST_CASE( "sorted vector merge", "[SortedVector]" )
+{
+  SortedVector<String8> evens;
+  SortedVector<String8> threes;
+  for( int i = 0; i < 300; i += 2 ) {
+    evens.add( number( "%03d", i ) );
+  }
+  for( int i = 0; i < 300; i += 3 ) {
+    threes.add( number( "%03d", i ) );
+  }
+  SortedVector<String8> shared = evens;
+
+  REQUIRE( evens.merge( threes ) == NO_ERROR );
+  REQUIRE( evens.size() == 200 );
+  for( size_t i = 1; i < evens.size(); i++ ) {
+    REQUIRE( evens[i - 1] < evens[i] );
+  }
+  REQUIRE( evens.indexOf( String8( "009" ) ) >= 0 );
+  REQUIRE( evens.indexOf( String8( "007" ) ) < 0 );
+  REQUIRE( shared.size() == 150 );
+
+  // merging into the only owner relocates, replaced items are destroyed
+  REQUIRE( shared.merge( threes ) == NO_ERROR );
+  REQUIRE( shared.size() == 200 );
+  REQUIRE( shared[199] == evens[199] );
+}
+
+TEST_CASE( "sorted vector merge replaces equal items", "[SortedVector]" )
+{
+  SortedVector<SortItem> items;
+  for( int i = 0; i < 10; i++ ) {
+    items.add( { i * 2, 0 } );
+  }
+
+  SortedVector<SortItem> sorted;
+  sorted.add( { 4, 1 } );
+  sorted.add( { 5, 1 } );
+  REQUIRE( items.merge( sorted ) == NO_ERROR );
+  REQUIRE( items.size() == 11 );
+  REQUIRE( items[2].mSeq == 1 );
+  REQUIRE( items[3].mKey == 5 );
+
+  // like adding the items one by one, the last of equal ones wins
+  Vector<SortItem> unsorted;
+  unsorted.add( { 7, 2 } );
+  unsorted.add( { 0, 2 } );
+  unsorted.add( { 7, 3 } );
+  unsorted.add( { 100, 2 } );
+  REQUIRE( items.merge( unsorted ) == NO_ERROR );
+  REQUIRE( items.size() == 13 );
+  REQUIRE( items[0].mSeq == 2 );
+  REQUIRE( items[items.indexOf( { 7, 0 } )].mSeq == 3 );
+  REQUIRE( items[12].mKey == 100 );
+}
+
+#ifdef BASELINE_THREAD_SUPPORT
+TEST_CASE( "parallel sort and merge", "[Vector]" )
+{
+  sp<ExecutorService> executor = ExecutorService::createExecutorService( String8( "sort" ), 4 );
+
+  Vector<SortItem> vector;
+  uint32_t seed = 7;
+  for( int i = 0; i < 100000; i++ ) {
+    seed = seed * 1103515245 + 12345;
+    vector.add( { int( ( seed >> 8 ) % 5000 ), i } );
+  }
+  Vector<SortItem> serial = vector;
+  REQUIRE( serial.sort( compareSortItem ) == NO_ERROR );
+  REQUIRE( vector.sort( compareSortItem, executor ) == NO_ERROR );
+  for( size_t i = 0; i < vector.size(); i++ ) {
+    REQUIRE( vector[i].mKey == serial[i].mKey );
+    REQUIRE( vector[i].mSeq == serial[i].mSeq );
+  }
+
+  SortedVector<String8> lhs;
+  SortedVector<String8> rhs;
+  Vector<String8> unsorted;
+  for( int i = 0; i < 60000; i++ ) {
+    lhs.add( number( "%06d", i * 2 ) );
+    rhs.add( number( "%06d", i * 3 ) );
+    unsorted.add( number( "%06d", ( i * 7919 ) % 60000 * 5 ) );
+  }
+  SortedVector<String8> expected = lhs;
+  REQUIRE( expected.merge( rhs ) == NO_ERROR );
+  REQUIRE( lhs.merge( rhs, executor ) == NO_ERROR );
+  REQUIRE( lhs.size() == expected.size() );
+  for( size_t i = 0; i < lhs.size(); i++ ) {
+    REQUIRE( lhs[i] == expected[i] );
+  }
+
+  REQUIRE( expected.merge( unsorted ) == NO_ERROR );
+  REQUIRE( lhs.merge( unsorted, executor ) == NO_ERROR );
+  REQUIRE( lhs.size() == expected.size() );
+  for( size_t i = 0; i < lhs.size(); i++ ) {
+    REQUIRE( lhs[i] == expected[i] );
+  }
+
+  executor->shutdown();
+}
+
+TEST_CASE( "parallel sort on an executor that does not count its threads", "[Vector]" )
+{
+  // written against the interface as it was before getNumThreads()
+  class InlineExecutor : public ExecutorService
+  {
+  public:
+    void shutdown() {}
+    sp<Future> execute( const sp<Runnable>& task ) {
+      task->run();
+      return new Future();
+    }
+    sp<Future> schedule( const sp<Runnable>& task, uint32_t ) {
+      return execute( task );
+    }
+    sp<Future> scheduleWithFixedDelay( const sp<Runnable>& task, uint32_t ) {
+      return execute( task );
+    }
+  };
+  sp<ExecutorService> executor = new InlineExecutor();
+  REQUIRE( executor->getNumThreads() == 1 );
+
+  Vector<SortItem> vector;
+  for( int i = 0; i < 20000; i++ ) {
+    vector.add( { ( i * 7919 ) % 300, i } );
+  }
+  Vector<SortItem> serial = vector;
+  REQUIRE( serial.sort( compareSortItem ) == NO_ERROR );
+  REQUIRE( vector.sort( compareSortItem, executor ) == NO_ERROR );
+  for( size_t i = 0; i < vector.size(); i++ ) {
+    REQUIRE( vector[i].mKey == serial[i].mKey );
+    REQUIRE( vector[i].mSeq == serial[i].mSeq );
+  }
+}
+#endif
+
+TEST_CASE( "small vector stays inline until it spills", "[SmallVector]" )
+{
+  SmallVector<String8, 4> vector;
+  REQUIRE( vector.isInline() );
+  REQUIRE( vector.capacity() == 4 );
+  vector.add( String8( "b" ) );
+  vector.push_back( String8( "d" ) );
+  vector.emplace( 0, "a" );
+  vector.insertAt( String8( "c" ), 2 );
+  REQUIRE( vector.isInline() );
+  REQUIRE( vector.size() == 4 );
+
+  // pushing an item of the vector itself while spilling
+  vector.push_back( vector[0] );
+  REQUIRE( !vector.isInline() );
+  for( int i = 0; i < 100; i++ ) {
+    vector.add( number( "%d", i ) );
+  }
+  REQUIRE( vector.size() == 105 );
+  REQUIRE( vector[0] == "a" );
+  REQUIRE( vector[1] == "b" );
+  REQUIRE( vector[2] == "c" );
+  REQUIRE( vector[3] == "d" );
+  REQUIRE( vector[4] == "a" );
+  REQUIRE( vector[104] == "99" );
+
+  REQUIRE( vector.removeItemsAt( 4, 101 ) == 4 );
+  REQUIRE( vector.removeItemsAt( 4, 1 ) == BAD_VALUE );
+  REQUIRE( vector.size() == 4 );
+  vector.clear();
+  REQUIRE( vector.isInline() );
+}
+
+TEST_CASE( "small vector copy, move and sort", "[SmallVector]" )
+{
+  for( size_t count = 1; count < 6; count += 3 ) {
+    SmallVector<String8, 2> vector;
+    for( size_t i = 0; i < count; i++ ) {
+      vector.insertAt( number( "%d", int( i ) ), 0 );
+    }
+    SmallVector<String8, 2> copy( vector );
+    REQUIRE( copy.size() == count );
+    copy.editItemAt( 0 ) = "changed";
+    REQUIRE( vector[0] != "changed" );
+
+    SmallVector<String8, 2> moved( std::move( vector ) );
+    REQUIRE( vector.isEmpty() );
+    REQUIRE( vector.isInline() );
+    REQUIRE( moved.size() == count );
+    REQUIRE( moved.sort() == NO_ERROR );
+    for( size_t i = 0; i < count; i++ ) {
+      REQUIRE( moved[i] == number( "%d", int( i ) ) );
+    }
+
+    vector = moved;
+    copy = std::move( moved );
+    REQUIRE( moved.isEmpty() );
+    REQUIRE( copy.size() == count );
+    REQUIRE( vector.size() == count );
+  }
+
+  Vector<int> source;
+  for( int i = 0; i < 10; i++ ) {
+    source.add( i );
+  }
+  SmallVector<int, 8> ints( source );
+  REQUIRE( ints.size() == 10 );
+  REQUIRE( ints.setCapacity( 100 ) == 100 );
+  REQUIRE( ints.insertArrayAt( source.array(), 5, 10 ) == 5 );
+  REQUIRE( ints.size() == 20 );
+  REQUIRE( ints[5] == 0 );
+  REQUIRE( ints[15] == 5 );
+  REQUIRE( ints[19] == 9 );
+}
+
+template<typename TYPE>
+static void checkSearch( TYPE lo, TYPE hi )
+{
+  uint64_t seed = 7;
+  for( size_t n = 0; n < 300; n += ( n < 40 ? 1 : 37 ) ) {
+    Vector<TYPE> vector;
+    for( size_t i = 0; i < n; i++ ) {
+      seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+      // few distinct values, including both ends of the range
+      const int pick = int( ( seed >> 33 ) % 8 );
+      vector.add( pick == 0 ? lo : pick == 1 ? hi : TYPE( pick * 1000 ) );
+    }
+    const TYPE* a = vector.array();
+    const TYPE probes[] = { lo, hi, TYPE( 3000 ), TYPE( 3001 ) };
+    for( size_t p = 0; p < sizeof( probes ) / sizeof( probes[0] ); p++ ) {
+      const TYPE value = probes[p];
+      size_t first = n;
+      size_t count = 0;
+      for( size_t i = 0; i < n; i++ ) {
+        if( a[i] == value ) {
+          first = MIN( first, i );
+          count++;
+        }
+      }
+      REQUIRE( find_type( a, n, value ) == first );
+      REQUIRE( count_type( a, n, value ) == count );
+    }
+    if( n > 0 ) {
+      size_t minIndex = 0;
+      size_t maxIndex = 0;
+      for( size_t i = 1; i < n; i++ ) {
+        minIndex = a[i] < a[minIndex] ? i : minIndex;
+        maxIndex = a[maxIndex] < a[i] ? i : maxIndex;
+      }
+      REQUIRE( &min_type( a, n ) == a + minIndex );
+      REQUIRE( &max_type( a, n ) == a + maxIndex );
+    }
+
+    REQUIRE( vector.sort() == NO_ERROR );
+    a = vector.array();
+    for( size_t p = 0; p < sizeof( probes ) / sizeof( probes[0] ); p++ ) {
+      size_t order = 0;
+      while( order < n && a[order] < probes[p] ) {
+        order++;
+      }
+      REQUIRE( lower_bound_type( a, n, probes[p] ) == order );
+    }
+  }
+}
+
+TEST_CASE( "search kernels", "[Search]" )
+{
+  checkSearch<int32_t>( INT32_MIN, INT32_MAX );
+  checkSearch<uint32_t>( 0, UINT32_MAX );
+  checkSearch<int64_t>( INT64_MIN, INT64_MAX );
+  checkSearch<uint64_t>( 0, UINT64_MAX );
+  checkSearch<int16_t>( INT16_MIN, INT16_MAX );
+
+  // large sorted arrays go through the prefetching binary search
+  SortedVector<uint64_t> sorted;
+  Vector<uint64_t> values;
+  for( uint64_t i = 0; i < 100000; i++ ) {
+    values.add( i * 3 + ( uint64_t( 1 ) << 63 ) );
+  }
+  REQUIRE( sorted.merge( values ) == NO_ERROR );
+  for( uint64_t i = 0; i < 300000; i += 7 ) {
+    const uint64_t value = i + ( uint64_t( 1 ) << 63 );
+    REQUIRE( sorted.orderOf( value ) == ( i + 2 ) / 3 );
+    REQUIRE( sorted.indexOf( value ) == ( i % 3 == 0 ? int( i / 3 ) : NAME_NOT_FOUND ) );
+  }
+  REQUIRE( sorted.remove( ( uint64_t( 1 ) << 63 ) + 3 ) == 1 );
+  REQUIRE( sorted.add( ( uint64_t( 1 ) << 63 ) + 4 ) == 1 );
+  REQUIRE( sorted.add( 5 ) == 0 );
+  REQUIRE( sorted.size() == 100001 );
+
+  Vector<String8> strings;
+  strings.add( String8( "a" ) );
+  strings.add( String8( "b" ) );
+  REQUIRE( strings.indexOf( String8( "b" ) ) == 1 );
+  REQUIRE( strings.indexOf( String8( "c" ) ) == NAME_NOT_FOUND );
+}